@@ -12,7 +12,7 @@ struct VertexOut
     float2 TexCoord : TEXCOORD;
 };
 
-cbuffer ConstantBuffer : register(b0)
+cbuffer WorldMatrixBuffer : register(b0)
 {
     matrix worldMatrix;
 };
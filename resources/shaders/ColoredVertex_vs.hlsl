@@ -1,4 +1,4 @@
-cbuffer ConstantBuffer : register(b0)
+cbuffer WorldMatrixBuffer : register(b0)
 {
     matrix worldMatrix;
 };
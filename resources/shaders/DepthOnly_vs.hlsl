@@ -0,0 +1,24 @@
+// Vertex shader for depth prepasses and shadow maps, it only reads the position stream of a Mesh
+struct VertexIn
+{
+    float3 Position : POSITION;
+};
+
+struct VertexOut
+{
+    float4 Position : SV_POSITION;
+};
+
+cbuffer WorldMatrixBuffer : register(b0)
+{
+    matrix worldMatrix;
+};
+
+VertexOut vs_main(VertexIn input)
+{
+    VertexOut output;
+
+    output.Position = mul(float4(input.Position, 1.0f), worldMatrix);
+
+    return output;
+}
@@ -0,0 +1,40 @@
+#include "VertexCompression.hlsli"
+
+struct VertexIn
+{
+    float4 Position : POSITION;
+    float4 NormalTangent : NORMAL;
+    float2 TexCoord : TEXCOORD;
+    float4 Color : COLOR;
+};
+
+struct VertexOut
+{
+    float4 Position : SV_POSITION;
+    float4 Color : COLOR;
+    float2 TexCoord : TEXCOORD;
+};
+
+cbuffer WorldMatrixBuffer : register(b0)
+{
+    matrix worldMatrix;
+};
+
+// Matches MeshBounds in src/graphics/VertexCompression.h
+cbuffer MeshBoundsBuffer : register(b1)
+{
+    float3 boundsMin;
+    float3 boundsExtent;
+};
+
+VertexOut vs_main(VertexIn input)
+{
+    VertexOut output;
+
+    float3 position = DecodePosition(input.Position, boundsMin, boundsExtent);
+    output.Position = mul(float4(position, 1.0f), worldMatrix);
+    output.Color = input.Color;
+    output.TexCoord = input.TexCoord;
+
+    return output;
+}
@@ -0,0 +1,34 @@
+#ifndef VERTEX_COMPRESSION_HLSLI
+#define VERTEX_COMPRESSION_HLSLI
+
+// Decoders for PackedVertexData (see src/graphics/VertexFormat.h and VertexCompression.cpp)
+
+// Positions are 16-bit UNORM relative to the mesh bounds
+float3 DecodePosition(float4 packedPosition, float3 boundsMin, float3 boundsExtent)
+{
+    return boundsMin + packedPosition.xyz * boundsExtent;
+}
+
+// The w component of the packed position holds the tangent handedness
+float DecodeHandedness(float4 packedPosition)
+{
+    return packedPosition.w > 0.5f ? 1.0f : -1.0f;
+}
+
+float3 OctahedralDecode(float2 encoded)
+{
+    float3 normal = float3(encoded.xy, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-normal.z);
+    normal.xy += (normal.xy >= 0.0f) ? -t : t;
+    return normalize(normal);
+}
+
+// Normal and tangent are octahedral encoded in xy and zw, the bitangent is rebuilt from them
+void DecodeTangentFrame(float4 packedNormalTangent, float handedness, out float3 normal, out float3 tangent, out float3 bitangent)
+{
+    normal = OctahedralDecode(packedNormalTangent.xy);
+    tangent = OctahedralDecode(packedNormalTangent.zw);
+    bitangent = cross(normal, tangent) * handedness;
+}
+
+#endif // VERTEX_COMPRESSION_HLSLI
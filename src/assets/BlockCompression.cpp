@@ -0,0 +1,948 @@
+#include "BlockCompression.h"
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+
+#include <immintrin.h>
+
+#include "TextureLoader.h"
+#include "../utils/ConsoleLogger.h"
+#include "../utils/ThreadPool.h"
+
+
+namespace {
+	constexpr uint32_t BLOCK_TEXELS = 16;
+	// Blocks per ParallelFor batch
+	constexpr size_t BATCH_BLOCKS = 256;
+	// Interpolation weights of the 4-bit BC7 indices, out of 64
+	constexpr uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	// Rounds of least squares refinement per quality level
+	constexpr uint32_t REFINE_ITERATIONS[] = { 0, 2, 6 };
+	constexpr uint32_t LOCAL_SEARCH_PASSES = 4;
+
+	// 16 texels, one array per channel so four texels fit in an SSE register
+	struct Block {
+		alignas(16) float channels[4][BLOCK_TEXELS];
+	};
+
+	struct Color {
+		float c[4] = {};
+	};
+
+	void LoadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, Block& block) {
+		for (uint32_t y = 0; y < 4; ++y) {
+			const uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; ++x) {
+				const uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+				const uint8_t* texel = pixels + (size_t(sourceY) * width + sourceX) * 4;
+				for (uint32_t c = 0; c < 4; ++c)
+					block.channels[c][y * 4 + x] = texel[c];
+			}
+		}
+	}
+
+	// Nearest palette entry of every texel, by squared distance over the channels with a non-zero weight.
+	// The texels of `ignoredTexels` (bit per texel) don't count in the returned error, their index is set by the caller.
+	float SelectIndices(const Block& block, const Color* palette, uint32_t paletteSize, const float (&weights)[4], uint32_t ignoredTexels,
+		uint8_t (&indices)[BLOCK_TEXELS]) {
+		alignas(16) int32_t bestIndices[BLOCK_TEXELS];
+		alignas(16) float errors[BLOCK_TEXELS];
+		for (uint32_t group = 0; group < BLOCK_TEXELS; group += 4) {
+			__m128 texels[4];
+			for (uint32_t c = 0; c < 4; ++c)
+				texels[c] = _mm_load_ps(block.channels[c] + group);
+
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (uint32_t p = 0; p < paletteSize; ++p) {
+				__m128 distance = _mm_setzero_ps();
+				for (uint32_t c = 0; c < 4; ++c) {
+					if (weights[c] == 0.0f)
+						continue;
+					__m128 difference = _mm_sub_ps(texels[c], _mm_set1_ps(palette[p].c[c]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(_mm_mul_ps(difference, difference), _mm_set1_ps(weights[c])));
+				}
+				// Strictly closer, ties keep the lower index
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+				best = _mm_min_ps(distance, best);
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(p))), _mm_andnot_si128(closer, bestIndex));
+			}
+			_mm_store_si128(reinterpret_cast<__m128i*>(bestIndices + group), bestIndex);
+			_mm_store_ps(errors + group, best);
+		}
+
+		float total = 0.0f;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+			indices[i] = static_cast<uint8_t>(bestIndices[i]);
+			if (!(ignoredTexels & (1u << i)))
+				total += errors[i];
+		}
+		return total;
+	}
+
+	// Mean and direction of largest variance of the texels, over the first `channelCount` channels
+	void ComputePrincipalAxis(const Block& block, uint32_t channelCount, uint32_t ignoredTexels, Color& mean, Color& axis) {
+		uint32_t count = 0;
+		mean = Color();
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+			if (ignoredTexels & (1u << i))
+				continue;
+			for (uint32_t c = 0; c < channelCount; ++c)
+				mean.c[c] += block.channels[c][i];
+			++count;
+		}
+		for (uint32_t c = 0; c < channelCount; ++c)
+			mean.c[c] /= std::max(count, 1u);
+
+		float covariance[4][4] = {};
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+			if (ignoredTexels & (1u << i))
+				continue;
+			for (uint32_t row = 0; row < channelCount; ++row) {
+				for (uint32_t column = 0; column < channelCount; ++column)
+					covariance[row][column] += (block.channels[row][i] - mean.c[row]) * (block.channels[column][i] - mean.c[column]);
+			}
+		}
+
+		// Power iteration, starting from the column of the channel that varies the most
+		uint32_t start = 0;
+		for (uint32_t c = 1; c < channelCount; ++c) {
+			if (covariance[c][c] > covariance[start][start])
+				start = c;
+		}
+		axis = Color();
+		for (uint32_t c = 0; c < channelCount; ++c)
+			axis.c[c] = covariance[c][start];
+		for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+			Color next;
+			float length = 0.0f;
+			for (uint32_t row = 0; row < channelCount; ++row) {
+				for (uint32_t column = 0; column < channelCount; ++column)
+					next.c[row] += covariance[row][column] * axis.c[column];
+				length += next.c[row] * next.c[row];
+			}
+			if (length <= 0.0f)
+				break;
+			length = 1.0f / std::sqrt(length);
+			for (uint32_t c = 0; c < channelCount; ++c)
+				axis.c[c] = next.c[c] * length;
+		}
+	}
+
+	// Ends of the segment of the axis the texels project on
+	void GetAxisEndpoints(const Block& block, uint32_t channelCount, uint32_t ignoredTexels, const Color& mean, const Color& axis, Color& a, Color& b) {
+		float minimum = FLT_MAX;
+		float maximum = -FLT_MAX;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+			if (ignoredTexels & (1u << i))
+				continue;
+			float projection = 0.0f;
+			for (uint32_t c = 0; c < channelCount; ++c)
+				projection += (block.channels[c][i] - mean.c[c]) * axis.c[c];
+			minimum = std::min(minimum, projection);
+			maximum = std::max(maximum, projection);
+		}
+		if (minimum > maximum)
+			minimum = maximum = 0.0f;
+		for (uint32_t c = 0; c < channelCount; ++c) {
+			a.c[c] = std::clamp(mean.c[c] + minimum * axis.c[c], 0.0f, 255.0f);
+			b.c[c] = std::clamp(mean.c[c] + maximum * axis.c[c], 0.0f, 255.0f);
+		}
+	}
+
+	// Least squares endpoints for fixed interpolation factors: minimizes the sum of |(1 - t) a + t b - x|^2.
+	// Returns false if the factors are all the same, the system is singular then.
+	bool FitEndpoints(const Block& block, uint32_t firstChannel, uint32_t channelCount, uint32_t ignoredTexels, const float (&factors)[BLOCK_TEXELS],
+		Color& a, Color& b) {
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		Color ax;
+		Color bx;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+			if (ignoredTexels & (1u << i))
+				continue;
+			const float t = factors[i];
+			aa += (1.0f - t) * (1.0f - t);
+			ab += (1.0f - t) * t;
+			bb += t * t;
+			for (uint32_t c = firstChannel; c < firstChannel + channelCount; ++c) {
+				ax.c[c] += (1.0f - t) * block.channels[c][i];
+				bx.c[c] += t * block.channels[c][i];
+			}
+		}
+		const float determinant = aa * bb - ab * ab;
+		if (std::abs(determinant) < 1e-6f)
+			return false;
+		const float inverse = 1.0f / determinant;
+		for (uint32_t c = firstChannel; c < firstChannel + channelCount; ++c) {
+			a.c[c] = std::clamp((bb * ax.c[c] - ab * bx.c[c]) * inverse, 0.0f, 255.0f);
+			b.c[c] = std::clamp((aa * bx.c[c] - ab * ax.c[c]) * inverse, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	// BC1 color block: two RGB565 endpoints, then 2-bit indices, texel 0 in the lowest bits.
+	// color0 > color1 selects the 4 color mode, otherwise 3 colors and transparent black.
+	uint16_t QuantizeColor565(const Color& color) {
+		uint32_t r = static_cast<uint32_t>(std::lround(std::clamp(color.c[0], 0.0f, 255.0f) * 31.0f / 255.0f));
+		uint32_t g = static_cast<uint32_t>(std::lround(std::clamp(color.c[1], 0.0f, 255.0f) * 63.0f / 255.0f));
+		uint32_t b = static_cast<uint32_t>(std::lround(std::clamp(color.c[2], 0.0f, 255.0f) * 31.0f / 255.0f));
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	Color ExpandColor565(uint16_t color) {
+		const uint32_t r = (color >> 11) & 31;
+		const uint32_t g = (color >> 5) & 63;
+		const uint32_t b = color & 31;
+		Color expanded;
+		expanded.c[0] = static_cast<float>((r << 3) | (r >> 2));
+		expanded.c[1] = static_cast<float>((g << 2) | (g >> 4));
+		expanded.c[2] = static_cast<float>((b << 3) | (b >> 2));
+		expanded.c[3] = 255.0f;
+		return expanded;
+	}
+
+	struct Bc1Candidate {
+		uint16_t color0 = 0;
+		uint16_t color1 = 0;
+		uint8_t indices[BLOCK_TEXELS] = {};
+		float error = FLT_MAX;
+	};
+
+	// Keeps the endpoints in `best` if they do better, with the indices that fit them best
+	void EvaluateBc1(const Block& block, uint16_t color0, uint16_t color1, uint32_t transparentTexels, Bc1Candidate& best) {
+		const Color endpoint0 = ExpandColor565(color0);
+		const Color endpoint1 = ExpandColor565(color1);
+		Color palette[4] = { endpoint0, endpoint1 };
+		uint32_t paletteSize = 4;
+		for (uint32_t c = 0; c < 3; ++c) {
+			if (transparentTexels != 0) {
+				palette[2].c[c] = (endpoint0.c[c] + endpoint1.c[c]) * 0.5f;
+				paletteSize = 3;
+			}
+			else {
+				palette[2].c[c] = (2.0f * endpoint0.c[c] + endpoint1.c[c]) / 3.0f;
+				palette[3].c[c] = (endpoint0.c[c] + 2.0f * endpoint1.c[c]) / 3.0f;
+			}
+		}
+
+		static const float COLOR_WEIGHTS[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+		Bc1Candidate candidate;
+		candidate.color0 = color0;
+		candidate.color1 = color1;
+		candidate.error = SelectIndices(block, palette, paletteSize, COLOR_WEIGHTS, transparentTexels, candidate.indices);
+		if (candidate.error < best.error)
+			best = candidate;
+	}
+
+	void WriteBc1(const Bc1Candidate& candidate, uint32_t transparentTexels, uint8_t* output) {
+		uint16_t color0 = candidate.color0;
+		uint16_t color1 = candidate.color1;
+		uint8_t indices[BLOCK_TEXELS];
+		std::memcpy(indices, candidate.indices, sizeof(indices));
+
+		// The endpoint order selects the mode, swapping them swaps indices 0 and 1 (and 2 and 3 in 4 color mode)
+		const bool swap = transparentTexels != 0 ? color0 > color1 : color0 < color1;
+		if (swap) {
+			std::swap(color0, color1);
+			for (uint8_t& index : indices)
+				index = transparentTexels != 0 && index >= 2 ? index : static_cast<uint8_t>(index ^ 1);
+		}
+		// Equal endpoints decode in 3 color mode, index 0 is the color in both modes
+		if (color0 == color1 && transparentTexels == 0)
+			std::memset(indices, 0, sizeof(indices));
+
+		uint32_t packed = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+			uint32_t index = transparentTexels & (1u << i) ? 3u : indices[i];
+			packed |= index << (i * 2);
+		}
+		std::memcpy(output, &color0, 2);
+		std::memcpy(output + 2, &color1, 2);
+		std::memcpy(output + 4, &packed, 4);
+	}
+
+	// `allowTransparency`: texels with an alpha below 128 are written transparent (BC1 on its own, not in BC3)
+	void EncodeBc1(const Block& block, CompressionQuality quality, bool allowTransparency, uint8_t* output) {
+		uint32_t transparentTexels = 0;
+		if (allowTransparency) {
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+				transparentTexels |= block.channels[3][i] < 128.0f ? 1u << i : 0u;
+		}
+		Bc1Candidate best;
+		if (transparentTexels == 0xFFFF) {
+			best.error = 0.0f;
+			WriteBc1(best, transparentTexels, output);
+			return;
+		}
+
+		Color mean;
+		Color axis;
+		Color a;
+		Color b;
+		ComputePrincipalAxis(block, 3, transparentTexels, mean, axis);
+		GetAxisEndpoints(block, 3, transparentTexels, mean, axis, a, b);
+		EvaluateBc1(block, QuantizeColor565(a), QuantizeColor565(b), transparentTexels, best);
+
+		for (uint32_t iteration = 0; iteration < REFINE_ITERATIONS[static_cast<uint32_t>(quality)] && best.error > 0.0f; ++iteration) {
+			float factors[BLOCK_TEXELS];
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+				static const float FOUR_COLOR_FACTORS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+				static const float THREE_COLOR_FACTORS[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+				factors[i] = (transparentTexels != 0 ? THREE_COLOR_FACTORS : FOUR_COLOR_FACTORS)[best.indices[i]];
+			}
+			const float previousError = best.error;
+			if (!FitEndpoints(block, 0, 3, transparentTexels, factors, a, b))
+				break;
+			EvaluateBc1(block, QuantizeColor565(a), QuantizeColor565(b), transparentTexels, best);
+			if (best.error >= previousError)
+				break;
+		}
+
+		if (quality == CompressionQuality::High) {
+			// Steps of one quantization level on every component of both endpoints, while the error drops
+			static const uint32_t SHIFTS[3] = { 11, 5, 0 };
+			static const uint32_t MAXIMUMS[3] = { 31, 63, 31 };
+			for (uint32_t pass = 0; pass < LOCAL_SEARCH_PASSES && best.error > 0.0f; ++pass) {
+				const float previousError = best.error;
+				for (uint32_t endpoint = 0; endpoint < 2; ++endpoint) {
+					for (uint32_t component = 0; component < 3; ++component) {
+						for (int step : { -1, 1 }) {
+							uint16_t color = endpoint == 0 ? best.color0 : best.color1;
+							int value = static_cast<int>((color >> SHIFTS[component]) & MAXIMUMS[component]) + step;
+							if (value < 0 || value > static_cast<int>(MAXIMUMS[component]))
+								continue;
+							color = static_cast<uint16_t>((color & ~(MAXIMUMS[component] << SHIFTS[component])) | (uint32_t(value) << SHIFTS[component]));
+							EvaluateBc1(block, endpoint == 0 ? color : best.color0, endpoint == 0 ? best.color1 : color, transparentTexels, best);
+						}
+					}
+				}
+				if (best.error >= previousError)
+					break;
+			}
+		}
+
+		WriteBc1(best, transparentTexels, output);
+	}
+
+	// BC4 block: two 8-bit endpoints, then 3-bit indices. endpoint0 > endpoint1 selects 6 interpolated values,
+	// otherwise 4 interpolated values plus 0 and 255.
+	void BuildBc4Palette(uint8_t endpoint0, uint8_t endpoint1, float (&palette)[8]) {
+		palette[0] = endpoint0;
+		palette[1] = endpoint1;
+		if (endpoint0 > endpoint1) {
+			for (uint32_t k = 1; k <= 6; ++k)
+				palette[k + 1] = ((7 - k) * endpoint0 + k * endpoint1) / 7.0f;
+		}
+		else {
+			for (uint32_t k = 1; k <= 4; ++k)
+				palette[k + 1] = ((5 - k) * endpoint0 + k * endpoint1) / 5.0f;
+			palette[6] = 0.0f;
+			palette[7] = 255.0f;
+		}
+	}
+
+	struct Bc4Candidate {
+		uint8_t endpoint0 = 0;
+		uint8_t endpoint1 = 0;
+		uint8_t indices[BLOCK_TEXELS] = {};
+		float error = FLT_MAX;
+	};
+
+	void EvaluateBc4(const Block& block, uint32_t channel, uint8_t endpoint0, uint8_t endpoint1, Bc4Candidate& best) {
+		float values[8];
+		BuildBc4Palette(endpoint0, endpoint1, values);
+		Color palette[8];
+		for (uint32_t i = 0; i < 8; ++i)
+			palette[i].c[channel] = values[i];
+		float weights[4] = {};
+		weights[channel] = 1.0f;
+
+		Bc4Candidate candidate;
+		candidate.endpoint0 = endpoint0;
+		candidate.endpoint1 = endpoint1;
+		candidate.error = SelectIndices(block, palette, 8, weights, 0, candidate.indices);
+		if (candidate.error < best.error)
+			best = candidate;
+	}
+
+	uint8_t QuantizeBc4Endpoint(float value) {
+		return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 255.0f)));
+	}
+
+	void EncodeBc4(const Block& block, uint32_t channel, CompressionQuality quality, uint8_t* output) {
+		const float* values = block.channels[channel];
+		float minimum = 255.0f;
+		float maximum = 0.0f;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+			minimum = std::min(minimum, values[i]);
+			maximum = std::max(maximum, values[i]);
+		}
+
+		Bc4Candidate best;
+		// 6 interpolated values, the endpoints go in decreasing order
+		EvaluateBc4(block, channel, QuantizeBc4Endpoint(maximum), QuantizeBc4Endpoint(minimum), best);
+
+		for (uint32_t iteration = 0; iteration < REFINE_ITERATIONS[static_cast<uint32_t>(quality)] && best.error > 0.0f && best.endpoint0 > best.endpoint1; ++iteration) {
+			float factors[BLOCK_TEXELS];
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+				factors[i] = best.indices[i] <= 1 ? static_cast<float>(best.indices[i]) : (best.indices[i] - 1) / 7.0f;
+			Color a;
+			Color b;
+			const float previousError = best.error;
+			if (!FitEndpoints(block, channel, 1, 0, factors, a, b))
+				break;
+			uint8_t endpoint0 = QuantizeBc4Endpoint(a.c[channel]);
+			uint8_t endpoint1 = QuantizeBc4Endpoint(b.c[channel]);
+			if (endpoint0 < endpoint1)
+				std::swap(endpoint0, endpoint1);
+			if (endpoint0 == endpoint1)
+				break;
+			EvaluateBc4(block, channel, endpoint0, endpoint1, best);
+			if (best.error >= previousError)
+				break;
+		}
+
+		if (quality == CompressionQuality::High) {
+			// 4 interpolated values between the extremes other than 0 and 255, which the mode has for free
+			float innerMinimum = 255.0f;
+			float innerMaximum = 0.0f;
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+				if (values[i] > 0.0f && values[i] < 255.0f) {
+					innerMinimum = std::min(innerMinimum, values[i]);
+					innerMaximum = std::max(innerMaximum, values[i]);
+				}
+			}
+			if (innerMinimum <= innerMaximum)
+				EvaluateBc4(block, channel, QuantizeBc4Endpoint(innerMinimum), QuantizeBc4Endpoint(innerMaximum), best);
+
+			// Steps of one on both endpoints, keeping the order of the mode
+			for (uint32_t pass = 0; pass < LOCAL_SEARCH_PASSES && best.error > 0.0f; ++pass) {
+				const float previousError = best.error;
+				const bool sixValues = best.endpoint0 > best.endpoint1;
+				for (uint32_t endpoint = 0; endpoint < 2; ++endpoint) {
+					for (int step : { -1, 1 }) {
+						int endpoint0 = best.endpoint0 + (endpoint == 0 ? step : 0);
+						int endpoint1 = best.endpoint1 + (endpoint == 1 ? step : 0);
+						if (endpoint0 < 0 || endpoint0 > 255 || endpoint1 < 0 || endpoint1 > 255 || (endpoint0 > endpoint1) != sixValues)
+							continue;
+						EvaluateBc4(block, channel, static_cast<uint8_t>(endpoint0), static_cast<uint8_t>(endpoint1), best);
+					}
+				}
+				if (best.error >= previousError)
+					break;
+			}
+		}
+
+		uint64_t packed = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			packed |= uint64_t(best.indices[i]) << (i * 3);
+		output[0] = best.endpoint0;
+		output[1] = best.endpoint1;
+		for (uint32_t i = 0; i < 6; ++i)
+			output[2 + i] = static_cast<uint8_t>(packed >> (i * 8));
+	}
+
+	// BC7 mode 6 endpoint: 7 bits per RGBA channel plus a p-bit shared by the channels, the lowest bit of each
+	struct Bc7Endpoint {
+		uint8_t channels[4] = {};
+		uint8_t pBit = 0;
+	};
+
+	Color DecodeBc7Endpoint(const Bc7Endpoint& endpoint) {
+		Color color;
+		for (uint32_t c = 0; c < 4; ++c)
+			color.c[c] = static_cast<float>((endpoint.channels[c] << 1) | endpoint.pBit);
+		return color;
+	}
+
+	Bc7Endpoint QuantizeBc7Endpoint(const Color& color, uint8_t pBit) {
+		Bc7Endpoint endpoint;
+		endpoint.pBit = pBit;
+		for (uint32_t c = 0; c < 4; ++c)
+			endpoint.channels[c] = static_cast<uint8_t>(std::clamp<long>(std::lround((color.c[c] - pBit) * 0.5f), 0, 127));
+		return endpoint;
+	}
+
+	// The p-bit that brings the endpoint closest to the color
+	Bc7Endpoint QuantizeBc7Endpoint(const Color& color) {
+		Bc7Endpoint best;
+		float bestError = FLT_MAX;
+		for (uint8_t pBit = 0; pBit < 2; ++pBit) {
+			Bc7Endpoint endpoint = QuantizeBc7Endpoint(color, pBit);
+			Color decoded = DecodeBc7Endpoint(endpoint);
+			float error = 0.0f;
+			for (uint32_t c = 0; c < 4; ++c)
+				error += (decoded.c[c] - color.c[c]) * (decoded.c[c] - color.c[c]);
+			if (error < bestError) {
+				bestError = error;
+				best = endpoint;
+			}
+		}
+		return best;
+	}
+
+	struct Bc7Candidate {
+		Bc7Endpoint endpoint0;
+		Bc7Endpoint endpoint1;
+		uint8_t indices[BLOCK_TEXELS] = {};
+		float error = FLT_MAX;
+	};
+
+	void EvaluateBc7(const Block& block, const Bc7Endpoint& endpoint0, const Bc7Endpoint& endpoint1, Bc7Candidate& best) {
+		const Color decoded0 = DecodeBc7Endpoint(endpoint0);
+		const Color decoded1 = DecodeBc7Endpoint(endpoint1);
+		// The integer interpolation of the decoder
+		Color palette[16];
+		for (uint32_t i = 0; i < 16; ++i) {
+			for (uint32_t c = 0; c < 4; ++c) {
+				const uint32_t value0 = static_cast<uint32_t>(decoded0.c[c]);
+				const uint32_t value1 = static_cast<uint32_t>(decoded1.c[c]);
+				palette[i].c[c] = static_cast<float>(((64 - BC7_WEIGHTS[i]) * value0 + BC7_WEIGHTS[i] * value1 + 32) >> 6);
+			}
+		}
+
+		static const float RGBA_WEIGHTS[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		Bc7Candidate candidate;
+		candidate.endpoint0 = endpoint0;
+		candidate.endpoint1 = endpoint1;
+		candidate.error = SelectIndices(block, palette, 16, RGBA_WEIGHTS, 0, candidate.indices);
+		if (candidate.error < best.error)
+			best = candidate;
+	}
+
+	// Quantizes a pair of endpoints, with every p-bit combination at high quality
+	void EvaluateBc7Endpoints(const Block& block, const Color& a, const Color& b, CompressionQuality quality, Bc7Candidate& best) {
+		if (quality != CompressionQuality::High) {
+			EvaluateBc7(block, QuantizeBc7Endpoint(a), QuantizeBc7Endpoint(b), best);
+			return;
+		}
+		for (uint8_t pBits = 0; pBits < 4; ++pBits)
+			EvaluateBc7(block, QuantizeBc7Endpoint(a, pBits & 1), QuantizeBc7Endpoint(b, pBits >> 1), best);
+	}
+
+	// 128 bits written from the lowest bit of the first byte
+	class BlockBitWriter {
+		public:
+			void Write(uint32_t value, uint32_t bitCount) {
+				const uint32_t shift = m_position & 63;
+				m_bits[m_position >> 6] |= uint64_t(value) << shift;
+				if (shift + bitCount > 64)
+					m_bits[(m_position >> 6) + 1] |= uint64_t(value) >> (64 - shift);
+				m_position += bitCount;
+			}
+
+			void Store(uint8_t* output) const {
+				for (uint32_t i = 0; i < 16; ++i)
+					output[i] = static_cast<uint8_t>(m_bits[i >> 3] >> ((i & 7) * 8));
+			}
+
+		private:
+			uint64_t m_bits[2] = {};
+			uint32_t m_position = 0;
+	};
+
+	class BlockBitReader {
+		public:
+			explicit BlockBitReader(const uint8_t* block) {
+				for (uint32_t i = 0; i < 16; ++i)
+					m_bits[i >> 3] |= uint64_t(block[i]) << ((i & 7) * 8);
+			}
+
+			uint32_t Read(uint32_t bitCount) {
+				const uint32_t shift = m_position & 63;
+				uint64_t value = m_bits[m_position >> 6] >> shift;
+				if (shift + bitCount > 64)
+					value |= m_bits[(m_position >> 6) + 1] << (64 - shift);
+				m_position += bitCount;
+				return static_cast<uint32_t>(value & ((uint64_t(1) << bitCount) - 1));
+			}
+
+		private:
+			uint64_t m_bits[2] = {};
+			uint32_t m_position = 0;
+	};
+
+	void EncodeBc7(const Block& block, CompressionQuality quality, uint8_t* output) {
+		Color mean;
+		Color axis;
+		Color a;
+		Color b;
+		ComputePrincipalAxis(block, 4, 0, mean, axis);
+		GetAxisEndpoints(block, 4, 0, mean, axis, a, b);
+
+		Bc7Candidate best;
+		EvaluateBc7Endpoints(block, a, b, quality, best);
+
+		for (uint32_t iteration = 0; iteration < REFINE_ITERATIONS[static_cast<uint32_t>(quality)] && best.error > 0.0f; ++iteration) {
+			float factors[BLOCK_TEXELS];
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+				factors[i] = BC7_WEIGHTS[best.indices[i]] / 64.0f;
+			const float previousError = best.error;
+			if (!FitEndpoints(block, 0, 4, 0, factors, a, b))
+				break;
+			EvaluateBc7Endpoints(block, a, b, quality, best);
+			if (best.error >= previousError)
+				break;
+		}
+
+		if (quality == CompressionQuality::High) {
+			for (uint32_t pass = 0; pass < LOCAL_SEARCH_PASSES && best.error > 0.0f; ++pass) {
+				const float previousError = best.error;
+				for (uint32_t endpoint = 0; endpoint < 2; ++endpoint) {
+					for (uint32_t c = 0; c < 4; ++c) {
+						for (int step : { -1, 1 }) {
+							Bc7Endpoint endpoint0 = best.endpoint0;
+							Bc7Endpoint endpoint1 = best.endpoint1;
+							Bc7Endpoint& changed = endpoint == 0 ? endpoint0 : endpoint1;
+							int value = changed.channels[c] + step;
+							if (value < 0 || value > 127)
+								continue;
+							changed.channels[c] = static_cast<uint8_t>(value);
+							EvaluateBc7(block, endpoint0, endpoint1, best);
+						}
+					}
+				}
+				if (best.error >= previousError)
+					break;
+			}
+		}
+
+		// The highest bit of the first index is implicit and must be 0: swapping the endpoints mirrors the indices
+		if (best.indices[0] >= 8) {
+			std::swap(best.endpoint0, best.endpoint1);
+			for (uint8_t& index : best.indices)
+				index = static_cast<uint8_t>(15 - index);
+		}
+
+		BlockBitWriter writer;
+		writer.Write(1 << 6, 7);  // Mode 6: six zero bits then a one
+		for (uint32_t c = 0; c < 4; ++c) {
+			writer.Write(best.endpoint0.channels[c], 7);
+			writer.Write(best.endpoint1.channels[c], 7);
+		}
+		writer.Write(best.endpoint0.pBit, 1);
+		writer.Write(best.endpoint1.pBit, 1);
+		writer.Write(best.indices[0], 3);
+		for (uint32_t i = 1; i < BLOCK_TEXELS; ++i)
+			writer.Write(best.indices[i], 4);
+		writer.Store(output);
+	}
+
+	void EncodeBlock(const Block& block, const CompressionSettings& settings, uint8_t* output) {
+		switch (settings.format) {
+		case BlockFormat::BC1:
+			EncodeBc1(block, settings.quality, true, output);
+			break;
+		case BlockFormat::BC3:
+			EncodeBc4(block, 3, settings.quality, output);
+			EncodeBc1(block, settings.quality, false, output + 8);
+			break;
+		case BlockFormat::BC4:
+			EncodeBc4(block, 0, settings.quality, output);
+			break;
+		case BlockFormat::BC5:
+			EncodeBc4(block, 0, settings.quality, output);
+			EncodeBc4(block, 1, settings.quality, output + 8);
+			break;
+		case BlockFormat::BC7:
+			EncodeBc7(block, settings.quality, output);
+			break;
+		case BlockFormat::RGBA8:  // Copied by Compress, never encoded
+			break;
+		}
+	}
+
+	// Decoders, texels of a block as RGBA8 in row order
+
+	void DecodeBc1(const uint8_t* input, bool alwaysFourColors, uint8_t (&texels)[BLOCK_TEXELS][4]) {
+		uint16_t color0;
+		uint16_t color1;
+		uint32_t indices;
+		std::memcpy(&color0, input, 2);
+		std::memcpy(&color1, input + 2, 2);
+		std::memcpy(&indices, input + 4, 4);
+
+		const Color endpoint0 = ExpandColor565(color0);
+		const Color endpoint1 = ExpandColor565(color1);
+		uint8_t palette[4][4] = {};
+		for (uint32_t c = 0; c < 3; ++c) {
+			const uint32_t value0 = static_cast<uint32_t>(endpoint0.c[c]);
+			const uint32_t value1 = static_cast<uint32_t>(endpoint1.c[c]);
+			palette[0][c] = static_cast<uint8_t>(value0);
+			palette[1][c] = static_cast<uint8_t>(value1);
+			if (color0 > color1 || alwaysFourColors) {
+				palette[2][c] = static_cast<uint8_t>((2 * value0 + value1 + 1) / 3);
+				palette[3][c] = static_cast<uint8_t>((value0 + 2 * value1 + 1) / 3);
+			}
+			else {
+				palette[2][c] = static_cast<uint8_t>((value0 + value1 + 1) / 2);
+			}
+		}
+		palette[0][3] = palette[1][3] = palette[2][3] = 255;
+		palette[3][3] = color0 > color1 || alwaysFourColors ? 255 : 0;
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			std::memcpy(texels[i], palette[(indices >> (i * 2)) & 3], 4);
+	}
+
+	void DecodeBc4(const uint8_t* input, uint32_t channel, uint8_t (&texels)[BLOCK_TEXELS][4]) {
+		float palette[8];
+		BuildBc4Palette(input[0], input[1], palette);
+		uint64_t indices = 0;
+		for (uint32_t i = 0; i < 6; ++i)
+			indices |= uint64_t(input[2 + i]) << (i * 8);
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			texels[i][channel] = static_cast<uint8_t>(std::lround(palette[(indices >> (i * 3)) & 7]));
+	}
+
+	void DecodeBc7(const uint8_t* input, uint8_t (&texels)[BLOCK_TEXELS][4]) {
+		if ((input[0] & 0x7F) != 0x40) {
+			for (uint8_t (&texel)[4] : texels) {
+				texel[0] = 255;
+				texel[1] = 0;
+				texel[2] = 255;
+				texel[3] = 255;
+			}
+			return;
+		}
+
+		BlockBitReader reader(input);
+		reader.Read(7);
+		uint32_t endpoints[2][4];
+		for (uint32_t c = 0; c < 4; ++c) {
+			endpoints[0][c] = reader.Read(7) << 1;
+			endpoints[1][c] = reader.Read(7) << 1;
+		}
+		const uint32_t pBit0 = reader.Read(1);
+		const uint32_t pBit1 = reader.Read(1);
+		for (uint32_t c = 0; c < 4; ++c) {
+			endpoints[0][c] |= pBit0;
+			endpoints[1][c] |= pBit1;
+		}
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i) {
+			const uint32_t weight = BC7_WEIGHTS[reader.Read(i == 0 ? 3 : 4)];
+			for (uint32_t c = 0; c < 4; ++c)
+				texels[i][c] = static_cast<uint8_t>(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+		}
+	}
+
+	void DecodeBlock(const uint8_t* input, BlockFormat format, uint8_t (&texels)[BLOCK_TEXELS][4]) {
+		for (uint8_t (&texel)[4] : texels) {
+			texel[0] = texel[1] = texel[2] = 0;
+			texel[3] = 255;
+		}
+		switch (format) {
+		case BlockFormat::BC1:
+			DecodeBc1(input, false, texels);
+			break;
+		case BlockFormat::BC3:
+			DecodeBc1(input + 8, true, texels);
+			DecodeBc4(input, 3, texels);
+			break;
+		case BlockFormat::BC4:
+			DecodeBc4(input, 0, texels);
+			break;
+		case BlockFormat::BC5:
+			DecodeBc4(input, 0, texels);
+			DecodeBc4(input + 8, 1, texels);
+			break;
+		case BlockFormat::BC7:
+			DecodeBc7(input, texels);
+			break;
+		case BlockFormat::RGBA8:  // Copied by Decompress, never decoded
+			break;
+		}
+	}
+}
+
+bool BlockCompression::Compress(const DecodedImage& image, const CompressionSettings& settings, CompressedImage& compressed, ThreadPool* threadPool) {
+	if (!image.IsValid() || image.width == 0 || image.height == 0) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to compress image ", image.id, ": the image is empty.");
+		return false;
+	}
+	CompressedImage result;
+	result.id = image.id;
+	result.width = image.width;
+	result.height = image.height;
+	result.levelCount = image.levelCount;
+	result.format = settings.format;
+	// The smaller levels can have partial blocks, the top level can't: the other sizes are kept uncompressed
+	if (image.width % 4 != 0 || image.height % 4 != 0 || settings.format == BlockFormat::RGBA8) {
+		if (settings.format != BlockFormat::RGBA8) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "Image ", image.id, " is stored uncompressed: its size (", image.width, "x", image.height,
+				") isn't a multiple of 4.");
+		}
+		result.format = BlockFormat::RGBA8;
+	}
+	const bool colorFormat = result.format == BlockFormat::BC1 || result.format == BlockFormat::BC3 || result.format == BlockFormat::BC7 ||
+		result.format == BlockFormat::RGBA8;
+	result.sRGB = settings.sRGB && colorFormat;
+	result.data.reset(static_cast<uint8_t*>(StagingMemory::Allocate(result.GetSize())));
+	if (result.data == nullptr) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to compress image ", image.id, ": out of memory.");
+		return false;
+	}
+
+	// Same level layout as the decoded image
+	if (!result.IsBlockCompressed()) {
+		std::memcpy(result.data.get(), image.pixels.get(), result.GetSize());
+		compressed = std::move(result);
+		return true;
+	}
+
+	for (uint32_t level = 0; level < image.levelCount; ++level) {
+		const uint8_t* pixels = image.pixels.get() + image.GetLevelOffset(level);
+		const uint32_t width = image.GetLevelWidth(level);
+		const uint32_t height = image.GetLevelHeight(level);
+		const uint32_t blockCountX = result.GetBlockCountX(level);
+		const uint32_t rowPitch = result.GetRowPitch(level);
+		const uint32_t blockSize = result.GetBlockSize();
+		uint8_t* destination = result.data.get() + result.GetLevelOffset(level);
+
+		auto encodeRows = [&](size_t begin, size_t end) {
+			Block block;
+			for (size_t blockY = begin; blockY < end; ++blockY) {
+				for (uint32_t blockX = 0; blockX < blockCountX; ++blockX) {
+					LoadBlock(pixels, width, height, blockX, static_cast<uint32_t>(blockY), block);
+					EncodeBlock(block, settings, destination + blockY * rowPitch + size_t(blockX) * blockSize);
+				}
+			}
+		};
+		if (threadPool != nullptr)
+			threadPool->ParallelFor(result.GetBlockCountY(level), std::max<size_t>(BATCH_BLOCKS / blockCountX, 1), encodeRows);
+		else
+			encodeRows(0, result.GetBlockCountY(level));
+	}
+
+	compressed = std::move(result);
+	return true;
+}
+
+void BlockCompression::Decompress(const CompressedImage& compressed, uint32_t level, uint8_t* pixels) {
+	const uint32_t width = compressed.GetLevelWidth(level);
+	const uint32_t height = compressed.GetLevelHeight(level);
+	const uint8_t* blocks = compressed.data.get() + compressed.GetLevelOffset(level);
+	if (!compressed.IsBlockCompressed()) {
+		std::memcpy(pixels, blocks, compressed.GetLevelSize(level));
+		return;
+	}
+	for (uint32_t blockY = 0; blockY < compressed.GetBlockCountY(level); ++blockY) {
+		for (uint32_t blockX = 0; blockX < compressed.GetBlockCountX(level); ++blockX) {
+			uint8_t texels[BLOCK_TEXELS][4];
+			DecodeBlock(blocks + size_t(blockY) * compressed.GetRowPitch(level) + size_t(blockX) * compressed.GetBlockSize(), compressed.format, texels);
+			// Texels past the edges of partial blocks are dropped
+			for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; ++y) {
+				for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; ++x)
+					std::memcpy(pixels + ((size_t(blockY) * 4 + y) * width + blockX * 4 + x) * 4, texels[y * 4 + x], 4);
+			}
+		}
+	}
+}
+
+float BlockCompression::ComputePsnr(const DecodedImage& reference, const CompressedImage& compressed, uint32_t level) {
+	const size_t texelCount = size_t(compressed.GetLevelWidth(level)) * compressed.GetLevelHeight(level);
+	std::vector<uint8_t> decoded(texelCount * 4);
+	Decompress(compressed, level, decoded.data());
+
+	uint32_t channelCount = 4;
+	if (compressed.format == BlockFormat::BC1)
+		channelCount = 3;
+	else if (compressed.format == BlockFormat::BC4)
+		channelCount = 1;
+	else if (compressed.format == BlockFormat::BC5)
+		channelCount = 2;
+
+	const uint8_t* pixels = reference.pixels.get() + reference.GetLevelOffset(level);
+	double squaredError = 0.0;
+	size_t comparedTexels = 0;
+	for (size_t i = 0; i < texelCount; ++i) {
+		// BC1 cuts out the texels below half alpha, their color is gone by design
+		if (compressed.format == BlockFormat::BC1 && pixels[i * 4 + 3] < 128)
+			continue;
+		++comparedTexels;
+		for (uint32_t c = 0; c < channelCount; ++c) {
+			const double difference = double(decoded[i * 4 + c]) - double(pixels[i * 4 + c]);
+			squaredError += difference * difference;
+		}
+	}
+	if (squaredError == 0.0)
+		return std::numeric_limits<float>::infinity();
+	const double meanSquaredError = squaredError / (double(comparedTexels) * channelCount);
+	return static_cast<float>(10.0 * std::log10(255.0 * 255.0 / meanSquaredError));
+}
+
+const char* BlockCompression::GetFormatName(BlockFormat format) {
+	switch (format) {
+	case BlockFormat::BC1:
+		return "BC1";
+	case BlockFormat::BC3:
+		return "BC3";
+	case BlockFormat::BC4:
+		return "BC4";
+	case BlockFormat::BC5:
+		return "BC5";
+	case BlockFormat::BC7:
+		return "BC7";
+	case BlockFormat::RGBA8:
+		return "RGBA8";
+	}
+	return "Unknown";
+}
+
+void BlockCompression::Benchmark(ThreadPool& threadPool) {
+	using Clock = std::chrono::high_resolution_clock;
+	auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); };
+
+	// Smooth gradients, hard edges and noise: the cases the endpoint fits and the index selection have to handle
+	constexpr uint32_t SIZE = 1024;
+	DecodedImage image;
+	image.width = SIZE;
+	image.height = SIZE;
+	image.sourceChannels = 4;
+	image.pixels.reset(static_cast<uint8_t*>(StagingMemory::Allocate(image.GetSize())));
+	std::mt19937 random(7);
+	for (uint32_t y = 0; y < SIZE; ++y) {
+		for (uint32_t x = 0; x < SIZE; ++x) {
+			uint8_t* texel = image.pixels.get() + (size_t(y) * SIZE + x) * 4;
+			const bool edge = ((x / 37) + (y / 23)) & 1;
+			texel[0] = static_cast<uint8_t>(x * 255 / SIZE);
+			texel[1] = static_cast<uint8_t>(edge ? 220 - y * 128 / SIZE : 30 + (random() & 31));
+			texel[2] = static_cast<uint8_t>((x + y) * 255 / (2 * SIZE));
+			texel[3] = static_cast<uint8_t>(y * 255 / SIZE);
+		}
+	}
+
+	const float megaTexels = SIZE * SIZE / 1e6f;
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Block compression benchmark, ", SIZE, "x", SIZE, " on ", threadPool.GetThreadCount() + 1, " threads:");
+	static const char* QUALITY_NAMES[] = { "fast", "normal", "high" };
+	for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 }) {
+		for (CompressionQuality quality : { CompressionQuality::Fast, CompressionQuality::Normal, CompressionQuality::High }) {
+			CompressionSettings settings;
+			settings.format = format;
+			settings.quality = quality;
+			CompressedImage compressed;
+			auto start = Clock::now();
+			if (!Compress(image, settings, compressed, &threadPool))
+				return;
+			float ms = elapsedMs(start);
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "  ", GetFormatName(format), " ", QUALITY_NAMES[static_cast<uint32_t>(quality)], ": ", ms, " ms (",
+				megaTexels / (ms / 1000.0f), " MTexels/s), PSNR ", ComputePsnr(image, compressed), " dB");
+		}
+	}
+
+	CompressionSettings settings;
+	CompressedImage compressed;
+	auto start = Clock::now();
+	Compress(image, settings, compressed);
+	float singleMs = elapsedMs(start);
+	start = Clock::now();
+	Compress(image, settings, compressed, &threadPool);
+	float poolMs = elapsedMs(start);
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "  BC7 normal on one thread: ", singleMs, " ms, on the pool: ", poolMs, " ms (speedup ", singleMs / std::max(poolMs, 1e-6f), "x)");
+}
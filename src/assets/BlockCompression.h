@@ -0,0 +1,102 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "../utils/StagingMemory.h"
+
+class ThreadPool;
+struct DecodedImage;
+
+
+// Block compressed formats, each block covers 4x4 texels, plus the uncompressed fallback
+enum class BlockFormat : uint8_t {
+	BC1,   // RGB with 1-bit alpha (texels below 128 become transparent), 8 bytes per block
+	BC3,   // RGB + smooth alpha, 16 bytes
+	BC4,   // Single channel (red), for roughness, occlusion or height maps, 8 bytes
+	BC5,   // Two channels (red, green), for tangent space normal maps, 16 bytes
+	BC7,   // High quality RGBA, mode 6 (one subset, 4-bit indices), 16 bytes
+	RGBA8  // Uncompressed, one texel per "block" of 4 bytes, for the images BCn can't hold
+};
+
+enum class CompressionQuality : uint8_t {
+	Fast,    // Principal axis endpoints, one index selection
+	Normal,  // Plus least squares refinement of the endpoints
+	High     // Plus a local search around the endpoints, every BC4 mode and every BC7 p-bit combination
+};
+
+struct CompressionSettings {
+	BlockFormat format = BlockFormat::BC7;
+	CompressionQuality quality = CompressionQuality::Normal;
+	// Color formats (BC1, BC3, BC7) are created as their sRGB variant. Blocks are fitted on the stored values
+	// either way, the GPU interpolates them before the conversion to linear.
+	bool sRGB = true;
+};
+
+// Compressed mip chain, ready for CreateTexture2D: every level is rows of blocks, largest level first
+struct CompressedImage {
+	uint32_t id = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t levelCount = 1;
+	BlockFormat format = BlockFormat::BC1;
+	bool sRGB = false;
+	StagingMemory::Buffer data;
+
+	bool IsValid() const { return data != nullptr; }
+	uint32_t GetLevelWidth(uint32_t level) const { return std::max(width >> level, 1u); }
+	uint32_t GetLevelHeight(uint32_t level) const { return std::max(height >> level, 1u); }
+	bool IsBlockCompressed() const { return format != BlockFormat::RGBA8; }
+	// Texels per side of a block
+	uint32_t GetBlockDimension() const { return IsBlockCompressed() ? 4 : 1; }
+	uint32_t GetBlockCountX(uint32_t level) const { return (GetLevelWidth(level) + GetBlockDimension() - 1) / GetBlockDimension(); }
+	uint32_t GetBlockCountY(uint32_t level) const { return (GetLevelHeight(level) + GetBlockDimension() - 1) / GetBlockDimension(); }
+	uint32_t GetBlockSize() const {
+		if (!IsBlockCompressed())
+			return 4;
+		return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+	}
+	// Bytes per row of blocks, the SysMemPitch of the level
+	uint32_t GetRowPitch(uint32_t level) const { return GetBlockCountX(level) * GetBlockSize(); }
+	size_t GetLevelSize(uint32_t level) const { return size_t(GetRowPitch(level)) * GetBlockCountY(level); }
+	size_t GetLevelOffset(uint32_t level) const {
+		size_t offset = 0;
+		for (uint32_t i = 0; i < level; ++i)
+			offset += GetLevelSize(i);
+		return offset;
+	}
+	size_t GetSize() const { return GetLevelOffset(levelCount); }
+};
+
+// CPU encoder of the BCn formats, for the cooker.
+//
+// A block is loaded as 16 float texels per channel, partial blocks at the edges repeat their last row and
+// column. Endpoints start on the principal axis of the texels (power iteration on the covariance), then the
+// quality level refines them; index selection compares every texel with every palette entry, four texels
+// per SSE register. Blocks are independent, rows of blocks are split over the pool workers.
+namespace BlockCompression {
+	// Compresses every level of an RGBA8 image. D3D11 only creates BCn textures whose top level is a whole
+	// number of blocks, images whose width or height isn't a multiple of 4 (the 1x1 placeholders among them)
+	// are stored as RGBA8 instead, with the sRGB flag of the settings. Logs and returns false on failure.
+	bool Compress(const DecodedImage& image, const CompressionSettings& settings, CompressedImage& compressed, ThreadPool* threadPool = nullptr);
+
+	// Decodes a level to RGBA8 (`width * height * 4` bytes), the channels a format doesn't have are 0, alpha 255.
+	// RGBA8 levels are copied.
+	// BC7 blocks other than mode 6, which the encoder doesn't write, decode to magenta.
+	void Decompress(const CompressedImage& compressed, uint32_t level, uint8_t* pixels);
+
+	// Peak signal to noise ratio of a level against the image it was compressed from, in dB, over the channels
+	// the format stores (RGB for BC1, RGBA for BC3 and BC7, R for BC4, RG for BC5). Infinite if lossless.
+	// BC1 skips the texels cut out by the reference alpha.
+	float ComputePsnr(const DecodedImage& reference, const CompressedImage& compressed, uint32_t level = 0);
+
+	const char* GetFormatName(BlockFormat format);
+
+	// Compresses a synthetic 1024x1024 image in every format and quality on the pool, then logs the
+	// throughputs and PSNRs, plus the scaling of BC7 from one thread to the pool
+	void Benchmark(ThreadPool& threadPool);
+}
+
+#endif // !BLOCK_COMPRESSION_H
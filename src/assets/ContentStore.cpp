@@ -0,0 +1,68 @@
+#include "ContentStore.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "../utils/ConsoleLogger.h"
+
+
+bool ContentStore::Create() const {
+	std::error_code error;
+	std::filesystem::create_directories(m_rootDirectory, error);
+	if (error) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to create the content store ", m_rootDirectory, ": ", error.message());
+		return false;
+	}
+	return true;
+}
+
+std::string ContentStore::GetPath(const Hash128& key, const std::string& extension) const {
+	return (std::filesystem::path(m_rootDirectory) / (Hash::ToString(key) + extension)).generic_string();
+}
+
+bool ContentStore::GetKey(const std::string& filePath, Hash128& key) {
+	return Hash::FromString(std::filesystem::path(filePath).stem().string(), key);
+}
+
+bool ContentStore::WriteIndex(const std::string& filePath, const std::vector<std::optional<Hash128>>& imageKeys) {
+	// Written next to the destination and renamed once complete, like the cooked files
+	std::string temporaryPath = filePath + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::trunc);
+		for (const std::optional<Hash128>& imageKey : imageKeys)
+			file << (imageKey.has_value() ? Hash::ToString(*imageKey) : std::string()) << "\n";
+		if (!file) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the texture index ", temporaryPath, ".");
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, filePath, error);
+	if (error) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the texture index ", filePath, ": ", error.message());
+		return false;
+	}
+	return true;
+}
+
+bool ContentStore::ReadIndex(const std::string& filePath, std::vector<std::optional<Hash128>>& imageKeys) {
+	std::ifstream file(filePath);
+	if (!file) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to open the texture index ", filePath, ".");
+		return false;
+	}
+	imageKeys.clear();
+	std::string line;
+	while (std::getline(file, line)) {
+		std::optional<Hash128>& imageKey = imageKeys.emplace_back();
+		if (line.empty())
+			continue;
+		if (!Hash::FromString(line, imageKey.emplace())) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid texture index ", filePath, ": line ", imageKeys.size(), " isn't a key.");
+			imageKeys.clear();
+			return false;
+		}
+	}
+	return true;
+}
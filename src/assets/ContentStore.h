@@ -0,0 +1,42 @@
+#ifndef CONTENT_STORE_H
+#define CONTENT_STORE_H
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../utils/Hash.h"
+
+
+// Local store of cooked outputs, each named after the 128-bit key of what it's cooked from (content of the
+// source, settings, format versions): <root>/<32 hex digits><extension>.
+//
+// A key always names the same content, so an output shared by several scenes (the same image in several
+// models) is cooked and stored once, and the engine loads it once: the asset registry reads the key back
+// from the file name. A store file that exists is up to date, it's never written twice.
+//
+// The outputs of a scene are found through its index, written by the cooker next to the cooked mesh
+// (<scene.pmesh>.textures): one line per glTF image, the key of its cooked texture, or an empty line if it
+// has none. Keys don't depend on where the store is, the engine resolves them against its own root.
+class ContentStore {
+	public:
+		explicit ContentStore(const std::string& rootDirectory) : m_rootDirectory(rootDirectory) {}
+
+		// Creates the root folder. Logs and returns false on failure.
+		bool Create() const;
+		std::string GetPath(const Hash128& key, const std::string& extension) const;
+		const std::string& GetRootDirectory() const { return m_rootDirectory; }
+
+		// Key of a store file from its name, false if the name isn't a key
+		static bool GetKey(const std::string& filePath, Hash128& key);
+
+		static std::string GetIndexPath(const std::string& cookedMeshPath) { return cookedMeshPath + ".textures"; }
+		// Log and return false on failure
+		static bool WriteIndex(const std::string& filePath, const std::vector<std::optional<Hash128>>& imageKeys);
+		static bool ReadIndex(const std::string& filePath, std::vector<std::optional<Hash128>>& imageKeys);
+
+	private:
+		std::string m_rootDirectory;
+};
+
+#endif // !CONTENT_STORE_H
@@ -0,0 +1,342 @@
+#include "CookedMesh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "../utils/ConsoleLogger.h"
+
+
+using namespace DirectX;
+
+namespace {
+	constexpr size_t SECTION_COUNT = static_cast<size_t>(CookedMeshSectionType::Count);
+
+	// Size of the elements of every section, in CookedMeshSectionType order
+	constexpr uint32_t SECTION_ELEMENT_SIZES[SECTION_COUNT] = {
+		sizeof(CookedMeshRecord),
+		sizeof(CookedMeshPartRecord),
+		sizeof(CookedMeshBounds),
+		sizeof(char),
+		sizeof(SimpleVertexData),
+		sizeof(CompleteAttributeData),
+		sizeof(uint16_t),
+		sizeof(MeshLod),
+		sizeof(Meshlet),
+		sizeof(MeshletBounds),
+		sizeof(uint32_t),
+		sizeof(uint8_t)
+	};
+
+	uint64_t AlignSection(uint64_t offset) {
+		return (offset + COOKED_MESH_SECTION_ALIGNMENT - 1) & ~static_cast<uint64_t>(COOKED_MESH_SECTION_ALIGNMENT - 1);
+	}
+
+	// Appends `source` to `destination` and returns the index of its first element
+	template <typename T>
+	size_t Append(std::vector<T>& destination, const std::vector<T>& source) {
+		size_t first = destination.size();
+		destination.insert(destination.end(), source.begin(), source.end());
+		return first;
+	}
+
+	bool IsRangeValid(uint64_t first, uint64_t count, size_t total) {
+		return first <= total && count <= total - first;
+	}
+}
+
+bool CookedMeshFile::Write(const std::string& filePath, const std::vector<CookedMeshSource>& meshes) {
+	std::vector<CookedMeshRecord> meshRecords;
+	std::vector<CookedMeshPartRecord> partRecords;
+	std::vector<CookedMeshBounds> bounds;
+	std::string names;
+	std::vector<SimpleVertexData> positions;
+	std::vector<CompleteAttributeData> attributes;
+	std::vector<uint16_t> indices;
+	std::vector<MeshLod> lods;
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshletBounds> meshletBounds;
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint8_t> meshletTriangles;
+
+	for (const CookedMeshSource& mesh : meshes) {
+		CookedMeshRecord& meshRecord = meshRecords.emplace_back();
+		meshRecord.nameOffset = static_cast<uint32_t>(names.size());
+		meshRecord.nameLength = static_cast<uint32_t>(mesh.name.size());
+		meshRecord.material = mesh.material;
+		meshRecord.firstPart = static_cast<uint32_t>(partRecords.size());
+		meshRecord.partCount = static_cast<uint32_t>(mesh.parts.size());
+		names += mesh.name;
+
+		XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+		for (const MeshPartData& part : mesh.parts) {
+			CookedMeshPartRecord& partRecord = partRecords.emplace_back();
+			partRecord.firstVertex = static_cast<uint32_t>(Append(positions, part.positions));
+			partRecord.vertexCount = static_cast<uint32_t>(part.positions.size());
+			Append(attributes, part.attributes);
+			partRecord.firstIndex = static_cast<uint32_t>(Append(indices, part.indices));
+			partRecord.indexCount = static_cast<uint32_t>(part.indices.size());
+			partRecord.firstLod = static_cast<uint32_t>(Append(lods, part.lods));
+			partRecord.lodCount = static_cast<uint32_t>(part.lods.size());
+			partRecord.firstMeshlet = static_cast<uint32_t>(Append(meshlets, part.meshletData.meshlets));
+			partRecord.meshletCount = static_cast<uint32_t>(part.meshletData.meshlets.size());
+			Append(meshletBounds, part.meshletData.bounds);
+			partRecord.firstMeshletVertex = static_cast<uint32_t>(Append(meshletVertices, part.meshletData.vertices));
+			partRecord.meshletVertexCount = static_cast<uint32_t>(part.meshletData.vertices.size());
+			partRecord.firstMeshletTriangle = static_cast<uint32_t>(Append(meshletTriangles, part.meshletData.triangles));
+			partRecord.meshletTriangleCount = static_cast<uint32_t>(part.meshletData.triangles.size());
+			partRecord.uvDensity = part.uvDensity;
+
+			for (const SimpleVertexData& vertex : part.positions) {
+				XMVECTOR position = XMLoadFloat3(&vertex.vPosition);
+				minimum = XMVectorMin(minimum, position);
+				maximum = XMVectorMax(maximum, position);
+			}
+		}
+
+		CookedMeshBounds& meshBounds = bounds.emplace_back();
+		if (XMVector3LessOrEqual(minimum, maximum)) {
+			XMVECTOR extents = XMVectorScale(XMVectorSubtract(maximum, minimum), 0.5f);
+			XMStoreFloat3(&meshBounds.center, XMVectorAdd(minimum, extents));
+			XMStoreFloat3(&meshBounds.extents, extents);
+			meshBounds.radius = XMVectorGetX(XMVector3Length(extents));
+		}
+		else {
+			meshBounds = CookedMeshBounds();
+		}
+	}
+
+	// Element indices are stored on 32 bits
+	if (positions.size() > UINT32_MAX || indices.size() > UINT32_MAX || meshletTriangles.size() > UINT32_MAX || names.size() > UINT32_MAX) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the cooked mesh file ", filePath, ": the meshes are too big.");
+		return false;
+	}
+
+	struct SectionData {
+		const void* data;
+		size_t size;
+	};
+	const SectionData sectionData[SECTION_COUNT] = {
+		{ meshRecords.data(), meshRecords.size() * sizeof(CookedMeshRecord) },
+		{ partRecords.data(), partRecords.size() * sizeof(CookedMeshPartRecord) },
+		{ bounds.data(), bounds.size() * sizeof(CookedMeshBounds) },
+		{ names.data(), names.size() },
+		{ positions.data(), positions.size() * sizeof(SimpleVertexData) },
+		{ attributes.data(), attributes.size() * sizeof(CompleteAttributeData) },
+		{ indices.data(), indices.size() * sizeof(uint16_t) },
+		{ lods.data(), lods.size() * sizeof(MeshLod) },
+		{ meshlets.data(), meshlets.size() * sizeof(Meshlet) },
+		{ meshletBounds.data(), meshletBounds.size() * sizeof(MeshletBounds) },
+		{ meshletVertices.data(), meshletVertices.size() * sizeof(uint32_t) },
+		{ meshletTriangles.data(), meshletTriangles.size() }
+	};
+
+	CookedMeshSection sections[SECTION_COUNT];
+	uint64_t offset = AlignSection(sizeof(CookedMeshHeader) + sizeof(sections));
+	for (size_t i = 0; i < SECTION_COUNT; ++i) {
+		sections[i].type = static_cast<uint32_t>(i);
+		sections[i].elementSize = SECTION_ELEMENT_SIZES[i];
+		sections[i].offset = offset;
+		sections[i].size = sectionData[i].size;
+		offset = AlignSection(offset + sectionData[i].size);
+	}
+
+	CookedMeshHeader header = {};
+	header.magic = COOKED_MESH_MAGIC;
+	header.version = COOKED_MESH_VERSION;
+	header.fileSize = offset;
+	header.sectionCount = static_cast<uint32_t>(SECTION_COUNT);
+	header.meshCount = static_cast<uint32_t>(meshRecords.size());
+	header.partCount = static_cast<uint32_t>(partRecords.size());
+
+	// Written next to the destination and renamed once complete, so an interrupted cook never leaves a truncated file
+	std::string temporaryPath = filePath + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(sections), sizeof(sections));
+		const char padding[COOKED_MESH_SECTION_ALIGNMENT] = {};
+		uint64_t position = sizeof(header) + sizeof(sections);
+		for (size_t i = 0; i < SECTION_COUNT; ++i) {
+			file.write(padding, static_cast<std::streamsize>(sections[i].offset - position));
+			file.write(static_cast<const char*>(sectionData[i].data), static_cast<std::streamsize>(sectionData[i].size));
+			position = sections[i].offset + sections[i].size;
+		}
+		file.write(padding, static_cast<std::streamsize>(header.fileSize - position));
+		if (!file) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the cooked mesh file ", temporaryPath, ".");
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, filePath, error);
+	if (error) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the cooked mesh file ", filePath, ": ", error.message());
+		return false;
+	}
+	return true;
+}
+
+bool CookedMeshFile::Load(const std::string& filePath) {
+	Close();
+	m_filePath = filePath;
+	if (!m_file.Open(filePath))
+		return false;
+
+	const uint8_t* data = m_file.GetData();
+	const size_t size = m_file.GetSize();
+	CookedMeshHeader header;
+	if (size < sizeof(header))
+		return Fail("the file is truncated");
+	std::memcpy(&header, data, sizeof(header));
+	if (header.magic != COOKED_MESH_MAGIC)
+		return Fail("it isn't a cooked mesh");
+	if (header.version != COOKED_MESH_VERSION)
+		return Fail("it was cooked for another version of the format and must be cooked again");
+	if (header.fileSize != size)
+		return Fail("the file is truncated");
+	if (header.sectionCount != SECTION_COUNT || sizeof(header) + SECTION_COUNT * sizeof(CookedMeshSection) > size)
+		return Fail("the section table is invalid");
+
+	// Offsets to pointers: the mapping is page aligned, so 16 byte aligned offsets give aligned arrays
+	const uint8_t* sectionData[SECTION_COUNT];
+	size_t sectionCounts[SECTION_COUNT];
+	for (size_t i = 0; i < SECTION_COUNT; ++i) {
+		CookedMeshSection section;
+		std::memcpy(&section, data + sizeof(header) + i * sizeof(section), sizeof(section));
+		bool valid = section.type == i && section.elementSize == SECTION_ELEMENT_SIZES[i] &&
+			section.offset % COOKED_MESH_SECTION_ALIGNMENT == 0 && IsRangeValid(section.offset, section.size, size) &&
+			section.size % section.elementSize == 0;
+		if (!valid)
+			return Fail("a section is invalid");
+		sectionData[i] = data + section.offset;
+		sectionCounts[i] = static_cast<size_t>(section.size / section.elementSize);
+	}
+
+	auto getSection = [&sectionData](CookedMeshSectionType type) { return sectionData[static_cast<size_t>(type)]; };
+	auto getCount = [&sectionCounts](CookedMeshSectionType type) { return sectionCounts[static_cast<size_t>(type)]; };
+	if (getCount(CookedMeshSectionType::Meshes) != header.meshCount || getCount(CookedMeshSectionType::Bounds) != header.meshCount ||
+		getCount(CookedMeshSectionType::Parts) != header.partCount ||
+		getCount(CookedMeshSectionType::Positions) != getCount(CookedMeshSectionType::Attributes) ||
+		getCount(CookedMeshSectionType::Meshlets) != getCount(CookedMeshSectionType::MeshletBounds)) {
+		return Fail("the section sizes don't match");
+	}
+
+	const auto* meshRecords = reinterpret_cast<const CookedMeshRecord*>(getSection(CookedMeshSectionType::Meshes));
+	const auto* partRecords = reinterpret_cast<const CookedMeshPartRecord*>(getSection(CookedMeshSectionType::Parts));
+	const auto* bounds = reinterpret_cast<const CookedMeshBounds*>(getSection(CookedMeshSectionType::Bounds));
+	const auto* names = reinterpret_cast<const char*>(getSection(CookedMeshSectionType::Names));
+	const auto* positions = reinterpret_cast<const SimpleVertexData*>(getSection(CookedMeshSectionType::Positions));
+	const auto* attributes = reinterpret_cast<const CompleteAttributeData*>(getSection(CookedMeshSectionType::Attributes));
+	const auto* indices = reinterpret_cast<const uint16_t*>(getSection(CookedMeshSectionType::Indices));
+	const auto* lods = reinterpret_cast<const MeshLod*>(getSection(CookedMeshSectionType::Lods));
+	const auto* meshlets = reinterpret_cast<const Meshlet*>(getSection(CookedMeshSectionType::Meshlets));
+	const auto* meshletBounds = reinterpret_cast<const MeshletBounds*>(getSection(CookedMeshSectionType::MeshletBounds));
+	const auto* meshletVertices = reinterpret_cast<const uint32_t*>(getSection(CookedMeshSectionType::MeshletVertices));
+	const auto* meshletTriangles = getSection(CookedMeshSectionType::MeshletTriangles);
+
+	m_parts.resize(header.partCount);
+	for (size_t i = 0; i < header.partCount; ++i) {
+		const CookedMeshPartRecord& record = partRecords[i];
+		bool valid = IsRangeValid(record.firstVertex, record.vertexCount, getCount(CookedMeshSectionType::Positions)) &&
+			IsRangeValid(record.firstIndex, record.indexCount, getCount(CookedMeshSectionType::Indices)) &&
+			IsRangeValid(record.firstLod, record.lodCount, getCount(CookedMeshSectionType::Lods)) &&
+			IsRangeValid(record.firstMeshlet, record.meshletCount, getCount(CookedMeshSectionType::Meshlets)) &&
+			IsRangeValid(record.firstMeshletVertex, record.meshletVertexCount, getCount(CookedMeshSectionType::MeshletVertices)) &&
+			IsRangeValid(record.firstMeshletTriangle, record.meshletTriangleCount, getCount(CookedMeshSectionType::MeshletTriangles));
+		if (!valid)
+			return Fail("a part references data outside of the sections");
+		if (!std::isfinite(record.uvDensity) || record.uvDensity < 0.0f)
+			return Fail("a part has an invalid UV density");
+		// Levels index into the indices of their part, a draw of one must stay inside them
+		for (uint32_t lod = 0; lod < record.lodCount; ++lod) {
+			if (!IsRangeValid(lods[record.firstLod + lod].indexOffset, lods[record.firstLod + lod].indexCount, record.indexCount))
+				return Fail("a level of detail references indices outside of its part");
+		}
+
+		MeshPartView& part = m_parts[i];
+		part.positions = positions + record.firstVertex;
+		part.attributes = attributes + record.firstVertex;
+		part.vertexCount = record.vertexCount;
+		part.indices = indices + record.firstIndex;
+		part.indexCount = record.indexCount;
+		part.lods = lods + record.firstLod;
+		part.lodCount = record.lodCount;
+		part.meshlets = meshlets + record.firstMeshlet;
+		part.meshletBounds = meshletBounds + record.firstMeshlet;
+		part.meshletCount = record.meshletCount;
+		part.meshletVertices = meshletVertices + record.firstMeshletVertex;
+		part.meshletVertexCount = record.meshletVertexCount;
+		part.meshletTriangles = meshletTriangles + record.firstMeshletTriangle;
+		part.meshletTriangleCount = record.meshletTriangleCount;
+		part.uvDensity = record.uvDensity;
+	}
+
+	m_meshes.resize(header.meshCount);
+	for (size_t i = 0; i < header.meshCount; ++i) {
+		const CookedMeshRecord& record = meshRecords[i];
+		if (!IsRangeValid(record.nameOffset, record.nameLength, getCount(CookedMeshSectionType::Names)) ||
+			!IsRangeValid(record.firstPart, record.partCount, header.partCount)) {
+			return Fail("a mesh references data outside of the sections");
+		}
+
+		CookedMeshView& mesh = m_meshes[i];
+		mesh.name = std::string_view(names + record.nameOffset, record.nameLength);
+		mesh.material = record.material;
+		mesh.bounds = &bounds[i];
+		mesh.parts = m_parts.data() + record.firstPart;
+		mesh.partCount = record.partCount;
+	}
+	return true;
+}
+
+void CookedMeshFile::Benchmark(const std::string& filePath) {
+	using Clock = std::chrono::high_resolution_clock;
+	auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); };
+
+	auto start = Clock::now();
+	CookedMeshFile file;
+	if (!file.Load(filePath)) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Cooked mesh benchmark of ", filePath, " aborted: the file failed to load.");
+		return;
+	}
+	float loadMs = elapsedMs(start);
+
+	// One read per page brings the whole file in, like the upload would
+	start = Clock::now();
+	const volatile uint8_t* data = file.m_file.GetData();
+	uint32_t checksum = 0;
+	for (size_t offset = 0; offset < file.GetFileSize(); offset += 4096)
+		checksum += data[offset];
+	float readMs = elapsedMs(start);
+
+	size_t partCount = 0;
+	size_t vertexCount = 0;
+	for (const CookedMeshView& mesh : file.GetMeshes()) {
+		partCount += mesh.partCount;
+		for (uint32_t i = 0; i < mesh.partCount; ++i)
+			vertexCount += mesh.parts[i].vertexCount;
+	}
+	float sizeMb = file.GetFileSize() / 1048576.0f;
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Cooked mesh benchmark of ", filePath, ": ", file.GetMeshCount(), " meshes, ", partCount,
+		" parts, ", vertexCount, " vertices, ", sizeMb, " MB. Load (mapping + fixups): ", loadMs, " ms, reading the data: ", readMs, " ms (",
+		sizeMb / std::max(readMs / 1000.0f, 1e-6f), " MB/s, checksum ", checksum, ").");
+}
+
+void CookedMeshFile::Close() {
+	m_meshes.clear();
+	m_parts.clear();
+	m_file.Close();
+}
+
+bool CookedMeshFile::Fail(const char* reason) {
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid cooked mesh file ", m_filePath, ": ", reason, ".");
+	Close();
+	return false;
+}
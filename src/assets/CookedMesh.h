@@ -0,0 +1,149 @@
+#ifndef COOKED_MESH_H
+#define COOKED_MESH_H
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../geometry/MeshParts.h"
+#include "../utils/MappedFile.h"
+
+
+// Engine native mesh file (.pmesh), written by the asset cooker (Penumbra-Cooker) and loaded in place.
+//
+// Layout, little endian:
+// - CookedMeshHeader
+// - CookedMeshSection table, one entry per CookedMeshSectionType
+// - The sections, each starting on a 16 byte boundary
+// Sections are arrays of the engine structs exactly as the GeometryPool and the culling read them:
+// position and attribute streams, 16-bit indices, levels of detail, meshlets and their bounds. Section
+// offsets are relative to the start of the file and the records reference elements of the sections by
+// index, so a file is position independent. Loading maps it, validates the tables and turns the
+// offsets into pointers; no element is parsed, converted or copied before the upload.
+
+constexpr uint32_t COOKED_MESH_MAGIC = 0x48534D50;  // "PMSH"
+// Bumped on any change of the layout or of the structs stored in the sections
+constexpr uint32_t COOKED_MESH_VERSION = 2;
+constexpr size_t COOKED_MESH_SECTION_ALIGNMENT = 16;
+
+enum class CookedMeshSectionType : uint32_t {
+	Meshes,            // CookedMeshRecord
+	Parts,             // CookedMeshPartRecord
+	Bounds,            // CookedMeshBounds, one per mesh
+	Names,             // Mesh names, not null terminated
+	Positions,         // SimpleVertexData
+	Attributes,        // CompleteAttributeData
+	Indices,           // uint16_t
+	Lods,              // MeshLod
+	Meshlets,          // Meshlet
+	MeshletBounds,     // MeshletBounds
+	MeshletVertices,   // uint32_t
+	MeshletTriangles,  // uint8_t
+	Count
+};
+
+struct CookedMeshHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t fileSize;
+	uint32_t sectionCount;
+	uint32_t meshCount;
+	uint32_t partCount;
+	uint32_t reserved;
+};
+
+struct CookedMeshSection {
+	uint32_t type;         // CookedMeshSectionType
+	uint32_t elementSize;  // Checked against the engine struct at load time
+	uint64_t offset;
+	uint64_t size;
+};
+
+struct CookedMeshRecord {
+	uint32_t nameOffset;  // Bytes into the Names section
+	uint32_t nameLength;
+	uint32_t material;    // glTF material index, UINT32_MAX if none
+	uint32_t firstPart;
+	uint32_t partCount;
+};
+
+// Ranges of the sections used by a part, in elements
+struct CookedMeshPartRecord {
+	uint32_t firstVertex;  // Positions and Attributes
+	uint32_t vertexCount;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t firstLod;
+	uint32_t lodCount;
+	uint32_t firstMeshlet;  // Meshlets and MeshletBounds
+	uint32_t meshletCount;
+	uint32_t firstMeshletVertex;
+	uint32_t meshletVertexCount;
+	uint32_t firstMeshletTriangle;
+	uint32_t meshletTriangleCount;
+	float uvDensity;  // UV units per world unit, for the texture streaming (see MeshParts::ComputeUvDensity)
+};
+
+// Bounds of a whole mesh in its vertex space, the sphere encloses the box
+struct CookedMeshBounds {
+	DirectX::XMFLOAT3 center;
+	float radius;
+	DirectX::XMFLOAT3 extents;
+	float padding;
+};
+
+// A mesh to write, with its parts built by MeshParts::BuildParts
+struct CookedMeshSource {
+	std::string name;
+	uint32_t material = UINT32_MAX;
+	std::vector<MeshPartData> parts;
+};
+
+// A mesh of a loaded file, pointing into the mapping
+struct CookedMeshView {
+	std::string_view name;
+	uint32_t material = UINT32_MAX;
+	const CookedMeshBounds* bounds = nullptr;
+	const MeshPartView* parts = nullptr;  // Ready for Mesh::InitializeParts
+	uint32_t partCount = 0;
+};
+
+// Mapping of a .pmesh file, the views stay valid until the file is closed or destroyed
+class CookedMeshFile {
+	public:
+		CookedMeshFile() = default;
+		CookedMeshFile(const CookedMeshFile&) = delete;
+		CookedMeshFile& operator=(const CookedMeshFile&) = delete;
+
+		// Writes the meshes in the cooked format. Logs and returns false on failure.
+		static bool Write(const std::string& filePath, const std::vector<CookedMeshSource>& meshes);
+
+		// Maps a file and checks that every table and range is within its sections. The elements themselves
+		// aren't validated: the vertex and index data goes to the GPU, which bounds checks its reads.
+		// Logs and returns false on failure.
+		bool Load(const std::string& filePath);
+		void Close();
+
+		size_t GetMeshCount() const { return m_meshes.size(); }
+		const CookedMeshView& GetMesh(size_t index) const { return m_meshes[index]; }
+		const std::vector<CookedMeshView>& GetMeshes() const { return m_meshes; }
+		size_t GetFileSize() const { return m_file.GetSize(); }
+
+		// Times the load of a cooked file (mapping, validation, pointer fixups) and the reads of its data
+		// from disk, then logs them, to compare with GltfImporter::Benchmark
+		static void Benchmark(const std::string& filePath);
+
+	private:
+		bool Fail(const char* reason);
+
+	private:
+		std::string m_filePath;
+		MappedFile m_file;
+		std::vector<CookedMeshView> m_meshes;
+		std::vector<MeshPartView> m_parts;
+};
+
+#endif // !COOKED_MESH_H
@@ -0,0 +1,239 @@
+#include "CookedTexture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "MipGenerator.h"
+#include "../utils/ConsoleLogger.h"
+
+
+namespace {
+	uint64_t AlignLevel(uint64_t offset) {
+		return (offset + COOKED_TEXTURE_LEVEL_ALIGNMENT - 1) & ~static_cast<uint64_t>(COOKED_TEXTURE_LEVEL_ALIGNMENT - 1);
+	}
+
+	// Sizes D3D11 can create, and at most the levels of a full chain
+	bool IsTextureValid(uint32_t width, uint32_t height, uint32_t levelCount, uint32_t layerCount) {
+		return width > 0 && height > 0 && width <= COOKED_TEXTURE_MAX_SIZE && height <= COOKED_TEXTURE_MAX_SIZE && levelCount > 0 &&
+			levelCount <= MipGenerator::GetFullLevelCount(width, height) && layerCount > 0 && layerCount <= COOKED_TEXTURE_MAX_LAYER_COUNT;
+	}
+
+	bool IsRangeValid(uint64_t first, uint64_t count, size_t total) {
+		return first <= total && count <= total - first;
+	}
+
+	// Dimensions and block layout of a texture, the pitches and sizes every level must have
+	CompressedImage GetLayout(const CookedTextureHeader& header) {
+		CompressedImage layout;
+		layout.width = header.width;
+		layout.height = header.height;
+		layout.levelCount = header.levelCount;
+		layout.format = static_cast<BlockFormat>(header.format);
+		return layout;
+	}
+}
+
+bool CookedTextureFile::Write(const std::string& filePath, const CompressedImage* layers, uint32_t layerCount) {
+	bool valid = layerCount > 0;
+	for (uint32_t layer = 0; layer < layerCount && valid; ++layer) {
+		valid = layers[layer].IsValid() && layers[layer].width == layers[0].width && layers[layer].height == layers[0].height &&
+			layers[layer].levelCount == layers[0].levelCount && layers[layer].format == layers[0].format && layers[layer].sRGB == layers[0].sRGB;
+	}
+	if (!valid) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the cooked texture file ", filePath, ": the layers are empty or don't match.");
+		return false;
+	}
+	if (!IsTextureValid(layers[0].width, layers[0].height, layers[0].levelCount, layerCount)) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the cooked texture file ", filePath, ": ", layers[0].width, "x",
+			layers[0].height, " with ", layers[0].levelCount, " levels and ", layerCount, " layers isn't a valid D3D11 texture.");
+		return false;
+	}
+
+	const CompressedImage& first = layers[0];
+	const uint32_t subresourceCount = first.levelCount * layerCount;
+	std::vector<CookedTextureLevel> levels(subresourceCount);
+	uint64_t offset = AlignLevel(sizeof(CookedTextureHeader) + subresourceCount * sizeof(CookedTextureLevel));
+	for (uint32_t layer = 0; layer < layerCount; ++layer) {
+		for (uint32_t level = 0; level < first.levelCount; ++level) {
+			CookedTextureLevel& entry = levels[level + layer * first.levelCount];
+			entry.offset = offset;
+			entry.size = first.GetLevelSize(level);
+			entry.width = first.GetLevelWidth(level);
+			entry.height = first.GetLevelHeight(level);
+			entry.rowPitch = first.GetRowPitch(level);
+			entry.reserved = 0;
+			offset = AlignLevel(offset + entry.size);
+		}
+	}
+
+	CookedTextureHeader header = {};
+	header.magic = COOKED_TEXTURE_MAGIC;
+	header.version = COOKED_TEXTURE_VERSION;
+	header.fileSize = offset;
+	header.width = first.width;
+	header.height = first.height;
+	header.levelCount = first.levelCount;
+	header.layerCount = layerCount;
+	header.format = static_cast<uint32_t>(first.format);
+	header.sRGB = first.sRGB ? 1 : 0;
+
+	// Written next to the destination and renamed once complete, so an interrupted cook never leaves a truncated file
+	std::string temporaryPath = filePath + ".tmp";
+	std::error_code error;
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to create the cooked texture file ", temporaryPath, ".");
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(levels.data()), static_cast<std::streamsize>(levels.size() * sizeof(CookedTextureLevel)));
+		const char padding[COOKED_TEXTURE_LEVEL_ALIGNMENT] = {};
+		uint64_t position = sizeof(header) + levels.size() * sizeof(CookedTextureLevel);
+		for (uint32_t layer = 0; layer < layerCount; ++layer) {
+			for (uint32_t level = 0; level < first.levelCount; ++level) {
+				const CookedTextureLevel& entry = levels[level + layer * first.levelCount];
+				file.write(padding, static_cast<std::streamsize>(entry.offset - position));
+				file.write(reinterpret_cast<const char*>(layers[layer].data.get() + layers[layer].GetLevelOffset(level)), static_cast<std::streamsize>(entry.size));
+				position = entry.offset + entry.size;
+			}
+		}
+		file.write(padding, static_cast<std::streamsize>(header.fileSize - position));
+		file.close();
+		if (!file) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the cooked texture file ", temporaryPath, ".");
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, filePath, error);
+	if (error) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the cooked texture file ", filePath, ": ", error.message());
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
+
+bool CookedTextureFile::Load(const std::string& filePath) {
+	Close();
+	m_filePath = filePath;
+	if (!m_file.Open(filePath))
+		return false;
+
+	const uint8_t* data = m_file.GetData();
+	const size_t size = m_file.GetSize();
+	if (size < sizeof(m_header))
+		return Fail("the file is truncated");
+	std::memcpy(&m_header, data, sizeof(m_header));
+	if (m_header.magic != COOKED_TEXTURE_MAGIC)
+		return Fail("it isn't a cooked texture");
+	if (m_header.version != COOKED_TEXTURE_VERSION)
+		return Fail("it was cooked for another version of the format and must be cooked again");
+	if (m_header.fileSize != size)
+		return Fail("the file is truncated");
+	if (!IsTextureValid(m_header.width, m_header.height, m_header.levelCount, m_header.layerCount) || m_header.format > static_cast<uint32_t>(BlockFormat::RGBA8))
+		return Fail("the header is invalid");
+	const uint64_t subresourceCount = uint64_t(m_header.levelCount) * m_header.layerCount;
+	if (!IsRangeValid(sizeof(m_header), subresourceCount * sizeof(CookedTextureLevel), size))
+		return Fail("the level table is invalid");
+
+	// The mapping is page aligned, so the 16 byte aligned offsets give aligned rows of blocks
+	const CompressedImage layout = GetLayout(m_header);
+	m_levels.resize(static_cast<size_t>(subresourceCount));
+	for (uint32_t subresource = 0; subresource < subresourceCount; ++subresource) {
+		CookedTextureLevel entry;
+		std::memcpy(&entry, data + sizeof(m_header) + subresource * sizeof(entry), sizeof(entry));
+		const uint32_t level = subresource % m_header.levelCount;
+		bool valid = entry.width == layout.GetLevelWidth(level) && entry.height == layout.GetLevelHeight(level) &&
+			entry.rowPitch == layout.GetRowPitch(level) && entry.size == layout.GetLevelSize(level) &&
+			entry.offset % COOKED_TEXTURE_LEVEL_ALIGNMENT == 0 && IsRangeValid(entry.offset, entry.size, size);
+		if (!valid)
+			return Fail("a level is invalid");
+
+		CookedTextureLevelView& view = m_levels[subresource];
+		view.data = data + entry.offset;
+		view.size = static_cast<size_t>(entry.size);
+		view.width = entry.width;
+		view.height = entry.height;
+		view.rowPitch = entry.rowPitch;
+	}
+	return true;
+}
+
+uint32_t CookedTextureFile::GetMaxFirstLevel() const {
+	if (GetFormat() == BlockFormat::RGBA8)
+		return m_header.levelCount - 1;
+	uint32_t level = 0;
+	while (level + 1 < m_header.levelCount && m_levels[level + 1].width % 4 == 0 && m_levels[level + 1].height % 4 == 0)
+		++level;
+	return level;
+}
+
+void CookedTextureFile::Benchmark(const std::string& directory) {
+	using Clock = std::chrono::high_resolution_clock;
+	auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); };
+
+	std::vector<std::string> filePaths;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		if (entry.path().extension() == ".ptex")
+			filePaths.push_back(entry.path().string());
+	}
+	if (filePaths.empty()) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Cooked texture benchmark aborted: ", directory, " has no cooked textures.");
+		return;
+	}
+
+	auto start = Clock::now();
+	std::vector<CookedTextureFile> files(filePaths.size());
+	size_t loadedCount = 0;
+	for (size_t i = 0; i < filePaths.size(); ++i)
+		loadedCount += files[i].Load(filePaths[i]) ? 1 : 0;
+	float loadMs = elapsedMs(start);
+
+	// One read per page brings the blocks in, like CreateTexture2D would
+	start = Clock::now();
+	size_t totalSize = 0;
+	uint32_t checksum = 0;
+	for (const CookedTextureFile& file : files) {
+		const volatile uint8_t* data = file.m_file.GetData();
+		for (size_t offset = 0; file.IsLoaded() && offset < file.GetFileSize(); offset += 4096)
+			checksum += data[offset];
+		totalSize += file.IsLoaded() ? file.GetFileSize() : 0;
+	}
+	float readMs = elapsedMs(start);
+
+	float sizeMb = totalSize / 1048576.0f;
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Cooked texture benchmark of ", directory, ": ", loadedCount, "/", filePaths.size(), " textures, ",
+		sizeMb, " MB. Load (mapping + validation): ", loadMs, " ms, reading the blocks: ", readMs, " ms (",
+		sizeMb / std::max(readMs / 1000.0f, 1e-6f), " MB/s, checksum ", checksum, ").");
+}
+
+void CookedTextureFile::PageIn(uint32_t firstLevel, uint32_t endLevel) const {
+	endLevel = std::min(endLevel, m_header.levelCount);
+	volatile uint8_t sink = 0;
+	for (uint32_t layer = 0; layer < m_header.layerCount; ++layer) {
+		for (uint32_t level = firstLevel; level < endLevel; ++level) {
+			const CookedTextureLevelView& view = GetLevel(level, layer);
+			for (size_t offset = 0; offset < view.size; offset += 4096)
+				sink = sink + view.data[offset];
+		}
+	}
+}
+
+void CookedTextureFile::Close() {
+	m_levels.clear();
+	m_header = {};
+	m_file.Close();
+}
+
+bool CookedTextureFile::Fail(const char* reason) {
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid cooked texture file ", m_filePath, ": ", reason, ".");
+	Close();
+	return false;
+}
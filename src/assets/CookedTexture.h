@@ -0,0 +1,110 @@
+#ifndef COOKED_TEXTURE_H
+#define COOKED_TEXTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
+#include "../utils/MappedFile.h"
+
+
+// Engine native texture file (.ptex), written by the asset cooker (Penumbra-Cooker) and uploaded from its mapping.
+//
+// Layout, little endian:
+// - CookedTextureHeader
+// - CookedTextureLevel table, one entry per subresource in D3D order (every level of layer 0, then layer 1...)
+// - The levels, each starting on a 16 byte boundary, as rows of BCn blocks (see CompressedImage)
+// Level offsets are relative to the start of the file. Loading maps it and validates the tables; the
+// D3D11_SUBRESOURCE_DATA of the texture point straight into the mapping (see Texture::Initialize), so
+// nothing is decoded or copied on the CPU.
+
+constexpr uint32_t COOKED_TEXTURE_MAGIC = 0x58455450;  // "PTEX"
+// Bumped on any change of the layout or of the block formats
+constexpr uint32_t COOKED_TEXTURE_VERSION = 2;
+constexpr size_t COOKED_TEXTURE_LEVEL_ALIGNMENT = 16;
+// D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION and D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION, the cooker doesn't include d3d11.h
+constexpr uint32_t COOKED_TEXTURE_MAX_SIZE = 16384;
+constexpr uint32_t COOKED_TEXTURE_MAX_LAYER_COUNT = 2048;
+
+struct CookedTextureHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t fileSize;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	uint32_t layerCount;
+	uint32_t format;  // BlockFormat
+	uint32_t sRGB;    // 1 if the texture is created with the sRGB variant of its format
+};
+
+struct CookedTextureLevel {
+	uint64_t offset;
+	uint64_t size;
+	uint32_t width;
+	uint32_t height;
+	uint32_t rowPitch;  // Bytes per row of blocks
+	uint32_t reserved;
+};
+
+// A subresource of a loaded file, pointing into the mapping
+struct CookedTextureLevelView {
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t rowPitch = 0;
+};
+
+// Mapping of a .ptex file, the level views stay valid until the file is closed or destroyed
+class CookedTextureFile {
+	public:
+		CookedTextureFile() = default;
+		CookedTextureFile(const CookedTextureFile&) = delete;
+		CookedTextureFile& operator=(const CookedTextureFile&) = delete;
+
+		// Writes the layers of a texture, which must share their size, level count and format and fit in a D3D11
+		// texture. Logs and returns false on failure.
+		static bool Write(const std::string& filePath, const CompressedImage* layers, uint32_t layerCount = 1);
+
+		// Maps a file and checks the header and that every level has the size its format and dimensions give.
+		// Logs and returns false on failure.
+		bool Load(const std::string& filePath);
+		void Close();
+
+		bool IsLoaded() const { return !m_levels.empty(); }
+		uint32_t GetWidth() const { return m_header.width; }
+		uint32_t GetHeight() const { return m_header.height; }
+		uint32_t GetLevelCount() const { return m_header.levelCount; }
+		uint32_t GetLayerCount() const { return m_header.layerCount; }
+		BlockFormat GetFormat() const { return static_cast<BlockFormat>(m_header.format); }
+		bool IsSRGB() const { return m_header.sRGB != 0; }
+		// Subresource `level + layer * levelCount`, the D3D11CalcSubresource order
+		const CookedTextureLevelView& GetLevel(uint32_t level, uint32_t layer = 0) const { return m_levels[level + layer * m_header.levelCount]; }
+		// Deepest level a texture can start at: D3D11 needs the top level of a BCn texture to be a whole number
+		// of blocks, 1000 texels can start at 500 but not at 250. RGBA8 textures can start at any level
+		uint32_t GetMaxFirstLevel() const;
+		const std::vector<CookedTextureLevelView>& GetLevels() const { return m_levels; }
+		const std::string& GetFilePath() const { return m_filePath; }
+		size_t GetFileSize() const { return m_file.GetSize(); }
+		// Reads one byte per page of the levels [firstLevel, endLevel) of every layer, so creating a texture from
+		// them doesn't wait on the disk. Meant for the workers.
+		void PageIn(uint32_t firstLevel = 0, uint32_t endLevel = UINT32_MAX) const;
+
+		// Times the load of every .ptex file of a directory (mapping, validation) and the reads of their blocks
+		// from disk, then logs them, to compare with TextureLoader::Benchmark
+		static void Benchmark(const std::string& directory);
+
+	private:
+		bool Fail(const char* reason);
+
+	private:
+		std::string m_filePath;
+		MappedFile m_file;
+		CookedTextureHeader m_header = {};
+		std::vector<CookedTextureLevelView> m_levels;
+};
+
+#endif // !COOKED_TEXTURE_H
@@ -0,0 +1,826 @@
+#include "GltfAsset.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <filesystem>
+
+#include "Json.h"
+#include "MeshoptDecoder.h"
+#include "../utils/ConsoleLogger.h"
+#include "../utils/ThreadPool.h"
+
+
+using namespace DirectX;
+
+namespace {
+	// Quantized attributes go through ReadFloats, meshopt compressed views are decoded at load time
+	const char* const SUPPORTED_REQUIRED_EXTENSIONS[] = {
+		"KHR_mesh_quantization",
+		"EXT_meshopt_compression"
+	};
+
+	// GLB layout, little endian: a 12 byte header (magic, version, total length), then chunks made of
+	// their length, their type and their data padded to 4 bytes. The JSON chunk comes first, the BIN one second.
+	constexpr uint32_t GLB_MAGIC = 0x46546C67;       // "glTF"
+	constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+	constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;   // "BIN\0"
+	constexpr size_t GLB_HEADER_SIZE = 12;
+	constexpr size_t GLB_CHUNK_HEADER_SIZE = 8;
+
+	uint32_t ReadUInt32(const uint8_t* data) {
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	bool ParseAccessorType(std::string_view type, GltfAccessorType& accessorType) {
+		static const struct {
+			const char* name;
+			GltfAccessorType type;
+		} types[] = {
+			{ "SCALAR", GltfAccessorType::Scalar }, { "VEC2", GltfAccessorType::Vec2 }, { "VEC3", GltfAccessorType::Vec3 },
+			{ "VEC4", GltfAccessorType::Vec4 }, { "MAT2", GltfAccessorType::Mat2 }, { "MAT3", GltfAccessorType::Mat3 },
+			{ "MAT4", GltfAccessorType::Mat4 }
+		};
+		for (const auto& entry : types) {
+			if (type == entry.name) {
+				accessorType = entry.type;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ParseMeshoptMode(std::string_view name, GltfMeshoptMode& mode) {
+		static const struct {
+			const char* name;
+			GltfMeshoptMode mode;
+		} modes[] = {
+			{ "ATTRIBUTES", GltfMeshoptMode::Attributes }, { "TRIANGLES", GltfMeshoptMode::Triangles }, { "INDICES", GltfMeshoptMode::Indices }
+		};
+		for (const auto& entry : modes) {
+			if (name == entry.name) {
+				mode = entry.mode;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ParseMeshoptFilter(std::string_view name, GltfMeshoptFilter& filter) {
+		static const struct {
+			const char* name;
+			GltfMeshoptFilter filter;
+		} filters[] = {
+			{ "NONE", GltfMeshoptFilter::None }, { "OCTAHEDRAL", GltfMeshoptFilter::Octahedral },
+			{ "QUATERNION", GltfMeshoptFilter::Quaternion }, { "EXPONENTIAL", GltfMeshoptFilter::Exponential }
+		};
+		for (const auto& entry : filters) {
+			if (name == entry.name) {
+				filter = entry.filter;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Strides the codecs and filters accept, the rest of the data is checked while decoding
+	bool IsValidMeshoptLayout(const GltfCompressedBufferView& view) {
+		if (view.mode != GltfMeshoptMode::Attributes) {
+			bool validIndices = view.byteStride == 2 || view.byteStride == 4;
+			return validIndices && view.filter == GltfMeshoptFilter::None && (view.mode != GltfMeshoptMode::Triangles || view.count % 3 == 0);
+		}
+		if (view.byteStride == 0 || view.byteStride > 256 || view.byteStride % 4 != 0)
+			return false;
+		switch (view.filter) {
+		case GltfMeshoptFilter::Octahedral:
+			return view.byteStride == 4 || view.byteStride == 8;
+		case GltfMeshoptFilter::Quaternion:
+			return view.byteStride == 8;
+		default:
+			return true;
+		}
+	}
+
+	bool DecodeMeshoptView(const GltfCompressedBufferView& view, const uint8_t* source, uint8_t* destination) {
+		switch (view.mode) {
+		case GltfMeshoptMode::Triangles:
+			return MeshoptDecoder::DecodeIndexBuffer(destination, view.count, view.byteStride, source, view.byteLength);
+		case GltfMeshoptMode::Indices:
+			return MeshoptDecoder::DecodeIndexSequence(destination, view.count, view.byteStride, source, view.byteLength);
+		default:
+			break;
+		}
+
+		if (!MeshoptDecoder::DecodeVertexBuffer(destination, view.count, view.byteStride, source, view.byteLength))
+			return false;
+		switch (view.filter) {
+		case GltfMeshoptFilter::Octahedral:
+			MeshoptDecoder::DecodeOctahedralFilter(destination, view.count, view.byteStride);
+			break;
+		case GltfMeshoptFilter::Quaternion:
+			MeshoptDecoder::DecodeQuaternionFilter(destination, view.count, view.byteStride);
+			break;
+		case GltfMeshoptFilter::Exponential:
+			MeshoptDecoder::DecodeExponentialFilter(destination, view.count, view.byteStride);
+			break;
+		default:
+			break;
+		}
+		return true;
+	}
+
+	bool IsValidComponentType(uint32_t componentType) {
+		return (componentType >= 5120 && componentType <= 5123) || componentType == 5125 || componentType == 5126;
+	}
+
+	// URIs are percent encoded ("my%20model.bin")
+	std::string DecodeUri(std::string_view uri) {
+		std::string decoded;
+		decoded.reserve(uri.size());
+		for (size_t i = 0; i < uri.size(); ++i) {
+			if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) &&
+				std::isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+				decoded += static_cast<char>(std::stoi(std::string(uri.substr(i + 1, 2)), nullptr, 16));
+				i += 2;
+			}
+			else {
+				decoded += uri[i];
+			}
+		}
+		return decoded;
+	}
+
+	bool DecodeBase64(std::string_view text, std::vector<uint8_t>& output) {
+		static const auto decodeTable = []() {
+			std::array<int8_t, 256> table;
+			table.fill(-1);
+			const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			for (int i = 0; i < 64; ++i)
+				table[static_cast<uint8_t>(alphabet[i])] = static_cast<int8_t>(i);
+			return table;
+		}();
+
+		output.clear();
+		output.reserve(text.size() / 4 * 3);
+		uint32_t accumulator = 0;
+		int bits = 0;
+		for (char c : text) {
+			if (c == '=')
+				break;
+			int8_t value = decodeTable[static_cast<uint8_t>(c)];
+			if (value < 0)
+				return false;
+			accumulator = (accumulator << 6) | static_cast<uint32_t>(value);
+			bits += 6;
+			if (bits >= 8) {
+				bits -= 8;
+				output.push_back(static_cast<uint8_t>(accumulator >> bits));
+			}
+		}
+		return true;
+	}
+
+	GltfTextureInfo ParseTextureInfo(const JsonValue& textureInfo, const char* scaleName = nullptr) {
+		GltfTextureInfo info;
+		if (!textureInfo.IsObject())
+			return info;
+		info.texture = textureInfo["index"].GetUInt(GLTF_INVALID_INDEX);
+		info.texCoord = textureInfo["texCoord"].GetUInt(0);
+		if (scaleName != nullptr)
+			info.scale = textureInfo[scaleName].GetFloat(1.0f);
+		return info;
+	}
+}
+
+uint32_t GltfAccessorView::GetComponentCount() const {
+	static const uint32_t componentCounts[] = { 1, 2, 3, 4, 4, 9, 16 };
+	return componentCounts[static_cast<size_t>(type)];
+}
+
+uint32_t GltfAccessorView::GetComponentSize() const {
+	switch (componentType) {
+	case GltfComponentType::Byte:
+	case GltfComponentType::UnsignedByte:
+		return 1;
+	case GltfComponentType::Short:
+	case GltfComponentType::UnsignedShort:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+uint32_t GltfAccessorView::ReadFloats(size_t index, float* values, uint32_t maxComponents) const {
+	const uint32_t componentCount = std::min(GetComponentCount(), maxComponents);
+	if (data == nullptr) {
+		std::fill(values, values + componentCount, 0.0f);
+		return componentCount;
+	}
+
+	const uint8_t* element = data + index * stride;
+	for (uint32_t c = 0; c < componentCount; ++c) {
+		switch (componentType) {
+		case GltfComponentType::Float: {
+			std::memcpy(&values[c], element + c * 4, 4);
+			break;
+		}
+		case GltfComponentType::UnsignedByte: {
+			float value = static_cast<float>(element[c]);
+			values[c] = normalized ? value / 255.0f : value;
+			break;
+		}
+		case GltfComponentType::Byte: {
+			float value = static_cast<float>(static_cast<int8_t>(element[c]));
+			values[c] = normalized ? std::max(value / 127.0f, -1.0f) : value;
+			break;
+		}
+		case GltfComponentType::UnsignedShort: {
+			uint16_t value;
+			std::memcpy(&value, element + c * 2, 2);
+			values[c] = normalized ? value / 65535.0f : static_cast<float>(value);
+			break;
+		}
+		case GltfComponentType::Short: {
+			int16_t value;
+			std::memcpy(&value, element + c * 2, 2);
+			values[c] = normalized ? std::max(value / 32767.0f, -1.0f) : static_cast<float>(value);
+			break;
+		}
+		case GltfComponentType::UnsignedInt: {
+			uint32_t value;
+			std::memcpy(&value, element + c * 4, 4);
+			values[c] = static_cast<float>(value);
+			break;
+		}
+		}
+	}
+	return componentCount;
+}
+
+uint32_t GltfAccessorView::ReadIndex(size_t index) const {
+	if (data == nullptr)
+		return 0;
+
+	const uint8_t* element = data + index * stride;
+	switch (componentType) {
+	case GltfComponentType::UnsignedByte:
+		return element[0];
+	case GltfComponentType::UnsignedShort: {
+		uint16_t value;
+		std::memcpy(&value, element, 2);
+		return value;
+	}
+	case GltfComponentType::UnsignedInt: {
+		uint32_t value;
+		std::memcpy(&value, element, 4);
+		return value;
+	}
+	default:
+		// Rejected by ParseMeshes for index accessors
+		return 0;
+	}
+}
+
+bool GltfAsset::Load(const std::string& filePath, ThreadPool* threadPool) {
+	Clear();
+	m_filePath = filePath;
+	std::filesystem::path parentPath = std::filesystem::path(filePath).parent_path();
+	m_directory = parentPath.empty() ? std::string() : parentPath.generic_string() + "/";
+
+	// The JSON is parsed in place from the mapping, only the values the engine uses are kept
+	if (!m_file.Open(filePath))
+		return false;
+
+	GltfByteRange json{ m_file.GetData(), m_file.GetSize() };
+	const bool isBinaryContainer = json.size >= sizeof(uint32_t) && ReadUInt32(json.data) == GLB_MAGIC;
+	if (isBinaryContainer && !ReadBinaryContainer(json)) {
+		Clear();
+		return false;
+	}
+
+	JsonDocument document;
+	if (!document.Parse(reinterpret_cast<const char*>(json.data), json.size)) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to parse glTF file ", filePath, ": ", document.GetError());
+		Clear();
+		return false;
+	}
+
+	if (!ParseDocument(document.GetRoot()) || !DecodeCompressedBufferViews(threadPool)) {
+		Clear();
+		return false;
+	}
+	// Nothing points into a .gltf once parsed, a .glb stays mapped for its BIN chunk
+	if (!isBinaryContainer)
+		m_file.Close();
+	return true;
+}
+
+GltfAccessorView GltfAsset::GetAccessorView(uint32_t accessorIndex) const {
+	GltfAccessorView view;
+	if (accessorIndex >= m_accessors.size())
+		return view;
+
+	const GltfAccessor& accessor = m_accessors[accessorIndex];
+	view.count = accessor.count;
+	view.componentType = accessor.componentType;
+	view.type = accessor.type;
+	view.normalized = accessor.normalized;
+	view.stride = view.GetElementSize();
+	if (accessor.bufferView != GLTF_INVALID_INDEX) {
+		const GltfBufferView& bufferView = m_bufferViews[accessor.bufferView];
+		view.data = GetBufferViewData(accessor.bufferView) + accessor.byteOffset;
+		if (bufferView.byteStride != 0)
+			view.stride = bufferView.byteStride;
+	}
+	return view;
+}
+
+const uint8_t* GltfAsset::GetBufferViewData(uint32_t bufferView) const {
+	if (bufferView >= m_bufferViews.size())
+		return nullptr;
+	const GltfBufferView& view = m_bufferViews[bufferView];
+	return m_buffers[view.buffer].data + view.byteOffset;
+}
+
+GltfByteRange GltfAsset::GetImageData(uint32_t image) const {
+	if (image >= m_images.size() || m_images[image].bufferView == GLTF_INVALID_INDEX)
+		return GltfByteRange();
+	uint32_t bufferView = m_images[image].bufferView;
+	return GltfByteRange{ GetBufferViewData(bufferView), m_bufferViews[bufferView].byteLength };
+}
+
+void GltfAsset::Clear() {
+	m_file.Close();
+	m_binaryChunk = GltfByteRange();
+	m_mappedBuffers.clear();
+	m_decodedBuffers.clear();
+	m_defaultScene = 0;
+	m_buffers.clear();
+	m_bufferViews.clear();
+	m_compressedBufferViews.clear();
+	m_accessors.clear();
+	m_meshes.clear();
+	m_nodes.clear();
+	m_scenes.clear();
+	m_materials.clear();
+	m_samplers.clear();
+	m_images.clear();
+	m_textures.clear();
+}
+
+bool GltfAsset::ReadBinaryContainer(GltfByteRange& jsonChunk) {
+	const uint8_t* data = m_file.GetData();
+	size_t size = m_file.GetSize();
+	if (size < GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid GLB file ", m_filePath, ": the file is truncated.");
+		return false;
+	}
+	uint32_t version = ReadUInt32(data + 4);
+	if (version != 2) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unsupported GLB version in ", m_filePath, ": ", version, ", 2 is required.");
+		return false;
+	}
+	size_t length = ReadUInt32(data + 8);
+	if (length > size) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid GLB file ", m_filePath, ": the file is smaller than its header length.");
+		return false;
+	}
+
+	// Chunks are views into the mapping, unknown chunk types are skipped as the specification requires
+	jsonChunk = GltfByteRange();
+	size_t offset = GLB_HEADER_SIZE;
+	while (offset + GLB_CHUNK_HEADER_SIZE <= length) {
+		size_t chunkLength = ReadUInt32(data + offset);
+		uint32_t chunkType = ReadUInt32(data + offset + 4);
+		offset += GLB_CHUNK_HEADER_SIZE;
+		if (chunkLength > length - offset) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid GLB file ", m_filePath, ": a chunk is out of the file bounds.");
+			return false;
+		}
+
+		GltfByteRange chunk{ data + offset, chunkLength };
+		if (jsonChunk.data == nullptr) {
+			if (chunkType != GLB_CHUNK_JSON) {
+				ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid GLB file ", m_filePath, ": the first chunk isn't JSON.");
+				return false;
+			}
+			jsonChunk = chunk;
+		}
+		else if (chunkType == GLB_CHUNK_BIN && m_binaryChunk.data == nullptr) {
+			m_binaryChunk = chunk;
+		}
+		offset += (chunkLength + 3) & ~size_t(3);
+	}
+
+	if (jsonChunk.data == nullptr) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid GLB file ", m_filePath, ": the JSON chunk is missing.");
+		return false;
+	}
+	// The mapping is page aligned, so a BIN chunk at a 4 byte offset keeps the alignment glTF requires from
+	// accessors (offsets multiple of the component size) and the views can read it in place
+	if (reinterpret_cast<uintptr_t>(m_binaryChunk.data) % 4 != 0) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid GLB file ", m_filePath, ": the BIN chunk isn't 4 byte aligned.");
+		return false;
+	}
+	return true;
+}
+
+bool GltfAsset::ParseDocument(const JsonValue& root) {
+	if (!root.IsObject()) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": the root isn't an object.");
+		return false;
+	}
+
+	std::string_view version = root["asset"]["version"].GetRawString();
+	if (version.empty() || version[0] != '2') {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unsupported glTF version in ", m_filePath, ": '", version, "', 2.0 is required.");
+		return false;
+	}
+
+	for (JsonValue extension : root["extensionsRequired"]) {
+		bool supported = std::any_of(std::begin(SUPPORTED_REQUIRED_EXTENSIONS), std::end(SUPPORTED_REQUIRED_EXTENSIONS),
+			[&extension](const char* name) { return extension.StringEquals(name); });
+		if (!supported) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "glTF file ", m_filePath, " requires the unsupported extension ",
+				extension.GetRawString(), ".");
+			return false;
+		}
+	}
+
+	if (!ParseBuffers(root["buffers"]) || !ParseBufferViews(root["bufferViews"]) || !ParseAccessors(root["accessors"]) ||
+		!ParseMeshes(root["meshes"]) || !ParseNodes(root["nodes"])) {
+		return false;
+	}
+	ParseMaterials(root["materials"]);
+	ParseTextures(root);
+
+	for (JsonValue scene : root["scenes"]) {
+		GltfScene& gltfScene = m_scenes.emplace_back();
+		gltfScene.name = scene["name"].GetString();
+		for (JsonValue node : scene["nodes"]) {
+			uint32_t nodeIndex = node.GetUInt(GLTF_INVALID_INDEX);
+			if (nodeIndex >= m_nodes.size()) {
+				ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": a scene references a missing node.");
+				return false;
+			}
+			gltfScene.nodes.push_back(nodeIndex);
+		}
+	}
+	m_defaultScene = std::min<uint32_t>(root["scene"].GetUInt(0), m_scenes.empty() ? 0 : static_cast<uint32_t>(m_scenes.size() - 1));
+	return true;
+}
+
+bool GltfAsset::ParseBuffers(const JsonValue& buffers) {
+	m_buffers.reserve(buffers.Size());
+	m_mappedBuffers.reserve(buffers.Size());
+	for (JsonValue buffer : buffers) {
+		GltfBuffer& gltfBuffer = m_buffers.emplace_back();
+		gltfBuffer.byteLength = buffer["byteLength"].GetSize(0);
+
+		// A fallback buffer is only meant for loaders without EXT_meshopt_compression (its uri can even be missing),
+		// the compressed views are decoded into zeroed memory instead
+		if (buffer["extensions"]["EXT_meshopt_compression"]["fallback"].GetBool(false)) {
+			std::vector<uint8_t>& decoded = m_decodedBuffers.emplace_back(gltfBuffer.byteLength);
+			gltfBuffer.data = decoded.data();
+			gltfBuffer.compressedFallback = true;
+			continue;
+		}
+
+		std::string_view uri = buffer["uri"].GetRawString();
+		if (uri.empty()) {
+			// The first buffer of a GLB container is its BIN chunk, used in place
+			if (m_buffers.size() != 1 || m_binaryChunk.data == nullptr) {
+				ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath,
+					": a buffer has no uri, which is only valid for the first buffer of a GLB container with a BIN chunk.");
+				return false;
+			}
+			if (m_binaryChunk.size < gltfBuffer.byteLength) {
+				ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid GLB file ", m_filePath, ": the BIN chunk is smaller than its buffer.");
+				return false;
+			}
+			gltfBuffer.data = m_binaryChunk.data;
+			continue;
+		}
+
+		if (uri.compare(0, 5, "data:") == 0) {
+			size_t dataStart = uri.find(";base64,");
+			std::vector<uint8_t>& decoded = m_decodedBuffers.emplace_back();
+			if (dataStart == std::string_view::npos || !DecodeBase64(uri.substr(dataStart + 8), decoded)) {
+				ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": unsupported data URI in a buffer.");
+				return false;
+			}
+			gltfBuffer.data = decoded.data();
+			if (decoded.size() < gltfBuffer.byteLength) {
+				ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": an embedded buffer is truncated.");
+				return false;
+			}
+			continue;
+		}
+
+		std::string bufferPath = m_directory + DecodeUri(uri);
+		MappedFile& mappedFile = m_mappedBuffers.emplace_back();
+		if (!mappedFile.Open(bufferPath))
+			return false;
+		if (mappedFile.GetSize() < gltfBuffer.byteLength) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF buffer ", bufferPath, ": the file is smaller than its byteLength.");
+			return false;
+		}
+		gltfBuffer.data = mappedFile.GetData();
+		gltfBuffer.uri = bufferPath;
+	}
+	return true;
+}
+
+bool GltfAsset::ParseBufferViews(const JsonValue& bufferViews) {
+	m_bufferViews.reserve(bufferViews.Size());
+	for (JsonValue bufferView : bufferViews) {
+		GltfBufferView& view = m_bufferViews.emplace_back();
+		view.buffer = bufferView["buffer"].GetUInt(GLTF_INVALID_INDEX);
+		view.byteOffset = bufferView["byteOffset"].GetSize(0);
+		view.byteLength = bufferView["byteLength"].GetSize(0);
+		view.byteStride = bufferView["byteStride"].GetUInt(0);
+
+		if (view.buffer >= m_buffers.size() || view.byteOffset > m_buffers[view.buffer].byteLength ||
+			view.byteLength > m_buffers[view.buffer].byteLength - view.byteOffset) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": buffer view ", m_bufferViews.size() - 1,
+				" is out of the bounds of its buffer.");
+			return false;
+		}
+
+		JsonValue extension = bufferView["extensions"]["EXT_meshopt_compression"];
+		if (extension.IsObject() && !ParseCompressedBufferView(extension, static_cast<uint32_t>(m_bufferViews.size() - 1)))
+			return false;
+	}
+	return true;
+}
+
+bool GltfAsset::ParseCompressedBufferView(const JsonValue& extension, uint32_t bufferView) {
+	GltfCompressedBufferView compressed;
+	compressed.bufferView = bufferView;
+	compressed.buffer = extension["buffer"].GetUInt(GLTF_INVALID_INDEX);
+	compressed.byteOffset = extension["byteOffset"].GetSize(0);
+	compressed.byteLength = extension["byteLength"].GetSize(0);
+	compressed.byteStride = extension["byteStride"].GetUInt(0);
+	compressed.count = extension["count"].GetSize(0);
+
+	std::string_view filter = extension["filter"].GetRawString();
+	bool valid = ParseMeshoptMode(extension["mode"].GetRawString(), compressed.mode) &&
+		(filter.empty() || ParseMeshoptFilter(filter, compressed.filter)) && IsValidMeshoptLayout(compressed);
+	// The encoded bytes come from a regular buffer, the decoded elements must fit in the view
+	valid = valid && compressed.buffer < m_buffers.size() && !m_buffers[compressed.buffer].compressedFallback &&
+		compressed.byteOffset <= m_buffers[compressed.buffer].byteLength &&
+		compressed.byteLength <= m_buffers[compressed.buffer].byteLength - compressed.byteOffset &&
+		compressed.count <= m_bufferViews[bufferView].byteLength / compressed.byteStride;
+	if (!valid) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": the EXT_meshopt_compression data of buffer view ",
+			bufferView, " is invalid.");
+		return false;
+	}
+	m_compressedBufferViews.push_back(compressed);
+	return true;
+}
+
+bool GltfAsset::DecodeCompressedBufferViews(ThreadPool* threadPool) {
+	// Views of regular buffers also have their uncompressed data, which is used as is
+	std::vector<const GltfCompressedBufferView*> views;
+	for (const GltfCompressedBufferView& compressed : m_compressedBufferViews) {
+		if (m_buffers[m_bufferViews[compressed.bufferView].buffer].compressedFallback)
+			views.push_back(&compressed);
+	}
+	// Largest first, so the views left for the end of the loop are the quick ones
+	std::sort(views.begin(), views.end(),
+		[](const GltfCompressedBufferView* a, const GltfCompressedBufferView* b) { return a->byteLength > b->byteLength; });
+
+	// Views decode into disjoint ranges of the fallback buffers, which the asset owns (m_decodedBuffers)
+	std::vector<uint8_t> decoded(views.size(), 0);
+	auto decodeViews = [this, &views, &decoded](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const GltfCompressedBufferView& view = *views[i];
+			uint8_t* destination = const_cast<uint8_t*>(GetBufferViewData(view.bufferView));
+			decoded[i] = DecodeMeshoptView(view, m_buffers[view.buffer].data + view.byteOffset, destination) ? 1 : 0;
+		}
+	};
+	if (threadPool != nullptr)
+		threadPool->ParallelFor(views.size(), 1, decodeViews);
+	else
+		decodeViews(0, views.size());
+
+	// Logged from the calling thread once every view is done
+	for (size_t i = 0; i < views.size(); ++i) {
+		if (decoded[i] == 0) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": the EXT_meshopt_compression data of buffer view ",
+				views[i]->bufferView, " is corrupted.");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool GltfAsset::ParseAccessors(const JsonValue& accessors) {
+	m_accessors.reserve(accessors.Size());
+	for (JsonValue accessor : accessors) {
+		const size_t accessorIndex = m_accessors.size();
+		GltfAccessor& gltfAccessor = m_accessors.emplace_back();
+		gltfAccessor.bufferView = accessor["bufferView"].GetUInt(GLTF_INVALID_INDEX);
+		gltfAccessor.byteOffset = accessor["byteOffset"].GetSize(0);
+		gltfAccessor.count = accessor["count"].GetSize(0);
+		gltfAccessor.normalized = accessor["normalized"].GetBool(false);
+		gltfAccessor.sparse = accessor.HasMember("sparse");
+
+		uint32_t componentType = accessor["componentType"].GetUInt(0);
+		if (!IsValidComponentType(componentType) || !ParseAccessorType(accessor["type"].GetRawString(), gltfAccessor.type)) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": accessor ", accessorIndex,
+				" has an invalid type.");
+			return false;
+		}
+		gltfAccessor.componentType = static_cast<GltfComponentType>(componentType);
+
+		if (gltfAccessor.bufferView == GLTF_INVALID_INDEX || gltfAccessor.count == 0)
+			continue;
+
+		// Every element has to be inside the buffer view, so the views never read out of bounds
+		bool inBounds = gltfAccessor.bufferView < m_bufferViews.size();
+		if (inBounds) {
+			GltfAccessorView view = GetAccessorView(static_cast<uint32_t>(accessorIndex));
+			const size_t elementSize = view.GetElementSize();
+			const size_t viewLength = m_bufferViews[gltfAccessor.bufferView].byteLength;
+			inBounds = view.stride >= elementSize && gltfAccessor.byteOffset <= viewLength && elementSize <= viewLength - gltfAccessor.byteOffset &&
+				gltfAccessor.count - 1 <= (viewLength - gltfAccessor.byteOffset - elementSize) / view.stride;
+		}
+		if (!inBounds) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": accessor ", accessorIndex,
+				" is out of the bounds of its buffer view.");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool GltfAsset::ParseMeshes(const JsonValue& meshes) {
+	m_meshes.reserve(meshes.Size());
+	for (JsonValue mesh : meshes) {
+		GltfMesh& gltfMesh = m_meshes.emplace_back();
+		gltfMesh.name = mesh["name"].GetString();
+		gltfMesh.primitives.reserve(mesh["primitives"].Size());
+
+		for (JsonValue primitive : mesh["primitives"]) {
+			GltfPrimitive& gltfPrimitive = gltfMesh.primitives.emplace_back();
+			JsonValue attributes = primitive["attributes"];
+			gltfPrimitive.position = attributes["POSITION"].GetUInt(GLTF_INVALID_INDEX);
+			gltfPrimitive.normal = attributes["NORMAL"].GetUInt(GLTF_INVALID_INDEX);
+			gltfPrimitive.tangent = attributes["TANGENT"].GetUInt(GLTF_INVALID_INDEX);
+			gltfPrimitive.texCoord0 = attributes["TEXCOORD_0"].GetUInt(GLTF_INVALID_INDEX);
+			gltfPrimitive.texCoord1 = attributes["TEXCOORD_1"].GetUInt(GLTF_INVALID_INDEX);
+			gltfPrimitive.color0 = attributes["COLOR_0"].GetUInt(GLTF_INVALID_INDEX);
+			gltfPrimitive.indices = primitive["indices"].GetUInt(GLTF_INVALID_INDEX);
+			gltfPrimitive.material = primitive["material"].GetUInt(GLTF_INVALID_INDEX);
+			uint32_t mode = primitive["mode"].GetUInt(static_cast<uint32_t>(GltfPrimitiveMode::Triangles));
+
+			const uint32_t accessorCount = static_cast<uint32_t>(m_accessors.size());
+			const uint32_t accessors[] = { gltfPrimitive.position, gltfPrimitive.normal, gltfPrimitive.tangent, gltfPrimitive.texCoord0,
+				gltfPrimitive.texCoord1, gltfPrimitive.color0, gltfPrimitive.indices };
+			bool valid = mode <= static_cast<uint32_t>(GltfPrimitiveMode::TriangleFan);
+			for (uint32_t accessor : accessors)
+				valid &= accessor == GLTF_INVALID_INDEX || accessor < accessorCount;
+			if (!valid) {
+				ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": a primitive of mesh ",
+					m_meshes.size() - 1, " has an invalid mode or accessor.");
+				return false;
+			}
+			// Indices are unsigned scalars, anything else would be read with the wrong element size
+			if (gltfPrimitive.indices != GLTF_INVALID_INDEX) {
+				const GltfAccessor& indices = m_accessors[gltfPrimitive.indices];
+				if (indices.type != GltfAccessorType::Scalar || (indices.componentType != GltfComponentType::UnsignedByte &&
+					indices.componentType != GltfComponentType::UnsignedShort && indices.componentType != GltfComponentType::UnsignedInt)) {
+					ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": a primitive of mesh ",
+						m_meshes.size() - 1, " has indices that aren't unsigned byte, short or int scalars.");
+					return false;
+				}
+			}
+			gltfPrimitive.mode = static_cast<GltfPrimitiveMode>(mode);
+		}
+	}
+	return true;
+}
+
+bool GltfAsset::ParseNodes(const JsonValue& nodes) {
+	m_nodes.reserve(nodes.Size());
+	for (JsonValue node : nodes) {
+		GltfNode& gltfNode = m_nodes.emplace_back();
+		gltfNode.name = node["name"].GetString();
+		gltfNode.mesh = node["mesh"].GetUInt(GLTF_INVALID_INDEX);
+		for (JsonValue child : node["children"])
+			gltfNode.children.push_back(child.GetUInt(GLTF_INVALID_INDEX));
+
+		JsonValue matrix = node["matrix"];
+		if (matrix.Size() == 16) {
+			// glTF matrices are column major for column vectors, which is the same memory layout as
+			// a row major matrix for row vectors
+			matrix.GetFloats(&gltfNode.localTransform.m[0][0], 16);
+		}
+		else {
+			XMFLOAT3 translation(0.0f, 0.0f, 0.0f);
+			XMFLOAT4 rotation(0.0f, 0.0f, 0.0f, 1.0f);
+			XMFLOAT3 scale(1.0f, 1.0f, 1.0f);
+			node["translation"].GetFloats(&translation.x, 3);
+			node["rotation"].GetFloats(&rotation.x, 4);
+			node["scale"].GetFloats(&scale.x, 3);
+
+			XMMATRIX transform = XMMatrixScaling(scale.x, scale.y, scale.z) * XMMatrixRotationQuaternion(XMLoadFloat4(&rotation)) *
+				XMMatrixTranslation(translation.x, translation.y, translation.z);
+			XMStoreFloat4x4(&gltfNode.localTransform, transform);
+		}
+	}
+
+	for (const GltfNode& node : m_nodes) {
+		bool valid = node.mesh == GLTF_INVALID_INDEX || node.mesh < m_meshes.size();
+		for (uint32_t child : node.children)
+			valid &= child < m_nodes.size();
+		if (!valid) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Invalid glTF file ", m_filePath, ": node '", node.name,
+				"' references a missing mesh or child.");
+			return false;
+		}
+	}
+	return true;
+}
+
+void GltfAsset::ParseMaterials(const JsonValue& materials) {
+	m_materials.reserve(materials.Size());
+	for (JsonValue material : materials) {
+		GltfMaterial& gltfMaterial = m_materials.emplace_back();
+		gltfMaterial.name = material["name"].GetString();
+
+		JsonValue pbr = material["pbrMetallicRoughness"];
+		pbr["baseColorFactor"].GetFloats(&gltfMaterial.baseColorFactor.x, 4);
+		gltfMaterial.baseColorTexture = ParseTextureInfo(pbr["baseColorTexture"]);
+		gltfMaterial.metallicFactor = pbr["metallicFactor"].GetFloat(1.0f);
+		gltfMaterial.roughnessFactor = pbr["roughnessFactor"].GetFloat(1.0f);
+		gltfMaterial.metallicRoughnessTexture = ParseTextureInfo(pbr["metallicRoughnessTexture"]);
+
+		gltfMaterial.normalTexture = ParseTextureInfo(material["normalTexture"], "scale");
+		gltfMaterial.occlusionTexture = ParseTextureInfo(material["occlusionTexture"], "strength");
+		gltfMaterial.emissiveTexture = ParseTextureInfo(material["emissiveTexture"]);
+		material["emissiveFactor"].GetFloats(&gltfMaterial.emissiveFactor.x, 3);
+
+		JsonValue alphaMode = material["alphaMode"];
+		if (alphaMode.StringEquals("MASK"))
+			gltfMaterial.alphaMode = GltfAlphaMode::Mask;
+		else if (alphaMode.StringEquals("BLEND"))
+			gltfMaterial.alphaMode = GltfAlphaMode::Blend;
+		gltfMaterial.alphaCutoff = material["alphaCutoff"].GetFloat(0.5f);
+		gltfMaterial.doubleSided = material["doubleSided"].GetBool(false);
+	}
+}
+
+void GltfAsset::ParseTextures(const JsonValue& root) {
+	for (JsonValue sampler : root["samplers"]) {
+		GltfSampler& gltfSampler = m_samplers.emplace_back();
+		gltfSampler.magFilter = sampler["magFilter"].GetUInt(0);
+		gltfSampler.minFilter = sampler["minFilter"].GetUInt(0);
+		gltfSampler.wrapS = sampler["wrapS"].GetUInt(10497);
+		gltfSampler.wrapT = sampler["wrapT"].GetUInt(10497);
+	}
+
+	for (JsonValue image : root["images"]) {
+		GltfImage& gltfImage = m_images.emplace_back();
+		gltfImage.mimeType = image["mimeType"].GetString();
+		gltfImage.bufferView = image["bufferView"].GetUInt(GLTF_INVALID_INDEX);
+		if (gltfImage.bufferView >= m_bufferViews.size())
+			gltfImage.bufferView = GLTF_INVALID_INDEX;
+
+		std::string_view uri = image["uri"].GetRawString();
+		if (uri.compare(0, 5, "data:") == 0) {
+			// Embedded images become a buffer view of their own, so they're read like the GLB ones
+			size_t dataStart = uri.find(";base64,");
+			std::vector<uint8_t> decoded;
+			if (dataStart == std::string_view::npos || !DecodeBase64(uri.substr(dataStart + 8), decoded)) {
+				ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "glTF file ", m_filePath, ": unsupported data URI in image ",
+					m_images.size() - 1, ".");
+				continue;
+			}
+			if (gltfImage.mimeType.empty())
+				gltfImage.mimeType = std::string(uri.substr(5, uri.find(';') - 5));
+
+			std::vector<uint8_t>& storage = m_decodedBuffers.emplace_back(std::move(decoded));
+			m_buffers.push_back(GltfBuffer{ storage.data(), storage.size() });
+			m_bufferViews.push_back(GltfBufferView{ static_cast<uint32_t>(m_buffers.size() - 1), 0, storage.size(), 0 });
+			gltfImage.bufferView = static_cast<uint32_t>(m_bufferViews.size() - 1);
+		}
+		else if (!uri.empty()) {
+			gltfImage.uri = m_directory + DecodeUri(uri);
+		}
+	}
+
+	for (JsonValue texture : root["textures"]) {
+		GltfTexture& gltfTexture = m_textures.emplace_back();
+		gltfTexture.source = texture["source"].GetUInt(GLTF_INVALID_INDEX);
+		gltfTexture.sampler = texture["sampler"].GetUInt(GLTF_INVALID_INDEX);
+		if (gltfTexture.source >= m_images.size())
+			gltfTexture.source = GLTF_INVALID_INDEX;
+		if (gltfTexture.sampler >= m_samplers.size())
+			gltfTexture.sampler = GLTF_INVALID_INDEX;
+	}
+}
@@ -0,0 +1,323 @@
+#ifndef GLTF_ASSET_H
+#define GLTF_ASSET_H
+
+#include <DirectXMath.h>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../utils/MappedFile.h"
+
+class JsonValue;
+class ThreadPool;
+
+
+// glTF 2.0 asset: the scene description parsed from the JSON and the binary buffers it points to.
+//
+// External .bin buffers are memory mapped and accessors are exposed as strided views straight into
+// the mapping, nothing is copied or converted at load time. Conversion into the engine vertex
+// formats happens on demand, see GltfImporter. Only embedded base64 buffers (data URIs) are decoded
+// into owned memory.
+// Binary .glb containers are mapped once: the JSON chunk is parsed in place, and the BIN chunk and
+// the images it holds are used straight from the mapping.
+// Buffer views compressed with EXT_meshopt_compression are decoded at load time into the fallback
+// buffers they point to, after which they read like any other view.
+// Indices into the asset arrays follow the glTF ones, GLTF_INVALID_INDEX stands for "none".
+
+constexpr uint32_t GLTF_INVALID_INDEX = UINT32_MAX;
+
+// Values of the glTF componentType property (the OpenGL type enums)
+enum class GltfComponentType : uint32_t {
+	Byte = 5120,
+	UnsignedByte = 5121,
+	Short = 5122,
+	UnsignedShort = 5123,
+	UnsignedInt = 5125,
+	Float = 5126
+};
+
+enum class GltfAccessorType : uint8_t {
+	Scalar,
+	Vec2,
+	Vec3,
+	Vec4,
+	Mat2,
+	Mat3,
+	Mat4
+};
+
+enum class GltfPrimitiveMode : uint8_t {
+	Points,
+	Lines,
+	LineLoop,
+	LineStrip,
+	Triangles,
+	TriangleStrip,
+	TriangleFan
+};
+
+enum class GltfAlphaMode : uint8_t {
+	Opaque,
+	Mask,
+	Blend
+};
+
+// Bytes inside the asset memory (a mapping or a decoded data URI), valid while the asset is loaded
+struct GltfByteRange {
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+};
+
+struct GltfBuffer {
+	const uint8_t* data = nullptr;  // Mapped file, decoded data URI, GLB chunk or decoded EXT_meshopt_compression views
+	size_t byteLength = 0;
+	bool compressedFallback = false;  // Only holds data decoded from EXT_meshopt_compression views
+	std::string uri;  // Path of an external buffer file, relative to the working directory. Empty for the others.
+};
+
+struct GltfBufferView {
+	uint32_t buffer = GLTF_INVALID_INDEX;
+	size_t byteOffset = 0;
+	size_t byteLength = 0;
+	uint32_t byteStride = 0;  // 0 when the elements are tightly packed
+};
+
+enum class GltfMeshoptMode : uint8_t {
+	Attributes,
+	Triangles,
+	Indices
+};
+
+enum class GltfMeshoptFilter : uint8_t {
+	None,
+	Octahedral,
+	Quaternion,
+	Exponential
+};
+
+// EXT_meshopt_compression data of a buffer view: `count` elements of `byteStride` bytes encoded in a range of another buffer
+struct GltfCompressedBufferView {
+	uint32_t bufferView = GLTF_INVALID_INDEX;  // Destination of the decoded elements
+	uint32_t buffer = GLTF_INVALID_INDEX;
+	size_t byteOffset = 0;
+	size_t byteLength = 0;
+	uint32_t byteStride = 0;
+	size_t count = 0;
+	GltfMeshoptMode mode = GltfMeshoptMode::Attributes;
+	GltfMeshoptFilter filter = GltfMeshoptFilter::None;
+};
+
+struct GltfAccessor {
+	uint32_t bufferView = GLTF_INVALID_INDEX;  // No buffer view means all zeros
+	size_t byteOffset = 0;
+	size_t count = 0;
+	GltfComponentType componentType = GltfComponentType::Float;
+	GltfAccessorType type = GltfAccessorType::Scalar;
+	bool normalized = false;
+	bool sparse = false;  // Sparse substitutions aren't applied, the view only covers the base values
+};
+
+struct GltfPrimitive {
+	uint32_t position = GLTF_INVALID_INDEX;
+	uint32_t normal = GLTF_INVALID_INDEX;
+	uint32_t tangent = GLTF_INVALID_INDEX;
+	uint32_t texCoord0 = GLTF_INVALID_INDEX;
+	uint32_t texCoord1 = GLTF_INVALID_INDEX;
+	uint32_t color0 = GLTF_INVALID_INDEX;
+	uint32_t indices = GLTF_INVALID_INDEX;  // Non indexed primitive if invalid
+	uint32_t material = GLTF_INVALID_INDEX;
+	GltfPrimitiveMode mode = GltfPrimitiveMode::Triangles;
+};
+
+struct GltfMesh {
+	std::string name;
+	std::vector<GltfPrimitive> primitives;
+};
+
+struct GltfNode {
+	std::string name;
+	uint32_t mesh = GLTF_INVALID_INDEX;
+	std::vector<uint32_t> children;
+	// Transform relative to the parent, for row vectors like the rest of DirectXMath
+	DirectX::XMFLOAT4X4 localTransform = DirectX::XMFLOAT4X4(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+};
+
+struct GltfScene {
+	std::string name;
+	std::vector<uint32_t> nodes;
+};
+
+struct GltfTextureInfo {
+	uint32_t texture = GLTF_INVALID_INDEX;
+	uint32_t texCoord = 0;
+	float scale = 1.0f;  // Normal texture scale or occlusion strength
+};
+
+struct GltfMaterial {
+	std::string name;
+	DirectX::XMFLOAT4 baseColorFactor = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	GltfTextureInfo baseColorTexture;
+	float metallicFactor = 1.0f;
+	float roughnessFactor = 1.0f;
+	GltfTextureInfo metallicRoughnessTexture;
+	GltfTextureInfo normalTexture;
+	GltfTextureInfo occlusionTexture;
+	GltfTextureInfo emissiveTexture;
+	DirectX::XMFLOAT3 emissiveFactor = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+	GltfAlphaMode alphaMode = GltfAlphaMode::Opaque;
+	float alphaCutoff = 0.5f;
+	bool doubleSided = false;
+};
+
+// Filters and wrap modes keep their glTF (OpenGL) values, 0 when unspecified
+struct GltfSampler {
+	uint32_t magFilter = 0;
+	uint32_t minFilter = 0;
+	uint32_t wrapS = 10497;  // GL_REPEAT
+	uint32_t wrapT = 10497;
+};
+
+struct GltfImage {
+	std::string uri;  // Path of an external image, relative to the working directory. Empty for embedded images.
+	uint32_t bufferView = GLTF_INVALID_INDEX;
+	std::string mimeType;
+};
+
+struct GltfTexture {
+	uint32_t source = GLTF_INVALID_INDEX;
+	uint32_t sampler = GLTF_INVALID_INDEX;
+};
+
+// Typed view over strided elements. glTF only guarantees the alignment of the components, so
+// elements are read through memcpy, which compiles to plain loads.
+template <typename T>
+class GltfStridedView {
+	public:
+		GltfStridedView() = default;
+		GltfStridedView(const uint8_t* data, size_t count, size_t stride) : m_data(data), m_count(count), m_stride(stride) {}
+
+		T operator[](size_t index) const {
+			assert(index < m_count);
+			T value;
+			std::memcpy(&value, m_data + index * m_stride, sizeof(T));
+			return value;
+		}
+
+		size_t Size() const { return m_count; }
+		size_t GetStride() const { return m_stride; }
+		const uint8_t* GetData() const { return m_data; }
+		bool IsEmpty() const { return m_count == 0; }
+		// Tightly packed elements can be copied in one go
+		bool IsPacked() const { return m_stride == sizeof(T); }
+
+	private:
+		const uint8_t* m_data = nullptr;
+		size_t m_count = 0;
+		size_t m_stride = 0;
+};
+
+// Elements of an accessor, pointing into the buffer memory
+struct GltfAccessorView {
+	const uint8_t* data = nullptr;  // First element, nullptr if the accessor has no buffer view (all zeros)
+	size_t count = 0;
+	size_t stride = 0;
+	GltfComponentType componentType = GltfComponentType::Float;
+	GltfAccessorType type = GltfAccessorType::Scalar;
+	bool normalized = false;
+
+	uint32_t GetComponentCount() const;
+	uint32_t GetComponentSize() const;
+	size_t GetElementSize() const { return static_cast<size_t>(GetComponentCount()) * GetComponentSize(); }
+
+	// Reinterprets the elements as T, which must have the size of an element (e.g. XMFLOAT3 for float VEC3)
+	template <typename T>
+	GltfStridedView<T> As() const {
+		assert(sizeof(T) == GetElementSize());
+		return GltfStridedView<T>(data, data != nullptr ? count : 0, stride);
+	}
+
+	// Reads up to `maxComponents` components of an element as floats, dequantizing normalized integers.
+	// Returns the number of components written.
+	uint32_t ReadFloats(size_t index, float* values, uint32_t maxComponents) const;
+	// Reads an element of an index accessor (unsigned byte, short or int scalars)
+	uint32_t ReadIndex(size_t index) const;
+};
+
+class GltfAsset {
+	public:
+		GltfAsset() = default;
+		GltfAsset(const GltfAsset&) = delete;
+		GltfAsset& operator=(const GltfAsset&) = delete;
+
+		// Loads a .gltf file and maps its buffers, or maps a .glb container (detected from its header).
+		// Compressed buffer views are decoded on the workers of `threadPool` if given, on the calling thread otherwise.
+		// Logs and returns false on failure.
+		bool Load(const std::string& filePath, ThreadPool* threadPool = nullptr);
+
+		// View over the elements of an accessor, empty for invalid indices
+		GltfAccessorView GetAccessorView(uint32_t accessor) const;
+		// Bytes of a buffer view, used by embedded images
+		const uint8_t* GetBufferViewData(uint32_t bufferView) const;
+		// Encoded bytes of an image stored in a buffer view (GLB or data URI), empty for external images
+		GltfByteRange GetImageData(uint32_t image) const;
+
+		const std::string& GetFilePath() const { return m_filePath; }
+		uint32_t GetDefaultScene() const { return m_defaultScene; }
+		bool IsBinaryContainer() const { return m_file.IsOpen(); }
+		// BIN chunk of a .glb container, the data of its first buffer
+		GltfByteRange GetBinaryChunk() const { return m_binaryChunk; }
+
+		const std::vector<GltfBuffer>& GetBuffers() const { return m_buffers; }
+		const std::vector<GltfBufferView>& GetBufferViews() const { return m_bufferViews; }
+		const std::vector<GltfCompressedBufferView>& GetCompressedBufferViews() const { return m_compressedBufferViews; }
+		const std::vector<GltfAccessor>& GetAccessors() const { return m_accessors; }
+		const std::vector<GltfMesh>& GetMeshes() const { return m_meshes; }
+		const std::vector<GltfNode>& GetNodes() const { return m_nodes; }
+		const std::vector<GltfScene>& GetScenes() const { return m_scenes; }
+		const std::vector<GltfMaterial>& GetMaterials() const { return m_materials; }
+		const std::vector<GltfSampler>& GetSamplers() const { return m_samplers; }
+		const std::vector<GltfImage>& GetImages() const { return m_images; }
+		const std::vector<GltfTexture>& GetTextures() const { return m_textures; }
+
+	private:
+		void Clear();
+		bool ReadBinaryContainer(GltfByteRange& jsonChunk);
+		bool ParseDocument(const JsonValue& root);
+		bool ParseBuffers(const JsonValue& buffers);
+		bool ParseBufferViews(const JsonValue& bufferViews);
+		bool ParseCompressedBufferView(const JsonValue& extension, uint32_t bufferView);
+		bool DecodeCompressedBufferViews(ThreadPool* threadPool);
+		bool ParseAccessors(const JsonValue& accessors);
+		bool ParseMeshes(const JsonValue& meshes);
+		bool ParseNodes(const JsonValue& nodes);
+		void ParseMaterials(const JsonValue& materials);
+		void ParseTextures(const JsonValue& root);
+
+	private:
+		std::string m_filePath;
+		std::string m_directory;  // Directory of the .gltf, with a trailing separator, external URIs are relative to it
+
+		MappedFile m_file;  // The .glb container, kept mapped for its BIN chunk
+		GltfByteRange m_binaryChunk;
+		std::vector<MappedFile> m_mappedBuffers;
+		std::vector<std::vector<uint8_t>> m_decodedBuffers;  // Data URIs and EXT_meshopt_compression fallback buffers
+
+		uint32_t m_defaultScene = 0;
+		std::vector<GltfBuffer> m_buffers;
+		std::vector<GltfBufferView> m_bufferViews;
+		std::vector<GltfCompressedBufferView> m_compressedBufferViews;
+		std::vector<GltfAccessor> m_accessors;
+		std::vector<GltfMesh> m_meshes;
+		std::vector<GltfNode> m_nodes;
+		std::vector<GltfScene> m_scenes;
+		std::vector<GltfMaterial> m_materials;
+		std::vector<GltfSampler> m_samplers;
+		std::vector<GltfImage> m_images;
+		std::vector<GltfTexture> m_textures;
+};
+
+#endif // !GLTF_ASSET_H
@@ -0,0 +1,501 @@
+#include "GltfConversion.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "../graphics/VertexFormat.h"
+#include "../utils/ConsoleLogger.h"
+
+
+namespace {
+	// Normalized integers are multiplied by 1 / max, signed ones are clamped as their minimum maps below -1
+	struct Dequantization {
+		float scale;
+		float minimum;
+	};
+
+	template <typename T>
+	Dequantization GetDequantization(bool normalized) {
+		if constexpr (std::is_floating_point_v<T>) {
+			return { 1.0f, -FLT_MAX };
+		}
+		else {
+			if (!normalized)
+				return { 1.0f, -FLT_MAX };
+			return { 1.0f / static_cast<float>(std::numeric_limits<T>::max()), std::is_signed_v<T> ? -1.0f : 0.0f };
+		}
+	}
+
+	// Number of leading elements that can be read with `loadSize` byte loads without going past the last element
+	size_t GetWideLoadCount(size_t count, size_t stride, size_t elementSize, size_t loadSize) {
+		if (count == 0)
+			return 0;
+		size_t end = (count - 1) * stride + elementSize;
+		if (end < loadSize)
+			return 0;
+		return std::min(count, (end - loadSize) / stride + 1);
+	}
+
+	template <typename T, uint32_t N>
+	void ConvertScalar(const uint8_t* source, size_t sourceStride, size_t begin, size_t end, uint8_t* destination,
+		size_t destinationStride, Dequantization dequantization) {
+		for (size_t i = begin; i < end; ++i) {
+			T components[N];
+			std::memcpy(components, source + i * sourceStride, sizeof(components));
+			float values[N];
+			for (uint32_t c = 0; c < N; ++c) {
+				if constexpr (std::is_floating_point_v<T>)
+					values[c] = components[c];
+				else
+					values[c] = std::max(static_cast<float>(components[c]) * dequantization.scale, dequantization.minimum);
+			}
+			std::memcpy(destination + i * destinationStride, values, sizeof(values));
+		}
+	}
+
+	// Stores the first N lanes, without touching the bytes after them
+	template <uint32_t N>
+	void StoreFloats(uint8_t* destination, __m128 values) {
+		float* output = reinterpret_cast<float*>(destination);
+		if constexpr (N == 1) {
+			_mm_store_ss(output, values);
+		}
+		else if constexpr (N == 2) {
+			_mm_storel_pi(reinterpret_cast<__m64*>(output), values);
+		}
+		else if constexpr (N == 3) {
+			_mm_storel_pi(reinterpret_cast<__m64*>(output), values);
+			_mm_store_ss(output + 2, _mm_movehl_ps(values, values));
+		}
+		else {
+			_mm_storeu_ps(output, values);
+		}
+	}
+
+	// Loads 4 components of an element as floats, reading 4 * sizeof(T) bytes
+	template <typename T>
+	__m128 LoadElementSse41(const uint8_t* element) {
+		if constexpr (std::is_same_v<T, float>) {
+			return _mm_loadu_ps(reinterpret_cast<const float*>(element));
+		}
+		else if constexpr (sizeof(T) == 1) {
+			int32_t packed;
+			std::memcpy(&packed, element, sizeof(packed));
+			__m128i bytes = _mm_cvtsi32_si128(packed);
+			if constexpr (std::is_signed_v<T>)
+				return _mm_cvtepi32_ps(_mm_cvtepi8_epi32(bytes));
+			else
+				return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(bytes));
+		}
+		else {
+			__m128i shorts = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(element));
+			if constexpr (std::is_signed_v<T>)
+				return _mm_cvtepi32_ps(_mm_cvtepi16_epi32(shorts));
+			else
+				return _mm_cvtepi32_ps(_mm_cvtepu16_epi32(shorts));
+		}
+	}
+
+	// Same for two elements, one per 128-bit lane
+	template <typename T>
+	__m256 LoadElementPairAvx2(const uint8_t* first, const uint8_t* second) {
+		if constexpr (std::is_same_v<T, float>) {
+			__m128 low = _mm_loadu_ps(reinterpret_cast<const float*>(first));
+			return _mm256_insertf128_ps(_mm256_castps128_ps256(low), _mm_loadu_ps(reinterpret_cast<const float*>(second)), 1);
+		}
+		else if constexpr (sizeof(T) == 1) {
+			int32_t packed[2];
+			std::memcpy(&packed[0], first, sizeof(int32_t));
+			std::memcpy(&packed[1], second, sizeof(int32_t));
+			__m128i bytes = _mm_unpacklo_epi32(_mm_cvtsi32_si128(packed[0]), _mm_cvtsi32_si128(packed[1]));
+			if constexpr (std::is_signed_v<T>)
+				return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(bytes));
+			else
+				return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+		}
+		else {
+			__m128i shorts = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(first)),
+				_mm_loadl_epi64(reinterpret_cast<const __m128i*>(second)));
+			if constexpr (std::is_signed_v<T>)
+				return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(shorts));
+			else
+				return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(shorts));
+		}
+	}
+
+	template <typename T, uint32_t N>
+	void ConvertSse41(const uint8_t* source, size_t sourceStride, size_t begin, size_t end, uint8_t* destination,
+		size_t destinationStride, Dequantization dequantization) {
+		const __m128 scale = _mm_set1_ps(dequantization.scale);
+		const __m128 minimum = _mm_set1_ps(dequantization.minimum);
+		for (size_t i = begin; i < end; ++i) {
+			__m128 values = LoadElementSse41<T>(source + i * sourceStride);
+			if constexpr (!std::is_floating_point_v<T>)
+				values = _mm_max_ps(_mm_mul_ps(values, scale), minimum);
+			StoreFloats<N>(destination + i * destinationStride, values);
+		}
+	}
+
+	// Returns the index the remaining (odd) element starts at
+	template <typename T, uint32_t N>
+	size_t ConvertAvx2(const uint8_t* source, size_t sourceStride, size_t begin, size_t end, uint8_t* destination,
+		size_t destinationStride, Dequantization dequantization) {
+		const __m256 scale = _mm256_set1_ps(dequantization.scale);
+		const __m256 minimum = _mm256_set1_ps(dequantization.minimum);
+		size_t i = begin;
+		for (; i + 2 <= end; i += 2) {
+			const uint8_t* element = source + i * sourceStride;
+			__m256 values = LoadElementPairAvx2<T>(element, element + sourceStride);
+			if constexpr (!std::is_floating_point_v<T>)
+				values = _mm256_max_ps(_mm256_mul_ps(values, scale), minimum);
+
+			uint8_t* output = destination + i * destinationStride;
+			StoreFloats<N>(output, _mm256_castps256_ps128(values));
+			StoreFloats<N>(output + destinationStride, _mm256_extractf128_ps(values, 1));
+		}
+		_mm256_zeroupper();
+		return i;
+	}
+
+	template <typename T, uint32_t N>
+	void ConvertElements(const GltfAccessorView& view, uint8_t* destination, size_t destinationStride, SimdLevel level) {
+		const size_t elementSize = view.GetElementSize();
+		if constexpr (std::is_same_v<T, float>) {
+			// Packed floats into packed floats, e.g. a separate position stream
+			if (elementSize == N * sizeof(float) && view.stride == elementSize && destinationStride == elementSize) {
+				std::memcpy(destination, view.data, view.count * elementSize);
+				return;
+			}
+		}
+		// 32-bit integers aren't valid vertex attributes, they only get the scalar kernel
+		if constexpr (std::is_same_v<T, uint32_t>)
+			level = SimdLevel::Scalar;
+
+		const Dequantization dequantization = GetDequantization<T>(view.normalized);
+		const size_t wideCount = level == SimdLevel::Scalar ? 0 : GetWideLoadCount(view.count, view.stride, elementSize, 4 * sizeof(T));
+		size_t converted = 0;
+		if constexpr (!std::is_same_v<T, uint32_t>) {
+			if (level == SimdLevel::AVX2)
+				converted = ConvertAvx2<T, N>(view.data, view.stride, 0, wideCount, destination, destinationStride, dequantization);
+			if (level >= SimdLevel::SSE41) {
+				ConvertSse41<T, N>(view.data, view.stride, converted, wideCount, destination, destinationStride, dequantization);
+				converted = wideCount;
+			}
+		}
+		ConvertScalar<T, N>(view.data, view.stride, converted, view.count, destination, destinationStride, dequantization);
+	}
+
+	template <typename T>
+	void ConvertComponents(const GltfAccessorView& view, uint8_t* destination, size_t destinationStride, uint32_t componentCount,
+		SimdLevel level) {
+		switch (componentCount) {
+		case 1:
+			ConvertElements<T, 1>(view, destination, destinationStride, level);
+			break;
+		case 2:
+			ConvertElements<T, 2>(view, destination, destinationStride, level);
+			break;
+		case 3:
+			ConvertElements<T, 3>(view, destination, destinationStride, level);
+			break;
+		case 4:
+			ConvertElements<T, 4>(view, destination, destinationStride, level);
+			break;
+		}
+	}
+
+	// Packed index conversions, 8 indices per iteration. Returns the index the next kernel resumes at.
+	template <typename Source, typename Destination>
+	size_t ConvertIndicesSse41(const Source* source, Destination* destination, size_t begin, size_t count) {
+		size_t i = begin;
+		for (; i + 8 <= count; i += 8) {
+			const __m128i* input = reinterpret_cast<const __m128i*>(source + i);
+			__m128i* output = reinterpret_cast<__m128i*>(destination + i);
+			if constexpr (sizeof(Source) == 1 && sizeof(Destination) == 4) {
+				__m128i bytes = _mm_loadl_epi64(input);
+				_mm_storeu_si128(output, _mm_cvtepu8_epi32(bytes));
+				_mm_storeu_si128(output + 1, _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4)));
+			}
+			else if constexpr (sizeof(Source) == 2 && sizeof(Destination) == 4) {
+				__m128i shorts = _mm_loadu_si128(input);
+				_mm_storeu_si128(output, _mm_cvtepu16_epi32(shorts));
+				_mm_storeu_si128(output + 1, _mm_cvtepu16_epi32(_mm_srli_si128(shorts, 8)));
+			}
+			else if constexpr (sizeof(Source) == 1 && sizeof(Destination) == 2) {
+				_mm_storeu_si128(output, _mm_cvtepu8_epi16(_mm_loadl_epi64(input)));
+			}
+			else {
+				// Indices below 65536 are positive int32, the unsigned saturation keeps them as is
+				_mm_storeu_si128(output, _mm_packus_epi32(_mm_loadu_si128(input), _mm_loadu_si128(input + 1)));
+			}
+		}
+		return i;
+	}
+
+	// 16 indices per iteration
+	template <typename Source, typename Destination>
+	size_t ConvertIndicesAvx2(const Source* source, Destination* destination, size_t count) {
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			const __m128i* input = reinterpret_cast<const __m128i*>(source + i);
+			__m256i* output = reinterpret_cast<__m256i*>(destination + i);
+			if constexpr (sizeof(Source) == 1 && sizeof(Destination) == 4) {
+				__m128i bytes = _mm_loadu_si128(input);
+				_mm256_storeu_si256(output, _mm256_cvtepu8_epi32(bytes));
+				_mm256_storeu_si256(output + 1, _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+			}
+			else if constexpr (sizeof(Source) == 2 && sizeof(Destination) == 4) {
+				_mm256_storeu_si256(output, _mm256_cvtepu16_epi32(_mm_loadu_si128(input)));
+				_mm256_storeu_si256(output + 1, _mm256_cvtepu16_epi32(_mm_loadu_si128(input + 1)));
+			}
+			else if constexpr (sizeof(Source) == 1 && sizeof(Destination) == 2) {
+				_mm256_storeu_si256(output, _mm256_cvtepu8_epi16(_mm_loadu_si128(input)));
+			}
+			else {
+				// packus works per 128-bit lane, the permute puts the 64-bit groups back in order
+				const __m256i* wideInput = reinterpret_cast<const __m256i*>(source + i);
+				__m256i packed = _mm256_packus_epi32(_mm256_loadu_si256(wideInput), _mm256_loadu_si256(wideInput + 1));
+				_mm256_storeu_si256(output, _mm256_permute4x64_epi64(packed, 0xD8));
+			}
+		}
+		_mm256_zeroupper();
+		return i;
+	}
+
+	template <typename Source, typename Destination>
+	void ConvertPackedIndices(const Source* source, Destination* destination, size_t count, SimdLevel level) {
+		if constexpr (sizeof(Source) == sizeof(Destination)) {
+			std::memcpy(destination, source, count * sizeof(Source));
+		}
+		else {
+			size_t i = 0;
+			if (level == SimdLevel::AVX2)
+				i = ConvertIndicesAvx2(source, destination, count);
+			if (level >= SimdLevel::SSE41)
+				i = ConvertIndicesSse41(source, destination, i, count);
+			for (; i < count; ++i)
+				destination[i] = static_cast<Destination>(source[i]);
+		}
+	}
+
+	template <typename Destination>
+	void ConvertIndexAccessor(const GltfAccessorView& view, Destination* destination, SimdLevel level) {
+		if (view.data == nullptr) {
+			// Accessors without buffer view are all zeros
+			std::fill(destination, destination + view.count, Destination(0));
+			return;
+		}
+		const bool packed = view.stride == view.GetComponentSize();
+		if (!packed) {
+			// Index buffer views can't have a stride in glTF, this only covers invalid files
+			for (size_t i = 0; i < view.count; ++i)
+				destination[i] = static_cast<Destination>(view.ReadIndex(i));
+			return;
+		}
+
+		switch (view.componentType) {
+		case GltfComponentType::UnsignedByte:
+			ConvertPackedIndices(view.data, destination, view.count, level);
+			break;
+		case GltfComponentType::UnsignedShort:
+			ConvertPackedIndices(reinterpret_cast<const uint16_t*>(view.data), destination, view.count, level);
+			break;
+		case GltfComponentType::UnsignedInt:
+			ConvertPackedIndices(reinterpret_cast<const uint32_t*>(view.data), destination, view.count, level);
+			break;
+		default:
+			for (size_t i = 0; i < view.count; ++i)
+				destination[i] = static_cast<Destination>(view.ReadIndex(i));
+			break;
+		}
+	}
+}
+
+void GltfConversion::ConvertToFloats(const GltfAccessorView& view, void* destination, size_t destinationStride, uint32_t componentCount,
+	SimdLevel level) {
+	const uint32_t count = std::min({ componentCount, view.GetComponentCount(), 4u });
+	uint8_t* output = static_cast<uint8_t*>(destination);
+	if (view.data == nullptr) {
+		// Accessors without buffer view are all zeros
+		for (size_t i = 0; i < view.count; ++i)
+			std::memset(output + i * destinationStride, 0, count * sizeof(float));
+		return;
+	}
+
+	switch (view.componentType) {
+	case GltfComponentType::Byte:
+		ConvertComponents<int8_t>(view, output, destinationStride, count, level);
+		break;
+	case GltfComponentType::UnsignedByte:
+		ConvertComponents<uint8_t>(view, output, destinationStride, count, level);
+		break;
+	case GltfComponentType::Short:
+		ConvertComponents<int16_t>(view, output, destinationStride, count, level);
+		break;
+	case GltfComponentType::UnsignedShort:
+		ConvertComponents<uint16_t>(view, output, destinationStride, count, level);
+		break;
+	case GltfComponentType::UnsignedInt:
+		ConvertComponents<uint32_t>(view, output, destinationStride, count, level);
+		break;
+	case GltfComponentType::Float:
+		ConvertComponents<float>(view, output, destinationStride, count, level);
+		break;
+	}
+}
+
+void GltfConversion::ConvertIndices(const GltfAccessorView& view, uint32_t* destination, SimdLevel level) {
+	ConvertIndexAccessor(view, destination, level);
+}
+
+void GltfConversion::ConvertIndices(const GltfAccessorView& view, uint16_t* destination, SimdLevel level) {
+	ConvertIndexAccessor(view, destination, level);
+}
+
+void GltfConversion::Benchmark() {
+	using Clock = std::chrono::high_resolution_clock;
+	constexpr size_t ELEMENT_COUNT = 1 << 18;
+	constexpr int RUN_COUNT = 10;
+	const SimdLevel maxLevel = CpuFeatures::GetSimdLevel();
+
+	// Best of several runs, in seconds
+	auto measure = [](auto&& function) {
+		float best = FLT_MAX;
+		for (int run = 0; run < RUN_COUNT; ++run) {
+			auto start = Clock::now();
+			function();
+			best = std::min(best, std::chrono::duration<float>(Clock::now() - start).count());
+		}
+		return std::max(best, 1e-9f);
+	};
+
+	// Source data read through the different layouts, floats so the float layouts don't hit denormals or NaNs
+	std::vector<float> sourceFloats(ELEMENT_COUNT * 8);
+	for (size_t i = 0; i < sourceFloats.size(); ++i)
+		sourceFloats[i] = static_cast<float>(i % 1000) * 0.001f - 0.5f;
+	const uint8_t* source = reinterpret_cast<const uint8_t*>(sourceFloats.data());
+
+	std::vector<CompleteVertexData> vertices(ELEMENT_COUNT);
+	std::vector<CompleteVertexData> reference(ELEMENT_COUNT);
+
+	struct AttributeLayout {
+		const char* name;
+		GltfComponentType componentType;
+		GltfAccessorType type;
+		bool normalized;
+		size_t stride;
+		size_t destinationOffset;
+		uint32_t componentCount;
+	};
+	const AttributeLayout attributeLayouts[] = {
+		{ "float3 positions", GltfComponentType::Float, GltfAccessorType::Vec3, false, 12, offsetof(CompleteVertexData, vPosition), 3 },
+		{ "float3 normals, 32 B stride", GltfComponentType::Float, GltfAccessorType::Vec3, false, 32, offsetof(CompleteVertexData, vNormal), 3 },
+		{ "unorm16 texcoords", GltfComponentType::UnsignedShort, GltfAccessorType::Vec2, true, 4, offsetof(CompleteVertexData, vTexCoordinate), 2 },
+		{ "unorm8 colors", GltfComponentType::UnsignedByte, GltfAccessorType::Vec4, true, 4, offsetof(CompleteVertexData, vColor), 4 },
+		{ "snorm16 normals", GltfComponentType::Short, GltfAccessorType::Vec3, true, 8, offsetof(CompleteVertexData, vNormal), 3 },
+		{ "snorm8 tangents", GltfComponentType::Byte, GltfAccessorType::Vec4, true, 4, offsetof(CompleteVertexData, vTangent), 3 }
+	};
+
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Accessor conversion benchmark: ", ELEMENT_COUNT, " elements into CompleteVertexData, best of ",
+		RUN_COUNT, " runs, up to ", CpuFeatures::GetSimdLevelName(maxLevel), ".");
+	auto throughput = [](size_t bytes, float seconds) { return static_cast<float>(bytes) / seconds / 1e9f; };
+
+	for (const AttributeLayout& layout : attributeLayouts) {
+		GltfAccessorView view;
+		view.data = source;
+		view.count = ELEMENT_COUNT;
+		view.stride = layout.stride;
+		view.componentType = layout.componentType;
+		view.type = layout.type;
+		view.normalized = layout.normalized;
+		const size_t bytes = ELEMENT_COUNT * (view.GetElementSize() + layout.componentCount * sizeof(float));
+		uint8_t* destination = reinterpret_cast<uint8_t*>(vertices.data()) + layout.destinationOffset;
+
+		std::ostringstream line;
+		line << std::fixed << std::setprecision(2) << "  " << layout.name << ": ReadFloats loop ";
+		float seconds = measure([&]() {
+			for (size_t i = 0; i < ELEMENT_COUNT; ++i)
+				view.ReadFloats(i, reinterpret_cast<float*>(destination + i * sizeof(CompleteVertexData)), layout.componentCount);
+		});
+		line << throughput(bytes, seconds) << " GB/s";
+
+		for (int level = 0; level <= static_cast<int>(maxLevel); ++level) {
+			SimdLevel simdLevel = static_cast<SimdLevel>(level);
+			seconds = measure([&]() { ConvertToFloats(view, destination, sizeof(CompleteVertexData), layout.componentCount, simdLevel); });
+			line << ", " << CpuFeatures::GetSimdLevelName(simdLevel) << " " << throughput(bytes, seconds) << " GB/s";
+
+			// Every level computes the same products, the results must match the scalar kernel bit for bit
+			if (simdLevel == SimdLevel::Scalar)
+				reference = vertices;
+			else if (std::memcmp(reference.data(), vertices.data(), vertices.size() * sizeof(CompleteVertexData)) != 0)
+				line << " (MISMATCH)";
+		}
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, line.str());
+	}
+
+	struct IndexLayout {
+		const char* name;
+		GltfComponentType componentType;
+		bool narrow;
+	};
+	const IndexLayout indexLayouts[] = {
+		{ "u8 -> u32 indices", GltfComponentType::UnsignedByte, false },
+		{ "u16 -> u32 indices", GltfComponentType::UnsignedShort, false },
+		{ "u32 -> u16 indices", GltfComponentType::UnsignedInt, true }
+	};
+
+	// Indices below 65536 so the narrowing is valid
+	std::vector<uint32_t> sourceIndices(ELEMENT_COUNT);
+	for (size_t i = 0; i < ELEMENT_COUNT; ++i)
+		sourceIndices[i] = static_cast<uint32_t>((i * 2654435761u) & 0xFFFF);
+	std::vector<uint32_t> indices(ELEMENT_COUNT);
+	std::vector<uint16_t> shortIndices(ELEMENT_COUNT);
+
+	for (const IndexLayout& layout : indexLayouts) {
+		GltfAccessorView view;
+		view.data = reinterpret_cast<const uint8_t*>(sourceIndices.data());
+		view.count = ELEMENT_COUNT;
+		view.componentType = layout.componentType;
+		view.stride = view.GetComponentSize();
+		const size_t bytes = ELEMENT_COUNT * (view.GetComponentSize() + (layout.narrow ? sizeof(uint16_t) : sizeof(uint32_t)));
+
+		std::ostringstream line;
+		line << std::fixed << std::setprecision(2) << "  " << layout.name << ": ReadIndex loop ";
+		float seconds = measure([&]() {
+			for (size_t i = 0; i < ELEMENT_COUNT; ++i) {
+				if (layout.narrow)
+					shortIndices[i] = static_cast<uint16_t>(view.ReadIndex(i));
+				else
+					indices[i] = view.ReadIndex(i);
+			}
+		});
+		line << throughput(bytes, seconds) << " GB/s";
+
+		for (int level = 0; level <= static_cast<int>(maxLevel); ++level) {
+			SimdLevel simdLevel = static_cast<SimdLevel>(level);
+			seconds = measure([&]() {
+				if (layout.narrow)
+					ConvertIndices(view, shortIndices.data(), simdLevel);
+				else
+					ConvertIndices(view, indices.data(), simdLevel);
+			});
+			line << ", " << CpuFeatures::GetSimdLevelName(simdLevel) << " " << throughput(bytes, seconds) << " GB/s";
+
+			bool matches = true;
+			for (size_t i = 0; i < ELEMENT_COUNT && matches; ++i)
+				matches = (layout.narrow ? shortIndices[i] : indices[i]) == view.ReadIndex(i);
+			if (!matches)
+				line << " (MISMATCH)";
+		}
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, line.str());
+	}
+}
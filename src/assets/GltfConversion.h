@@ -0,0 +1,39 @@
+#ifndef GLTF_CONVERSION_H
+#define GLTF_CONVERSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "GltfAsset.h"
+#include "../utils/CpuFeatures.h"
+
+
+// SIMD kernels converting glTF accessors into engine vertex and index data.
+//
+// A kernel is picked per accessor layout (component type, component count) and SIMD level: SSE4.1
+// converts one element per iteration, AVX2 two, both widening integers with pmovzx/pmovsx and
+// dequantizing normalized ones with a multiply. Elements are gathered from any byte stride and
+// written any stride apart, so pointing the destination at a member of the first vertex interleaves
+// the attribute straight into the vertex structs (e.g. &vertices[0].vTexCoordinate, sizeof(CompleteVertexData)).
+// Wide loads never read past the accessor: the elements near its end go through the scalar kernel.
+// The level defaults to the best the CPU supports, lower ones are used by the benchmark.
+namespace GltfConversion {
+	// Writes the first `componentCount` (up to 4) components of every element as floats, `destinationStride`
+	// bytes apart. Normalized integers are dequantized as glTF specifies (signed ones clamped to -1), other
+	// integers are converted as is. Components the accessor doesn't have are left untouched, so defaults
+	// (e.g. an alpha of 1 for RGB colors) can be written beforehand.
+	void ConvertToFloats(const GltfAccessorView& view, void* destination, size_t destinationStride, uint32_t componentCount,
+		SimdLevel level = CpuFeatures::GetSimdLevel());
+
+	// Widens or copies an index accessor (unsigned byte, short or int scalars) to 32-bit indices
+	void ConvertIndices(const GltfAccessorView& view, uint32_t* destination, SimdLevel level = CpuFeatures::GetSimdLevel());
+	// Same for 16-bit indices, 32-bit ones are narrowed and must all be below 65536
+	void ConvertIndices(const GltfAccessorView& view, uint16_t* destination, SimdLevel level = CpuFeatures::GetSimdLevel());
+
+	// Measures the throughput of the kernels for the common attribute and index layouts at every
+	// supported level, against the per-element GltfAccessorView::ReadFloats loop, and logs it in GB/s
+	// (bytes read plus bytes written per second)
+	void Benchmark();
+}
+
+#endif // !GLTF_CONVERSION_H
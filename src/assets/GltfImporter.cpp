@@ -0,0 +1,393 @@
+#include "GltfImporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <future>
+
+#include "GltfConversion.h"
+#include "../geometry/TangentGenerator.h"
+#include "../utils/ConsoleLogger.h"
+#include "../utils/ThreadPool.h"
+
+
+using namespace DirectX;
+
+namespace {
+	struct PrimitiveInstance {
+		uint32_t mesh;
+		uint32_t primitive;
+		XMFLOAT4X4 worldTransform;
+	};
+
+	std::vector<PrimitiveInstance> CollectPrimitiveInstances(const GltfAsset& asset) {
+		std::vector<PrimitiveInstance> instances;
+		for (const GltfImporter::NodeInstance& nodeInstance : GltfImporter::CollectNodeInstances(asset, asset.GetDefaultScene())) {
+			uint32_t mesh = asset.GetNodes()[nodeInstance.node].mesh;
+			if (mesh == GLTF_INVALID_INDEX)
+				continue;
+			for (uint32_t p = 0; p < asset.GetMeshes()[mesh].primitives.size(); ++p)
+				instances.push_back(PrimitiveInstance{ mesh, p, nodeInstance.worldTransform });
+		}
+		return instances;
+	}
+
+	// Attribute views must have one element per vertex, others are ignored
+	GltfAccessorView GetAttributeView(const GltfAsset& asset, uint32_t accessor, size_t vertexCount, const char* attributeName, const std::string& meshName) {
+		if (accessor == GLTF_INVALID_INDEX)
+			return GltfAccessorView();
+
+		GltfAccessorView view = asset.GetAccessorView(accessor);
+		if (view.count != vertexCount) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "glTF mesh '", meshName, "': the ", attributeName,
+				" attribute doesn't have one element per vertex, it's ignored.");
+			return GltfAccessorView();
+		}
+		if (asset.GetAccessors()[accessor].sparse) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "glTF mesh '", meshName, "': sparse accessors aren't supported, the ",
+				attributeName, " attribute is read without its sparse substitutions.");
+		}
+		return view;
+	}
+
+	// Builds a triangle list from the indices (or the vertex order) of a list, strip or fan
+	bool ReadTriangles(const GltfAsset& asset, const GltfPrimitive& primitive, size_t vertexCount, std::vector<uint32_t>& triangles) {
+		std::vector<uint32_t> indices;
+		if (primitive.indices != GLTF_INVALID_INDEX) {
+			GltfAccessorView view = asset.GetAccessorView(primitive.indices);
+			// Indices without data would all be 0, nothing but degenerate triangles
+			if (view.data == nullptr)
+				return false;
+			indices.resize(view.count);
+			GltfConversion::ConvertIndices(view, indices.data());
+
+			if (std::any_of(indices.begin(), indices.end(), [vertexCount](uint32_t index) { return index >= vertexCount; }))
+				return false;
+		}
+		else {
+			indices.resize(vertexCount);
+			for (size_t i = 0; i < vertexCount; ++i)
+				indices[i] = static_cast<uint32_t>(i);
+		}
+
+		triangles.clear();
+		if (primitive.mode == GltfPrimitiveMode::Triangles) {
+			indices.resize(indices.size() - indices.size() % 3);
+			triangles.swap(indices);
+		}
+		else if (primitive.mode == GltfPrimitiveMode::TriangleStrip) {
+			// Every other triangle of a strip is wound the other way
+			for (size_t i = 2; i < indices.size(); ++i) {
+				bool odd = (i % 2) == 1;
+				triangles.insert(triangles.end(), { indices[i - 2], indices[odd ? i : i - 1], indices[odd ? i - 1 : i] });
+			}
+		}
+		else {
+			for (size_t i = 2; i < indices.size(); ++i)
+				triangles.insert(triangles.end(), { indices[0], indices[i - 1], indices[i] });
+		}
+		return true;
+	}
+
+	// Flat normals need a vertex per corner, the welding pass merges back the corners of coplanar triangles
+	void GenerateFlatNormals(GltfImportedMesh& mesh) {
+		std::vector<CompleteVertexData> vertices;
+		vertices.reserve(mesh.indices.size());
+		for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+			CompleteVertexData corners[3] = { mesh.vertices[mesh.indices[t]], mesh.vertices[mesh.indices[t + 1]], mesh.vertices[mesh.indices[t + 2]] };
+			XMVECTOR p0 = XMLoadFloat3(&corners[0].vPosition);
+			// Clockwise front faces in a left handed space
+			XMVECTOR normal = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&corners[1].vPosition), p0),
+				XMVectorSubtract(XMLoadFloat3(&corners[2].vPosition), p0)));
+			for (CompleteVertexData& corner : corners) {
+				XMStoreFloat3(&corner.vNormal, normal);
+				vertices.push_back(corner);
+			}
+		}
+
+		mesh.vertices.swap(vertices);
+		for (size_t i = 0; i < mesh.indices.size(); ++i)
+			mesh.indices[i] = static_cast<uint32_t>(i);
+	}
+}
+
+std::vector<GltfImporter::NodeInstance> GltfImporter::CollectNodeInstances(const GltfAsset& asset, uint32_t scene) {
+	const std::vector<GltfNode>& nodes = asset.GetNodes();
+
+	std::vector<uint32_t> roots;
+	if (scene < asset.GetScenes().size()) {
+		roots = asset.GetScenes()[scene].nodes;
+	}
+	else {
+		// Files without scenes: every node that isn't a child is a root
+		std::vector<bool> isChild(nodes.size(), false);
+		for (const GltfNode& node : nodes) {
+			for (uint32_t child : node.children)
+				isChild[child] = true;
+		}
+		for (uint32_t n = 0; n < nodes.size(); ++n) {
+			if (!isChild[n])
+				roots.push_back(n);
+		}
+	}
+
+	std::vector<NodeInstance> instances;
+	// glTF nodes form strict trees, a node reached twice means a malformed hierarchy (or a cycle)
+	std::vector<bool> visited(nodes.size(), false);
+	std::vector<NodeInstance> stack;
+	for (auto it = roots.rbegin(); it != roots.rend(); ++it)
+		stack.push_back(NodeInstance{ *it, nodes[*it].localTransform });
+
+	while (!stack.empty()) {
+		NodeInstance instance = stack.back();
+		stack.pop_back();
+		if (visited[instance.node]) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "glTF node '", nodes[instance.node].name,
+				"' has several parents, only its first instance is kept.");
+			continue;
+		}
+		visited[instance.node] = true;
+		instances.push_back(instance);
+
+		XMMATRIX worldTransform = XMLoadFloat4x4(&instance.worldTransform);
+		const std::vector<uint32_t>& children = nodes[instance.node].children;
+		for (auto it = children.rbegin(); it != children.rend(); ++it) {
+			NodeInstance child{ *it, {} };
+			XMStoreFloat4x4(&child.worldTransform, XMLoadFloat4x4(&nodes[*it].localTransform) * worldTransform);
+			stack.push_back(child);
+		}
+	}
+	return instances;
+}
+
+bool GltfImporter::ConvertPrimitive(const GltfAsset& asset, const GltfPrimitive& primitive, FXMMATRIX worldTransform, GltfImportedMesh& mesh) {
+	if (primitive.mode != GltfPrimitiveMode::Triangles && primitive.mode != GltfPrimitiveMode::TriangleStrip &&
+		primitive.mode != GltfPrimitiveMode::TriangleFan) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "glTF mesh '", mesh.name, "': point and line primitives aren't supported.");
+		return false;
+	}
+	if (primitive.position == GLTF_INVALID_INDEX) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "glTF mesh '", mesh.name, "': a primitive has no POSITION attribute.");
+		return false;
+	}
+
+	GltfAccessorView positions = asset.GetAccessorView(primitive.position);
+	const size_t vertexCount = positions.count;
+	if (vertexCount == 0) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "glTF mesh '", mesh.name, "': a primitive has no vertices.");
+		return false;
+	}
+	GltfAccessorView normals = GetAttributeView(asset, primitive.normal, vertexCount, "NORMAL", mesh.name);
+	GltfAccessorView tangents = GetAttributeView(asset, primitive.tangent, vertexCount, "TANGENT", mesh.name);
+	GltfAccessorView texCoords = GetAttributeView(asset, primitive.texCoord0, vertexCount, "TEXCOORD_0", mesh.name);
+	GltfAccessorView colors = GetAttributeView(asset, primitive.color0, vertexCount, "COLOR_0", mesh.name);
+	const bool hasNormals = normals.count != 0;
+	const bool hasTangents = hasNormals && tangents.count != 0;
+
+	// glTF space to the engine's: the node transform, then Z negated for the left handed convention
+	XMMATRIX transform = worldTransform * XMMatrixScaling(1.0f, 1.0f, -1.0f);
+	XMMATRIX normalTransform = XMMatrixTranspose(XMMatrixInverse(nullptr, transform));
+	const bool flipWinding = XMVectorGetX(XMMatrixDeterminant(transform)) < 0.0f;
+
+	mesh.material = primitive.material;
+	mesh.hasTangents = hasTangents;
+	// Attributes are converted by the SIMD kernels straight into the vertex structs (zeroed by resize),
+	// then the transforms run over them in place with the DirectXMath stream functions
+	mesh.vertices.resize(vertexCount);
+	CompleteVertexData* vertices = mesh.vertices.data();
+	const size_t vertexStride = sizeof(CompleteVertexData);
+	GltfConversion::ConvertToFloats(positions, &vertices[0].vPosition, vertexStride, 3);
+	if (hasNormals)
+		GltfConversion::ConvertToFloats(normals, &vertices[0].vNormal, vertexStride, 3);
+	if (texCoords.count != 0)
+		GltfConversion::ConvertToFloats(texCoords, &vertices[0].vTexCoordinate, vertexStride, 2);
+
+	// RGB colors keep the default alpha
+	for (size_t v = 0; v < vertexCount; ++v)
+		vertices[v].vColor = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	if (colors.count != 0)
+		GltfConversion::ConvertToFloats(colors, &vertices[0].vColor, vertexStride, 4);
+
+	if (hasTangents) {
+		// The bitangent is built in glTF space, where the handedness in w applies, then transformed like the tangent
+		std::vector<XMFLOAT4> tangentData(vertexCount, XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f));
+		GltfConversion::ConvertToFloats(tangents, tangentData.data(), sizeof(XMFLOAT4), 4);
+		for (size_t v = 0; v < vertexCount; ++v) {
+			XMVECTOR tangent = XMLoadFloat4(&tangentData[v]);
+			XMVECTOR bitangent = XMVector3Cross(XMLoadFloat3(&vertices[v].vNormal), tangent);
+			XMStoreFloat3(&vertices[v].vTangent, tangent);
+			XMStoreFloat3(&vertices[v].vBitangent, XMVectorScale(bitangent, tangentData[v].w < 0.0f ? -1.0f : 1.0f));
+		}
+		XMVector3TransformNormalStream(&vertices[0].vTangent, vertexStride, &vertices[0].vTangent, vertexStride, vertexCount, transform);
+		XMVector3TransformNormalStream(&vertices[0].vBitangent, vertexStride, &vertices[0].vBitangent, vertexStride, vertexCount, transform);
+	}
+
+	XMVector3TransformCoordStream(&vertices[0].vPosition, vertexStride, &vertices[0].vPosition, vertexStride, vertexCount, transform);
+	if (hasNormals)
+		XMVector3TransformNormalStream(&vertices[0].vNormal, vertexStride, &vertices[0].vNormal, vertexStride, vertexCount, normalTransform);
+	for (size_t v = 0; v < vertexCount && (hasNormals || hasTangents); ++v) {
+		CompleteVertexData& vertex = vertices[v];
+		XMStoreFloat3(&vertex.vNormal, XMVector3Normalize(XMLoadFloat3(&vertex.vNormal)));
+		if (hasTangents) {
+			XMStoreFloat3(&vertex.vTangent, XMVector3Normalize(XMLoadFloat3(&vertex.vTangent)));
+			XMStoreFloat3(&vertex.vBitangent, XMVector3Normalize(XMLoadFloat3(&vertex.vBitangent)));
+		}
+	}
+
+	if (!ReadTriangles(asset, primitive, vertexCount, mesh.indices)) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "glTF mesh '", mesh.name, "': a primitive has missing or out of range indices.");
+		mesh.vertices.clear();
+		return false;
+	}
+	if (flipWinding) {
+		for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+			std::swap(mesh.indices[t + 1], mesh.indices[t + 2]);
+	}
+
+	if (!hasNormals)
+		GenerateFlatNormals(mesh);
+	return true;
+}
+
+void GltfImporter::ProcessMesh(GltfImportedMesh& mesh, const GltfImportSettings& settings) {
+	if (settings.weldVertices)
+		VertexWelder::WeldVertices(mesh.vertices, mesh.indices, settings.weldSettings);
+
+	if (settings.generateTangents && !mesh.hasTangents) {
+		TangentGenerator::GenerateTangents(mesh.vertices, mesh.indices);
+		mesh.hasTangents = true;
+	}
+
+	if (settings.optimize)
+		mesh.optimizationReport = MeshOptimizer::OptimizeMesh(mesh.vertices, mesh.indices, settings.optimizationSettings);
+}
+
+bool GltfImporter::ImportScene(const GltfAsset& asset, ThreadPool& threadPool, const GltfImportSettings& settings,
+	std::vector<GltfImportedMesh>& meshes) {
+	std::vector<PrimitiveInstance> instances = CollectPrimitiveInstances(asset);
+	meshes.clear();
+	meshes.resize(instances.size());
+
+	std::vector<std::future<bool>> results;
+	results.reserve(instances.size());
+	for (size_t i = 0; i < instances.size(); ++i) {
+		const PrimitiveInstance& instance = instances[i];
+		GltfImportedMesh& mesh = meshes[i];
+		mesh.name = asset.GetMeshes()[instance.mesh].name + "[" + std::to_string(instance.primitive) + "]";
+
+		results.push_back(threadPool.Submit([&asset, &instance, &mesh, &settings]() {
+			const GltfPrimitive& primitive = asset.GetMeshes()[instance.mesh].primitives[instance.primitive];
+			if (!ConvertPrimitive(asset, primitive, XMLoadFloat4x4(&instance.worldTransform), mesh))
+				return false;
+			ProcessMesh(mesh, settings);
+			return true;
+		}));
+	}
+
+	// Primitives that failed to convert were logged, they're dropped
+	std::vector<GltfImportedMesh> importedMeshes;
+	importedMeshes.reserve(meshes.size());
+	for (size_t i = 0; i < results.size(); ++i) {
+		if (results[i].get())
+			importedMeshes.push_back(std::move(meshes[i]));
+	}
+	meshes.swap(importedMeshes);
+
+	if (meshes.empty()) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "glTF file ", asset.GetFilePath(), " has no mesh to import.");
+		return false;
+	}
+	return true;
+}
+
+void GltfImporter::Benchmark(const std::string& filePath, ThreadPool& threadPool) {
+	using Clock = std::chrono::high_resolution_clock;
+	auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); };
+
+	// JSON parsing, buffer mapping and decoding of the compressed views, the other buffers are paged in by the conversion
+	auto start = Clock::now();
+	GltfAsset asset;
+	if (!asset.Load(filePath, &threadPool)) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "glTF import benchmark of ", filePath, " aborted: the file failed to load.");
+		return;
+	}
+	float loadMs = elapsedMs(start);
+
+	GltfImportSettings conversionOnly;
+	conversionOnly.weldVertices = false;
+	conversionOnly.generateTangents = false;
+	conversionOnly.optimize = false;
+
+	start = Clock::now();
+	std::vector<GltfImportedMesh> meshes;
+	if (!GltfImporter::ImportScene(asset, threadPool, conversionOnly, meshes))
+		return;
+	float conversionMs = elapsedMs(start);
+
+	size_t convertedVertices = 0;
+	size_t triangleCount = 0;
+	for (const GltfImportedMesh& mesh : meshes) {
+		convertedVertices += mesh.vertices.size();
+		triangleCount += mesh.indices.size() / 3;
+	}
+
+	GltfImportSettings settings;
+	start = Clock::now();
+	threadPool.ParallelFor(meshes.size(), 1, [&meshes, &settings](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			VertexWelder::WeldVertices(meshes[i].vertices, meshes[i].indices, settings.weldSettings);
+	});
+	float weldMs = elapsedMs(start);
+
+	size_t weldedVertices = 0;
+	std::vector<TangentMesh> tangentMeshes;
+	std::vector<TangentMesh> missingTangents;
+	for (GltfImportedMesh& mesh : meshes) {
+		weldedVertices += mesh.vertices.size();
+		tangentMeshes.push_back(TangentMesh{ &mesh.vertices, &mesh.indices });
+		if (!mesh.hasTangents)
+			missingTangents.push_back(TangentMesh{ &mesh.vertices, &mesh.indices });
+	}
+
+	// Generation over every primitive compares one thread with the pool, the import only runs it where tangents are missing
+	TangentGenerator::Benchmark(tangentMeshes.data(), tangentMeshes.size(), threadPool);
+	start = Clock::now();
+	TangentGenerator::GenerateTangents(missingTangents.data(), missingTangents.size(), threadPool);
+	float tangentMs = elapsedMs(start);
+
+	start = Clock::now();
+	threadPool.ParallelFor(meshes.size(), 1, [&meshes, &settings](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			meshes[i].optimizationReport = MeshOptimizer::OptimizeMesh(meshes[i].vertices, meshes[i].indices, settings.optimizationSettings);
+	});
+	float optimizationMs = elapsedMs(start);
+
+	// Whole scene statistics, weighted by the triangles and vertices of every primitive
+	MeshOptimizationReport sceneReport;
+	for (const GltfImportedMesh& mesh : meshes) {
+		sceneReport.before.vertexTransforms += mesh.optimizationReport.before.vertexTransforms;
+		sceneReport.after.vertexTransforms += mesh.optimizationReport.after.vertexTransforms;
+		sceneReport.vertexCountBefore += mesh.optimizationReport.vertexCountBefore;
+		sceneReport.vertexCountAfter += mesh.optimizationReport.vertexCountAfter;
+	}
+	sceneReport.before.acmr = static_cast<float>(sceneReport.before.vertexTransforms) / std::max<size_t>(triangleCount, 1);
+	sceneReport.after.acmr = static_cast<float>(sceneReport.after.vertexTransforms) / std::max<size_t>(triangleCount, 1);
+	sceneReport.before.atvr = static_cast<float>(sceneReport.before.vertexTransforms) / std::max<size_t>(sceneReport.vertexCountBefore, 1);
+	sceneReport.after.atvr = static_cast<float>(sceneReport.after.vertexTransforms) / std::max<size_t>(sceneReport.vertexCountAfter, 1);
+
+	size_t bufferBytes = 0;
+	for (const GltfBuffer& buffer : asset.GetBuffers())
+		bufferBytes += buffer.byteLength;
+	float totalMs = loadMs + conversionMs + weldMs + tangentMs + optimizationMs;
+
+	std::string fileName = std::filesystem::path(filePath).filename().string();
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "glTF import benchmark of ", fileName, ": ", meshes.size(), " primitives, ",
+		convertedVertices, " vertices, ", triangleCount, " triangles, ", bufferBytes / 1024, " KB of buffers, ",
+		threadPool.GetThreadCount(), " workers.");
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "  load (JSON + mapping + ", asset.GetCompressedBufferViews().size(),
+		" compressed views): ", loadMs, " ms, conversion: ", conversionMs, " ms (",
+		bufferBytes / 1048576.0f / std::max(conversionMs / 1000.0f, 1e-6f), " MB/s), welding: ", weldMs, " ms (", convertedVertices, " -> ",
+		weldedVertices, " vertices), tangents: ", tangentMs, " ms (", missingTangents.size(), " primitives without tangents), optimization: ",
+		optimizationMs, " ms, total: ", totalMs, " ms.");
+	MeshOptimizer::LogReport(fileName.c_str(), sceneReport);
+}
@@ -0,0 +1,67 @@
+#ifndef GLTF_IMPORTER_H
+#define GLTF_IMPORTER_H
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GltfAsset.h"
+#include "../geometry/MeshOptimizer.h"
+#include "../geometry/VertexWelder.h"
+#include "../graphics/VertexFormat.h"
+
+class ThreadPool;
+
+
+struct GltfImportSettings {
+	// Merges the vertices exporters duplicate (VertexWelder)
+	bool weldVertices = true;
+	WeldSettings weldSettings;
+	// Generates tangents for the primitives that don't have any (TangentGenerator)
+	bool generateTangents = true;
+	// Vertex cache, overdraw and vertex fetch passes (MeshOptimizer)
+	bool optimize = true;
+	MeshOptimizationSettings optimizationSettings;
+};
+
+// A primitive instance of a scene in the engine vertex format, in world space
+struct GltfImportedMesh {
+	std::string name;
+	uint32_t material = GLTF_INVALID_INDEX;
+	std::vector<CompleteVertexData> vertices;
+	std::vector<uint32_t> indices;
+	bool hasTangents = false;  // False if the primitive had no TANGENT attribute and none were generated yet
+	MeshOptimizationReport optimizationReport;
+};
+
+// Conversion of glTF scenes into engine meshes.
+//
+// glTF is right handed with counter clockwise front faces, the engine is left handed with clockwise front
+// faces: Z is negated on positions, normals and tangents, and the triangle winding follows the sign of the
+// final transform, so the faces stay front facing (mirroring node transforms included).
+namespace GltfImporter {
+	// World transform of every node instance of a scene (row vectors, glTF space), in depth first order
+	struct NodeInstance {
+		uint32_t node;
+		DirectX::XMFLOAT4X4 worldTransform;
+	};
+	std::vector<NodeInstance> CollectNodeInstances(const GltfAsset& asset, uint32_t scene);
+
+	// Converts a triangle primitive (list, strip or fan) into `mesh`, with `worldTransform` applied.
+	// Primitives without normals get flat normals as the glTF specification requires.
+	// Logs and returns false for primitives that can't be drawn as triangles.
+	bool ConvertPrimitive(const GltfAsset& asset, const GltfPrimitive& primitive, DirectX::FXMMATRIX worldTransform, GltfImportedMesh& mesh);
+
+	// Runs the optional passes of the settings on a converted mesh
+	void ProcessMesh(GltfImportedMesh& mesh, const GltfImportSettings& settings);
+
+	// Converts and processes every primitive instance of the default scene, one task per primitive on the pool
+	bool ImportScene(const GltfAsset& asset, ThreadPool& threadPool, const GltfImportSettings& settings, std::vector<GltfImportedMesh>& meshes);
+
+	// Loads a glTF file and times every import stage on its own (loading, conversion, welding, tangents,
+	// optimization), then logs the timings with the welding, tangent and optimization reports
+	void Benchmark(const std::string& filePath, ThreadPool& threadPool);
+}
+
+#endif // !GLTF_IMPORTER_H
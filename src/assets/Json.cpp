@@ -0,0 +1,451 @@
+#include "Json.h"
+
+#include <charconv>
+#include <cstring>
+
+
+namespace {
+	enum class Expect : uint8_t {
+		Value,
+		ValueOrEnd,  // First element of an array
+		Key,
+		KeyOrEnd,    // First member of an object
+		Colon,
+		CommaOrEnd,
+		Nothing      // The root value is complete, only whitespace may follow
+	};
+
+	bool IsWhitespace(char c) {
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+
+	bool IsDigit(char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	int HexValue(char c) {
+		if (c >= '0' && c <= '9')
+			return c - '0';
+		if (c >= 'a' && c <= 'f')
+			return c - 'a' + 10;
+		if (c >= 'A' && c <= 'F')
+			return c - 'A' + 10;
+		return -1;
+	}
+
+	// Returns the end of the number starting at `position`, or `position` if it isn't a valid JSON number
+	size_t ScanNumber(const char* text, size_t position, size_t size) {
+		size_t i = position;
+		if (i < size && text[i] == '-')
+			++i;
+		if (i >= size || !IsDigit(text[i]))
+			return position;
+		if (text[i] == '0') {
+			++i;
+		}
+		else {
+			while (i < size && IsDigit(text[i]))
+				++i;
+		}
+
+		if (i < size && text[i] == '.') {
+			++i;
+			if (i >= size || !IsDigit(text[i]))
+				return position;
+			while (i < size && IsDigit(text[i]))
+				++i;
+		}
+
+		if (i < size && (text[i] == 'e' || text[i] == 'E')) {
+			++i;
+			if (i < size && (text[i] == '+' || text[i] == '-'))
+				++i;
+			if (i >= size || !IsDigit(text[i]))
+				return position;
+			while (i < size && IsDigit(text[i]))
+				++i;
+		}
+		return i;
+	}
+
+	void AppendUtf8(std::string& output, uint32_t codePoint) {
+		if (codePoint < 0x80) {
+			output += static_cast<char>(codePoint);
+		}
+		else if (codePoint < 0x800) {
+			output += static_cast<char>(0xC0 | (codePoint >> 6));
+			output += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000) {
+			output += static_cast<char>(0xE0 | (codePoint >> 12));
+			output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			output += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		else {
+			output += static_cast<char>(0xF0 | (codePoint >> 18));
+			output += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			output += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	uint32_t ReadHex4(const char* text) {
+		uint32_t value = 0;
+		for (int i = 0; i < 4; ++i)
+			value = (value << 4) | static_cast<uint32_t>(HexValue(text[i]));
+		return value;
+	}
+}
+
+bool JsonDocument::Parse(const char* text, size_t size) {
+	m_text = text;
+	m_size = size;
+	m_tokens.clear();
+	m_error.clear();
+
+	if (size >= UINT32_MAX)
+		return Fail("the text is larger than 4 GB", 0);
+
+	// Rough guess of one value every 16 characters, so big files don't grow the array too many times
+	m_tokens.reserve(size / 16 + 16);
+	// Containers still open, it only grows with the nesting depth
+	std::vector<uint32_t> openContainers;
+	openContainers.reserve(32);
+
+	Expect expect = Expect::Value;
+	size_t position = 0;
+
+	// Counts a new value in its parent array, members are counted on their keys
+	auto addValue = [this, &openContainers](JsonType type, size_t start, size_t length) {
+		if (!openContainers.empty() && m_tokens[openContainers.back()].type == JsonType::Array)
+			m_tokens[openContainers.back()].size++;
+		uint32_t index = static_cast<uint32_t>(m_tokens.size());
+		m_tokens.push_back(JsonToken{ static_cast<uint32_t>(start), static_cast<uint32_t>(length), 0, index + 1, type, false });
+	};
+	auto afterValue = [&openContainers, &expect]() {
+		expect = openContainers.empty() ? Expect::Nothing : Expect::CommaOrEnd;
+	};
+
+	while (position < size) {
+		const char c = text[position];
+		if (IsWhitespace(c)) {
+			++position;
+			continue;
+		}
+		if (expect == Expect::Nothing)
+			return Fail("unexpected content after the root value", position);
+
+		const bool expectsValue = expect == Expect::Value || expect == Expect::ValueOrEnd;
+		switch (c) {
+		case '{':
+		case '[': {
+			if (!expectsValue)
+				return Fail("unexpected container", position);
+			addValue(c == '{' ? JsonType::Object : JsonType::Array, position, 0);
+			openContainers.push_back(static_cast<uint32_t>(m_tokens.size() - 1));
+			expect = c == '{' ? Expect::KeyOrEnd : Expect::ValueOrEnd;
+			++position;
+			break;
+		}
+		case '}':
+		case ']': {
+			JsonType closedType = c == '}' ? JsonType::Object : JsonType::Array;
+			bool canClose = expect == Expect::CommaOrEnd || (closedType == JsonType::Object ? expect == Expect::KeyOrEnd : expect == Expect::ValueOrEnd);
+			if (!canClose || openContainers.empty() || m_tokens[openContainers.back()].type != closedType)
+				return Fail(c == '}' ? "unexpected '}'" : "unexpected ']'", position);
+
+			JsonToken& container = m_tokens[openContainers.back()];
+			container.length = static_cast<uint32_t>(position + 1 - container.start);
+			container.next = static_cast<uint32_t>(m_tokens.size());
+			openContainers.pop_back();
+			++position;
+			afterValue();
+			break;
+		}
+		case ',': {
+			if (expect != Expect::CommaOrEnd)
+				return Fail("unexpected ','", position);
+			expect = m_tokens[openContainers.back()].type == JsonType::Object ? Expect::Key : Expect::Value;
+			++position;
+			break;
+		}
+		case ':': {
+			if (expect != Expect::Colon)
+				return Fail("unexpected ':'", position);
+			expect = Expect::Value;
+			++position;
+			break;
+		}
+		case '"': {
+			const bool isKey = expect == Expect::Key || expect == Expect::KeyOrEnd;
+			if (!isKey && !expectsValue)
+				return Fail("unexpected string", position);
+
+			size_t start = position + 1;
+			size_t end = start;
+			bool escaped = false;
+			while (end < size && text[end] != '"') {
+				if (static_cast<unsigned char>(text[end]) < 0x20)
+					return Fail("control character in a string", end);
+				if (text[end] == '\\') {
+					escaped = true;
+					if (end + 1 >= size) {
+						end = size;
+						break;
+					}
+					char escape = text[end + 1];
+					if (escape == 'u') {
+						if (end + 5 >= size || HexValue(text[end + 2]) < 0 || HexValue(text[end + 3]) < 0 ||
+							HexValue(text[end + 4]) < 0 || HexValue(text[end + 5]) < 0)
+							return Fail("invalid \\u escape sequence", end);
+						end += 6;
+						continue;
+					}
+					if (std::strchr("\"\\/bfnrt", escape) == nullptr || escape == '\0')
+						return Fail("invalid escape sequence", end);
+					end += 2;
+					continue;
+				}
+				++end;
+			}
+			if (end >= size)
+				return Fail("unterminated string", position);
+
+			if (isKey) {
+				m_tokens[openContainers.back()].size++;
+				uint32_t index = static_cast<uint32_t>(m_tokens.size());
+				m_tokens.push_back(JsonToken{ static_cast<uint32_t>(start), static_cast<uint32_t>(end - start), 0, index + 1, JsonType::String, escaped });
+				expect = Expect::Colon;
+			}
+			else {
+				addValue(JsonType::String, start, end - start);
+				m_tokens.back().escaped = escaped;
+				afterValue();
+			}
+			position = end + 1;
+			break;
+		}
+		case 't':
+		case 'f':
+		case 'n': {
+			if (!expectsValue)
+				return Fail("unexpected literal", position);
+			const char* literal = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+			size_t length = std::strlen(literal);
+			if (size - position < length || std::memcmp(text + position, literal, length) != 0)
+				return Fail("invalid literal", position);
+			addValue(c == 'n' ? JsonType::Null : JsonType::Bool, position, length);
+			position += length;
+			afterValue();
+			break;
+		}
+		default: {
+			if (!expectsValue)
+				return Fail("unexpected character", position);
+			size_t end = ScanNumber(text, position, size);
+			if (end == position)
+				return Fail("invalid value", position);
+			addValue(JsonType::Number, position, end - position);
+			position = end;
+			afterValue();
+			break;
+		}
+		}
+	}
+
+	if (expect != Expect::Nothing)
+		return Fail(m_tokens.empty() ? "empty document" : "unexpected end of the document", size);
+	return true;
+}
+
+JsonValue JsonDocument::GetRoot() const {
+	return m_tokens.empty() ? JsonValue() : JsonValue(this, 0);
+}
+
+bool JsonDocument::Fail(const char* message, size_t offset) {
+	size_t line = 1;
+	size_t column = 1;
+	for (size_t i = 0; i < offset && i < m_size; ++i) {
+		if (m_text[i] == '\n') {
+			line++;
+			column = 1;
+		}
+		else {
+			column++;
+		}
+	}
+
+	m_error = std::string(message) + " at line " + std::to_string(line) + ", column " + std::to_string(column);
+	m_tokens.clear();
+	return false;
+}
+
+JsonValue::Iterator& JsonValue::Iterator::operator++() {
+	const std::vector<JsonToken>& tokens = m_document->GetTokens();
+	m_token = m_members ? tokens[m_token + 1].next : tokens[m_token].next;
+	return *this;
+}
+
+std::string_view JsonValue::Iterator::GetKey() const {
+	return m_members ? JsonValue(m_document, m_token).GetRawString() : std::string_view();
+}
+
+size_t JsonValue::Size() const {
+	if (!IsArray() && !IsObject())
+		return 0;
+	return GetToken().size;
+}
+
+JsonValue JsonValue::operator[](const char* key) const {
+	return (*this)[std::string_view(key)];
+}
+
+JsonValue JsonValue::operator[](std::string_view key) const {
+	if (!IsObject())
+		return JsonValue();
+
+	for (Iterator it = begin(), last = end(); it != last; ++it) {
+		// Keys are the tokens right before the values
+		JsonValue value = *it;
+		if (JsonValue(m_document, value.m_token - 1).StringEquals(key))
+			return value;
+	}
+	return JsonValue();
+}
+
+JsonValue JsonValue::operator[](size_t index) const {
+	if (!IsArray() || index >= GetToken().size)
+		return JsonValue();
+
+	Iterator it = begin();
+	for (size_t i = 0; i < index; ++i)
+		++it;
+	return *it;
+}
+
+JsonValue::Iterator JsonValue::begin() const {
+	if (!IsArray() && !IsObject())
+		return end();
+	return Iterator(m_document, m_token + 1, GetToken().type == JsonType::Object);
+}
+
+JsonValue::Iterator JsonValue::end() const {
+	if (!IsValid())
+		return Iterator(nullptr, 0, false);
+	return Iterator(m_document, GetToken().next, GetToken().type == JsonType::Object);
+}
+
+bool JsonValue::GetBool(bool defaultValue) const {
+	if (!IsBool())
+		return defaultValue;
+	return m_document->GetText()[GetToken().start] == 't';
+}
+
+double JsonValue::GetDouble(double defaultValue) const {
+	if (!IsNumber())
+		return defaultValue;
+
+	const char* first = m_document->GetText() + GetToken().start;
+	double value = defaultValue;
+	std::from_chars_result result = std::from_chars(first, first + GetToken().length, value);
+	return result.ec == std::errc() ? value : defaultValue;
+}
+
+int64_t JsonValue::GetInt(int64_t defaultValue) const {
+	if (!IsNumber())
+		return defaultValue;
+
+	const char* first = m_document->GetText() + GetToken().start;
+	const char* last = first + GetToken().length;
+	int64_t value = 0;
+	std::from_chars_result result = std::from_chars(first, last, value);
+	if (result.ec == std::errc() && result.ptr == last)
+		return value;
+
+	// Written with a fraction or an exponent ("2.0", "1e3")
+	double number = GetDouble(static_cast<double>(defaultValue));
+	if (!(number >= -9.2e18 && number <= 9.2e18))
+		return defaultValue;
+	return static_cast<int64_t>(number);
+}
+
+uint32_t JsonValue::GetUInt(uint32_t defaultValue) const {
+	int64_t value = GetInt(-1);
+	if (value < 0 || value > static_cast<int64_t>(UINT32_MAX))
+		return defaultValue;
+	return static_cast<uint32_t>(value);
+}
+
+size_t JsonValue::GetSize(size_t defaultValue) const {
+	int64_t value = GetInt(-1);
+	if (value < 0)
+		return defaultValue;
+	return static_cast<size_t>(value);
+}
+
+std::string_view JsonValue::GetRawString() const {
+	if (!IsString())
+		return std::string_view();
+	return std::string_view(m_document->GetText() + GetToken().start, GetToken().length);
+}
+
+std::string JsonValue::GetString(const std::string& defaultValue) const {
+	if (!IsString())
+		return defaultValue;
+
+	std::string_view raw = GetRawString();
+	if (!GetToken().escaped)
+		return std::string(raw);
+
+	// The escape sequences were validated by the parser
+	std::string output;
+	output.reserve(raw.size());
+	for (size_t i = 0; i < raw.size(); ++i) {
+		if (raw[i] != '\\') {
+			output += raw[i];
+			continue;
+		}
+
+		char escape = raw[++i];
+		switch (escape) {
+		case 'b': output += '\b'; break;
+		case 'f': output += '\f'; break;
+		case 'n': output += '\n'; break;
+		case 'r': output += '\r'; break;
+		case 't': output += '\t'; break;
+		case 'u': {
+			uint32_t codePoint = ReadHex4(&raw[i + 1]);
+			i += 4;
+			// Characters outside of the BMP are written as UTF-16 surrogate pairs
+			if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 6 < raw.size() && raw.substr(i + 1, 2) == "\\u") {
+				uint32_t low = ReadHex4(&raw[i + 3]);
+				if (low >= 0xDC00 && low < 0xE000) {
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					i += 6;
+				}
+			}
+			AppendUtf8(output, codePoint);
+			break;
+		}
+		default:
+			output += escape;  // '"', '\\' and '/'
+			break;
+		}
+	}
+	return output;
+}
+
+bool JsonValue::StringEquals(std::string_view value) const {
+	if (!IsString())
+		return false;
+	if (!GetToken().escaped)
+		return GetRawString() == value;
+	return GetString() == value;
+}
+
+size_t JsonValue::GetFloats(float* values, size_t count) const {
+	size_t read = 0;
+	for (Iterator it = begin(), last = end(); it != last && read < count; ++it, ++read)
+		values[read] = (*it).GetFloat(values[read]);
+	return read;
+}
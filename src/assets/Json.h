@@ -0,0 +1,133 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// Minimal JSON reader for asset files (glTF and the like).
+//
+// Parsing is a single pass over the text that fills one flat array of tokens, one per value, in
+// document order. Containers store the index of the token that follows their last child, so a value
+// and everything under it can be skipped in O(1). Nothing is allocated per value: strings and numbers
+// stay in the source text and are only decoded when read, through JsonValue.
+// The text must outlive the document, it can be a memory mapped file.
+
+enum class JsonType : uint8_t {
+	Null,
+	Bool,
+	Number,
+	String,
+	Array,
+	Object
+};
+
+struct JsonToken {
+	uint32_t start;   // Offset of the value in the text, after the opening quote for strings
+	uint32_t length;  // Length of the value in the text, without the quotes for strings
+	uint32_t size;    // Number of elements of an array or members of an object
+	uint32_t next;    // Index of the token that follows this value and all its children
+	JsonType type;
+	bool escaped;     // String with escape sequences, it can't be used as is
+};
+
+class JsonValue;
+
+class JsonDocument {
+	public:
+		// Parses `size` bytes of text, the text must stay alive as long as the document is used.
+		// Returns false on malformed JSON, GetError tells what and where.
+		bool Parse(const char* text, size_t size);
+
+		JsonValue GetRoot() const;
+
+		const char* GetText() const { return m_text; }
+		const std::vector<JsonToken>& GetTokens() const { return m_tokens; }
+		const std::string& GetError() const { return m_error; }
+
+	private:
+		bool Fail(const char* message, size_t offset);
+
+	private:
+		const char* m_text = nullptr;
+		size_t m_size = 0;
+		std::vector<JsonToken> m_tokens;
+		std::string m_error;
+};
+
+// Handle to a value of a JsonDocument. Lookups that fail (missing member, out of range index, wrong
+// type) return an invalid value whose getters return the given defaults, so optional members read as:
+//     float cutoff = material["alphaCutoff"].GetFloat(0.5f);
+class JsonValue {
+	public:
+		// Iterates the elements of an array, or the values of the members of an object
+		class Iterator {
+			public:
+				Iterator(const JsonDocument* document, uint32_t token, bool members) : m_document(document), m_token(token), m_members(members) {}
+
+				JsonValue operator*() const { return JsonValue(m_document, m_members ? m_token + 1 : m_token); }
+				Iterator& operator++();
+				bool operator!=(const Iterator& other) const { return m_token != other.m_token; }
+
+				// Key of the current member when iterating an object
+				std::string_view GetKey() const;
+
+			private:
+				const JsonDocument* m_document;
+				uint32_t m_token;
+				bool m_members;
+		};
+
+		JsonValue() = default;
+		JsonValue(const JsonDocument* document, uint32_t token) : m_document(document), m_token(token) {}
+
+		bool IsValid() const { return m_document != nullptr; }
+		JsonType GetType() const { return IsValid() ? GetToken().type : JsonType::Null; }
+		bool IsNull() const { return GetType() == JsonType::Null; }
+		bool IsBool() const { return IsValid() && GetToken().type == JsonType::Bool; }
+		bool IsNumber() const { return IsValid() && GetToken().type == JsonType::Number; }
+		bool IsString() const { return IsValid() && GetToken().type == JsonType::String; }
+		bool IsArray() const { return IsValid() && GetToken().type == JsonType::Array; }
+		bool IsObject() const { return IsValid() && GetToken().type == JsonType::Object; }
+
+		// Number of elements or members, 0 for other values
+		size_t Size() const;
+
+		// Member lookup, linear in the number of members
+		JsonValue operator[](const char* key) const;
+		JsonValue operator[](std::string_view key) const;
+		// Array element, linear in the index (iterate with begin/end to walk an array)
+		JsonValue operator[](size_t index) const;
+		bool HasMember(const char* key) const { return (*this)[key].IsValid(); }
+
+		Iterator begin() const;
+		Iterator end() const;
+
+		bool GetBool(bool defaultValue = false) const;
+		double GetDouble(double defaultValue = 0.0) const;
+		float GetFloat(float defaultValue = 0.0f) const { return static_cast<float>(GetDouble(defaultValue)); }
+		int64_t GetInt(int64_t defaultValue = 0) const;
+		uint32_t GetUInt(uint32_t defaultValue = 0) const;
+		size_t GetSize(size_t defaultValue = 0) const;
+
+		// Raw text of a string, escape sequences included
+		std::string_view GetRawString() const;
+		// Decoded string, escape sequences and \u code points included
+		std::string GetString(const std::string& defaultValue = std::string()) const;
+		bool StringEquals(std::string_view value) const;
+
+		// Reads up to `count` numbers of an array, returns how many were read
+		size_t GetFloats(float* values, size_t count) const;
+
+	private:
+		const JsonToken& GetToken() const { return m_document->GetTokens()[m_token]; }
+
+	private:
+		const JsonDocument* m_document = nullptr;
+		uint32_t m_token = 0;
+};
+
+#endif // !JSON_H
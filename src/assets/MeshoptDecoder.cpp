@@ -0,0 +1,616 @@
+#include "MeshoptDecoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <immintrin.h>
+
+
+namespace {
+	constexpr uint8_t VERTEX_HEADER = 0xA0;
+	constexpr uint8_t INDEX_HEADER = 0xE0;
+	constexpr uint8_t SEQUENCE_HEADER = 0xD0;
+
+	constexpr size_t BYTE_GROUP_SIZE = 16;
+	// Most bytes a group can read: 8 bytes of 4-bit values and 16 explicit bytes
+	constexpr size_t BYTE_GROUP_DECODE_LIMIT = 24;
+	constexpr size_t VERTEX_BLOCK_SIZE_BYTES = 8192;
+	constexpr size_t VERTEX_BLOCK_MAX_SIZE = 256;
+	constexpr size_t MAX_VERTEX_SIZE = 256;
+	// The encoder pads the end of the vertex stream to this size, so groups can always read their limit
+	constexpr size_t TAIL_MIN_SIZE = 32;
+
+	uint8_t Unzigzag8(uint8_t value) {
+		return static_cast<uint8_t>(-(value & 1) ^ (value >> 1));
+	}
+
+	size_t GetVertexBlockSize(size_t vertexSize) {
+		size_t blockSize = (VERTEX_BLOCK_SIZE_BYTES / vertexSize) & ~(BYTE_GROUP_SIZE - 1);
+		return std::min(blockSize, VERTEX_BLOCK_MAX_SIZE);
+	}
+
+	// Values are packed from the most significant bits, all ones means the byte is stored after the packed values
+	template <int Bits>
+	const uint8_t* DecodeBitsGroup(const uint8_t* data, uint8_t* buffer) {
+		constexpr size_t VALUES_PER_BYTE = 8 / Bits;
+		constexpr uint8_t SENTINEL = (1 << Bits) - 1;
+		const uint8_t* explicitBytes = data + BYTE_GROUP_SIZE / VALUES_PER_BYTE;
+		for (size_t i = 0; i < BYTE_GROUP_SIZE; ++i) {
+			uint8_t value = (data[i / VALUES_PER_BYTE] >> (8 - Bits * (1 + i % VALUES_PER_BYTE))) & SENTINEL;
+			buffer[i] = value == SENTINEL ? *explicitBytes++ : value;
+		}
+		return explicitBytes;
+	}
+
+	const uint8_t* DecodeBytesGroup(const uint8_t* data, uint8_t* buffer, int bitsLog2) {
+		switch (bitsLog2) {
+		case 0:
+			std::memset(buffer, 0, BYTE_GROUP_SIZE);
+			return data;
+		case 1:
+			return DecodeBitsGroup<2>(data, buffer);
+		case 2:
+			return DecodeBitsGroup<4>(data, buffer);
+		default:
+			std::memcpy(buffer, data, BYTE_GROUP_SIZE);
+			return data + BYTE_GROUP_SIZE;
+		}
+	}
+
+	// pshufb masks gathering the explicit bytes of 8 values from a mask of which ones are explicit
+	struct ShuffleTables {
+		uint8_t shuffle[256][8];
+		uint8_t count[256];
+	};
+
+	const ShuffleTables& GetShuffleTables() {
+		static const ShuffleTables tables = []() {
+			ShuffleTables result = {};
+			for (int mask = 0; mask < 256; ++mask) {
+				uint8_t count = 0;
+				for (int i = 0; i < 8; ++i)
+					result.shuffle[mask][i] = (mask & (1 << i)) != 0 ? count++ : 0x80;
+				result.count[mask] = count;
+			}
+			return result;
+		}();
+		return tables;
+	}
+
+	// Replaces the sentinel values of `selectors` with the explicit bytes following the packed values
+	const uint8_t* ResolveExplicitBytesSse41(const uint8_t* explicitData, __m128i selectors, uint8_t sentinel, uint8_t* buffer) {
+		const ShuffleTables& tables = GetShuffleTables();
+		__m128i isExplicit = _mm_cmpeq_epi8(selectors, _mm_set1_epi8(static_cast<char>(sentinel)));
+		int mask = _mm_movemask_epi8(isExplicit);
+		uint8_t mask0 = static_cast<uint8_t>(mask & 255);
+		uint8_t mask1 = static_cast<uint8_t>(mask >> 8);
+
+		// The second half reads the explicit bytes after the ones of the first half (0x80 + count keeps the zeroing bit)
+		__m128i shuffle0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(tables.shuffle[mask0]));
+		__m128i shuffle1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(tables.shuffle[mask1]));
+		shuffle1 = _mm_add_epi8(shuffle1, _mm_set1_epi8(static_cast<char>(tables.count[mask0])));
+		__m128i shuffle = _mm_unpacklo_epi64(shuffle0, shuffle1);
+
+		__m128i explicitBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(explicitData));
+		__m128i result = _mm_or_si128(_mm_shuffle_epi8(explicitBytes, shuffle), _mm_andnot_si128(isExplicit, selectors));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), result);
+		return explicitData + tables.count[mask0] + tables.count[mask1];
+	}
+
+	// Reads up to BYTE_GROUP_DECODE_LIMIT bytes, which DecodeBytes checks
+	const uint8_t* DecodeBytesGroupSse41(const uint8_t* data, uint8_t* buffer, int bitsLog2) {
+		switch (bitsLog2) {
+		case 0:
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), _mm_setzero_si128());
+			return data;
+		case 1: {
+			// Spreads each byte into 4 bytes, most significant bits first, with two interleaving steps
+			int32_t packed;
+			std::memcpy(&packed, data, sizeof(packed));
+			__m128i selectors2 = _mm_cvtsi32_si128(packed);
+			__m128i selectors4 = _mm_unpacklo_epi8(_mm_srli_epi16(selectors2, 4), selectors2);
+			__m128i selectors = _mm_unpacklo_epi8(_mm_srli_epi16(selectors4, 2), selectors4);
+			return ResolveExplicitBytesSse41(data + 4, _mm_and_si128(selectors, _mm_set1_epi8(3)), 3, buffer);
+		}
+		case 2: {
+			__m128i selectors4 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+			__m128i selectors = _mm_unpacklo_epi8(_mm_srli_epi16(selectors4, 4), selectors4);
+			return ResolveExplicitBytesSse41(data + 8, _mm_and_si128(selectors, _mm_set1_epi8(15)), 15, buffer);
+		}
+		default:
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+			return data + BYTE_GROUP_SIZE;
+		}
+	}
+
+	// Decodes the stream of one vertex byte over a block, `bufferSize` is the block size rounded up to the group size
+	const uint8_t* DecodeBytes(const uint8_t* data, const uint8_t* dataEnd, uint8_t* buffer, size_t bufferSize, bool simd) {
+		// 2 bits per group giving its bit count, rounded up to whole bytes
+		const uint8_t* header = data;
+		size_t headerSize = (bufferSize / BYTE_GROUP_SIZE + 3) / 4;
+		if (static_cast<size_t>(dataEnd - data) < headerSize)
+			return nullptr;
+		data += headerSize;
+
+		for (size_t i = 0; i < bufferSize; i += BYTE_GROUP_SIZE) {
+			if (static_cast<size_t>(dataEnd - data) < BYTE_GROUP_DECODE_LIMIT)
+				return nullptr;
+			size_t group = i / BYTE_GROUP_SIZE;
+			int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+			data = simd ? DecodeBytesGroupSse41(data, buffer + i, bitsLog2) : DecodeBytesGroup(data, buffer + i, bitsLog2);
+		}
+		return data;
+	}
+
+	// Unzigzags 16 deltas and adds them up on top of `previous` with a log step prefix sum
+	__m128i PrefixSumDeltasSse41(__m128i deltas, uint8_t previous) {
+		__m128i half = _mm_and_si128(_mm_srli_epi16(deltas, 1), _mm_set1_epi8(0x7F));
+		__m128i negative = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(deltas, _mm_set1_epi8(1)));
+		__m128i values = _mm_xor_si128(half, negative);
+		values = _mm_add_epi8(values, _mm_slli_si128(values, 1));
+		values = _mm_add_epi8(values, _mm_slli_si128(values, 2));
+		values = _mm_add_epi8(values, _mm_slli_si128(values, 4));
+		values = _mm_add_epi8(values, _mm_slli_si128(values, 8));
+		return _mm_add_epi8(values, _mm_set1_epi8(static_cast<char>(previous)));
+	}
+
+	const uint8_t* DecodeVertexBlock(const uint8_t* data, const uint8_t* dataEnd, uint8_t* vertexData, size_t vertexCount,
+		size_t vertexSize, uint8_t* lastVertex, bool simd) {
+		uint8_t buffer[VERTEX_BLOCK_MAX_SIZE];
+		const size_t alignedCount = (vertexCount + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+
+		for (size_t k = 0; k < vertexSize; ++k) {
+			data = DecodeBytes(data, dataEnd, buffer, alignedCount, simd);
+			if (data == nullptr)
+				return nullptr;
+
+			// Deltas chain from the same byte of the previous vertex, written straight at their place in the vertices
+			uint8_t previous = lastVertex[k];
+			uint8_t* output = vertexData + k;
+			if (simd) {
+				for (size_t i = 0; i < vertexCount; i += BYTE_GROUP_SIZE) {
+					alignas(16) uint8_t values[BYTE_GROUP_SIZE];
+					_mm_store_si128(reinterpret_cast<__m128i*>(values),
+						PrefixSumDeltasSse41(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i)), previous));
+					size_t groupCount = std::min(BYTE_GROUP_SIZE, vertexCount - i);
+					for (size_t j = 0; j < groupCount; ++j)
+						output[(i + j) * vertexSize] = values[j];
+					previous = values[groupCount - 1];
+				}
+			}
+			else {
+				for (size_t i = 0; i < vertexCount; ++i) {
+					previous = static_cast<uint8_t>(previous + Unzigzag8(buffer[i]));
+					output[i * vertexSize] = previous;
+				}
+			}
+		}
+
+		std::memcpy(lastVertex, vertexData + vertexSize * (vertexCount - 1), vertexSize);
+		return data;
+	}
+
+	uint32_t DecodeVByte(const uint8_t*& data) {
+		uint8_t lead = *data++;
+		if (lead < 128)
+			return lead;
+
+		// Up to 4 more bytes of 7 bits
+		uint32_t result = lead & 127;
+		uint32_t shift = 7;
+		for (int i = 0; i < 4; ++i) {
+			uint8_t group = *data++;
+			result |= static_cast<uint32_t>(group & 127) << shift;
+			shift += 7;
+			if (group < 128)
+				break;
+		}
+		return result;
+	}
+
+	uint32_t DecodeIndex(const uint8_t*& data, uint32_t last) {
+		uint32_t value = DecodeVByte(data);
+		uint32_t delta = (value >> 1) ^ (0u - (value & 1));
+		return last + delta;
+	}
+
+	void WriteIndex(void* destination, size_t index, size_t indexSize, uint32_t value) {
+		if (indexSize == 2)
+			static_cast<uint16_t*>(destination)[index] = static_cast<uint16_t>(value);
+		else
+			static_cast<uint32_t*>(destination)[index] = value;
+	}
+
+	// FIFOs of the index codec, 16 entries wrapping around
+	struct IndexFifos {
+		uint32_t edges[16][2];
+		uint32_t vertices[16];
+		size_t edgeOffset = 0;
+		size_t vertexOffset = 0;
+
+		void PushEdge(uint32_t a, uint32_t b) {
+			edges[edgeOffset][0] = a;
+			edges[edgeOffset][1] = b;
+			edgeOffset = (edgeOffset + 1) & 15;
+		}
+		void PushVertex(uint32_t vertex, bool condition = true) {
+			vertices[vertexOffset] = vertex;
+			vertexOffset = (vertexOffset + (condition ? 1 : 0)) & 15;
+		}
+	};
+
+	template <typename T>
+	void DecodeOctahedralScalar(T* data, size_t count, size_t stride) {
+		const float maxValue = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+		for (size_t i = 0; i < count; ++i) {
+			T* element = reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(data) + i * stride);
+			// z holds the scale of the encoding, the octahedron is unfolded for z < 0
+			float x = static_cast<float>(element[0]);
+			float y = static_cast<float>(element[1]);
+			float z = static_cast<float>(element[2]) - std::fabs(x) - std::fabs(y);
+			float t = z < 0.0f ? z : 0.0f;
+			x += x >= 0.0f ? t : -t;
+			y += y >= 0.0f ? t : -t;
+
+			float length = std::sqrt(x * x + y * y + z * z);
+			float scale = maxValue / length;
+			element[0] = static_cast<T>(static_cast<int>(x * scale + (x >= 0.0f ? 0.5f : -0.5f)));
+			element[1] = static_cast<T>(static_cast<int>(y * scale + (y >= 0.0f ? 0.5f : -0.5f)));
+			element[2] = static_cast<T>(static_cast<int>(z * scale + (z >= 0.0f ? 0.5f : -0.5f)));
+		}
+	}
+
+	// Round half away from zero, like the scalar (int)(v + (v >= 0 ? 0.5 : -0.5))
+	__m128i RoundSse41(__m128 values) {
+		__m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(values, _mm_set1_ps(-0.0f)));
+		return _mm_cvttps_epi32(_mm_add_ps(values, half));
+	}
+
+	void DecodeOctahedralSse41(__m128i xi, __m128i yi, __m128i zi, float maxValue, __m128i& xr, __m128i& yr, __m128i& zr) {
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		__m128 x = _mm_cvtepi32_ps(xi);
+		__m128 y = _mm_cvtepi32_ps(yi);
+		__m128 z = _mm_sub_ps(_mm_sub_ps(_mm_cvtepi32_ps(zi), _mm_andnot_ps(signMask, x)), _mm_andnot_ps(signMask, y));
+		// min returns its second operand for zeros, so -0 gives +0 like the scalar comparison
+		__m128 t = _mm_min_ps(z, _mm_setzero_ps());
+		x = _mm_add_ps(x, _mm_xor_ps(t, _mm_and_ps(x, signMask)));
+		y = _mm_add_ps(y, _mm_xor_ps(t, _mm_and_ps(y, signMask)));
+
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		__m128 scale = _mm_div_ps(_mm_set1_ps(maxValue), length);
+		xr = RoundSse41(_mm_mul_ps(x, scale));
+		yr = RoundSse41(_mm_mul_ps(y, scale));
+		zr = RoundSse41(_mm_mul_ps(z, scale));
+	}
+
+	void DecodeQuaternionScalar(int16_t* data, size_t count, size_t stride) {
+		const float scale = 1.0f / std::sqrt(2.0f);
+		for (size_t i = 0; i < count; ++i) {
+			int16_t* element = reinterpret_cast<int16_t*>(reinterpret_cast<uint8_t*>(data) + i * stride);
+			// The 4th component holds the range scale and, in its 2 low bits, which component was dropped
+			int rangeScale = element[3] | 3;
+			float componentScale = scale / static_cast<float>(rangeScale);
+			float x = static_cast<float>(element[0]) * componentScale;
+			float y = static_cast<float>(element[1]) * componentScale;
+			float z = static_cast<float>(element[2]) * componentScale;
+			float ww = 1.0f - x * x - y * y - z * z;
+			float w = std::sqrt(ww >= 0.0f ? ww : 0.0f);
+
+			int xf = static_cast<int>(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f));
+			int yf = static_cast<int>(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f));
+			int zf = static_cast<int>(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f));
+			int wf = static_cast<int>(w * 32767.0f + 0.5f);
+
+			int dropped = element[3] & 3;
+			element[(dropped + 1) & 3] = static_cast<int16_t>(xf);
+			element[(dropped + 2) & 3] = static_cast<int16_t>(yf);
+			element[(dropped + 3) & 3] = static_cast<int16_t>(zf);
+			element[dropped] = static_cast<int16_t>(wf);
+		}
+	}
+
+	void DecodeExponentialScalar(uint32_t* data, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			// 8-bit signed exponent, 24-bit signed mantissa
+			int32_t mantissa = static_cast<int32_t>(data[i] << 8) >> 8;
+			int32_t exponent = static_cast<int32_t>(data[i]) >> 24;
+			// ldexp(mantissa, exponent) through a power of two built from its bits
+			uint32_t powerBits = static_cast<uint32_t>(exponent + 127) << 23;
+			float power;
+			std::memcpy(&power, &powerBits, sizeof(power));
+			float value = power * static_cast<float>(mantissa);
+			std::memcpy(&data[i], &value, sizeof(value));
+		}
+	}
+}
+
+bool MeshoptDecoder::DecodeVertexBuffer(void* destination, size_t vertexCount, size_t vertexSize, const uint8_t* buffer, size_t bufferSize,
+	SimdLevel level) {
+	if (vertexSize == 0 || vertexSize > MAX_VERTEX_SIZE || vertexSize % 4 != 0)
+		return false;
+	if (bufferSize < 1 + vertexSize)
+		return false;
+
+	const uint8_t* data = buffer;
+	const uint8_t* dataEnd = buffer + bufferSize;
+	uint8_t header = *data++;
+	// Only version 0 is part of the extension
+	if ((header & 0xF0) != VERTEX_HEADER || (header & 0x0F) != 0)
+		return false;
+
+	// The first vertex of the first block is coded against the last bytes of the stream
+	uint8_t lastVertex[MAX_VERTEX_SIZE];
+	std::memcpy(lastVertex, dataEnd - vertexSize, vertexSize);
+
+	const bool simd = level >= SimdLevel::SSE41;
+	const size_t blockSize = GetVertexBlockSize(vertexSize);
+	uint8_t* vertexData = static_cast<uint8_t*>(destination);
+	for (size_t offset = 0; offset < vertexCount; offset += blockSize) {
+		size_t count = std::min(blockSize, vertexCount - offset);
+		data = DecodeVertexBlock(data, dataEnd, vertexData + offset * vertexSize, count, vertexSize, lastVertex, simd);
+		if (data == nullptr)
+			return false;
+	}
+
+	// Everything but the tail must have been consumed
+	return static_cast<size_t>(dataEnd - data) == std::max(vertexSize, TAIL_MIN_SIZE);
+}
+
+bool MeshoptDecoder::DecodeIndexBuffer(void* destination, size_t indexCount, size_t indexSize, const uint8_t* buffer, size_t bufferSize) {
+	if (indexCount % 3 != 0 || (indexSize != 2 && indexSize != 4))
+		return false;
+	// Smallest valid stream: the header, a code byte per triangle and the 16 byte auxiliary code table
+	if (bufferSize < 1 + indexCount / 3 + 16)
+		return false;
+	if ((buffer[0] & 0xF0) != INDEX_HEADER)
+		return false;
+	const int version = buffer[0] & 0x0F;
+	if (version > 1)
+		return false;
+
+	IndexFifos fifos;
+	std::memset(fifos.edges, 0xFF, sizeof(fifos.edges));
+	std::memset(fifos.vertices, 0xFF, sizeof(fifos.vertices));
+
+	uint32_t next = 0;
+	uint32_t last = 0;
+	// Version 1 codes the vertex FIFO entries 13 and 14 as last -1 and last +1
+	const int maxFifoCode = version >= 1 ? 13 : 15;
+
+	const uint8_t* code = buffer + 1;
+	const uint8_t* data = code + indexCount / 3;
+	const uint8_t* dataSafeEnd = buffer + bufferSize - 16;
+	const uint8_t* auxiliaryCodes = dataSafeEnd;
+
+	for (size_t i = 0; i < indexCount; i += 3) {
+		// A triangle reads at most 16 bytes (an auxiliary code and 3 varints), the table after the data covers it
+		if (data > dataSafeEnd)
+			return false;
+
+		uint8_t triangleCode = *code++;
+		if (triangleCode < 0xF0) {
+			// Edge from the FIFO, third vertex new, from the FIFO or coded
+			int edgeCode = triangleCode >> 4;
+			uint32_t a = fifos.edges[(fifos.edgeOffset - 1 - edgeCode) & 15][0];
+			uint32_t b = fifos.edges[(fifos.edgeOffset - 1 - edgeCode) & 15][1];
+			uint32_t c = 0;
+
+			int vertexCode = triangleCode & 15;
+			if (vertexCode < maxFifoCode) {
+				bool isNext = vertexCode == 0;
+				c = isNext ? next : fifos.vertices[(fifos.vertexOffset - 1 - vertexCode) & 15];
+				next += isNext ? 1 : 0;
+				fifos.PushVertex(c, isNext);
+			}
+			else {
+				// 13 and 14 (version 1) are -1 and +1 from the last coded index, 15 a coded delta
+				last = c = vertexCode != 15 ? last + (vertexCode - (vertexCode ^ 3)) : DecodeIndex(data, last);
+				fifos.PushVertex(c);
+			}
+
+			fifos.PushEdge(c, b);
+			fifos.PushEdge(a, c);
+			WriteIndex(destination, i + 0, indexSize, a);
+			WriteIndex(destination, i + 1, indexSize, b);
+			WriteIndex(destination, i + 2, indexSize, c);
+		}
+		else if (triangleCode < 0xFE) {
+			// No shared edge, the two last vertices are described by an entry of the auxiliary table
+			uint8_t auxiliaryCode = auxiliaryCodes[triangleCode & 15];
+			int codeB = auxiliaryCode >> 4;
+			int codeC = auxiliaryCode & 15;
+
+			// next is incremented for the three vertices before the FIFO reads, like the encoder
+			uint32_t a = next++;
+			uint32_t b = codeB == 0 ? next : fifos.vertices[(fifos.vertexOffset - codeB) & 15];
+			next += codeB == 0 ? 1 : 0;
+			uint32_t c = codeC == 0 ? next : fifos.vertices[(fifos.vertexOffset - codeC) & 15];
+			next += codeC == 0 ? 1 : 0;
+
+			fifos.PushVertex(a);
+			fifos.PushVertex(b, codeB == 0);
+			fifos.PushVertex(c, codeC == 0);
+			fifos.PushEdge(b, a);
+			fifos.PushEdge(c, b);
+			fifos.PushEdge(a, c);
+			WriteIndex(destination, i + 0, indexSize, a);
+			WriteIndex(destination, i + 1, indexSize, b);
+			WriteIndex(destination, i + 2, indexSize, c);
+		}
+		else {
+			// Explicit auxiliary code byte, with coded indices for any of the three vertices
+			uint8_t auxiliaryCode = *data++;
+			int codeA = triangleCode == 0xFE ? 0 : 15;
+			int codeB = auxiliaryCode >> 4;
+			int codeC = auxiliaryCode & 15;
+			// A zero code byte restarts the sequence of new vertices
+			if (auxiliaryCode == 0)
+				next = 0;
+
+			uint32_t a = codeA == 0 ? next++ : 0;
+			uint32_t b = codeB == 0 ? next++ : fifos.vertices[(fifos.vertexOffset - codeB) & 15];
+			uint32_t c = codeC == 0 ? next++ : fifos.vertices[(fifos.vertexOffset - codeC) & 15];
+			if (codeA == 15)
+				last = a = DecodeIndex(data, last);
+			if (codeB == 15)
+				last = b = DecodeIndex(data, last);
+			if (codeC == 15)
+				last = c = DecodeIndex(data, last);
+
+			fifos.PushVertex(a);
+			fifos.PushVertex(b, codeB == 0 || codeB == 15);
+			fifos.PushVertex(c, codeC == 0 || codeC == 15);
+			fifos.PushEdge(b, a);
+			fifos.PushEdge(c, b);
+			fifos.PushEdge(a, c);
+			WriteIndex(destination, i + 0, indexSize, a);
+			WriteIndex(destination, i + 1, indexSize, b);
+			WriteIndex(destination, i + 2, indexSize, c);
+		}
+	}
+
+	// The data must end exactly where the auxiliary table starts
+	return data == dataSafeEnd;
+}
+
+bool MeshoptDecoder::DecodeIndexSequence(void* destination, size_t indexCount, size_t indexSize, const uint8_t* buffer, size_t bufferSize) {
+	if (indexSize != 2 && indexSize != 4)
+		return false;
+	// Smallest valid stream: the header, a byte per index and a 4 byte tail
+	if (bufferSize < 1 + indexCount + 4)
+		return false;
+	if ((buffer[0] & 0xF0) != SEQUENCE_HEADER || (buffer[0] & 0x0F) > 1)
+		return false;
+
+	const uint8_t* data = buffer + 1;
+	const uint8_t* dataSafeEnd = buffer + bufferSize - 4;
+	uint32_t last[2] = {};
+	for (size_t i = 0; i < indexCount; ++i) {
+		// A varint reads at most 5 bytes, the tail covers the overrun past the check
+		if (data >= dataSafeEnd)
+			return false;
+
+		// The low bit picks the baseline, the rest is the zigzag delta against it
+		uint32_t value = DecodeVByte(data);
+		uint32_t baseline = value & 1;
+		value >>= 1;
+		uint32_t index = last[baseline] + ((value >> 1) ^ (0u - (value & 1)));
+		last[baseline] = index;
+		WriteIndex(destination, i, indexSize, index);
+	}
+	return data == dataSafeEnd;
+}
+
+void MeshoptDecoder::DecodeOctahedralFilter(void* data, size_t count, size_t stride, SimdLevel level) {
+	uint8_t* bytes = static_cast<uint8_t*>(data);
+	size_t i = 0;
+	if (stride == 4) {
+		if (level >= SimdLevel::SSE41) {
+			// 4 elements of 4 snorm8 per register, w is kept
+			for (; i + 4 <= count; i += 4) {
+				__m128i* elements = reinterpret_cast<__m128i*>(bytes + i * 4);
+				__m128i packed = _mm_loadu_si128(elements);
+				__m128i x = _mm_srai_epi32(_mm_slli_epi32(packed, 24), 24);
+				__m128i y = _mm_srai_epi32(_mm_slli_epi32(packed, 16), 24);
+				__m128i z = _mm_srai_epi32(_mm_slli_epi32(packed, 8), 24);
+				DecodeOctahedralSse41(x, y, z, 127.0f, x, y, z);
+
+				const __m128i byteMask = _mm_set1_epi32(0xFF);
+				__m128i result = _mm_or_si128(_mm_and_si128(x, byteMask), _mm_slli_epi32(_mm_and_si128(y, byteMask), 8));
+				result = _mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(z, byteMask), 16));
+				result = _mm_or_si128(result, _mm_and_si128(packed, _mm_set1_epi32(static_cast<int>(0xFF000000))));
+				_mm_storeu_si128(elements, result);
+			}
+		}
+		DecodeOctahedralScalar(reinterpret_cast<int8_t*>(bytes + i * stride), count - i, stride);
+	}
+	else if (stride == 8) {
+		if (level >= SimdLevel::SSE41) {
+			// 4 elements of 4 snorm16 in two registers, regrouped as xy and zw pairs
+			for (; i + 4 <= count; i += 4) {
+				__m128i* elements = reinterpret_cast<__m128i*>(bytes + i * 8);
+				__m128 elements01 = _mm_castsi128_ps(_mm_loadu_si128(elements));
+				__m128 elements23 = _mm_castsi128_ps(_mm_loadu_si128(elements + 1));
+				__m128i xy = _mm_castps_si128(_mm_shuffle_ps(elements01, elements23, _MM_SHUFFLE(2, 0, 2, 0)));
+				__m128i zw = _mm_castps_si128(_mm_shuffle_ps(elements01, elements23, _MM_SHUFFLE(3, 1, 3, 1)));
+				__m128i x = _mm_srai_epi32(_mm_slli_epi32(xy, 16), 16);
+				__m128i y = _mm_srai_epi32(xy, 16);
+				__m128i z = _mm_srai_epi32(_mm_slli_epi32(zw, 16), 16);
+				DecodeOctahedralSse41(x, y, z, 32767.0f, x, y, z);
+
+				const __m128i shortMask = _mm_set1_epi32(0xFFFF);
+				__m128i xyResult = _mm_or_si128(_mm_and_si128(x, shortMask), _mm_slli_epi32(y, 16));
+				__m128i zwResult = _mm_or_si128(_mm_and_si128(z, shortMask), _mm_andnot_si128(shortMask, zw));
+				_mm_storeu_si128(elements, _mm_unpacklo_epi32(xyResult, zwResult));
+				_mm_storeu_si128(elements + 1, _mm_unpackhi_epi32(xyResult, zwResult));
+			}
+		}
+		DecodeOctahedralScalar(reinterpret_cast<int16_t*>(bytes + i * stride), count - i, stride);
+	}
+}
+
+void MeshoptDecoder::DecodeQuaternionFilter(void* data, size_t count, size_t stride, SimdLevel level) {
+	if (stride != 8)
+		return;
+
+	uint8_t* bytes = static_cast<uint8_t*>(data);
+	size_t i = 0;
+	if (level >= SimdLevel::SSE41) {
+		const __m128 scale = _mm_set1_ps(1.0f / std::sqrt(2.0f));
+		const __m128 maxValue = _mm_set1_ps(32767.0f);
+		for (; i + 4 <= count; i += 4) {
+			__m128i* elements = reinterpret_cast<__m128i*>(bytes + i * 8);
+			__m128 elements01 = _mm_castsi128_ps(_mm_loadu_si128(elements));
+			__m128 elements23 = _mm_castsi128_ps(_mm_loadu_si128(elements + 1));
+			__m128i xy = _mm_castps_si128(_mm_shuffle_ps(elements01, elements23, _MM_SHUFFLE(2, 0, 2, 0)));
+			__m128i zw = _mm_castps_si128(_mm_shuffle_ps(elements01, elements23, _MM_SHUFFLE(3, 1, 3, 1)));
+			__m128i wi = _mm_srai_epi32(zw, 16);
+
+			__m128 componentScale = _mm_div_ps(scale, _mm_cvtepi32_ps(_mm_or_si128(wi, _mm_set1_epi32(3))));
+			__m128 x = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(xy, 16), 16)), componentScale);
+			__m128 y = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(xy, 16)), componentScale);
+			__m128 z = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(zw, 16), 16)), componentScale);
+			__m128 ww = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+			__m128 w = _mm_sqrt_ps(_mm_max_ps(ww, _mm_setzero_ps()));
+
+			alignas(16) int32_t results[4][4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(results[0]), RoundSse41(_mm_mul_ps(x, maxValue)));
+			_mm_store_si128(reinterpret_cast<__m128i*>(results[1]), RoundSse41(_mm_mul_ps(y, maxValue)));
+			_mm_store_si128(reinterpret_cast<__m128i*>(results[2]), RoundSse41(_mm_mul_ps(z, maxValue)));
+			_mm_store_si128(reinterpret_cast<__m128i*>(results[3]), RoundSse41(_mm_mul_ps(w, maxValue)));
+
+			// The output order depends on the dropped component of each element
+			for (size_t e = 0; e < 4; ++e) {
+				int16_t* element = reinterpret_cast<int16_t*>(bytes + (i + e) * 8);
+				int dropped = element[3] & 3;
+				element[(dropped + 1) & 3] = static_cast<int16_t>(results[0][e]);
+				element[(dropped + 2) & 3] = static_cast<int16_t>(results[1][e]);
+				element[(dropped + 3) & 3] = static_cast<int16_t>(results[2][e]);
+				element[dropped] = static_cast<int16_t>(results[3][e]);
+			}
+		}
+	}
+	DecodeQuaternionScalar(reinterpret_cast<int16_t*>(bytes + i * stride), count - i, stride);
+}
+
+void MeshoptDecoder::DecodeExponentialFilter(void* data, size_t count, size_t stride, SimdLevel level) {
+	if (stride % 4 != 0)
+		return;
+
+	// Every 32-bit component is filtered, the stride doesn't matter
+	uint32_t* values = static_cast<uint32_t*>(data);
+	const size_t valueCount = count * stride / 4;
+	size_t i = 0;
+	if (level >= SimdLevel::SSE41) {
+		for (; i + 4 <= valueCount; i += 4) {
+			__m128i* packed = reinterpret_cast<__m128i*>(values + i);
+			__m128i value = _mm_loadu_si128(packed);
+			__m128i mantissa = _mm_srai_epi32(_mm_slli_epi32(value, 8), 8);
+			__m128i exponent = _mm_srai_epi32(value, 24);
+			__m128 power = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(127)), 23));
+			_mm_storeu_si128(packed, _mm_castps_si128(_mm_mul_ps(power, _mm_cvtepi32_ps(mantissa))));
+		}
+	}
+	DecodeExponentialScalar(values + i, valueCount - i);
+}
@@ -0,0 +1,42 @@
+#ifndef MESHOPT_DECODER_H
+#define MESHOPT_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../utils/CpuFeatures.h"
+
+
+// Decoder for the buffer views of the EXT_meshopt_compression glTF extension (meshoptimizer's codecs).
+//
+// - Vertex codec (ATTRIBUTES mode): vertices are split in blocks of up to 256, and every byte of the
+//   vertex is stored as its own stream of zigzag deltas against the previous vertex, packed in groups
+//   of 16 with 0, 2, 4 or 8 bits per delta (values that don't fit are stored after the group).
+// - Index codec (TRIANGLES mode): triangles are coded against a FIFO of recent edges and vertices,
+//   with a code byte per triangle and varint deltas for the indices seen for the first time.
+// - Index sequence codec (INDICES mode): varint zigzag deltas against one of two baselines.
+// - Filters, applied after the vertex codec: octahedral normals, quaternions and exponent/mantissa floats.
+//
+// The SSE4.1 paths unpack the byte groups with pshufb, prefix sum the deltas 16 at a time and run the
+// filters 4 elements at a time, they give the same bytes as the scalar ones.
+// Every function validates its input and returns false on malformed data, without reading out of bounds.
+namespace MeshoptDecoder {
+	// Decodes `vertexCount` vertices of `vertexSize` bytes (a multiple of 4, up to 256)
+	bool DecodeVertexBuffer(void* destination, size_t vertexCount, size_t vertexSize, const uint8_t* buffer, size_t bufferSize,
+		SimdLevel level = CpuFeatures::GetSimdLevel());
+
+	// Decodes a triangle list of `indexCount` indices of `indexSize` bytes (2 or 4)
+	bool DecodeIndexBuffer(void* destination, size_t indexCount, size_t indexSize, const uint8_t* buffer, size_t bufferSize);
+
+	// Decodes an arbitrary index sequence of `indexCount` indices of `indexSize` bytes (2 or 4)
+	bool DecodeIndexSequence(void* destination, size_t indexCount, size_t indexSize, const uint8_t* buffer, size_t bufferSize);
+
+	// In place filters over `count` elements of `stride` bytes:
+	// octahedral normals as 4 snorm8 or snorm16 (stride 4 or 8), quaternions as 4 snorm16 (stride 8),
+	// exponential floats as 32-bit exponent/mantissa pairs (any stride multiple of 4)
+	void DecodeOctahedralFilter(void* data, size_t count, size_t stride, SimdLevel level = CpuFeatures::GetSimdLevel());
+	void DecodeQuaternionFilter(void* data, size_t count, size_t stride, SimdLevel level = CpuFeatures::GetSimdLevel());
+	void DecodeExponentialFilter(void* data, size_t count, size_t stride, SimdLevel level = CpuFeatures::GetSimdLevel());
+}
+
+#endif // !MESHOPT_DECODER_H
@@ -0,0 +1,529 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <random>
+
+#include <immintrin.h>
+
+#include "TextureLoader.h"
+#include "../utils/ConsoleLogger.h"
+#include "../utils/StagingMemory.h"
+#include "../utils/ThreadPool.h"
+
+
+namespace {
+	// Kaiser window parameters, in destination texels
+	constexpr double KAISER_WIDTH = 3.0;
+	constexpr double KAISER_ALPHA = 4.0;
+	// Steps integrating the kernel over the span of a source texel
+	constexpr int KAISER_SUBSAMPLES = 8;
+	// Texels per ParallelFor batch, small levels run as a single batch on the calling thread
+	constexpr size_t BATCH_TEXELS = 32768;
+
+	// Bits of the floats indexing the encoding table: 2^-13 up to 1, 8 mantissa bits per entry
+	constexpr uint32_t SRGB_TABLE_FIRST_BITS = 0x39000000;  // 2^-13
+	constexpr uint32_t SRGB_TABLE_SHIFT = 15;
+	constexpr uint32_t SRGB_TABLE_SIZE = (0x3F800000 - SRGB_TABLE_FIRST_BITS) >> SRGB_TABLE_SHIFT;
+
+	double SrgbToLinear(double value) {
+		return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+	}
+
+	uint32_t FloatBits(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	// sRGB <-> linear conversions. Encoding rounds exactly like round(255 * LinearToSrgb(value)): the table gives
+	// the encoded value at the start of the interval of the float, and the interval is narrow enough (a relative
+	// width of 2^-8) that at most one rounding threshold falls inside, checked against the thresholds.
+	// Values below 2^-13 all encode to 0, the first threshold is 1.5e-4.
+	class SrgbTables {
+		public:
+			SrgbTables() {
+				for (uint32_t i = 0; i < 256; ++i)
+					m_toLinear[i] = static_cast<float>(SrgbToLinear(i / 255.0));
+				m_thresholds[0] = -FLT_MAX;
+				for (uint32_t i = 1; i < 256; ++i)
+					m_thresholds[i] = static_cast<float>(SrgbToLinear((i - 0.5) / 255.0));
+
+				uint32_t encoded = 0;
+				for (uint32_t i = 0; i < SRGB_TABLE_SIZE; ++i) {
+					uint32_t bits = SRGB_TABLE_FIRST_BITS + (i << SRGB_TABLE_SHIFT);
+					float value;
+					std::memcpy(&value, &bits, sizeof(value));
+					while (encoded < 255 && value >= m_thresholds[encoded + 1])
+						++encoded;
+					m_intervalStart[i] = static_cast<uint8_t>(encoded);
+				}
+			}
+
+			float ToLinear(uint8_t value) const { return m_toLinear[value]; }
+
+			// NaNs encode to 0
+			uint8_t ToSrgb(float value) const {
+				if (!(value >= m_thresholds[1]))
+					return 0;
+				if (value >= 1.0f)
+					return 255;
+				uint32_t encoded = m_intervalStart[(FloatBits(value) - SRGB_TABLE_FIRST_BITS) >> SRGB_TABLE_SHIFT];
+				while (encoded < 255 && value >= m_thresholds[encoded + 1])
+					++encoded;
+				return static_cast<uint8_t>(encoded);
+			}
+
+		private:
+			float m_toLinear[256];
+			float m_thresholds[256];  // Linear value where each encoded value starts, (i - 0.5) / 255 in sRGB
+			uint8_t m_intervalStart[SRGB_TABLE_SIZE];
+	};
+
+	const SrgbTables& GetSrgbTables() {
+		static const SrgbTables tables;
+		return tables;
+	}
+
+	double Bessel0(double x) {
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 64; ++k) {
+			double factor = x / (2.0 * k);
+			term *= factor * factor;
+			sum += term;
+			if (term < sum * 1e-12)
+				break;
+		}
+		return sum;
+	}
+
+	// Kaiser windowed sinc, `x` in destination texels
+	double EvaluateKaiser(double x) {
+		if (std::abs(x) >= KAISER_WIDTH)
+			return 0.0;
+		constexpr double PI = 3.14159265358979323846;
+		double sinc = x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+		double t = x / KAISER_WIDTH;
+		return sinc * Bessel0(KAISER_ALPHA * std::sqrt(1.0 - t * t)) / Bessel0(KAISER_ALPHA);
+	}
+
+	// Taps of a resampling pass along one axis, the same for every row or column
+	struct AxisWeights {
+		uint32_t tapCount = 0;          // Per destination texel, the unused ones have a weight of 0
+		std::vector<uint32_t> indices;  // Source texel of each tap, with the edge mode applied
+		std::vector<float> weights;     // Normalized per destination texel
+	};
+
+	AxisWeights ComputeAxisWeights(uint32_t sourceSize, uint32_t destinationSize, MipFilter filter, MipEdgeMode edgeMode) {
+		// Source texels per destination texel, and the support of the filter in source texels
+		const double scale = static_cast<double>(sourceSize) / destinationSize;
+		const double radius = (filter == MipFilter::Box ? 0.5 : KAISER_WIDTH) * scale;
+
+		AxisWeights axis;
+		axis.tapCount = static_cast<uint32_t>(std::ceil(2.0 * radius)) + 1;
+		axis.indices.resize(size_t(destinationSize) * axis.tapCount, 0);
+		axis.weights.resize(size_t(destinationSize) * axis.tapCount, 0.0f);
+
+		for (uint32_t x = 0; x < destinationSize; ++x) {
+			const double center = (x + 0.5) * scale;
+			const int64_t first = static_cast<int64_t>(std::floor(center - radius));
+			uint32_t* indices = &axis.indices[size_t(x) * axis.tapCount];
+			float* weights = &axis.weights[size_t(x) * axis.tapCount];
+
+			double total = 0.0;
+			for (uint32_t tap = 0; tap < axis.tapCount; ++tap) {
+				// Span of the source texel relative to the destination texel center, in destination texels
+				const int64_t texel = first + tap;
+				const double begin = (texel - center) / scale;
+				const double end = (texel + 1 - center) / scale;
+
+				double weight = 0.0;
+				if (filter == MipFilter::Box) {
+					weight = std::max(0.0, std::min(end, 0.5) - std::max(begin, -0.5));
+				}
+				else {
+					const double step = (end - begin) / KAISER_SUBSAMPLES;
+					for (int s = 0; s < KAISER_SUBSAMPLES; ++s)
+						weight += EvaluateKaiser(begin + (s + 0.5) * step) * step;
+				}
+
+				int64_t index = texel;
+				if (edgeMode == MipEdgeMode::Wrap)
+					index = ((index % sourceSize) + sourceSize) % sourceSize;
+				else
+					index = std::clamp<int64_t>(index, 0, sourceSize - 1);
+				indices[tap] = static_cast<uint32_t>(index);
+				weights[tap] = static_cast<float>(weight);
+				total += weight;
+			}
+
+			if (total != 0.0) {
+				for (uint32_t tap = 0; tap < axis.tapCount; ++tap)
+					weights[tap] = static_cast<float>(weights[tap] / total);
+			}
+		}
+
+		// The last tap only covers the texel ending on the support edge for integer ratios (a 2:1 box has
+		// two taps, not three): drop the taps that are zero for every destination texel
+		uint32_t usedTapCount = 1;
+		for (uint32_t x = 0; x < destinationSize; ++x) {
+			for (uint32_t tap = axis.tapCount; tap > usedTapCount; --tap) {
+				if (axis.weights[size_t(x) * axis.tapCount + tap - 1] != 0.0f) {
+					usedTapCount = tap;
+					break;
+				}
+			}
+		}
+		if (usedTapCount < axis.tapCount) {
+			for (uint32_t x = 0; x < destinationSize; ++x) {
+				for (uint32_t tap = 0; tap < usedTapCount; ++tap) {
+					axis.indices[size_t(x) * usedTapCount + tap] = axis.indices[size_t(x) * axis.tapCount + tap];
+					axis.weights[size_t(x) * usedTapCount + tap] = axis.weights[size_t(x) * axis.tapCount + tap];
+				}
+			}
+			axis.tapCount = usedTapCount;
+			axis.indices.resize(size_t(destinationSize) * usedTapCount);
+			axis.weights.resize(size_t(destinationSize) * usedTapCount);
+		}
+		return axis;
+	}
+
+	// Texels are float4, one SSE register each
+	void DecodeRow(const uint8_t* source, uint32_t width, bool sRGB, float* destination) {
+		const SrgbTables& tables = GetSrgbTables();
+		const __m128 alphaScale = _mm_set1_ps(1.0f / 255.0f);
+		const __m128i zero = _mm_setzero_si128();
+		for (uint32_t x = 0; x < width; ++x) {
+			int32_t packed;
+			std::memcpy(&packed, source + x * 4, sizeof(packed));
+			__m128i widened = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+			__m128 texel = _mm_mul_ps(_mm_cvtepi32_ps(widened), alphaScale);
+			_mm_store_ps(destination + x * 4, texel);
+			if (sRGB) {
+				destination[x * 4 + 0] = tables.ToLinear(source[x * 4 + 0]);
+				destination[x * 4 + 1] = tables.ToLinear(source[x * 4 + 1]);
+				destination[x * 4 + 2] = tables.ToLinear(source[x * 4 + 2]);
+			}
+		}
+	}
+
+	void FilterRow(const float* source, const AxisWeights& axis, uint32_t destinationWidth, float* destination) {
+		for (uint32_t x = 0; x < destinationWidth; ++x) {
+			const uint32_t* indices = &axis.indices[size_t(x) * axis.tapCount];
+			const float* weights = &axis.weights[size_t(x) * axis.tapCount];
+			__m128 sum = _mm_setzero_ps();
+			for (uint32_t tap = 0; tap < axis.tapCount; ++tap)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(source + size_t(indices[tap]) * 4), _mm_set1_ps(weights[tap])));
+			_mm_store_ps(destination + size_t(x) * 4, sum);
+		}
+	}
+
+	// Destination row `y` of a vertical pass: the weighted sum of whole source rows
+	void FilterColumns(const float* source, uint32_t width, const AxisWeights& axis, uint32_t y, float* destination) {
+		const uint32_t* indices = &axis.indices[size_t(y) * axis.tapCount];
+		const float* weights = &axis.weights[size_t(y) * axis.tapCount];
+		const size_t floatCount = size_t(width) * 4;
+
+		const float* row = source + indices[0] * floatCount;
+		__m128 weight = _mm_set1_ps(weights[0]);
+		for (size_t i = 0; i < floatCount; i += 4)
+			_mm_store_ps(destination + i, _mm_mul_ps(_mm_load_ps(row + i), weight));
+		for (uint32_t tap = 1; tap < axis.tapCount; ++tap) {
+			if (weights[tap] == 0.0f)
+				continue;
+			row = source + indices[tap] * floatCount;
+			weight = _mm_set1_ps(weights[tap]);
+			for (size_t i = 0; i < floatCount; i += 4)
+				_mm_store_ps(destination + i, _mm_add_ps(_mm_load_ps(destination + i), _mm_mul_ps(_mm_load_ps(row + i), weight)));
+		}
+	}
+
+	void EncodeRow(const float* source, uint32_t width, bool sRGB, float alphaScale, uint8_t* destination) {
+		const SrgbTables& tables = GetSrgbTables();
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 channelScale = _mm_set_ps(alphaScale, 1.0f, 1.0f, 1.0f);
+		for (uint32_t x = 0; x < width; ++x) {
+			__m128 texel = _mm_load_ps(source + x * 4);
+			// Kaiser lobes overshoot, the alpha scale can too
+			__m128 clamped = _mm_min_ps(_mm_max_ps(_mm_mul_ps(texel, channelScale), zero), one);
+			__m128i rounded = _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)));
+			__m128i packed = _mm_packus_epi16(_mm_packs_epi32(rounded, rounded), rounded);
+			int32_t bytes = _mm_cvtsi128_si32(packed);
+			std::memcpy(destination + x * 4, &bytes, sizeof(bytes));
+			if (sRGB) {
+				alignas(16) float linear[4];
+				_mm_store_ps(linear, clamped);
+				destination[x * 4 + 0] = tables.ToSrgb(linear[0]);
+				destination[x * 4 + 1] = tables.ToSrgb(linear[1]);
+				destination[x * 4 + 2] = tables.ToSrgb(linear[2]);
+			}
+		}
+	}
+
+	// Alpha scale that makes the same fraction of the level pass the alpha test as `targetCoverage`.
+	// With the texels sorted by alpha, the target count-th largest one must land exactly on the cutoff.
+	float ComputeAlphaScale(const float* texels, size_t texelCount, float alphaCutoff, float targetCoverage, std::vector<float>& alphas) {
+		const size_t targetCount = static_cast<size_t>(std::lround(static_cast<double>(targetCoverage) * texelCount));
+		if (targetCount == 0)
+			return 1.0f;
+
+		alphas.resize(texelCount);
+		for (size_t i = 0; i < texelCount; ++i)
+			alphas[i] = texels[i * 4 + 3];
+		std::nth_element(alphas.begin(), alphas.begin() + (targetCount - 1), alphas.end(), std::greater<float>());
+		// A level that's entirely transparent around the texels to keep can't reach the target, as close as it gets
+		const float threshold = std::max(alphas[targetCount - 1], 1.0f / 255.0f);
+		// Rounded up so the threshold texel itself passes
+		return std::nextafter(alphaCutoff / threshold, FLT_MAX);
+	}
+
+	void ForRows(ThreadPool* threadPool, uint32_t rowCount, uint32_t width, const std::function<void(size_t begin, size_t end)>& function) {
+		if (threadPool == nullptr) {
+			function(0, rowCount);
+			return;
+		}
+		threadPool->ParallelFor(rowCount, std::max<size_t>(BATCH_TEXELS / width, 1), function);
+	}
+
+	DecodedImage CopyImage(const DecodedImage& image) {
+		DecodedImage copy;
+		copy.id = image.id;
+		copy.width = image.width;
+		copy.height = image.height;
+		copy.sourceChannels = image.sourceChannels;
+		copy.levelCount = image.levelCount;
+		copy.pixels.reset(static_cast<uint8_t*>(StagingMemory::Allocate(image.GetSize())));
+		std::memcpy(copy.pixels.get(), image.pixels.get(), image.GetSize());
+		return copy;
+	}
+}
+
+uint32_t MipGenerator::GetFullLevelCount(uint32_t width, uint32_t height) {
+	uint32_t levelCount = 1;
+	while (std::max(width, height) >> levelCount)
+		++levelCount;
+	return levelCount;
+}
+
+bool MipGenerator::Generate(DecodedImage& image, const MipSettings& settings, ThreadPool* threadPool) {
+	if (!image.IsValid() || image.width == 0 || image.height == 0) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to generate the mips of image ", image.id, ": the image is empty.");
+		return false;
+	}
+
+	// Anything below the top level is regenerated
+	DecodedImage chain;
+	chain.id = image.id;
+	chain.width = image.width;
+	chain.height = image.height;
+	chain.sourceChannels = image.sourceChannels;
+	chain.levelCount = GetFullLevelCount(image.width, image.height);
+	if (settings.maxLevelCount != 0)
+		chain.levelCount = std::min(chain.levelCount, settings.maxLevelCount);
+	chain.pixels.reset(static_cast<uint8_t*>(StagingMemory::Allocate(chain.GetSize())));
+	if (chain.pixels == nullptr) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to generate the mips of image ", image.id, ": out of memory.");
+		return false;
+	}
+	std::memcpy(chain.pixels.get(), image.pixels.get(), image.GetLevelSize(0));
+
+	if (chain.levelCount > 1) {
+		// Linear float4 texels. The top level is decoded row by row by the first horizontal pass instead of
+		// being converted as a whole: `filtered` holds a horizontally filtered level (width of the next level,
+		// height of the current one), `levels` the two last levels.
+		const uint32_t width1 = chain.GetLevelWidth(1);
+		const uint32_t height1 = chain.GetLevelHeight(1);
+		const size_t levelFloats = size_t(width1) * height1 * 4;
+		StagingMemory::Buffer filtered(static_cast<uint8_t*>(StagingMemory::Allocate(size_t(width1) * image.height * 4 * sizeof(float))));
+		StagingMemory::Buffer levels[2] = {
+			StagingMemory::Buffer(static_cast<uint8_t*>(StagingMemory::Allocate(levelFloats * sizeof(float)))),
+			StagingMemory::Buffer(static_cast<uint8_t*>(StagingMemory::Allocate(levelFloats * sizeof(float))))
+		};
+		if (filtered == nullptr || levels[0] == nullptr || levels[1] == nullptr) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to generate the mips of image ", image.id, ": out of memory.");
+			return false;
+		}
+		float* filteredTexels = reinterpret_cast<float*>(filtered.get());
+
+		float targetCoverage = 0.0f;
+		if (settings.preserveAlphaCoverage) {
+			const uint8_t* pixels = image.pixels.get();
+			const size_t texelCount = size_t(image.width) * image.height;
+			size_t passing = 0;
+			for (size_t i = 0; i < texelCount; ++i)
+				passing += pixels[i * 4 + 3] / 255.0f >= settings.alphaCutoff ? 1 : 0;
+			targetCoverage = static_cast<float>(passing) / texelCount;
+		}
+
+		std::vector<float> alphas;
+		const float* current = nullptr;  // Level `level - 1`, null for the top level which is read as RGBA8
+		for (uint32_t level = 1; level < chain.levelCount; ++level) {
+			const uint32_t sourceWidth = chain.GetLevelWidth(level - 1);
+			const uint32_t sourceHeight = chain.GetLevelHeight(level - 1);
+			const uint32_t width = chain.GetLevelWidth(level);
+			const uint32_t height = chain.GetLevelHeight(level);
+			float* next = reinterpret_cast<float*>(levels[level & 1].get());
+
+			// Horizontal pass, straight into the level when its height doesn't change
+			const float* horizontal = current;
+			if (current == nullptr || width != sourceWidth) {
+				float* output = height == sourceHeight ? next : filteredTexels;
+				const AxisWeights axis = ComputeAxisWeights(sourceWidth, width, settings.filter, settings.edgeMode);
+				const uint8_t* pixels = image.pixels.get();
+				const bool filterRows = width != sourceWidth;
+				ForRows(threadPool, sourceHeight, sourceWidth, [&](size_t begin, size_t end) {
+					std::vector<float> decoded(current == nullptr && filterRows ? size_t(sourceWidth) * 4 + 4 : 0);
+					// Aligned for the float4 loads
+					float* decodedRow = reinterpret_cast<float*>((reinterpret_cast<uintptr_t>(decoded.data()) + 15) & ~uintptr_t(15));
+					for (size_t y = begin; y < end; ++y) {
+						float* outputRow = output + y * width * 4;
+						if (current == nullptr && !filterRows) {
+							DecodeRow(pixels + y * sourceWidth * 4, sourceWidth, settings.sRGB, outputRow);
+							continue;
+						}
+						const float* sourceRow = current + y * sourceWidth * 4;
+						if (current == nullptr) {
+							DecodeRow(pixels + y * sourceWidth * 4, sourceWidth, settings.sRGB, decodedRow);
+							sourceRow = decodedRow;
+						}
+						FilterRow(sourceRow, axis, width, outputRow);
+					}
+				});
+				horizontal = output;
+			}
+
+			// Vertical pass
+			if (height != sourceHeight) {
+				const AxisWeights axis = ComputeAxisWeights(sourceHeight, height, settings.filter, settings.edgeMode);
+				ForRows(threadPool, height, width, [&](size_t begin, size_t end) {
+					for (size_t y = begin; y < end; ++y)
+						FilterColumns(horizontal, width, axis, static_cast<uint32_t>(y), next + y * width * 4);
+				});
+			}
+
+			float alphaScale = 1.0f;
+			if (settings.preserveAlphaCoverage)
+				alphaScale = ComputeAlphaScale(next, size_t(width) * height, settings.alphaCutoff, targetCoverage, alphas);
+
+			uint8_t* destination = chain.pixels.get() + chain.GetLevelOffset(level);
+			ForRows(threadPool, height, width, [&](size_t begin, size_t end) {
+				for (size_t y = begin; y < end; ++y)
+					EncodeRow(next + y * width * 4, width, settings.sRGB, alphaScale, destination + y * width * 4);
+			});
+
+			// The next level is filtered from the unscaled alpha, the scale doesn't compound
+			current = next;
+		}
+	}
+
+	image = std::move(chain);
+	return true;
+}
+
+void MipGenerator::Generate(std::vector<DecodedImage>& images, const MipSettings& settings, ThreadPool& threadPool) {
+	threadPool.ParallelFor(images.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			if (images[i].IsValid())
+				Generate(images[i], settings, &threadPool);
+		}
+	});
+}
+
+void MipGenerator::Benchmark(ThreadPool& threadPool) {
+	using Clock = std::chrono::high_resolution_clock;
+	auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); };
+
+	std::mt19937 random(42);
+	auto createImage = [&random](uint32_t width, uint32_t height, bool cutout) {
+		DecodedImage image;
+		image.width = width;
+		image.height = height;
+		image.sourceChannels = 4;
+		image.pixels.reset(static_cast<uint8_t*>(StagingMemory::Allocate(image.GetSize())));
+		uint8_t* pixels = image.pixels.get();
+		for (uint32_t y = 0; y < height; ++y) {
+			for (uint32_t x = 0; x < width; ++x) {
+				uint8_t* texel = pixels + (size_t(y) * width + x) * 4;
+				// Checkers and gradients with some noise, the kind of detail that aliases without mips
+				uint8_t checker = ((x / 8 + y / 8) & 1) ? 200 : 40;
+				texel[0] = static_cast<uint8_t>(checker ^ (random() & 15));
+				texel[1] = static_cast<uint8_t>(x * 255 / width);
+				texel[2] = static_cast<uint8_t>(y * 255 / height);
+				// Thin leaf stripes, a third of the texels opaque
+				texel[3] = cutout ? ((x + y / 2) % 6 < 2 ? 255 : 0) : 255;
+			}
+		}
+		return image;
+	};
+
+	struct Case {
+		const char* name;
+		DecodedImage image;
+	};
+	Case cases[] = {
+		{ "2048x2048", createImage(2048, 2048, false) },
+		{ "1000x600 (non-power-of-two)", createImage(1000, 600, false) }
+	};
+
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Mip generation benchmark, ", threadPool.GetThreadCount() + 1, " threads:");
+	for (const Case& testCase : cases) {
+		const float megaTexels = testCase.image.width * testCase.image.height / 1e6f;
+		for (MipFilter filter : { MipFilter::Box, MipFilter::Kaiser }) {
+			MipSettings settings;
+			settings.filter = filter;
+
+			DecodedImage singleThreaded = CopyImage(testCase.image);
+			auto start = Clock::now();
+			Generate(singleThreaded, settings);
+			float singleMs = elapsedMs(start);
+
+			DecodedImage multiThreaded = CopyImage(testCase.image);
+			start = Clock::now();
+			Generate(multiThreaded, settings, &threadPool);
+			float poolMs = elapsedMs(start);
+
+			bool identical = std::memcmp(singleThreaded.pixels.get(), multiThreaded.pixels.get(), singleThreaded.GetSize()) == 0;
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "  ", testCase.name, ", ", filter == MipFilter::Box ? "box" : "Kaiser", ", ",
+				singleThreaded.levelCount, " levels: ", singleMs, " ms on one thread (", megaTexels / (singleMs / 1000.0f), " MTexels/s), ", poolMs,
+				" ms on the pool", identical ? "" : " (results differ!)");
+		}
+	}
+
+	// Many textures at once, one task per texture
+	constexpr size_t BATCH_IMAGE_COUNT = 16;
+	DecodedImage batchSource = createImage(1024, 1024, false);
+	std::vector<DecodedImage> batch;
+	for (size_t i = 0; i < BATCH_IMAGE_COUNT; ++i)
+		batch.push_back(CopyImage(batchSource));
+	auto start = Clock::now();
+	Generate(batch, MipSettings{}, threadPool);
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "  ", BATCH_IMAGE_COUNT, " textures of 1024x1024, Kaiser: ", elapsedMs(start), " ms on the pool");
+
+	// Fraction of texels passing the alpha test per level
+	DecodedImage cutout = createImage(512, 512, true);
+	auto coverage = [](const DecodedImage& image, uint32_t level, float cutoff) {
+		const uint8_t* pixels = image.pixels.get() + image.GetLevelOffset(level);
+		const size_t texelCount = size_t(image.GetLevelWidth(level)) * image.GetLevelHeight(level);
+		size_t passing = 0;
+		for (size_t i = 0; i < texelCount; ++i)
+			passing += pixels[i * 4 + 3] / 255.0f >= cutoff ? 1 : 0;
+		return 100.0f * passing / texelCount;
+	};
+	MipSettings cutoutSettings;
+	cutoutSettings.alphaCutoff = 0.5f;
+	DecodedImage plain = CopyImage(cutout);
+	Generate(plain, cutoutSettings, &threadPool);
+	cutoutSettings.preserveAlphaCoverage = true;
+	DecodedImage preserved = CopyImage(cutout);
+	Generate(preserved, cutoutSettings, &threadPool);
+	for (uint32_t level = 0; level < plain.levelCount; level += 2) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "  alpha coverage of a 512x512 cutout, level ", level, ": ", coverage(plain, level, cutoutSettings.alphaCutoff),
+			"% without preservation, ", coverage(preserved, level, cutoutSettings.alphaCutoff), "% with");
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef MIP_GENERATOR_H
+#define MIP_GENERATOR_H
+
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+struct DecodedImage;
+
+
+enum class MipFilter : uint8_t {
+	Box,    // Average of the texels under each destination texel, sharpest aliasing but cheapest
+	Kaiser  // Kaiser windowed sinc (width 3, alpha 4), keeps more detail without ringing much
+};
+
+// Texels the filter reads past the edges of the image
+enum class MipEdgeMode : uint8_t {
+	Clamp,
+	Wrap  // Tiling textures, glTF samplers repeat by default
+};
+
+struct MipSettings {
+	MipFilter filter = MipFilter::Kaiser;
+	MipEdgeMode edgeMode = MipEdgeMode::Wrap;
+	// Color textures are filtered in linear space, data textures (normals, roughness...) as they are
+	bool sRGB = true;
+	// Cutout textures: scales the alpha of every level so the fraction of texels passing the alpha test
+	// stays the one of the top level, instead of the foliage thinning out with the distance
+	bool preserveAlphaCoverage = false;
+	float alphaCutoff = 0.5f;
+	// Levels to generate, the top one included. 0 for the full chain down to 1x1.
+	uint32_t maxLevelCount = 0;
+};
+
+// Import time generation of mip chains for RGBA8 images.
+//
+// Texels are converted to linear floats (sRGB decoded through a table), then every level is filtered from
+// the previous one with a separable resampler: the weights of each axis are computed once per level, so
+// non-power-of-two sizes get the exact footprint of every destination texel (e.g. 5 -> 2 spans 2.5 texels)
+// instead of dropping a row or column. Filtering is SSE, one float4 texel per register, and the rows of
+// every level are split over the pool workers. Levels are written back as RGBA8 with an exact rounding
+// sRGB encoder; the top level is copied as is.
+namespace MipGenerator {
+	// Levels of a full chain, sizes are halved and rounded down like D3D does
+	uint32_t GetFullLevelCount(uint32_t width, uint32_t height);
+
+	// Replaces the pixels of a single level image with the chain (see DecodedImage::levelCount).
+	// Rows are split over the workers of `threadPool` if given. Returns false for invalid images.
+	bool Generate(DecodedImage& image, const MipSettings& settings, ThreadPool* threadPool = nullptr);
+	// Generates the chains of many images, one task per image on the pool
+	void Generate(std::vector<DecodedImage>& images, const MipSettings& settings, ThreadPool& threadPool);
+
+	// Times both filters on synthetic power-of-two and non-power-of-two images, on one thread and on the pool,
+	// and the alpha coverage of the small levels with and without coverage preservation, then logs them
+	void Benchmark(ThreadPool& threadPool);
+}
+
+#endif // !MIP_GENERATOR_H
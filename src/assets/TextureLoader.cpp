@@ -0,0 +1,217 @@
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <filesystem>
+#include <iterator>
+#include <thread>
+
+#include "GltfAsset.h"
+#include "../utils/ConsoleLogger.h"
+#include "../utils/MappedFile.h"
+#include "../utils/ThreadPool.h"
+
+// Every allocation of stb_image goes through the staging pool, its scratch buffers and the decoded pixels.
+// The zlib output buffer of PNG grows by doubling through STBI_REALLOC, which the size classes mostly absorb in place.
+#define STBI_MALLOC(size) StagingMemory::Allocate(size)
+#define STBI_REALLOC(memory, size) StagingMemory::Reallocate(memory, size)
+#define STBI_FREE(memory) StagingMemory::Free(memory)
+// Sources are always mapped or already in memory
+#define STBI_NO_STDIO
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+
+TextureLoader::TextureLoader(ThreadPool& threadPool) : m_threadPool(threadPool) {
+}
+
+TextureLoader::~TextureLoader() {
+	// The tasks reference the loader
+	WaitIdle();
+}
+
+void TextureLoader::Load(uint32_t id, const std::string& filePath, const std::optional<MipSettings>& mipSettings) {
+	TextureSource source;
+	source.id = id;
+	source.filePath = filePath;
+	source.mipSettings = mipSettings;
+	Enqueue(std::move(source));
+}
+
+void TextureLoader::Load(std::vector<TextureSource> sources) {
+	std::vector<std::pair<uintmax_t, size_t>> order;
+	order.reserve(sources.size());
+	for (size_t i = 0; i < sources.size(); ++i) {
+		uintmax_t size = sources[i].size;
+		if (sources[i].data == nullptr) {
+			// Missing files sort last, the decode logs the error
+			std::error_code error;
+			size = std::filesystem::file_size(sources[i].filePath, error);
+			if (error)
+				size = 0;
+		}
+		order.emplace_back(size, i);
+	}
+	std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	for (const auto& entry : order)
+		Enqueue(std::move(sources[entry.second]));
+}
+
+void TextureLoader::Enqueue(TextureSource source) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_pendingCount;
+	}
+	m_threadPool.Submit([this, source = std::move(source)]() {
+		DecodedImage image = Decode(source);
+		// Large images also split their rows over the pool, ParallelFor runs them here if every worker is busy
+		if (image.IsValid() && source.mipSettings)
+			MipGenerator::Generate(image, *source.mipSettings, &m_threadPool);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decoded.push_back(std::move(image));
+		if (--m_pendingCount == 0)
+			m_idleCondition.notify_all();
+	});
+}
+
+DecodedImage TextureLoader::Decode(const TextureSource& source) const {
+	DecodedImage image;
+	image.id = source.id;
+
+	MappedFile file;
+	const uint8_t* data = source.data;
+	size_t size = source.size;
+	if (data == nullptr) {
+		if (!file.Open(source.filePath))
+			return image;
+		data = file.GetData();
+		size = file.GetSize();
+	}
+	if (size == 0 || size > INT_MAX) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to decode image ", source.filePath, ": unsupported size of ", size, " bytes.");
+		return image;
+	}
+
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* pixels = stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channels, 4);
+	if (pixels == nullptr) {
+		// The failure reason is thread local
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to decode image ", source.filePath, ": ", stbi_failure_reason(), ".");
+		return image;
+	}
+	image.width = static_cast<uint32_t>(width);
+	image.height = static_cast<uint32_t>(height);
+	image.sourceChannels = static_cast<uint32_t>(channels);
+	image.pixels.reset(pixels);
+	return image;
+}
+
+size_t TextureLoader::PopDecoded(std::vector<DecodedImage>& images, size_t maxCount) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	size_t count = std::min(maxCount, m_decoded.size());
+	// Oldest first, the order they finished in
+	std::move(m_decoded.begin(), m_decoded.begin() + count, std::back_inserter(images));
+	m_decoded.erase(m_decoded.begin(), m_decoded.begin() + count);
+	return count;
+}
+
+void TextureLoader::WaitIdle() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idleCondition.wait(lock, [this]() { return m_pendingCount == 0; });
+}
+
+size_t TextureLoader::GetPendingCount() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pendingCount;
+}
+
+void TextureLoader::Benchmark(const std::string& gltfPath) {
+	using Clock = std::chrono::high_resolution_clock;
+	auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); };
+
+	GltfAsset asset;
+	if (!asset.Load(gltfPath)) {
+		// The image files may be there while a buffer (Sponza.bin) is missing, point at the error of the loader
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Texture decoding benchmark of ", gltfPath,
+			" aborted: the file or one of its buffers failed to load, see the error above.");
+		return;
+	}
+
+	std::vector<TextureSource> sources;
+	for (uint32_t i = 0; i < asset.GetImages().size(); ++i) {
+		TextureSource source;
+		source.id = i;
+		source.filePath = asset.GetImages()[i].uri;
+		if (source.filePath.empty()) {
+			GltfByteRange data = asset.GetImageData(i);
+			source.filePath = gltfPath + " (image " + std::to_string(i) + ")";
+			source.data = data.data;
+			source.size = data.size;
+		}
+		sources.push_back(std::move(source));
+	}
+	std::string fileName = std::filesystem::path(gltfPath).filename().string();
+	if (sources.empty()) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "Texture decoding benchmark of ", fileName, ": the file has no images.");
+		return;
+	}
+
+	// Decodes every image on `threadCount` workers, the pool is created before the timer starts
+	auto decodeAll = [&](size_t threadCount, size_t& decodedCount, size_t& decodedBytes) {
+		ThreadPool threadPool(threadCount);
+		TextureLoader loader(threadPool);
+		auto start = Clock::now();
+		loader.Load(sources);
+		loader.WaitIdle();
+		float ms = elapsedMs(start);
+
+		std::vector<DecodedImage> images;
+		loader.PopDecoded(images);
+		decodedCount = 0;
+		decodedBytes = 0;
+		for (const DecodedImage& image : images) {
+			decodedCount += image.IsValid() ? 1 : 0;
+			decodedBytes += image.IsValid() ? image.GetSize() : 0;
+		}
+		return ms;
+	};
+
+	const size_t hardwareThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	size_t decodedCount = 0;
+	size_t decodedBytes = 0;
+
+	// The first pass reads the files from disk and fills the staging pool, the timed passes decode from the file cache
+	StagingMemory::Stats stats = StagingMemory::GetStats();
+	float coldMs = decodeAll(hardwareThreads, decodedCount, decodedBytes);
+	StagingMemory::Stats coldStats = StagingMemory::GetStats();
+	if (decodedCount == 0) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Texture decoding benchmark of ", fileName, " aborted: none of its ", sources.size(),
+			" images could be decoded.");
+		return;
+	}
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Texture decoding benchmark of ", fileName, ": ", decodedCount, "/", sources.size(),
+		" images, ", decodedBytes / 1048576.0f, " MB decoded. Cold pass on ", hardwareThreads, " threads: ", coldMs, " ms, ",
+		coldStats.systemAllocations - stats.systemAllocations, " system allocations, ", coldStats.pooledAllocations - stats.pooledAllocations,
+		" pooled, peak staging memory ", coldStats.peakLiveBytes / 1048576.0f, " MB.");
+
+	std::vector<size_t> threadCounts;
+	for (size_t threadCount = 1; threadCount < hardwareThreads; threadCount *= 2)
+		threadCounts.push_back(threadCount);
+	threadCounts.push_back(hardwareThreads);
+
+	float singleThreadMs = 0.0f;
+	for (size_t threadCount : threadCounts) {
+		stats = StagingMemory::GetStats();
+		float ms = decodeAll(threadCount, decodedCount, decodedBytes);
+		StagingMemory::Stats passStats = StagingMemory::GetStats();
+		if (threadCount == 1)
+			singleThreadMs = ms;
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "  ", threadCount, " threads: ", ms, " ms (", decodedBytes / 1048576.0f / std::max(ms / 1000.0f, 1e-6f),
+			" MB/s, speedup ", singleThreadMs / std::max(ms, 1e-6f), "x), ", passStats.systemAllocations - stats.systemAllocations, " system allocations, ",
+			passStats.pooledAllocations - stats.pooledAllocations, " pooled.");
+	}
+}
@@ -0,0 +1,99 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "MipGenerator.h"
+#include "../utils/StagingMemory.h"
+
+class ThreadPool;
+
+
+// An image decoded to RGBA8, its pixels live in staging memory until the image is destroyed
+struct DecodedImage {
+	uint32_t id = 0;  // Given to TextureLoader::Load
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t sourceChannels = 0;  // Channels stored in the file, the pixels always have four
+	uint32_t levelCount = 1;      // Mip levels in `pixels`, see MipGenerator
+	StagingMemory::Buffer pixels;  // Tightly packed rows of every level, largest first. Null if the decode failed.
+
+	bool IsValid() const { return pixels != nullptr; }
+	uint32_t GetLevelWidth(uint32_t level) const { return std::max(width >> level, 1u); }
+	uint32_t GetLevelHeight(uint32_t level) const { return std::max(height >> level, 1u); }
+	uint32_t GetRowPitch(uint32_t level = 0) const { return GetLevelWidth(level) * 4; }
+	size_t GetLevelSize(uint32_t level) const { return size_t(GetRowPitch(level)) * GetLevelHeight(level); }
+	// Bytes before a level, GetLevelOffset(levelCount) is the size of the whole chain
+	size_t GetLevelOffset(uint32_t level) const {
+		size_t offset = 0;
+		for (uint32_t i = 0; i < level; ++i)
+			offset += GetLevelSize(i);
+		return offset;
+	}
+	size_t GetSize() const { return GetLevelOffset(levelCount); }
+};
+
+// Encoded image to decode: a file, or bytes already in memory (embedded glTF images)
+struct TextureSource {
+	uint32_t id = 0;
+	std::string filePath;          // Also used as the name in the logs for in-memory sources
+	const uint8_t* data = nullptr;  // In-memory sources only, must stay valid until the image is decoded
+	size_t size = 0;
+	// Generates the mip chain on the worker right after the decode
+	std::optional<MipSettings> mipSettings;
+};
+
+// Decodes JPEG/PNG/TGA/BMP images on the workers of a thread pool.
+//
+// Every image is one task: files are mapped and decoded with stb_image straight from the mapping, and
+// every buffer stb_image allocates, the decoded pixels included, comes from StagingMemory. The same task
+// generates the mip chain if the source asks for one. Finished images wait in a queue until the render
+// thread pops them and creates the textures (see Texture::Initialize), so the render thread never decodes
+// and the workers never touch the device.
+class TextureLoader {
+	public:
+		explicit TextureLoader(ThreadPool& threadPool);
+		// Waits for the decodes in flight, the images not popped yet are dropped
+		~TextureLoader();
+
+		TextureLoader(const TextureLoader&) = delete;
+		TextureLoader& operator=(const TextureLoader&) = delete;
+
+		// Queues the decode of an image file, with its mip chain if `mipSettings` is given
+		void Load(uint32_t id, const std::string& filePath, const std::optional<MipSettings>& mipSettings = std::nullopt);
+		// Queues a batch, the largest encoded images first so a long decode doesn't start last and
+		// keep a single worker busy while the others are idle
+		void Load(std::vector<TextureSource> sources);
+
+		// Moves up to `maxCount` finished images at the end of `images`, failed decodes included
+		// (already logged, see DecodedImage::IsValid). Returns the number of images moved.
+		size_t PopDecoded(std::vector<DecodedImage>& images, size_t maxCount = SIZE_MAX);
+		// Blocks until every queued image is decoded
+		void WaitIdle();
+		// Images queued or decoding
+		size_t GetPendingCount() const;
+
+		// Decodes every image of a glTF file with 1, 2, 4... up to one thread per hardware thread and
+		// logs the wall times with the decoded sizes and the staging memory reuse
+		static void Benchmark(const std::string& gltfPath);
+
+	private:
+		void Enqueue(TextureSource source);
+		DecodedImage Decode(const TextureSource& source) const;
+
+	private:
+		ThreadPool& m_threadPool;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_idleCondition;
+		std::vector<DecodedImage> m_decoded;
+		size_t m_pendingCount = 0;
+};
+
+#endif // !TEXTURE_LOADER_H
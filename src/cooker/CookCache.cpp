@@ -0,0 +1,160 @@
+#include "CookCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "../utils/ConsoleLogger.h"
+#include "../utils/MappedFile.h"
+
+
+namespace {
+	constexpr const char* COOK_CACHE_MAGIC = "PenumbraCookCache";
+
+	// Size and write time of a file, false if it doesn't exist
+	bool GetStamp(const std::string& filePath, uint64_t& size, int64_t& writeTime) {
+		std::error_code error;
+		size = std::filesystem::file_size(filePath, error);
+		if (error)
+			return false;
+		writeTime = static_cast<int64_t>(std::filesystem::last_write_time(filePath, error).time_since_epoch().count());
+		return !error;
+	}
+
+	bool ReadHash(std::istringstream& line, Hash128& hash) {
+		std::string text;
+		return static_cast<bool>(line >> text) && Hash::FromString(text, hash);
+	}
+
+	// Paths are last on their line, they can have spaces
+	std::string ReadPath(std::istringstream& line) {
+		std::string path;
+		std::getline(line >> std::ws, path);
+		return path;
+	}
+}
+
+void CookCache::Load(const std::string& filePath) {
+	m_nodes.clear();
+	m_nodesByOutput.clear();
+	m_inputsByPath.clear();
+	m_complete = false;
+
+	// PenumbraCookCache <version> <settings hash> <complete>
+	std::ifstream file(filePath);
+	std::string text;
+	if (!std::getline(file, text))
+		return;
+	std::istringstream header(text);
+	std::string magic;
+	uint32_t version = 0;
+	int complete = 0;
+	if (!(header >> magic >> version) || magic != COOK_CACHE_MAGIC || version != COOKER_VERSION || !ReadHash(header, m_settingsHash) || !(header >> complete))
+		return;
+
+	// node <hash> <output size> <input count> <output path>
+	// input <hash> <size> <write time> <path>
+	// A truncated or malformed cache is dropped, the scene is cooked again
+	while (std::getline(file, text)) {
+		std::istringstream line(text);
+		std::string kind;
+		size_t inputCount = 0;
+		CookNode& node = m_nodes.emplace_back();
+		if (!(line >> kind) || kind != "node" || !ReadHash(line, node.hash) || !(line >> node.outputSize >> inputCount)) {
+			m_nodes.clear();
+			return;
+		}
+		node.outputPath = ReadPath(line);
+		for (size_t i = 0; i < inputCount; ++i) {
+			CookInput& input = node.inputs.emplace_back();
+			std::istringstream inputLine(std::getline(file, text) ? text : std::string());
+			if (!(inputLine >> kind) || kind != "input" || !ReadHash(inputLine, input.hash) || !(inputLine >> input.size >> input.writeTime)) {
+				m_nodes.clear();
+				return;
+			}
+			input.path = ReadPath(inputLine);
+		}
+	}
+
+	for (size_t i = 0; i < m_nodes.size(); ++i) {
+		m_nodesByOutput[m_nodes[i].outputPath] = i;
+		for (const CookInput& input : m_nodes[i].inputs)
+			m_inputsByPath[input.path] = &input;
+	}
+	m_complete = complete != 0;
+}
+
+bool CookCache::Save(const std::string& filePath, const std::vector<CookNode>& nodes, const Hash128& settingsHash, bool complete) {
+	// Written next to the destination and renamed once complete, like the outputs
+	std::string temporaryPath = filePath + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::trunc);
+		file << COOK_CACHE_MAGIC << " " << COOKER_VERSION << " " << Hash::ToString(settingsHash) << " " << (complete ? 1 : 0) << "\n";
+		for (const CookNode& node : nodes) {
+			file << "node " << Hash::ToString(node.hash) << " " << node.outputSize << " " << node.inputs.size() << " " << node.outputPath << "\n";
+			for (const CookInput& input : node.inputs)
+				file << "input " << Hash::ToString(input.hash) << " " << input.size << " " << input.writeTime << " " << input.path << "\n";
+		}
+		if (!file) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the cook cache ", temporaryPath, ".");
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, filePath, error);
+	if (error) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to write the cook cache ", filePath, ": ", error.message());
+		return false;
+	}
+	return true;
+}
+
+bool CookCache::IsUpToDate(const std::string& scenePath, const Hash128& settingsHash) const {
+	// A cook that failed left outputs missing that no node records, it's never skipped
+	if (!m_complete || m_settingsHash != settingsHash || m_inputsByPath.find(scenePath) == m_inputsByPath.end())
+		return false;
+	for (const CookNode& node : m_nodes) {
+		if (GetFileSize(node.outputPath) != node.outputSize)
+			return false;
+		for (const CookInput& input : node.inputs) {
+			uint64_t size;
+			int64_t writeTime;
+			if (!GetStamp(input.path, size, writeTime) || size != input.size || writeTime != input.writeTime)
+				return false;
+		}
+	}
+	return true;
+}
+
+bool CookCache::HashInput(const std::string& filePath, CookInput& input) const {
+	input.path = filePath;
+	if (!GetStamp(filePath, input.size, input.writeTime)) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to read the cook input ", filePath, ".");
+		return false;
+	}
+
+	auto cached = m_inputsByPath.find(filePath);
+	if (cached != m_inputsByPath.end() && cached->second->size == input.size && cached->second->writeTime == input.writeTime) {
+		input.hash = cached->second->hash;
+		return true;
+	}
+
+	MappedFile file;
+	if (input.size > 0 && !file.Open(filePath))
+		return false;
+	input.hash = Hash::Murmur3(file.GetData(), file.GetSize());
+	return true;
+}
+
+bool CookCache::IsCooked(const CookNode& node) const {
+	auto cached = m_nodesByOutput.find(node.outputPath);
+	return cached != m_nodesByOutput.end() && m_nodes[cached->second].hash == node.hash &&
+		GetFileSize(node.outputPath) == m_nodes[cached->second].outputSize;
+}
+
+uint64_t CookCache::GetFileSize(const std::string& filePath) {
+	std::error_code error;
+	uint64_t size = std::filesystem::file_size(filePath, error);
+	return error ? 0 : size;
+}
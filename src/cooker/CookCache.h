@@ -0,0 +1,69 @@
+#ifndef COOK_CACHE_H
+#define COOK_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../utils/Hash.h"
+
+
+// Bumped whenever the cooker writes different outputs from the same inputs and settings (importer or
+// encoder changes): every output is cooked again
+constexpr uint32_t COOKER_VERSION = 2;
+
+// A file an output is cooked from, with the stamp that lets the next cook skip hashing it again
+struct CookInput {
+	std::string path;
+	uint64_t size = 0;
+	int64_t writeTime = 0;
+	Hash128 hash;  // Of the content
+};
+
+// A node of the cook graph: an output and the files it's cooked from. `hash` combines the content of
+// everything the output depends on (input files or parts of them, settings, format versions), the output
+// is up to date as long as it doesn't change.
+struct CookNode {
+	std::string outputPath;
+	Hash128 hash;
+	uint64_t outputSize = 0;  // Once cooked
+	std::vector<CookInput> inputs;
+};
+
+// The graph of the previous cook of a scene, saved next to its outputs (<scene.pmesh>.cookcache).
+//
+// A cook first checks the stamps (size, write time) of every input and output of the previous graph: if
+// none changed, the previous cook succeeded and was made with the same settings, nothing is even parsed.
+// Otherwise the graph is built again from the sources, the content of the inputs whose stamp changed is
+// hashed again, and only the nodes whose hash changed are cooked.
+class CookCache {
+	public:
+		// Reads the cache of a previous cook. A missing cache, or one of another cooker version, is empty.
+		void Load(const std::string& filePath);
+		// Writes the graph of the cook, its nodes that failed left out so they're cooked again next time.
+		// `settingsHash` covers what the cook depends on besides its inputs (versions, settings, store),
+		// `complete` is false if anything failed. Logs and returns false on failure.
+		static bool Save(const std::string& filePath, const std::vector<CookNode>& nodes, const Hash128& settingsHash, bool complete);
+
+		// True if the cache is of a complete cook of `scenePath` with the same settings, and every input and
+		// output has the stamp it had after it
+		bool IsUpToDate(const std::string& scenePath, const Hash128& settingsHash) const;
+		// Stamps an input file and hashes its content, unless the cache has it with the same stamp.
+		// Logs and returns false if the file can't be read.
+		bool HashInput(const std::string& filePath, CookInput& input) const;
+		// True if the previous cook wrote the same node and its output is still there
+		bool IsCooked(const CookNode& node) const;
+
+		// Size of a file, 0 if it doesn't exist
+		static uint64_t GetFileSize(const std::string& filePath);
+
+	private:
+		std::vector<CookNode> m_nodes;
+		std::unordered_map<std::string, size_t> m_nodesByOutput;
+		std::unordered_map<std::string, const CookInput*> m_inputsByPath;
+		Hash128 m_settingsHash;
+		bool m_complete = false;
+};
+
+#endif // !COOK_CACHE_H
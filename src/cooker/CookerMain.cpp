@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "CookCache.h"
+#include "../assets/BlockCompression.h"
+#include "../assets/ContentStore.h"
+#include "../assets/CookedMesh.h"
+#include "../assets/CookedTexture.h"
+#include "../assets/GltfAsset.h"
+#include "../assets/GltfImporter.h"
+#include "../assets/MipGenerator.h"
+#include "../assets/TextureLoader.h"
+#include "../geometry/MeshParts.h"
+#include "../utils/ConsoleLogger.h"
+#include "../utils/Hash.h"
+#include "../utils/ThreadPool.h"
+
+
+// Penumbra-Cooker: converts source assets into the engine native formats, offline.
+//
+//     Penumbra-Cooker <scene.gltf|scene.glb> <scene.pmesh> [store folder, "store" by default]
+//
+// Every primitive instance of the default scene is imported (welding, tangents, optimization), split in
+// parts with their meshlets and levels of detail, and written as a cooked mesh (see CookedMesh.h), so the
+// engine loads it with a mapping and uploads it without touching the elements.
+// The images of the materials are decoded, given their mip chains, block compressed and written as cooked
+// textures (see CookedTexture.h) in the content store shared by every scene (see ContentStore.h), listed by
+// an index next to the cooked mesh. An image several scenes use the same way is cooked once.
+//
+// Cooks are incremental (see CookCache.h): the cooked mesh and every cooked texture are nodes hashed from
+// the content of their inputs and their settings, only the nodes whose hash changed are cooked again, the
+// mesh and the textures at the same time. A cook with no source or setting changed since a cook that
+// succeeded returns before parsing the scene.
+
+namespace {
+	struct TextureCookSettings {
+		MipSettings mipSettings;
+		CompressionSettings compressionSettings;
+	};
+
+	// The role of an image in the materials picks its format: color (base color, emissive) is sRGB BC7,
+	// normal maps are BC5 (X and Y only), packed data (metallic-roughness, occlusion) is linear BC7
+	std::vector<std::optional<TextureCookSettings>> GetTextureCookSettings(const GltfAsset& asset) {
+		std::vector<std::optional<TextureCookSettings>> settings(asset.GetImages().size());
+		auto assign = [&asset, &settings](const GltfTextureInfo& info, BlockFormat format, bool sRGB, const GltfMaterial* cutoutMaterial) {
+			if (info.texture >= asset.GetTextures().size())
+				return;
+			const GltfTexture& texture = asset.GetTextures()[info.texture];
+			// An image used in several roles keeps the first one
+			if (texture.source >= settings.size() || settings[texture.source].has_value())
+				return;
+
+			TextureCookSettings& cook = settings[texture.source].emplace();
+			cook.compressionSettings.format = format;
+			cook.compressionSettings.quality = CompressionQuality::Normal;
+			cook.compressionSettings.sRGB = sRGB;
+			cook.mipSettings.sRGB = sRGB;
+			constexpr uint32_t GL_CLAMP_TO_EDGE = 33071;
+			if (texture.sampler < asset.GetSamplers().size() && asset.GetSamplers()[texture.sampler].wrapS == GL_CLAMP_TO_EDGE)
+				cook.mipSettings.edgeMode = MipEdgeMode::Clamp;
+			if (cutoutMaterial != nullptr) {
+				cook.mipSettings.preserveAlphaCoverage = true;
+				cook.mipSettings.alphaCutoff = cutoutMaterial->alphaCutoff;
+			}
+		};
+		for (const GltfMaterial& material : asset.GetMaterials()) {
+			assign(material.normalTexture, BlockFormat::BC5, false, nullptr);
+			assign(material.baseColorTexture, BlockFormat::BC7, true, material.alphaMode == GltfAlphaMode::Mask ? &material : nullptr);
+			assign(material.emissiveTexture, BlockFormat::BC7, true, nullptr);
+			assign(material.metallicRoughnessTexture, BlockFormat::BC7, false, nullptr);
+			assign(material.occlusionTexture, BlockFormat::BC7, false, nullptr);
+		}
+		return settings;
+	}
+
+	// Settings are hashed field by field, the padding of the structures would make their bytes unstable
+	uint64_t HashFloat(float value, uint64_t hash) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return Hash::FNV1aValue(bits, sizeof(bits), hash);
+	}
+
+	uint64_t HashImportSettings(const GltfImportSettings& settings) {
+		uint64_t hash = Hash::FNV1aValue(settings.weldVertices, 1);
+		hash = HashFloat(settings.weldSettings.positionEpsilon, hash);
+		hash = HashFloat(settings.weldSettings.attributeEpsilon, hash);
+		hash = Hash::FNV1aValue(settings.weldSettings.removeDegenerateTriangles, 1, hash);
+		hash = Hash::FNV1aValue(settings.generateTangents, 1, hash);
+		hash = Hash::FNV1aValue(settings.optimize, 1, hash);
+		hash = Hash::FNV1aValue(settings.optimizationSettings.optimizeOverdraw, 1, hash);
+		return HashFloat(settings.optimizationSettings.overdrawThreshold, hash);
+	}
+
+	uint64_t HashTextureCookSettings(const TextureCookSettings& settings) {
+		uint64_t hash = Hash::FNV1aValue(static_cast<uint32_t>(settings.mipSettings.filter), 4);
+		hash = Hash::FNV1aValue(static_cast<uint32_t>(settings.mipSettings.edgeMode), 4, hash);
+		hash = Hash::FNV1aValue(settings.mipSettings.sRGB, 1, hash);
+		hash = Hash::FNV1aValue(settings.mipSettings.preserveAlphaCoverage, 1, hash);
+		hash = HashFloat(settings.mipSettings.alphaCutoff, hash);
+		hash = Hash::FNV1aValue(settings.mipSettings.maxLevelCount, 4, hash);
+		hash = Hash::FNV1aValue(static_cast<uint32_t>(settings.compressionSettings.format), 4, hash);
+		hash = Hash::FNV1aValue(static_cast<uint32_t>(settings.compressionSettings.quality), 4, hash);
+		return Hash::FNV1aValue(settings.compressionSettings.sRGB, 1, hash);
+	}
+
+	// Key of a node from the hashes it depends on
+	Hash128 HashWords(const std::vector<uint64_t>& words) {
+		return Hash::Murmur3(words.data(), words.size() * sizeof(uint64_t));
+	}
+
+	// What a cook depends on besides its input files, known before the scene is parsed: the format versions,
+	// the import settings, the texture settings the materials start from, and the store the textures go to
+	Hash128 HashCookSettings(const GltfImportSettings& importSettings, const ContentStore& store) {
+		const std::string& root = store.GetRootDirectory();
+		const Hash128 rootHash = Hash::Murmur3(root.data(), root.size());
+		return HashWords({ COOKER_VERSION, COOKED_MESH_VERSION, COOKED_TEXTURE_VERSION, HashImportSettings(importSettings),
+			HashTextureCookSettings(TextureCookSettings()), rootHash.low, rootHash.high });
+	}
+
+	// The cooked mesh depends on the scene file, its external buffers and the import settings
+	bool BuildMeshNode(const GltfAsset& asset, const std::string& outputPath, const GltfImportSettings& importSettings, const CookCache& cache,
+		CookNode& node) {
+		node.outputPath = outputPath;
+		std::vector<uint64_t> words = { COOKER_VERSION, COOKED_MESH_VERSION, HashImportSettings(importSettings) };
+		std::vector<std::string> inputPaths = { asset.GetFilePath() };
+		for (const GltfBuffer& buffer : asset.GetBuffers()) {
+			if (!buffer.uri.empty() && std::find(inputPaths.begin(), inputPaths.end(), buffer.uri) == inputPaths.end())
+				inputPaths.push_back(buffer.uri);
+		}
+		for (const std::string& inputPath : inputPaths) {
+			CookInput& input = node.inputs.emplace_back();
+			if (!cache.HashInput(inputPath, input))
+				return false;
+			words.push_back(input.hash.low);
+			words.push_back(input.hash.high);
+		}
+		node.hash = HashWords(words);
+		return true;
+	}
+
+	// A cooked texture depends on the content of its image and its settings only, not on the scene: the key
+	// names its file in the content store, shared by every scene using the same image the same way.
+	// Embedded images are hashed from their bytes, the scene file is an input for its stamp only.
+	bool BuildTextureNode(const GltfAsset& asset, uint32_t image, const TextureCookSettings& settings, const ContentStore& store,
+		const CookCache& cache, CookNode& node) {
+		const std::string& uri = asset.GetImages()[image].uri;
+		CookInput& input = node.inputs.emplace_back();
+		if (!cache.HashInput(uri.empty() ? asset.GetFilePath() : uri, input))
+			return false;
+		Hash128 content = input.hash;
+		if (uri.empty()) {
+			GltfByteRange data = asset.GetImageData(image);
+			content = Hash::Murmur3(data.data, data.size);
+		}
+		node.hash = HashWords({ COOKER_VERSION, COOKED_TEXTURE_VERSION, HashTextureCookSettings(settings), content.low, content.high });
+		node.outputPath = store.GetPath(node.hash, ".ptex");
+		return true;
+	}
+
+	// Cooks `images` into `outputPaths` (indexed by image). Images are decoded a batch at a time, one per
+	// worker, so the decoded chains of a whole scene never sit in memory together; every image is then
+	// compressed on the pool.
+	bool CookTextures(const GltfAsset& asset, const std::vector<std::optional<TextureCookSettings>>& settings, const std::vector<uint32_t>& images,
+		const std::vector<std::string>& outputPaths, ThreadPool& threadPool, size_t& cookedCount, size_t& cookedBytes) {
+		std::vector<TextureSource> sources;
+		for (uint32_t i : images) {
+			TextureSource& source = sources.emplace_back();
+			source.id = i;
+			source.filePath = asset.GetImages()[i].uri;
+			if (source.filePath.empty()) {
+				GltfByteRange data = asset.GetImageData(i);
+				source.filePath = asset.GetFilePath() + " (image " + std::to_string(i) + ")";
+				source.data = data.data;
+				source.size = data.size;
+			}
+			source.mipSettings = settings[i]->mipSettings;
+		}
+
+		bool succeeded = true;
+		TextureLoader loader(threadPool);
+		const size_t batchSize = threadPool.GetThreadCount() + 1;
+		for (size_t batchStart = 0; batchStart < sources.size(); batchStart += batchSize) {
+			size_t batchEnd = std::min(batchStart + batchSize, sources.size());
+			loader.Load(std::vector<TextureSource>(sources.begin() + batchStart, sources.begin() + batchEnd));
+			loader.WaitIdle();
+
+			std::vector<DecodedImage> images;
+			loader.PopDecoded(images);
+			// Sizes BCn can't hold, the 1x1 placeholders among them, come out as RGBA8: only the images that don't
+			// decode fail, so a scene whose sources are all readable completes and is skipped next time
+			for (DecodedImage& image : images) {
+				CompressedImage compressed;
+				bool cooked = image.IsValid() && BlockCompression::Compress(image, settings[image.id]->compressionSettings, compressed, &threadPool) &&
+					CookedTextureFile::Write(outputPaths[image.id], &compressed);
+				succeeded = cooked && succeeded;
+				if (cooked) {
+					++cookedCount;
+					cookedBytes += compressed.GetSize();
+				}
+				image = DecodedImage();
+			}
+		}
+		return succeeded;
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3 && argc != 4) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Usage: Penumbra-Cooker <scene.gltf|scene.glb> <scene.pmesh> [store folder]");
+		return 1;
+	}
+	const std::string inputPath = argv[1];
+	const std::string outputPath = argv[2];
+	const ContentStore store(argc == 4 ? argv[3] : "store");
+
+	using Clock = std::chrono::high_resolution_clock;
+	auto start = Clock::now();
+
+	const GltfImportSettings importSettings;
+	const Hash128 settingsHash = HashCookSettings(importSettings, store);
+	const std::string cachePath = outputPath + ".cookcache";
+	CookCache cache;
+	cache.Load(cachePath);
+	if (cache.IsUpToDate(inputPath, settingsHash)) {
+		float elapsedMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, outputPath, " is up to date (", elapsedMs, " ms).");
+		return 0;
+	}
+
+	ThreadPool threadPool;
+	GltfAsset asset;
+	if (!asset.Load(inputPath, &threadPool) || !store.Create())
+		return 1;
+
+	// The graph of this cook: the mesh first, then one node per image used by the materials
+	const std::vector<std::optional<TextureCookSettings>> textureSettings = GetTextureCookSettings(asset);
+	std::vector<uint32_t> nodeImages;
+	for (uint32_t i = 0; i < textureSettings.size(); ++i) {
+		if (textureSettings[i].has_value())
+			nodeImages.push_back(i);
+	}
+	std::vector<CookNode> nodes(nodeImages.size() + 1);
+	std::vector<uint8_t> hashed(nodes.size());  // Not vector<bool>, the workers write it
+	threadPool.ParallelFor(nodes.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			hashed[i] = i == 0 ? BuildMeshNode(asset, outputPath, importSettings, cache, nodes[i]) :
+				BuildTextureNode(asset, nodeImages[i - 1], *textureSettings[nodeImages[i - 1]], store, cache, nodes[i]);
+		}
+	});
+
+	// Textures already in the store, cooked for this scene or another one, are done. Nodes whose inputs
+	// can't be read are cooked anyway, so the failure is logged where it happens.
+	const bool meshDirty = !hashed[0] || !cache.IsCooked(nodes[0]);
+	std::vector<std::string> texturePaths(textureSettings.size());
+	std::vector<std::optional<Hash128>> textureKeys(textureSettings.size());
+	std::vector<uint32_t> dirtyImages;
+	std::unordered_set<std::string> dirtyPaths;
+	for (size_t i = 1; i < nodes.size(); ++i) {
+		const uint32_t image = nodeImages[i - 1];
+		texturePaths[image] = nodes[i].outputPath;
+		textureKeys[image] = nodes[i].hash;
+		if (!hashed[i] || (CookCache::GetFileSize(nodes[i].outputPath) == 0 && dirtyPaths.insert(nodes[i].outputPath).second))
+			dirtyImages.push_back(image);
+	}
+
+	// The textures are cooked while the mesh is, on a thread of their own: the pool tasks of both jobs
+	// interleave on the workers, and neither waits on the other
+	size_t textureCount = 0;
+	size_t textureBytes = 0;
+	std::future<bool> texturesCooked;
+	if (!dirtyImages.empty()) {
+		texturesCooked = std::async(std::launch::async, [&]() {
+			return CookTextures(asset, textureSettings, dirtyImages, texturePaths, threadPool, textureCount, textureBytes);
+		});
+	}
+
+	bool meshCooked = !meshDirty;
+	std::vector<CookedMeshSource> meshes;
+	if (meshDirty) {
+		std::vector<GltfImportedMesh> importedMeshes;
+		if (GltfImporter::ImportScene(asset, threadPool, importSettings, importedMeshes)) {
+			meshes.resize(importedMeshes.size());
+			threadPool.ParallelFor(importedMeshes.size(), 1, [&importedMeshes, &meshes](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					const GltfImportedMesh& imported = importedMeshes[i];
+					meshes[i].name = imported.name;
+					meshes[i].material = imported.material;
+					meshes[i].parts = MeshParts::BuildParts(imported.vertices.data(), imported.vertices.size(), imported.indices.data(),
+						imported.indices.size());
+				}
+			});
+			meshCooked = CookedMeshFile::Write(outputPath, meshes);
+		}
+	}
+	bool succeeded = meshCooked;
+	if (texturesCooked.valid())
+		succeeded = texturesCooked.get() && succeeded;
+
+	// The index lists the keys of the images, the ones that failed included: a cook with failures is never
+	// skipped, they're cooked again next time under the same key
+	const std::string indexPath = ContentStore::GetIndexPath(outputPath);
+	succeeded = ContentStore::WriteIndex(indexPath, textureKeys) && succeeded;
+
+	// Only the nodes that are on disk go in the cache, the others are cooked again next time. The index
+	// is a node without inputs, so the stamp check sees it go missing.
+	std::vector<CookNode> cookedNodes;
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		nodes[i].outputSize = CookCache::GetFileSize(nodes[i].outputPath);
+		if (hashed[i] && nodes[i].outputSize > 0 && (i > 0 || meshCooked))
+			cookedNodes.push_back(std::move(nodes[i]));
+	}
+	CookNode& indexNode = cookedNodes.emplace_back();
+	indexNode.outputPath = indexPath;
+	indexNode.outputSize = CookCache::GetFileSize(indexPath);
+	succeeded = CookCache::Save(cachePath, cookedNodes, settingsHash, succeeded) && succeeded;
+
+	size_t partCount = 0;
+	size_t vertexCount = 0;
+	size_t triangleCount = 0;
+	for (const CookedMeshSource& mesh : meshes) {
+		partCount += mesh.parts.size();
+		for (const MeshPartData& part : mesh.parts) {
+			vertexCount += part.positions.size();
+			triangleCount += part.lods[0].indexCount / 3;
+		}
+	}
+	float elapsedMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Cooked ", inputPath, " into ", outputPath, ": ", meshes.size(), " meshes, ", partCount,
+		" parts, ", vertexCount, " vertices, ", triangleCount, " triangles, ", textureCount, " textures (", textureBytes / 1048576.0f, " MB), ",
+		nodes.size() - dirtyImages.size() - (meshDirty ? 1 : 0), " outputs up to date, in ", elapsedMs, " ms.");
+	return succeeded ? 0 : 1;
+}
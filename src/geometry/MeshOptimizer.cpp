@@ -0,0 +1,371 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../utils/ConsoleLogger.h"
+
+
+namespace {
+	/// Forsyth's vertex cache optimization
+	// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+	constexpr int SIMULATED_CACHE_SIZE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	float VertexScore(int cachePosition, uint32_t liveTriangles) {
+		// Vertices without triangles left are never picked again
+		if (liveTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			if (cachePosition < 3) {
+				// The last triangle emitted, a fixed score so it isn't favoured too much
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else {
+				const float scaler = 1.0f / (SIMULATED_CACHE_SIZE - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+			}
+		}
+
+		// Boost vertices with few triangles left, so lone triangles don't get left behind
+		score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(liveTriangles), -VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	// Triangles referencing every vertex, stored as a flat list with per-vertex ranges
+	struct TriangleAdjacency {
+		std::vector<uint32_t> counts;
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+
+		void Build(const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+			counts.assign(vertexCount, 0);
+			offsets.assign(vertexCount, 0);
+			triangles.resize(indexCount);
+
+			for (size_t i = 0; i < indexCount; ++i)
+				counts[indices[i]]++;
+
+			uint32_t offset = 0;
+			for (size_t v = 0; v < vertexCount; ++v) {
+				offsets[v] = offset;
+				offset += counts[v];
+			}
+
+			std::vector<uint32_t> fill(offsets);
+			for (size_t i = 0; i < indexCount; ++i)
+				triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	};
+
+	// Number of cache misses of a triangle in a FIFO cache, updating the cache
+	unsigned SimulateFifoTriangle(const uint32_t* triangle, std::vector<uint32_t>& cacheTimestamps, uint32_t& timestamp, unsigned cacheSize) {
+		unsigned misses = 0;
+		for (int k = 0; k < 3; ++k) {
+			uint32_t vertex = triangle[k];
+			// A vertex is in the cache if it was inserted less than cacheSize insertions ago
+			if (timestamp - cacheTimestamps[vertex] > cacheSize) {
+				cacheTimestamps[vertex] = timestamp++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	TriangleAdjacency adjacency;
+	adjacency.Build(indices, indexCount, vertexCount);
+
+	// Live triangles per vertex, the adjacency list of every vertex is shrunk as triangles get emitted
+	std::vector<uint32_t> liveTriangles(adjacency.counts);
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+		vertexScores[v] = VertexScore(-1, liveTriangles[v]);
+
+	std::vector<float> triangleScores(triangleCount);
+	for (size_t t = 0; t < triangleCount; ++t) {
+		triangleScores[t] = vertexScores[indices[t * 3 + 0]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+	}
+	std::vector<bool> emitted(triangleCount, false);
+
+	// The cache holds up to three extra entries while a triangle is being inserted
+	uint32_t cache[SIMULATED_CACHE_SIZE + 3];
+	uint32_t newCache[SIMULATED_CACHE_SIZE + 3];
+	size_t cacheCount = 0;
+
+	size_t bestTriangle = 0;
+	for (size_t t = 1; t < triangleCount; ++t) {
+		if (triangleScores[t] > triangleScores[bestTriangle])
+			bestTriangle = t;
+	}
+
+	size_t inputCursor = 0;
+	for (size_t outputTriangle = 0; outputTriangle < triangleCount; ++outputTriangle) {
+		// No candidate around the cache, continue with the next triangle of the input order
+		if (bestTriangle == SIZE_MAX) {
+			while (emitted[inputCursor])
+				++inputCursor;
+			bestTriangle = inputCursor;
+		}
+
+		const uint32_t* triangle = &indices[bestTriangle * 3];
+		destination[outputTriangle * 3 + 0] = triangle[0];
+		destination[outputTriangle * 3 + 1] = triangle[1];
+		destination[outputTriangle * 3 + 2] = triangle[2];
+		emitted[bestTriangle] = true;
+
+		// Remove the triangle from the adjacency of its vertices
+		for (int k = 0; k < 3; ++k) {
+			uint32_t vertex = triangle[k];
+			uint32_t* vertexTriangles = &adjacency.triangles[adjacency.offsets[vertex]];
+			uint32_t& count = liveTriangles[vertex];
+			for (uint32_t i = 0; i < count; ++i) {
+				if (vertexTriangles[i] == bestTriangle) {
+					vertexTriangles[i] = vertexTriangles[count - 1];
+					break;
+				}
+			}
+			count--;
+		}
+
+		// Push the triangle vertices to the front of the cache (LRU)
+		size_t newCacheCount = 0;
+		newCache[newCacheCount++] = triangle[0];
+		newCache[newCacheCount++] = triangle[1];
+		newCache[newCacheCount++] = triangle[2];
+		for (size_t i = 0; i < cacheCount; ++i) {
+			uint32_t vertex = cache[i];
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				newCache[newCacheCount++] = vertex;
+		}
+
+		// Update the scores of the cached vertices (and of the ones just evicted) and their triangles
+		for (size_t i = 0; i < newCacheCount; ++i) {
+			uint32_t vertex = newCache[i];
+			int position = i < SIMULATED_CACHE_SIZE ? static_cast<int>(i) : -1;
+			cachePositions[vertex] = position;
+
+			float score = VertexScore(position, liveTriangles[vertex]);
+			float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+
+			const uint32_t* vertexTriangles = &adjacency.triangles[adjacency.offsets[vertex]];
+			for (uint32_t j = 0; j < liveTriangles[vertex]; ++j)
+				triangleScores[vertexTriangles[j]] += delta;
+		}
+
+		// Pick the next triangle once every score is final: a triangle sharing several cached vertices
+		// gets one delta per vertex, comparing it after the first one would use a partial score
+		bestTriangle = SIZE_MAX;
+		float bestScore = -1.0f;
+		for (size_t i = 0; i < newCacheCount; ++i) {
+			uint32_t vertex = newCache[i];
+			const uint32_t* vertexTriangles = &adjacency.triangles[adjacency.offsets[vertex]];
+			for (uint32_t j = 0; j < liveTriangles[vertex]; ++j) {
+				uint32_t t = vertexTriangles[j];
+				if (triangleScores[t] > bestScore) {
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCacheCount, static_cast<size_t>(SIMULATED_CACHE_SIZE));
+		std::memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+	}
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride, float threshold) {
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	constexpr unsigned CACHE_SIZE = 16;
+	const size_t strideInFloats = positionStride / sizeof(float);
+
+	// Hard boundaries: triangles where the cache was effectively flushed (every vertex missed)
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+	uint32_t timestamp = CACHE_SIZE + 1;
+	std::vector<size_t> hardClusters;
+	for (size_t t = 0; t < triangleCount; ++t) {
+		if (SimulateFifoTriangle(&indices[t * 3], cacheTimestamps, timestamp, CACHE_SIZE) == 3)
+			hardClusters.push_back(t);
+	}
+	if (hardClusters.empty() || hardClusters[0] != 0)
+		hardClusters.insert(hardClusters.begin(), 0);
+
+	// Soft boundaries: split hard clusters further as long as the ACMR stays within the threshold
+	std::vector<size_t> clusters;
+	for (size_t c = 0; c < hardClusters.size(); ++c) {
+		size_t start = hardClusters[c];
+		size_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : triangleCount;
+
+		timestamp += CACHE_SIZE + 1;
+		size_t clusterMisses = 0;
+		for (size_t t = start; t < end; ++t)
+			clusterMisses += SimulateFifoTriangle(&indices[t * 3], cacheTimestamps, timestamp, CACHE_SIZE);
+		const float thresholdAcmr = static_cast<float>(clusterMisses) / (end - start) * threshold;
+
+		timestamp += CACHE_SIZE + 1;
+		size_t subStart = start;
+		size_t subMisses = 0;
+		clusters.push_back(start);
+		for (size_t t = start; t < end; ++t) {
+			subMisses += SimulateFifoTriangle(&indices[t * 3], cacheTimestamps, timestamp, CACHE_SIZE);
+			if (t + 1 < end && static_cast<float>(subMisses) / (t + 1 - subStart) <= thresholdAcmr) {
+				clusters.push_back(t + 1);
+				subStart = t + 1;
+				subMisses = 0;
+				timestamp += CACHE_SIZE + 1;
+			}
+		}
+	}
+
+	// Area weighted centroid of the mesh
+	double meshCentroid[3] = {};
+	double meshArea = 0.0;
+	for (size_t t = 0; t < triangleCount; ++t) {
+		const float* p0 = positions + indices[t * 3 + 0] * strideInFloats;
+		const float* p1 = positions + indices[t * 3 + 1] * strideInFloats;
+		const float* p2 = positions + indices[t * 3 + 2] * strideInFloats;
+
+		float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		float nx = e1[1] * e2[2] - e1[2] * e2[1];
+		float ny = e1[2] * e2[0] - e1[0] * e2[2];
+		float nz = e1[0] * e2[1] - e1[1] * e2[0];
+		float area = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+		for (int k = 0; k < 3; ++k) {
+			float centroid = (p0[k] + p1[k] + p2[k]) / 3.0f;
+			meshCentroid[k] += centroid * area;
+		}
+		meshArea += area;
+	}
+	if (meshArea > 0.0) {
+		for (double& value : meshCentroid)
+			value /= meshArea;
+	}
+
+	// Clusters facing away from the center (the outer shell) are drawn first, they occlude the rest
+	std::vector<float> clusterSortKeys(clusters.size());
+	for (size_t c = 0; c < clusters.size(); ++c) {
+		size_t start = clusters[c];
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+		float centroid[3] = {};
+		float normal[3] = {};
+		float clusterArea = 0.0f;
+		for (size_t t = start; t < end; ++t) {
+			const float* p0 = positions + indices[t * 3 + 0] * strideInFloats;
+			const float* p1 = positions + indices[t * 3 + 1] * strideInFloats;
+			const float* p2 = positions + indices[t * 3 + 2] * strideInFloats;
+
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (int k = 0; k < 3; ++k) {
+				centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * area;
+				normal[k] += n[k];
+			}
+			clusterArea += area;
+		}
+
+		float invArea = clusterArea > 0.0f ? 1.0f / clusterArea : 0.0f;
+		float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float invNormalLength = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+
+		float key = 0.0f;
+		for (int k = 0; k < 3; ++k)
+			key += (centroid[k] * invArea - static_cast<float>(meshCentroid[k])) * normal[k] * invNormalLength;
+		clusterSortKeys[c] = key;
+	}
+
+	std::vector<size_t> clusterOrder(clusters.size());
+	for (size_t c = 0; c < clusterOrder.size(); ++c)
+		clusterOrder[c] = c;
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&clusterSortKeys](size_t a, size_t b) {
+		return clusterSortKeys[a] > clusterSortKeys[b];
+	});
+
+	size_t outputIndex = 0;
+	for (size_t c : clusterOrder) {
+		size_t start = clusters[c];
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		std::memcpy(&destination[outputIndex], &indices[start * 3], (end - start) * 3 * sizeof(uint32_t));
+		outputIndex += (end - start) * 3;
+	}
+}
+
+size_t MeshOptimizer::OptimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	std::fill(remap, remap + vertexCount, UINT32_MAX);
+
+	uint32_t nextVertex = 0;
+	for (size_t i = 0; i < indexCount; ++i) {
+		uint32_t vertex = indices[i];
+		if (remap[vertex] == UINT32_MAX)
+			remap[vertex] = nextVertex++;
+	}
+	return nextVertex;
+}
+
+void MeshOptimizer::RemapIndexBuffer(uint32_t* destination, const uint32_t* indices, size_t indexCount, const uint32_t* remap) {
+	for (size_t i = 0; i < indexCount; ++i)
+		destination[i] = remap[indices[i]];
+}
+
+void MeshOptimizer::RemapVertexBuffer(void* destination, const void* vertices, size_t vertexCount, size_t vertexSize, const uint32_t* remap) {
+	uint8_t* output = static_cast<uint8_t*>(destination);
+	const uint8_t* input = static_cast<const uint8_t*>(vertices);
+	for (size_t v = 0; v < vertexCount; ++v) {
+		if (remap[v] != UINT32_MAX)
+			std::memcpy(output + remap[v] * vertexSize, input + v * vertexSize, vertexSize);
+	}
+}
+
+VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize) {
+	VertexCacheStatistics statistics;
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return statistics;
+
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+	for (size_t t = 0; t < triangleCount; ++t)
+		statistics.vertexTransforms += SimulateFifoTriangle(&indices[t * 3], cacheTimestamps, timestamp, cacheSize);
+
+	std::vector<bool> referenced(vertexCount, false);
+	size_t uniqueVertices = 0;
+	for (size_t i = 0; i < indexCount; ++i) {
+		if (!referenced[indices[i]]) {
+			referenced[indices[i]] = true;
+			uniqueVertices++;
+		}
+	}
+
+	statistics.acmr = static_cast<float>(statistics.vertexTransforms) / triangleCount;
+	statistics.atvr = static_cast<float>(statistics.vertexTransforms) / uniqueVertices;
+	return statistics;
+}
+
+void MeshOptimizer::LogReport(const char* meshName, const MeshOptimizationReport& report) {
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Mesh optimization of ", meshName,
+		": ACMR ", report.before.acmr, " -> ", report.after.acmr,
+		", ATVR ", report.before.atvr, " -> ", report.after.atvr,
+		", vertices ", report.vertexCountBefore, " -> ", report.vertexCountAfter);
+}
@@ -0,0 +1,92 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Statistics of the post-transform vertex cache for an index buffer
+struct VertexCacheStatistics {
+	size_t vertexTransforms = 0;  // Cache misses, i.e. vertex shader invocations
+	float acmr = 0.0f;            // Average cache miss ratio: transforms per triangle (0.5 is the best possible on a regular grid, 3.0 the worst)
+	float atvr = 0.0f;            // Average transform to vertex ratio: transforms per referenced vertex (1.0 is optimal)
+};
+
+struct MeshOptimizationSettings {
+	// Reorders clusters of triangles front to back from the mesh center to reduce overdraw
+	bool optimizeOverdraw = true;
+	// How much ACMR the overdraw pass is allowed to lose to get finer clusters (1.05 = 5% worse)
+	float overdrawThreshold = 1.05f;
+	// Size of the FIFO cache simulated for the ACMR/ATVR report
+	unsigned reportCacheSize = 16;
+};
+
+struct MeshOptimizationReport {
+	VertexCacheStatistics before;
+	VertexCacheStatistics after;
+	size_t vertexCountBefore = 0;
+	size_t vertexCountAfter = 0;  // Unreferenced vertices are dropped by the vertex fetch pass
+};
+
+// Import time mesh optimization passes, meant to run in this order:
+// 1. OptimizeVertexCache: reorders triangles for post-transform cache locality (Forsyth's linear-speed algorithm)
+// 2. OptimizeOverdraw (optional): splits the result in clusters and sorts them to reduce overdraw
+//    (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+// 3. OptimizeVertexFetchRemap + RemapIndexBuffer/RemapVertexBuffer: reorders the vertices in the
+//    order the indices reference them, so vertex fetches walk the buffer linearly
+namespace MeshOptimizer {
+	// `destination` can't alias `indices`
+	void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	// `positions` points to the first float3 position, `positionStride` is the vertex size in bytes.
+	// `destination` can't alias `indices`, which should already be vertex cache optimized.
+	void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+		const float* positions, size_t vertexCount, size_t positionStride, float threshold);
+
+	// Fills `remap` (vertexCount entries) with the new position of every vertex, in first use order.
+	// Unreferenced vertices get UINT32_MAX. Returns the number of referenced vertices.
+	size_t OptimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	void RemapIndexBuffer(uint32_t* destination, const uint32_t* indices, size_t indexCount, const uint32_t* remap);
+	// `destination` must hold the number of referenced vertices returned by OptimizeVertexFetchRemap
+	void RemapVertexBuffer(void* destination, const void* vertices, size_t vertexCount, size_t vertexSize, const uint32_t* remap);
+
+	// Simulates a FIFO post-transform cache of the given size
+	VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize = 16);
+
+	// Logs the before/after statistics of a mesh
+	void LogReport(const char* meshName, const MeshOptimizationReport& report);
+
+	// Runs every pass over a mesh in place. Works with any vertex struct with a `vPosition` XMFLOAT3 member.
+	template <typename VertexType>
+	MeshOptimizationReport OptimizeMesh(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices,
+		const MeshOptimizationSettings& settings = {}) {
+		MeshOptimizationReport report;
+		report.vertexCountBefore = vertices.size();
+		report.before = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), settings.reportCacheSize);
+
+		std::vector<uint32_t> scratch(indices.size());
+		OptimizeVertexCache(scratch.data(), indices.data(), indices.size(), vertices.size());
+		if (settings.optimizeOverdraw && !vertices.empty()) {
+			OptimizeOverdraw(indices.data(), scratch.data(), scratch.size(), &vertices[0].vPosition.x, vertices.size(),
+				sizeof(VertexType), settings.overdrawThreshold);
+		}
+		else {
+			indices.swap(scratch);
+		}
+
+		std::vector<uint32_t> remap(vertices.size());
+		size_t uniqueVertices = OptimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), vertices.size());
+		RemapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+		std::vector<VertexType> remappedVertices(uniqueVertices);
+		RemapVertexBuffer(remappedVertices.data(), vertices.data(), vertices.size(), sizeof(VertexType), remap.data());
+		vertices.swap(remappedVertices);
+
+		report.vertexCountAfter = vertices.size();
+		report.after = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), settings.reportCacheSize);
+		return report;
+	}
+}
+
+#endif // !MESH_OPTIMIZER_H
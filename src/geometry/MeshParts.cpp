@@ -0,0 +1,98 @@
+#include "MeshParts.h"
+
+#include <DirectXMath.h>
+#include <cmath>
+
+#include "MeshSplitter.h"
+
+
+using namespace DirectX;
+
+
+std::vector<MeshPartData> MeshParts::BuildParts(const CompleteVertexData* vertices, size_t vertexCount, const uint32_t* indices,
+	size_t indexCount, const MeshletSettings& meshletSettings, const MeshLodSettings& lodSettings) {
+	// Most meshes come back as a single part, bigger ones are split so every part fits 16-bit indices
+	MeshSplit split = MeshSplitter::SplitMesh(indices, indexCount, vertexCount, MeshSplitter::MAX_16BIT_VERTICES);
+	// Parts simplified on their own would open cracks along the edges they share
+	MeshLodSettings partLodSettings = lodSettings;
+	partLodSettings.lockBorder |= split.parts.size() > 1;
+
+	std::vector<MeshPartData> parts;
+	parts.reserve(split.parts.size());
+	for (const MeshPartRange& range : split.parts) {
+		// Nothing to draw, and the builders below need at least one vertex
+		if (range.vertexCount == 0 || range.indexCount == 0)
+			continue;
+		MeshPartData& part = parts.emplace_back();
+
+		// Split the interleaved vertices into the two streams
+		part.positions.resize(range.vertexCount);
+		part.attributes.resize(range.vertexCount);
+		for (uint32_t i = 0; i < range.vertexCount; ++i) {
+			const CompleteVertexData& vertex = vertices[split.vertices[range.firstVertex + i]];
+			part.positions[i].vPosition = vertex.vPosition;
+			part.attributes[i].vColor = vertex.vColor;
+			part.attributes[i].vNormal = vertex.vNormal;
+			part.attributes[i].vTexCoordinate = vertex.vTexCoordinate;
+			part.attributes[i].vTangent = vertex.vTangent;
+			part.attributes[i].vBitangent = vertex.vBitangent;
+		}
+
+		const uint32_t* partIndices = split.indices.data() + range.firstIndex;
+		part.meshletData = Meshlets::BuildMeshlets(partIndices, range.indexCount, &part.positions.data()->vPosition.x, range.vertexCount,
+			sizeof(SimpleVertexData), meshletSettings);
+		std::vector<uint32_t> meshletIndices = Meshlets::BuildMeshletIndices(part.meshletData);
+
+		// The coarser levels follow the meshlet ordered full resolution level in the index buffer
+		MeshLodChain lodChain = MeshSimplifier::GenerateLodChain(meshletIndices.data(), meshletIndices.size(),
+			&part.positions.data()->vPosition.x, range.vertexCount, sizeof(SimpleVertexData), partLodSettings);
+		part.lods = lodChain.lods;
+
+		part.indices.resize(lodChain.indices.size());
+		MeshSplitter::NarrowIndices(part.indices.data(), lodChain.indices.data(), lodChain.indices.size());
+		part.uvDensity = ComputeUvDensity(part.positions.data(), part.attributes.data(), part.indices.data() + part.lods[0].indexOffset,
+			part.lods[0].indexCount);
+	}
+	return parts;
+}
+
+MeshPartView MeshParts::GetView(const MeshPartData& part) {
+	MeshPartView view;
+	view.positions = part.positions.data();
+	view.attributes = part.attributes.data();
+	view.vertexCount = static_cast<uint32_t>(part.positions.size());
+	view.indices = part.indices.data();
+	view.indexCount = static_cast<uint32_t>(part.indices.size());
+	view.lods = part.lods.data();
+	view.lodCount = static_cast<uint32_t>(part.lods.size());
+	view.meshlets = part.meshletData.meshlets.data();
+	view.meshletBounds = part.meshletData.bounds.data();
+	view.meshletCount = static_cast<uint32_t>(part.meshletData.meshlets.size());
+	view.meshletVertices = part.meshletData.vertices.data();
+	view.meshletVertexCount = static_cast<uint32_t>(part.meshletData.vertices.size());
+	view.meshletTriangles = part.meshletData.triangles.data();
+	view.meshletTriangleCount = static_cast<uint32_t>(part.meshletData.triangles.size());
+	view.uvDensity = part.uvDensity;
+	return view;
+}
+
+float MeshParts::ComputeUvDensity(const SimpleVertexData* positions, const CompleteAttributeData* attributes, const uint16_t* indices,
+	size_t indexCount) {
+	float surfaceArea = 0.0f;
+	float uvArea = 0.0f;
+	for (size_t i = 0; i + 2 < indexCount; i += 3) {
+		const uint16_t i0 = indices[i];
+		const uint16_t i1 = indices[i + 1];
+		const uint16_t i2 = indices[i + 2];
+		XMVECTOR p0 = XMLoadFloat3(&positions[i0].vPosition);
+		XMVECTOR p1 = XMLoadFloat3(&positions[i1].vPosition);
+		XMVECTOR p2 = XMLoadFloat3(&positions[i2].vPosition);
+		surfaceArea += 0.5f * XMVectorGetX(XMVector3Length(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0))));
+
+		const XMFLOAT2& uv0 = attributes[i0].vTexCoordinate;
+		const XMFLOAT2& uv1 = attributes[i1].vTexCoordinate;
+		const XMFLOAT2& uv2 = attributes[i2].vTexCoordinate;
+		uvArea += 0.5f * std::abs((uv1.x - uv0.x) * (uv2.y - uv0.y) - (uv2.x - uv0.x) * (uv1.y - uv0.y));
+	}
+	return surfaceArea > 0.0f ? std::sqrt(uvArea / surfaceArea) : 0.0f;
+}
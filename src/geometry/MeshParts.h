@@ -0,0 +1,62 @@
+#ifndef MESH_PARTS_H
+#define MESH_PARTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "../graphics/VertexFormat.h"
+
+
+// Geometry of a mesh part as uploaded to a GeometryPool: the two vertex streams, the 16-bit index
+// buffer (meshlet ordered full resolution level, then the coarser levels), the levels and the meshlets
+struct MeshPartData {
+	std::vector<SimpleVertexData> positions;
+	std::vector<CompleteAttributeData> attributes;
+	std::vector<uint16_t> indices;
+	std::vector<MeshLod> lods;
+	MeshletData meshletData;
+	// UV units per world unit of the full resolution level, see MeshParts::ComputeUvDensity
+	float uvDensity = 0.0f;
+};
+
+// Same geometry, pointing to memory owned elsewhere (a MeshPartData or a cooked mesh file)
+struct MeshPartView {
+	const SimpleVertexData* positions = nullptr;
+	const CompleteAttributeData* attributes = nullptr;
+	uint32_t vertexCount = 0;
+	const uint16_t* indices = nullptr;
+	uint32_t indexCount = 0;
+	const MeshLod* lods = nullptr;
+	uint32_t lodCount = 0;
+	const Meshlet* meshlets = nullptr;
+	const MeshletBounds* meshletBounds = nullptr;  // One per meshlet
+	uint32_t meshletCount = 0;
+	const uint32_t* meshletVertices = nullptr;
+	uint32_t meshletVertexCount = 0;
+	const uint8_t* meshletTriangles = nullptr;
+	uint32_t meshletTriangleCount = 0;  // Bytes, three per triangle
+	float uvDensity = 0.0f;
+};
+
+// Builds the upload ready parts of a mesh, the CPU side of Mesh::Initialize. The asset cooker runs it
+// offline and stores the parts as they are, so loading a cooked mesh is a copy to the GPU.
+namespace MeshParts {
+	// Splits the mesh in parts of at most 65536 vertices for 16-bit indices, splits the interleaved vertices
+	// into the position and attribute streams, then builds the meshlets and the levels of detail of every part.
+	// The indices should already be vertex cache optimized (see MeshOptimizer). Parts without triangles are left out.
+	std::vector<MeshPartData> BuildParts(const CompleteVertexData* vertices, size_t vertexCount, const uint32_t* indices,
+		size_t indexCount, const MeshletSettings& meshletSettings = {}, const MeshLodSettings& lodSettings = {});
+
+	MeshPartView GetView(const MeshPartData& part);
+
+	// UV units per world unit of a triangle list, the square root of its UV area over its surface area. Times the
+	// size of a texture it gives the texels per world unit a draw samples, see TextureStreamer::ComputeRequiredLevel.
+	// 0 for degenerate geometry.
+	float ComputeUvDensity(const SimpleVertexData* positions, const CompleteAttributeData* attributes, const uint16_t* indices,
+		size_t indexCount);
+}
+
+#endif // !MESH_PARTS_H
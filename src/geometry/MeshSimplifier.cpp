@@ -0,0 +1,486 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "MeshOptimizer.h"
+
+
+namespace {
+	struct Vector3 {
+		float x, y, z;
+	};
+
+	Vector3 operator-(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	float Dot(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	float Length(const Vector3& a) { return std::sqrt(Dot(a, a)); }
+	Vector3 Cross(const Vector3& a, const Vector3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+	// Sum of squared distances to a set of weighted planes: Q(p) = p^T A p + 2 b.p + c
+	struct Quadric {
+		double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+
+		// Plane n.p + d = 0, with n normalized
+		void AddPlane(const Vector3& n, float d, float planeWeight) {
+			a00 += planeWeight * n.x * n.x;
+			a11 += planeWeight * n.y * n.y;
+			a22 += planeWeight * n.z * n.z;
+			a01 += planeWeight * n.x * n.y;
+			a02 += planeWeight * n.x * n.z;
+			a12 += planeWeight * n.y * n.z;
+			b0 += planeWeight * n.x * d;
+			b1 += planeWeight * n.y * d;
+			b2 += planeWeight * n.z * d;
+			c += planeWeight * d * d;
+			weight += planeWeight;
+		}
+
+		void Add(const Quadric& other) {
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a01 += other.a01; a02 += other.a02; a12 += other.a12;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+	};
+
+	// Weighted mean squared distance of a point to the planes of two quadrics
+	float CollapseError(const Quadric& q0, const Quadric& q1, const Vector3& p) {
+		Quadric q = q0;
+		q.Add(q1);
+		double x = p.x, y = p.y, z = p.z;
+		double error = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+			+ 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+			+ 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z)
+			+ q.c;
+		return q.weight > 0.0 ? static_cast<float>(std::fabs(error) / q.weight) : 0.0f;
+	}
+
+	uint64_t EdgeKey(uint32_t a, uint32_t b) {
+		return (static_cast<uint64_t>(a) << 32) | b;
+	}
+
+	struct PositionKey {
+		uint32_t bits[3];
+		bool operator==(const PositionKey& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+	};
+
+	struct PositionKeyHasher {
+		size_t operator()(const PositionKey& key) const {
+			return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+		}
+	};
+
+	// Collapses `source` (a position) onto `target`, moving every vertex of `source` to a vertex of `target`
+	struct Collapse {
+		uint32_t source;
+		uint32_t target;
+		float error;
+	};
+
+	// Normals of the triangles around a collapsed vertex can't turn by more than ~75 degrees
+	constexpr float MIN_NORMAL_DOT = 0.25f;
+	// Edges along seams and borders get planes perpendicular to their triangle, weighted like this many triangles
+	constexpr float BOUNDARY_WEIGHT = 2.0f;
+
+	class Simplifier {
+		public:
+			Simplifier(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+				bool lockBorder)
+				: m_lockBorder(lockBorder)
+				, m_indices(indices, indices + indexCount - indexCount % 3)
+				, m_positions(vertexCount)
+				, m_positionIds(vertexCount)
+				, m_wedges(vertexCount)
+				, m_quadrics(vertexCount) {
+				const size_t strideInFloats = positionStride / sizeof(float);
+				for (size_t v = 0; v < vertexCount; ++v) {
+					const float* position = positions + v * strideInFloats;
+					m_positions[v] = { position[0], position[1], position[2] };
+				}
+
+				BuildWedges();
+				BuildQuadrics();
+			}
+
+			float Run(size_t targetIndexCount, float targetError) {
+				const float targetErrorSquared = targetError * targetError;
+				float maxError = 0.0f;
+
+				while (m_indices.size() > targetIndexCount) {
+					BuildAdjacency();
+
+					std::vector<Collapse> collapses = PickCollapses();
+					if (collapses.empty())
+						break;
+					std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+						return a.error < b.error;
+					});
+
+					// Every collapse removes ~2 triangles. Don't go far past the cheap collapses in one pass,
+					// collapses get cheaper once their neighbours have been collapsed.
+					size_t triangleGoal = (m_indices.size() - targetIndexCount) / 3;
+					size_t edgeGoal = std::max<size_t>(triangleGoal / 2, 1);
+					size_t limitIndex = std::min(collapses.size() - 1, edgeGoal + edgeGoal / 2);
+					float passErrorLimit = std::min(collapses[limitIndex].error, targetErrorSquared);
+
+					size_t removedTriangles = 0;
+					bool collapsed = false;
+					std::vector<bool> locked(m_positions.size(), false);
+					std::vector<uint32_t> remap(m_positions.size());
+					for (size_t v = 0; v < remap.size(); ++v)
+						remap[v] = static_cast<uint32_t>(v);
+
+					for (const Collapse& collapse : collapses) {
+						if (collapse.error > passErrorLimit || removedTriangles >= triangleGoal)
+							break;
+						if (locked[collapse.source] || locked[collapse.target])
+							continue;
+
+						size_t collapseRemoved = 0;
+						if (!TryCollapse(collapse, remap, collapseRemoved))
+							continue;
+
+						locked[collapse.source] = true;
+						locked[collapse.target] = true;
+						m_quadrics[collapse.target].Add(m_quadrics[collapse.source]);
+						maxError = std::max(maxError, collapse.error);
+						removedTriangles += collapseRemoved;
+						collapsed = true;
+					}
+
+					if (!collapsed)
+						break;
+					ApplyRemap(remap);
+				}
+
+				return std::sqrt(maxError);
+			}
+
+			const std::vector<uint32_t>& GetIndices() const { return m_indices; }
+
+		private:
+			// Links the vertices sharing a position in rings, the first one of each position being its id
+			void BuildWedges() {
+				std::unordered_map<PositionKey, uint32_t, PositionKeyHasher> firstVertices;
+				firstVertices.reserve(m_positions.size());
+				for (uint32_t v = 0; v < m_positions.size(); ++v) {
+					PositionKey key;
+					std::memcpy(key.bits, &m_positions[v], sizeof(key.bits));
+					auto insertion = firstVertices.emplace(key, v);
+					uint32_t first = insertion.first->second;
+					m_positionIds[v] = first;
+					if (first == v) {
+						m_wedges[v] = v;
+					}
+					else {
+						m_wedges[v] = m_wedges[first];
+						m_wedges[first] = v;
+					}
+				}
+			}
+
+			void BuildQuadrics() {
+				std::unordered_set<uint64_t> vertexEdges;
+				vertexEdges.reserve(m_indices.size());
+				for (size_t i = 0; i < m_indices.size(); i += 3) {
+					for (int k = 0; k < 3; ++k)
+						vertexEdges.insert(EdgeKey(m_indices[i + k], m_indices[i + (k + 1) % 3]));
+				}
+
+				for (size_t i = 0; i < m_indices.size(); i += 3) {
+					uint32_t triangle[3] = { m_positionIds[m_indices[i]], m_positionIds[m_indices[i + 1]], m_positionIds[m_indices[i + 2]] };
+					const Vector3& p0 = m_positions[triangle[0]];
+					Vector3 normal = Cross(m_positions[triangle[1]] - p0, m_positions[triangle[2]] - p0);
+					float doubleArea = Length(normal);
+					if (doubleArea == 0.0f)
+						continue;
+					normal = { normal.x / doubleArea, normal.y / doubleArea, normal.z / doubleArea };
+
+					for (int k = 0; k < 3; ++k)
+						m_quadrics[triangle[k]].AddPlane(normal, -Dot(normal, p0), doubleArea * 0.5f);
+
+					// Seams and borders are edges without a twin in vertex space, keep them in place
+					for (int k = 0; k < 3; ++k) {
+						uint32_t a = m_indices[i + k];
+						uint32_t b = m_indices[i + (k + 1) % 3];
+						if (vertexEdges.count(EdgeKey(b, a)))
+							continue;
+
+						const Vector3& pa = m_positions[a];
+						Vector3 edge = m_positions[b] - pa;
+						float edgeLength = Length(edge);
+						Vector3 edgeNormal = Cross(edge, normal);
+						float edgeNormalLength = Length(edgeNormal);
+						if (edgeNormalLength == 0.0f)
+							continue;
+						edgeNormal = { edgeNormal.x / edgeNormalLength, edgeNormal.y / edgeNormalLength, edgeNormal.z / edgeNormalLength };
+
+						float weight = BOUNDARY_WEIGHT * edgeLength * edgeLength;
+						m_quadrics[triangle[k]].AddPlane(edgeNormal, -Dot(edgeNormal, pa), weight);
+						m_quadrics[triangle[(k + 1) % 3]].AddPlane(edgeNormal, -Dot(edgeNormal, pa), weight);
+					}
+				}
+			}
+
+			// Triangles around every vertex and the border edges of the current mesh
+			void BuildAdjacency() {
+				const size_t vertexCount = m_positions.size();
+				m_adjacencyCounts.assign(vertexCount, 0);
+				m_adjacencyOffsets.assign(vertexCount, 0);
+				m_adjacency.resize(m_indices.size());
+				for (uint32_t index : m_indices)
+					m_adjacencyCounts[index]++;
+				uint32_t offset = 0;
+				for (size_t v = 0; v < vertexCount; ++v) {
+					m_adjacencyOffsets[v] = offset;
+					offset += m_adjacencyCounts[v];
+				}
+				std::vector<uint32_t> fill(m_adjacencyOffsets);
+				for (size_t i = 0; i < m_indices.size(); ++i)
+					m_adjacency[fill[m_indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+				m_positionEdges.clear();
+				m_positionEdges.reserve(m_indices.size());
+				for (size_t i = 0; i < m_indices.size(); i += 3) {
+					for (int k = 0; k < 3; ++k)
+						m_positionEdges.insert(EdgeKey(m_positionIds[m_indices[i + k]], m_positionIds[m_indices[i + (k + 1) % 3]]));
+				}
+
+				m_borderVertices.assign(vertexCount, false);
+				for (uint64_t edge : m_positionEdges) {
+					uint32_t a = static_cast<uint32_t>(edge >> 32);
+					uint32_t b = static_cast<uint32_t>(edge);
+					if (!m_positionEdges.count(EdgeKey(b, a))) {
+						m_borderVertices[a] = true;
+						m_borderVertices[b] = true;
+					}
+				}
+			}
+
+			bool IsBorderEdge(uint32_t a, uint32_t b) const {
+				return m_positionEdges.count(EdgeKey(a, b)) != m_positionEdges.count(EdgeKey(b, a));
+			}
+
+			// Border vertices can only slide along the border
+			bool CanCollapse(uint32_t source, uint32_t target) const {
+				if (!m_borderVertices[source])
+					return true;
+				return !m_lockBorder && IsBorderEdge(source, target);
+			}
+
+			std::vector<Collapse> PickCollapses() const {
+				std::vector<Collapse> collapses;
+				for (size_t i = 0; i < m_indices.size(); i += 3) {
+					for (int k = 0; k < 3; ++k) {
+						uint32_t p0 = m_positionIds[m_indices[i + k]];
+						uint32_t p1 = m_positionIds[m_indices[i + (k + 1) % 3]];
+						// Interior edges show up in both directions, only keep one
+						if (p0 == p1 || (p0 > p1 && m_positionEdges.count(EdgeKey(p1, p0))))
+							continue;
+
+						bool forward = CanCollapse(p0, p1);
+						bool backward = CanCollapse(p1, p0);
+						if (!forward && !backward)
+							continue;
+
+						float forwardError = forward ? CollapseError(m_quadrics[p0], m_quadrics[p1], m_positions[p1]) : FLT_MAX;
+						float backwardError = backward ? CollapseError(m_quadrics[p0], m_quadrics[p1], m_positions[p0]) : FLT_MAX;
+						if (forwardError <= backwardError) {
+							collapses.push_back({ p0, p1, forwardError });
+						}
+						else {
+							collapses.push_back({ p1, p0, backwardError });
+						}
+					}
+				}
+				return collapses;
+			}
+
+			bool TryCollapse(const Collapse& collapse, std::vector<uint32_t>& remap, size_t& removedTriangles) const {
+				const Vector3& targetPosition = m_positions[collapse.target];
+
+				// Every vertex of the source needs a vertex of the target in its own attribute chart,
+				// otherwise the collapse crosses a seam
+				uint32_t wedgeTargets[64];
+				uint32_t wedgeCount = 0;
+				uint32_t wedge = collapse.source;
+				do {
+					if (wedgeCount == 64)
+						return false;
+
+					uint32_t wedgeTarget = UINT32_MAX;
+					const uint32_t* triangles = &m_adjacency[m_adjacencyOffsets[wedge]];
+					for (uint32_t t = 0; t < m_adjacencyCounts[wedge]; ++t) {
+						const uint32_t* triangle = &m_indices[triangles[t] * 3];
+						for (int k = 0; k < 3; ++k) {
+							if (m_positionIds[triangle[k]] != collapse.target)
+								continue;
+							if (wedgeTarget != UINT32_MAX && wedgeTarget != triangle[k])
+								return false;
+							wedgeTarget = triangle[k];
+						}
+					}
+
+					// Unused vertices sharing the position have no triangles and can stay as they are
+					if (wedgeTarget == UINT32_MAX && m_adjacencyCounts[wedge] > 0)
+						return false;
+					wedgeTargets[wedgeCount++] = wedgeTarget;
+					wedge = m_wedges[wedge];
+				} while (wedge != collapse.source);
+
+				// Reject collapses flipping the triangles moved with the source
+				size_t removed = 0;
+				wedge = collapse.source;
+				do {
+					const uint32_t* triangles = &m_adjacency[m_adjacencyOffsets[wedge]];
+					for (uint32_t t = 0; t < m_adjacencyCounts[wedge]; ++t) {
+						const uint32_t* triangle = &m_indices[triangles[t] * 3];
+						Vector3 before[3];
+						Vector3 after[3];
+						bool degenerate = false;
+						for (int k = 0; k < 3; ++k) {
+							uint32_t positionId = m_positionIds[triangle[k]];
+							degenerate |= positionId == collapse.target;
+							before[k] = m_positions[positionId];
+							after[k] = positionId == collapse.source ? targetPosition : before[k];
+						}
+
+						if (degenerate) {
+							removed++;
+							continue;
+						}
+
+						Vector3 normalBefore = Cross(before[1] - before[0], before[2] - before[0]);
+						Vector3 normalAfter = Cross(after[1] - after[0], after[2] - after[0]);
+						if (Dot(normalBefore, normalAfter) < MIN_NORMAL_DOT * Length(normalBefore) * Length(normalAfter))
+							return false;
+					}
+					wedge = m_wedges[wedge];
+				} while (wedge != collapse.source);
+
+				uint32_t wedgeIndex = 0;
+				wedge = collapse.source;
+				do {
+					if (wedgeTargets[wedgeIndex] != UINT32_MAX)
+						remap[wedge] = wedgeTargets[wedgeIndex];
+					wedgeIndex++;
+					wedge = m_wedges[wedge];
+				} while (wedge != collapse.source);
+
+				removedTriangles = removed;
+				return true;
+			}
+
+			// Moves the collapsed vertices and drops the triangles that became degenerate
+			void ApplyRemap(const std::vector<uint32_t>& remap) {
+				size_t writeIndex = 0;
+				for (size_t i = 0; i < m_indices.size(); i += 3) {
+					uint32_t a = remap[m_indices[i]];
+					uint32_t b = remap[m_indices[i + 1]];
+					uint32_t c = remap[m_indices[i + 2]];
+					uint32_t pa = m_positionIds[a];
+					uint32_t pb = m_positionIds[b];
+					uint32_t pc = m_positionIds[c];
+					if (pa == pb || pb == pc || pa == pc)
+						continue;
+
+					m_indices[writeIndex++] = a;
+					m_indices[writeIndex++] = b;
+					m_indices[writeIndex++] = c;
+				}
+				m_indices.resize(writeIndex);
+			}
+
+		private:
+			bool m_lockBorder;
+			std::vector<uint32_t> m_indices;
+			std::vector<Vector3> m_positions;
+			std::vector<uint32_t> m_positionIds;  // First vertex with the same position
+			std::vector<uint32_t> m_wedges;       // Next vertex with the same position
+			std::vector<Quadric> m_quadrics;      // Per position id
+
+			std::vector<uint32_t> m_adjacencyCounts;
+			std::vector<uint32_t> m_adjacencyOffsets;
+			std::vector<uint32_t> m_adjacency;
+			std::unordered_set<uint64_t> m_positionEdges;
+			std::vector<bool> m_borderVertices;
+	};
+}
+
+size_t MeshSimplifier::Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions,
+	size_t vertexCount, size_t positionStride, size_t targetIndexCount, float targetError, float* resultError, bool lockBorder) {
+	Simplifier simplifier(indices, indexCount, positions, vertexCount, positionStride, lockBorder);
+	float error = simplifier.Run(targetIndexCount, targetError);
+
+	const std::vector<uint32_t>& result = simplifier.GetIndices();
+	std::copy(result.begin(), result.end(), destination);
+	if (resultError)
+		*resultError = error;
+	return result.size();
+}
+
+MeshLodChain MeshSimplifier::GenerateLodChain(const uint32_t* indices, size_t indexCount, const float* positions,
+	size_t vertexCount, size_t positionStride, const MeshLodSettings& settings) {
+	MeshLodChain chain;
+	chain.indices.assign(indices, indices + indexCount);
+	chain.lods.push_back({ 0, static_cast<uint32_t>(indexCount), 0.0f });
+	if (vertexCount == 0)
+		return chain;
+
+	const size_t strideInFloats = positionStride / sizeof(float);
+	Vector3 boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+	Vector3 boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (size_t v = 0; v < vertexCount; ++v) {
+		const float* position = positions + v * strideInFloats;
+		boundsMin = { std::min(boundsMin.x, position[0]), std::min(boundsMin.y, position[1]), std::min(boundsMin.z, position[2]) };
+		boundsMax = { std::max(boundsMax.x, position[0]), std::max(boundsMax.y, position[1]), std::max(boundsMax.z, position[2]) };
+	}
+	const float maxError = Length(boundsMax - boundsMin) * settings.maxRelativeError;
+
+	// Every level is simplified from the full resolution mesh so its error is measured against it
+	std::vector<uint32_t> lodIndices(indexCount);
+	std::vector<uint32_t> optimizedIndices(indexCount);
+	size_t previousIndexCount = indexCount;
+	float previousError = 0.0f;
+	for (uint32_t level = 1; level < settings.maxLodCount; ++level) {
+		size_t targetIndexCount = static_cast<size_t>(previousIndexCount * settings.reductionPerLevel) / 3 * 3;
+		float error = 0.0f;
+		size_t lodIndexCount = Simplify(lodIndices.data(), indices, indexCount, positions, vertexCount, positionStride,
+			targetIndexCount, maxError, &error, settings.lockBorder);
+		if (lodIndexCount == 0 || lodIndexCount > previousIndexCount * (1.0f - settings.minReduction))
+			break;
+
+		MeshOptimizer::OptimizeVertexCache(optimizedIndices.data(), lodIndices.data(), lodIndexCount, vertexCount);
+
+		previousError = std::max(previousError, error);
+		chain.lods.push_back({ static_cast<uint32_t>(chain.indices.size()), static_cast<uint32_t>(lodIndexCount), previousError });
+		chain.indices.insert(chain.indices.end(), optimizedIndices.begin(), optimizedIndices.begin() + lodIndexCount);
+		previousIndexCount = lodIndexCount;
+	}
+
+	return chain;
+}
+
+float MeshSimplifier::ComputeProjectionScale(float fovY, float viewportHeight) {
+	return viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+}
+
+uint32_t MeshSimplifier::SelectLod(const float* lodErrors, size_t lodCount, float distance, float projectionScale, float maxScreenError) {
+	// Inside the bounds every level would be too coarse
+	if (distance <= 0.0f)
+		return 0;
+
+	for (size_t level = lodCount; level-- > 1;) {
+		if (lodErrors[level] * projectionScale / distance <= maxScreenError)
+			return static_cast<uint32_t>(level);
+	}
+	return 0;
+}
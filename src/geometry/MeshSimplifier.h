@@ -0,0 +1,60 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// One level of detail of a mesh, a range of the index buffer of the chain
+struct MeshLod {
+	uint32_t indexOffset;
+	uint32_t indexCount;
+	// Geometric deviation from the full resolution mesh, in the units of the vertex positions
+	float error;
+};
+
+struct MeshLodChain {
+	std::vector<uint32_t> indices;  // Every level, finest first, all referencing the same vertex buffer
+	std::vector<MeshLod> lods;
+};
+
+struct MeshLodSettings {
+	// Levels including the full resolution one
+	uint32_t maxLodCount = 4;
+	// Triangle count of each level relative to the previous one
+	float reductionPerLevel = 0.5f;
+	// Error allowed for the coarsest level, relative to the diagonal of the mesh bounds
+	float maxRelativeError = 0.05f;
+	// A level removing fewer triangles than this ratio of the previous one isn't worth its memory
+	float minReduction = 0.1f;
+	// Keeps the open borders of the mesh in place, for meshes split in parts that must not crack apart
+	bool lockBorder = false;
+};
+
+// Quadric error metric simplification (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics").
+// Edges are collapsed onto one of their vertices, so every level keeps using the original vertex buffer.
+// Vertices sharing a position but not their attributes (UV and normal seams) are collapsed together and only
+// along the seam, vertices on open borders only along the border, so neither seams nor silhouettes tear.
+namespace MeshSimplifier {
+	// Simplifies an indexed triangle list down to `targetIndexCount` indices, or fewer collapses if they would
+	// go over `targetError` (in position units). Returns the index count written to `destination`, which needs
+	// room for `indexCount` indices, and the error of the result in `resultError` if it's not null.
+	// With `lockBorder`, vertices on open borders are never collapsed.
+	size_t Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions,
+		size_t vertexCount, size_t positionStride, size_t targetIndexCount, float targetError, float* resultError = nullptr,
+		bool lockBorder = false);
+
+	// Builds the levels of detail of a mesh, level 0 being the mesh itself. The levels are vertex cache optimized.
+	MeshLodChain GenerateLodChain(const uint32_t* indices, size_t indexCount, const float* positions,
+		size_t vertexCount, size_t positionStride, const MeshLodSettings& settings = {});
+
+	// Scale from a distance in world units at a depth of 1 to pixels: viewportHeight / (2 * tan(fovY / 2))
+	float ComputeProjectionScale(float fovY, float viewportHeight);
+
+	// Picks the coarsest level whose error (MeshLod::error of each level), projected at `distance` from the camera,
+	// stays under `maxScreenError` pixels
+	uint32_t SelectLod(const float* lodErrors, size_t lodCount, float distance, float projectionScale, float maxScreenError);
+}
+
+#endif // !MESH_SIMPLIFIER_H
@@ -0,0 +1,57 @@
+#include "MeshSplitter.h"
+
+#include <cassert>
+
+
+MeshSplit MeshSplitter::SplitMesh(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t maxVertices) {
+	MeshSplit split;
+	const size_t triangleCount = indexCount / 3;
+	split.indices.reserve(triangleCount * 3);
+
+	// Part local index of every source vertex, valid if the stamp matches the current part
+	std::vector<uint32_t> localIndices(vertexCount);
+	std::vector<uint32_t> stamps(vertexCount, UINT32_MAX);
+
+	MeshPartRange part = {};
+	uint32_t partIndex = 0;
+	for (size_t t = 0; t < triangleCount; ++t) {
+		const uint32_t* triangle = &indices[t * 3];
+
+		uint32_t newVertices = 0;
+		for (int k = 0; k < 3; ++k) {
+			bool duplicate = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+			newVertices += stamps[triangle[k]] != partIndex && !duplicate ? 1 : 0;
+		}
+
+		if (part.vertexCount + newVertices > maxVertices) {
+			split.parts.push_back(part);
+			part.firstVertex += part.vertexCount;
+			part.firstIndex += part.indexCount;
+			part.vertexCount = 0;
+			part.indexCount = 0;
+			partIndex++;
+		}
+
+		for (int k = 0; k < 3; ++k) {
+			uint32_t vertex = triangle[k];
+			if (stamps[vertex] != partIndex) {
+				stamps[vertex] = partIndex;
+				localIndices[vertex] = part.vertexCount++;
+				split.vertices.push_back(vertex);
+			}
+			split.indices.push_back(localIndices[vertex]);
+		}
+		part.indexCount += 3;
+	}
+
+	if (part.indexCount > 0)
+		split.parts.push_back(part);
+	return split;
+}
+
+void MeshSplitter::NarrowIndices(uint16_t* destination, const uint32_t* indices, size_t indexCount) {
+	for (size_t i = 0; i < indexCount; ++i) {
+		assert(indices[i] < MAX_16BIT_VERTICES);
+		destination[i] = static_cast<uint16_t>(indices[i]);
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef MESH_SPLITTER_H
+#define MESH_SPLITTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// A part of a split mesh, a range of MeshSplit::vertices and a range of MeshSplit::indices
+struct MeshPartRange {
+	uint32_t firstVertex;
+	uint32_t vertexCount;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+};
+
+struct MeshSplit {
+	std::vector<MeshPartRange> parts;
+	std::vector<uint32_t> vertices;  // Source vertex of every part vertex
+	std::vector<uint32_t> indices;   // Relative to the first vertex of their part
+};
+
+// Index narrowing: 16-bit indices halve the index memory and are enough for the vast majority of meshes
+namespace MeshSplitter {
+	constexpr size_t MAX_16BIT_VERTICES = 65536;
+
+	// Splits a mesh in parts referencing at most `maxVertices` vertices each, keeping the triangle order.
+	// Vertices used by several parts are duplicated, a mesh that already fits is returned as a single part.
+	MeshSplit SplitMesh(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t maxVertices = MAX_16BIT_VERTICES);
+
+	// Every index must be below 65536
+	void NarrowIndices(uint16_t* destination, const uint32_t* indices, size_t indexCount);
+}
+
+#endif // !MESH_SPLITTER_H
@@ -0,0 +1,338 @@
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+using namespace DirectX;
+
+namespace {
+	struct Float3 {
+		float x, y, z;
+	};
+
+	Float3 operator-(const Float3& a, const Float3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	Float3 operator+(const Float3& a, const Float3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	Float3 operator*(const Float3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+	float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	float Length(const Float3& a) { return std::sqrt(Dot(a, a)); }
+	Float3 Cross(const Float3& a, const Float3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	Float3 Normalize(const Float3& a) {
+		float length = Length(a);
+		return length > 0.0f ? a * (1.0f / length) : Float3{ 0.0f, 0.0f, 0.0f };
+	}
+
+	// Below this, the triangles of a meshlet spread over more than ~85 degrees and the cone never culls anything
+	constexpr float MIN_CONE_DOT = 0.1f;
+
+	// Ritter's bounding sphere, within ~5% of the optimal one
+	void ComputeSphere(const Float3* points, size_t pointCount, Float3& center, float& radius) {
+		// Start with the pair of extreme points along the axis where they're the furthest apart
+		size_t minPoints[3] = {};
+		size_t maxPoints[3] = {};
+		for (size_t i = 0; i < pointCount; ++i) {
+			const float* p = &points[i].x;
+			for (int axis = 0; axis < 3; ++axis) {
+				if (p[axis] < (&points[minPoints[axis]].x)[axis]) minPoints[axis] = i;
+				if (p[axis] > (&points[maxPoints[axis]].x)[axis]) maxPoints[axis] = i;
+			}
+		}
+
+		int widestAxis = 0;
+		float widestDistance = 0.0f;
+		for (int axis = 0; axis < 3; ++axis) {
+			Float3 diagonal = points[maxPoints[axis]] - points[minPoints[axis]];
+			float distance = Dot(diagonal, diagonal);
+			if (distance > widestDistance) {
+				widestDistance = distance;
+				widestAxis = axis;
+			}
+		}
+
+		const Float3& p0 = points[minPoints[widestAxis]];
+		const Float3& p1 = points[maxPoints[widestAxis]];
+		center = (p0 + p1) * 0.5f;
+		radius = std::sqrt(widestDistance) * 0.5f;
+
+		// Grow the sphere to include every point outside of it
+		for (size_t i = 0; i < pointCount; ++i) {
+			float distance = Length(points[i] - center);
+			if (distance > radius) {
+				float shift = (distance - radius) * 0.5f;
+				center = center + (points[i] - center) * (shift / distance);
+				radius += shift;
+			}
+		}
+	}
+
+	MeshletBounds ComputeBounds(const Meshlet& meshlet, const MeshletData& meshletData, const Float3* vertexPositions,
+		const Float3* triangleNormals, const uint32_t* meshletTriangles) {
+		MeshletBounds bounds = {};
+
+		Float3 points[256];
+		for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+			points[i] = vertexPositions[meshletData.vertices[meshlet.vertexOffset + i]];
+
+		Float3 center;
+		float radius;
+		ComputeSphere(points, meshlet.vertexCount, center, radius);
+		bounds.center = XMFLOAT3(center.x, center.y, center.z);
+		bounds.radius = radius;
+
+		// The cone axis is the average normal, its spread is set by the normal furthest from it
+		Float3 normalSum = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+			normalSum = normalSum + triangleNormals[meshletTriangles[t]];
+		Float3 axis = Normalize(normalSum);
+
+		float minDot = 1.0f;
+		for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+			const Float3& normal = triangleNormals[meshletTriangles[t]];
+			// Degenerate triangles don't face any direction
+			if (Dot(normal, normal) > 0.0f)
+				minDot = std::min(minDot, Dot(normal, axis));
+		}
+
+		bounds.coneAxis = XMFLOAT3(axis.x, axis.y, axis.z);
+		if (minDot <= MIN_CONE_DOT) {
+			bounds.coneApex = bounds.center;
+			bounds.coneCutoff = 1.0f;
+			return bounds;
+		}
+
+		// Move the apex back along the axis until every triangle plane is in front of it
+		float maxOffset = 0.0f;
+		for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+			const Float3& normal = triangleNormals[meshletTriangles[t]];
+			if (Dot(normal, normal) == 0.0f)
+				continue;
+
+			const uint8_t* triangle = &meshletData.triangles[meshlet.triangleOffset + t * 3];
+			const Float3& p0 = vertexPositions[meshletData.vertices[meshlet.vertexOffset + triangle[0]]];
+			float offset = Dot(center - p0, normal) / Dot(axis, normal);
+			maxOffset = std::max(maxOffset, offset);
+		}
+
+		Float3 apex = center - axis * maxOffset;
+		bounds.coneApex = XMFLOAT3(apex.x, apex.y, apex.z);
+		bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+		return bounds;
+	}
+}
+
+MeshletData Meshlets::BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+	size_t positionStride, const MeshletSettings& settings) {
+	MeshletData meshletData;
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return meshletData;
+
+	const uint32_t maxVertices = std::min(std::max(settings.maxVertices, 3u), 256u);
+	const uint32_t maxTriangles = std::min(std::max(settings.maxTriangles, 1u), 256u);
+	const size_t strideInFloats = positionStride / sizeof(float);
+
+	std::vector<Float3> vertexPositions(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v) {
+		const float* position = positions + v * strideInFloats;
+		vertexPositions[v] = { position[0], position[1], position[2] };
+	}
+
+	std::vector<Float3> triangleNormals(triangleCount);
+	for (size_t t = 0; t < triangleCount; ++t) {
+		const Float3& p0 = vertexPositions[indices[t * 3 + 0]];
+		const Float3& p1 = vertexPositions[indices[t * 3 + 1]];
+		const Float3& p2 = vertexPositions[indices[t * 3 + 2]];
+		// Front faces are clockwise in a left-handed space, so this points towards the viewer of the front face
+		triangleNormals[t] = Normalize(Cross(p1 - p0, p2 - p0));
+	}
+
+	// Live triangles of every vertex, emitted triangles are swapped out of the lists
+	std::vector<uint32_t> adjacencyCounts(vertexCount, 0);
+	std::vector<uint32_t> adjacencyOffsets(vertexCount, 0);
+	std::vector<uint32_t> adjacency(indexCount);
+	for (size_t i = 0; i < indexCount; ++i)
+		adjacencyCounts[indices[i]]++;
+	uint32_t offset = 0;
+	for (size_t v = 0; v < vertexCount; ++v) {
+		adjacencyOffsets[v] = offset;
+		offset += adjacencyCounts[v];
+	}
+	std::vector<uint32_t> fill(adjacencyOffsets);
+	for (size_t i = 0; i < indexCount; ++i)
+		adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<bool> emitted(triangleCount, false);
+	// Local index of the vertices in the meshlet being built, UINT32_MAX if they're not in it
+	std::vector<uint32_t> localIndices(vertexCount, UINT32_MAX);
+	// Source triangle of every meshlet triangle, in meshlet order, to compute the bounds
+	std::vector<uint32_t> meshletTriangles;
+	meshletTriangles.reserve(triangleCount);
+
+	Meshlet meshlet = {};
+	Float3 normalSum = { 0.0f, 0.0f, 0.0f };
+
+	auto flushMeshlet = [&]() {
+		if (meshlet.triangleCount == 0)
+			return;
+
+		for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+			localIndices[meshletData.vertices[meshlet.vertexOffset + i]] = UINT32_MAX;
+
+		meshletData.meshlets.push_back(meshlet);
+		meshlet.vertexOffset = static_cast<uint32_t>(meshletData.vertices.size());
+		meshlet.triangleOffset = static_cast<uint32_t>(meshletData.triangles.size());
+		meshlet.vertexCount = 0;
+		meshlet.triangleCount = 0;
+		normalSum = { 0.0f, 0.0f, 0.0f };
+	};
+
+	auto newVertexCount = [&](size_t triangle) {
+		uint32_t count = 0;
+		for (int k = 0; k < 3; ++k)
+			count += localIndices[indices[triangle * 3 + k]] == UINT32_MAX ? 1 : 0;
+		return count;
+	};
+
+	size_t inputCursor = 0;
+	for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+		// Pick the triangle around the meshlet adding the fewest vertices and facing the meshlet direction
+		size_t bestTriangle = SIZE_MAX;
+		float bestScore = FLT_MAX;
+		Float3 meshletAxis = Normalize(normalSum);
+		for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+			uint32_t vertex = meshletData.vertices[meshlet.vertexOffset + i];
+			const uint32_t* vertexTriangles = &adjacency[adjacencyOffsets[vertex]];
+			for (uint32_t j = 0; j < adjacencyCounts[vertex]; ++j) {
+				uint32_t triangle = vertexTriangles[j];
+				uint32_t extraVertices = newVertexCount(triangle);
+				if (meshlet.vertexCount + extraVertices > maxVertices)
+					continue;
+
+				float score = extraVertices + settings.coneWeight * (1.0f - Dot(triangleNormals[triangle], meshletAxis));
+				if (score < bestScore) {
+					bestScore = score;
+					bestTriangle = triangle;
+				}
+			}
+		}
+
+		if (bestTriangle == SIZE_MAX) {
+			// Nothing connected fits: continue with the index order, in a new meshlet if needed
+			while (emitted[inputCursor])
+				++inputCursor;
+			bestTriangle = inputCursor;
+			if (meshlet.vertexCount + newVertexCount(bestTriangle) > maxVertices)
+				flushMeshlet();
+		}
+
+		// Append the triangle to the meshlet
+		for (int k = 0; k < 3; ++k) {
+			uint32_t vertex = indices[bestTriangle * 3 + k];
+			if (localIndices[vertex] == UINT32_MAX) {
+				localIndices[vertex] = meshlet.vertexCount++;
+				meshletData.vertices.push_back(vertex);
+			}
+			meshletData.triangles.push_back(static_cast<uint8_t>(localIndices[vertex]));
+
+			uint32_t* vertexTriangles = &adjacency[adjacencyOffsets[vertex]];
+			uint32_t& count = adjacencyCounts[vertex];
+			for (uint32_t j = 0; j < count; ++j) {
+				if (vertexTriangles[j] == bestTriangle) {
+					vertexTriangles[j] = vertexTriangles[count - 1];
+					count--;
+					break;
+				}
+			}
+		}
+		emitted[bestTriangle] = true;
+		meshletTriangles.push_back(static_cast<uint32_t>(bestTriangle));
+		normalSum = normalSum + triangleNormals[bestTriangle];
+
+		if (++meshlet.triangleCount == maxTriangles)
+			flushMeshlet();
+	}
+	flushMeshlet();
+
+	meshletData.bounds.reserve(meshletData.meshlets.size());
+	for (const Meshlet& builtMeshlet : meshletData.meshlets) {
+		meshletData.bounds.push_back(ComputeBounds(builtMeshlet, meshletData, vertexPositions.data(), triangleNormals.data(),
+			&meshletTriangles[builtMeshlet.triangleOffset / 3]));
+	}
+
+	return meshletData;
+}
+
+std::vector<uint32_t> Meshlets::BuildMeshletIndices(const MeshletData& meshletData) {
+	std::vector<uint32_t> indices(meshletData.triangles.size());
+	for (const Meshlet& meshlet : meshletData.meshlets) {
+		for (uint32_t i = 0; i < meshlet.triangleCount * 3; ++i) {
+			uint8_t localIndex = meshletData.triangles[meshlet.triangleOffset + i];
+			indices[meshlet.triangleOffset + i] = meshletData.vertices[meshlet.vertexOffset + localIndex];
+		}
+	}
+	return indices;
+}
+
+ViewFrustum XM_CALLCONV Meshlets::ExtractFrustum(FXMMATRIX viewProjection) {
+	// Gribb/Hartmann: with row vectors, clip = v * M, so each clip coordinate is the dot product with a column
+	XMFLOAT4X4 m;
+	XMStoreFloat4x4(&m, viewProjection);
+	const float columns[4][4] = {
+		{ m._11, m._21, m._31, m._41 },
+		{ m._12, m._22, m._32, m._42 },
+		{ m._13, m._23, m._33, m._43 },
+		{ m._14, m._24, m._34, m._44 }
+	};
+
+	ViewFrustum frustum;
+	auto setPlane = [&frustum](int plane, const float* a, const float* b, float sign) {
+		float x = a[0] + sign * b[0];
+		float y = a[1] + sign * b[1];
+		float z = a[2] + sign * b[2];
+		float w = a[3] + sign * b[3];
+		float length = std::sqrt(x * x + y * y + z * z);
+		float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+		frustum.planes[plane] = XMFLOAT4(x * invLength, y * invLength, z * invLength, w * invLength);
+	};
+
+	setPlane(0, columns[3], columns[0], 1.0f);   // Left:   w + x >= 0
+	setPlane(1, columns[3], columns[0], -1.0f);  // Right:  w - x >= 0
+	setPlane(2, columns[3], columns[1], 1.0f);   // Bottom: w + y >= 0
+	setPlane(3, columns[3], columns[1], -1.0f);  // Top:    w - y >= 0
+	setPlane(4, columns[2], columns[2], 0.0f);   // Near:   z >= 0 (D3D clip space)
+	setPlane(5, columns[3], columns[2], -1.0f);  // Far:    w - z >= 0
+	return frustum;
+}
+
+bool Meshlets::IsSphereVisible(const ViewFrustum& frustum, const XMFLOAT3& center, float radius) {
+	for (const XMFLOAT4& plane : frustum.planes) {
+		if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius)
+			return false;
+	}
+	return true;
+}
+
+bool Meshlets::IsConeBackfacing(const MeshletBounds& bounds, const XMFLOAT3& cameraPosition) {
+	if (bounds.coneCutoff >= 1.0f)
+		return false;
+
+	Float3 toApex = { bounds.coneApex.x - cameraPosition.x, bounds.coneApex.y - cameraPosition.y, bounds.coneApex.z - cameraPosition.z };
+	float distance = Length(toApex);
+	if (distance == 0.0f)
+		return false;
+
+	Float3 axis = { bounds.coneAxis.x, bounds.coneAxis.y, bounds.coneAxis.z };
+	return Dot(toApex, axis) >= bounds.coneCutoff * distance;
+}
+
+size_t Meshlets::CullMeshlets(const MeshletData& meshletData, const ViewFrustum& frustum, const XMFLOAT3& cameraPosition,
+	uint32_t* visibleMeshlets) {
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < meshletData.bounds.size(); ++i) {
+		const MeshletBounds& bounds = meshletData.bounds[i];
+		if (IsSphereVisible(frustum, bounds.center, bounds.radius) && !IsConeBackfacing(bounds, cameraPosition))
+			visibleMeshlets[visibleCount++] = static_cast<uint32_t>(i);
+	}
+	return visibleCount;
+}
@@ -0,0 +1,80 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// A cluster of triangles of a mesh, small enough to be culled on its own
+struct Meshlet {
+	uint32_t vertexOffset;    // First entry of the meshlet in MeshletData::vertices
+	uint32_t triangleOffset;  // First entry of the meshlet in MeshletData::triangles, also its first index in the meshlet ordered index buffer
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+};
+
+// Culling bounds of a meshlet, in the space of the mesh vertices
+struct MeshletBounds {
+	// Bounding sphere
+	DirectX::XMFLOAT3 center;
+	float radius;
+
+	// Normal cone: the meshlet faces away from any viewpoint v where
+	// dot(normalize(coneApex - v), coneAxis) >= coneCutoff. A cutoff of 1 disables the test.
+	DirectX::XMFLOAT3 coneApex;
+	float coneCutoff;
+	DirectX::XMFLOAT3 coneAxis;
+	float padding;
+};
+
+struct MeshletSettings {
+	// Limits of a meshlet, local indices are stored on 8 bits so neither can go over 256.
+	// The defaults are the sizes recommended for mesh shaders, they also work well for CPU culling.
+	uint32_t maxVertices = 64;
+	uint32_t maxTriangles = 124;
+	// How much the builder favours triangles facing the same way as the meshlet over triangles
+	// sharing more vertices with it. Higher values give tighter normal cones and more meshlets.
+	float coneWeight = 0.25f;
+};
+
+struct MeshletData {
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshletBounds> bounds;    // One per meshlet
+	std::vector<uint32_t> vertices;       // Indices into the mesh vertex buffer, per meshlet
+	std::vector<uint8_t> triangles;       // Three local indices (into the meshlet vertices) per triangle
+};
+
+// Six planes (left, right, bottom, top, near, far) pointing inside, normalized
+struct ViewFrustum {
+	DirectX::XMFLOAT4 planes[6];
+};
+
+// Splits meshes in meshlets and culls them on the CPU against the view frustum and their normal cone.
+// Meshlets are drawn with the meshlet ordered index buffer, where every meshlet is a contiguous range
+// of indices, so the visible meshlets are submitted as a few DrawIndexed calls.
+namespace Meshlets {
+	// Builds the meshlets of an indexed triangle list. The indices should already be vertex cache
+	// optimized, the builder grows each meshlet over adjacent triangles and falls back to the index order.
+	// `positions` points to the first float3 position, `positionStride` is the vertex size in bytes.
+	MeshletData BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+		size_t positionStride, const MeshletSettings& settings = {});
+
+	// Index buffer of the mesh in meshlet order, meshlet i covers [triangleOffset, triangleOffset + triangleCount * 3)
+	std::vector<uint32_t> BuildMeshletIndices(const MeshletData& meshletData);
+
+	// Extracts the planes of a view projection matrix (D3D clip space, row vectors like the rest of DirectXMath).
+	// Pass world * view * projection to get the frustum in the space of the mesh vertices.
+	ViewFrustum XM_CALLCONV ExtractFrustum(DirectX::FXMMATRIX viewProjection);
+
+	bool IsSphereVisible(const ViewFrustum& frustum, const DirectX::XMFLOAT3& center, float radius);
+	// `cameraPosition` must be in the same space as the bounds
+	bool IsConeBackfacing(const MeshletBounds& bounds, const DirectX::XMFLOAT3& cameraPosition);
+
+	// Writes the index of every visible meshlet to `visibleMeshlets` (in order) and returns their count
+	size_t CullMeshlets(const MeshletData& meshletData, const ViewFrustum& frustum, const DirectX::XMFLOAT3& cameraPosition,
+		uint32_t* visibleMeshlets);
+}
+
+#endif // !MESHLETS_H
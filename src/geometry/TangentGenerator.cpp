@@ -0,0 +1,209 @@
+#include "TangentGenerator.h"
+
+#include <DirectXMath.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+
+#include "../utils/ConsoleLogger.h"
+#include "../utils/ThreadPool.h"
+
+
+using namespace DirectX;
+
+namespace {
+	// Triangles with a UV area or a position area below this don't define a tangent
+	constexpr float DEGENERATE_EPSILON = 1e-20f;
+
+	enum TriangleFlags : uint8_t {
+		ORIENTATION_PRESERVING = 1 << 0,  // UV mapping not mirrored, the bitangent sign is +1
+		DEGENERATE = 1 << 1
+	};
+
+	// Any unit vector perpendicular to the normal, for vertices without usable UVs
+	XMVECTOR XM_CALLCONV FallbackTangent(FXMVECTOR normal) {
+		XMVECTOR axis = std::fabs(XMVectorGetX(normal)) < 0.9f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		return XMVector3Normalize(XMVector3Cross(XMVector3Cross(normal, axis), normal));
+	}
+
+	// Removes the component of `v` along the unit vector `normal`
+	XMVECTOR XM_CALLCONV ProjectOnPlane(FXMVECTOR v, FXMVECTOR normal) {
+		return XMVectorNegativeMultiplySubtract(normal, XMVector3Dot(normal, v), v);
+	}
+}
+
+size_t TangentGenerator::GenerateTangents(std::vector<CompleteVertexData>& vertices, std::vector<uint32_t>& indices) {
+	const size_t triangleCount = indices.size() / 3;
+	const size_t originalVertexCount = vertices.size();
+
+	// Tangent (direction of increasing U) and orientation of every triangle
+	std::vector<XMFLOAT3> triangleTangents(triangleCount);
+	std::vector<uint8_t> triangleFlags(triangleCount, 0);
+	for (size_t t = 0; t < triangleCount; ++t) {
+		const CompleteVertexData& v0 = vertices[indices[t * 3 + 0]];
+		const CompleteVertexData& v1 = vertices[indices[t * 3 + 1]];
+		const CompleteVertexData& v2 = vertices[indices[t * 3 + 2]];
+
+		XMVECTOR p0 = XMLoadFloat3(&v0.vPosition);
+		XMVECTOR edge1 = XMVectorSubtract(XMLoadFloat3(&v1.vPosition), p0);
+		XMVECTOR edge2 = XMVectorSubtract(XMLoadFloat3(&v2.vPosition), p0);
+
+		XMVECTOR uv0 = XMLoadFloat2(&v0.vTexCoordinate);
+		XMVECTOR uvEdge1 = XMVectorSubtract(XMLoadFloat2(&v1.vTexCoordinate), uv0);
+		XMVECTOR uvEdge2 = XMVectorSubtract(XMLoadFloat2(&v2.vTexCoordinate), uv0);
+
+		// Twice the signed UV area, negative when the mapping is mirrored
+		float signedUvArea = XMVectorGetX(uvEdge1) * XMVectorGetY(uvEdge2) - XMVectorGetY(uvEdge1) * XMVectorGetX(uvEdge2);
+		if (signedUvArea > 0.0f)
+			triangleFlags[t] |= ORIENTATION_PRESERVING;
+
+		// dP/dU scaled by the signed UV area: edge1 * dv2 - edge2 * dv1
+		XMVECTOR tangent = XMVectorSubtract(XMVectorMultiply(edge1, XMVectorSplatY(uvEdge2)), XMVectorMultiply(edge2, XMVectorSplatY(uvEdge1)));
+		float tangentLengthSquared = XMVectorGetX(XMVector3LengthSq(tangent));
+		float positionAreaSquared = XMVectorGetX(XMVector3LengthSq(XMVector3Cross(edge1, edge2)));
+		if (std::fabs(signedUvArea) <= DEGENERATE_EPSILON || tangentLengthSquared <= DEGENERATE_EPSILON || positionAreaSquared <= DEGENERATE_EPSILON) {
+			triangleFlags[t] |= DEGENERATE;
+			triangleTangents[t] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			continue;
+		}
+
+		float orientation = signedUvArea > 0.0f ? 1.0f : -1.0f;
+		XMStoreFloat3(&triangleTangents[t], XMVectorScale(tangent, orientation / std::sqrt(tangentLengthSquared)));
+	}
+
+	// Mirrored UV seams: vertices used with both orientations get a copy for the mirrored triangles
+	std::vector<uint8_t> vertexOrientations(originalVertexCount, 0);
+	for (size_t t = 0; t < triangleCount; ++t) {
+		if (triangleFlags[t] & DEGENERATE)
+			continue;
+		uint8_t orientation = (triangleFlags[t] & ORIENTATION_PRESERVING) ? 1 : 2;
+		for (int k = 0; k < 3; ++k)
+			vertexOrientations[indices[t * 3 + k]] |= orientation;
+	}
+
+	std::vector<uint32_t> mirroredCopies(originalVertexCount, UINT32_MAX);
+	for (size_t t = 0; t < triangleCount; ++t) {
+		if ((triangleFlags[t] & (DEGENERATE | ORIENTATION_PRESERVING)) != 0)
+			continue;
+		for (int k = 0; k < 3; ++k) {
+			uint32_t& index = indices[t * 3 + k];
+			if (vertexOrientations[index] != 3)
+				continue;
+			if (mirroredCopies[index] == UINT32_MAX) {
+				mirroredCopies[index] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(vertices[index]);
+			}
+			index = mirroredCopies[index];
+		}
+	}
+
+	// Accumulate the angle weighted tangent of every corner, projected on the plane of its vertex normal
+	const size_t vertexCount = vertices.size();
+	std::vector<XMFLOAT4A> accumulatedTangents(vertexCount, XMFLOAT4A(0.0f, 0.0f, 0.0f, 0.0f));
+	std::vector<float> bitangentSigns(vertexCount, 1.0f);
+	for (size_t t = 0; t < triangleCount; ++t) {
+		if (triangleFlags[t] & DEGENERATE)
+			continue;
+
+		XMVECTOR triangleTangent = XMLoadFloat3(&triangleTangents[t]);
+		float sign = (triangleFlags[t] & ORIENTATION_PRESERVING) ? 1.0f : -1.0f;
+		XMVECTOR positions[3];
+		for (int k = 0; k < 3; ++k)
+			positions[k] = XMLoadFloat3(&vertices[indices[t * 3 + k]].vPosition);
+
+		for (int k = 0; k < 3; ++k) {
+			uint32_t index = indices[t * 3 + k];
+			XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&vertices[index].vNormal));
+
+			XMVECTOR toNext = XMVector3Normalize(ProjectOnPlane(XMVectorSubtract(positions[(k + 1) % 3], positions[k]), normal));
+			XMVECTOR toPrevious = XMVector3Normalize(ProjectOnPlane(XMVectorSubtract(positions[(k + 2) % 3], positions[k]), normal));
+			float cosAngle = std::min(std::max(XMVectorGetX(XMVector3Dot(toNext, toPrevious)), -1.0f), 1.0f);
+			float angle = std::acos(cosAngle);
+
+			XMVECTOR cornerTangent = XMVector3Normalize(ProjectOnPlane(triangleTangent, normal));
+			XMVECTOR accumulated = XMLoadFloat4A(&accumulatedTangents[index]);
+			XMStoreFloat4A(&accumulatedTangents[index], XMVectorMultiplyAdd(cornerTangent, XMVectorReplicate(angle), accumulated));
+			bitangentSigns[index] = sign;
+		}
+	}
+
+	for (size_t v = 0; v < vertexCount; ++v) {
+		CompleteVertexData& vertex = vertices[v];
+		XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&vertex.vNormal));
+		XMVECTOR tangent = ProjectOnPlane(XMLoadFloat4A(&accumulatedTangents[v]), normal);
+		if (XMVectorGetX(XMVector3LengthSq(tangent)) <= DEGENERATE_EPSILON) {
+			tangent = FallbackTangent(normal);
+		}
+		else {
+			tangent = XMVector3Normalize(tangent);
+		}
+
+		XMVECTOR bitangent = XMVectorScale(XMVector3Cross(normal, tangent), bitangentSigns[v]);
+		XMStoreFloat3(&vertex.vTangent, tangent);
+		XMStoreFloat3(&vertex.vBitangent, bitangent);
+	}
+
+	return vertexCount - originalVertexCount;
+}
+
+void TangentGenerator::GenerateTangents(const TangentMesh* meshes, size_t meshCount, ThreadPool& threadPool) {
+	std::vector<std::future<size_t>> results;
+	results.reserve(meshCount);
+	for (size_t i = 0; i < meshCount; ++i) {
+		TangentMesh mesh = meshes[i];
+		results.push_back(threadPool.Submit([mesh]() { return GenerateTangents(*mesh.vertices, *mesh.indices); }));
+	}
+
+	size_t splitVertices = 0;
+	for (std::future<size_t>& result : results)
+		splitVertices += result.get();
+
+	if (splitVertices > 0) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Tangent generation split ", splitVertices,
+			" vertices on mirrored UVs over ", meshCount, " primitives.");
+	}
+}
+
+void TangentGenerator::Benchmark(const TangentMesh* meshes, size_t meshCount, ThreadPool& threadPool) {
+	using Clock = std::chrono::high_resolution_clock;
+
+	size_t vertexCount = 0;
+	size_t triangleCount = 0;
+	for (size_t i = 0; i < meshCount; ++i) {
+		vertexCount += meshes[i].vertices->size();
+		triangleCount += meshes[i].indices->size() / 3;
+	}
+
+	// Work on copies, the splits change the inputs
+	auto makeCopies = [meshes, meshCount](std::vector<std::vector<CompleteVertexData>>& vertices,
+		std::vector<std::vector<uint32_t>>& indices, std::vector<TangentMesh>& copies) {
+		vertices.resize(meshCount);
+		indices.resize(meshCount);
+		copies.resize(meshCount);
+		for (size_t i = 0; i < meshCount; ++i) {
+			vertices[i] = *meshes[i].vertices;
+			indices[i] = *meshes[i].indices;
+			copies[i] = { &vertices[i], &indices[i] };
+		}
+	};
+
+	std::vector<std::vector<CompleteVertexData>> vertexCopies;
+	std::vector<std::vector<uint32_t>> indexCopies;
+	std::vector<TangentMesh> copies;
+
+	makeCopies(vertexCopies, indexCopies, copies);
+	auto start = Clock::now();
+	for (TangentMesh& mesh : copies)
+		GenerateTangents(*mesh.vertices, *mesh.indices);
+	float singleThreadMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+	makeCopies(vertexCopies, indexCopies, copies);
+	start = Clock::now();
+	GenerateTangents(copies.data(), copies.size(), threadPool);
+	float poolMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+	ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Tangent generation benchmark: ", meshCount, " primitives, ",
+		vertexCount, " vertices, ", triangleCount, " triangles. 1 thread: ", singleThreadMs, " ms, ",
+		threadPool.GetThreadCount(), " workers: ", poolMs, " ms (", singleThreadMs / (poolMs > 0.0f ? poolMs : 1.0f), "x).");
+}
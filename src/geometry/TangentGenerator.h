@@ -0,0 +1,38 @@
+#ifndef TANGENT_GENERATOR_H
+#define TANGENT_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../graphics/VertexFormat.h"
+
+class ThreadPool;
+
+
+// A primitive to generate tangents for, the vectors are modified in place
+struct TangentMesh {
+	std::vector<CompleteVertexData>* vertices;
+	std::vector<uint32_t>* indices;
+};
+
+// Tangent space generation following the MikkTSpace conventions (the ones normal maps are baked with):
+// - the tangent of a triangle is the direction of increasing U, the bitangent of increasing V
+// - each corner contributes its triangle tangent projected on the vertex normal plane, weighted by the corner angle
+// - bitangent = sign * cross(normal, tangent), the sign being the handedness of the UV mapping
+// Vertices shared by triangles with opposite UV handedness (mirrored UVs) are split in two, one per handedness,
+// so the two sides of a mirror seam don't average their tangents out.
+// The per-triangle and per-corner math runs on DirectXMath vectors.
+namespace TangentGenerator {
+	// Fills vTangent and vBitangent, the normals and texture coordinates must be set.
+	// Returns the number of vertices added by mirrored UV splits, they're appended to `vertices`.
+	size_t GenerateTangents(std::vector<CompleteVertexData>& vertices, std::vector<uint32_t>& indices);
+
+	// Runs GenerateTangents on every primitive, one task per primitive on the pool
+	void GenerateTangents(const TangentMesh* meshes, size_t meshCount, ThreadPool& threadPool);
+
+	// Times tangent generation over copies of the primitives, on one thread then on the pool, and logs the results
+	void Benchmark(const TangentMesh* meshes, size_t meshCount, ThreadPool& threadPool);
+}
+
+#endif // !TANGENT_GENERATOR_H
@@ -0,0 +1,255 @@
+#include "VertexWelder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace {
+	// Cells span this many epsilons, so most vertices are far enough from the cell borders to need a single probe
+	constexpr double CELL_SIZE_IN_EPSILONS = 8.0;
+
+	// Position cell of a vertex: grid coordinates of a float position, or the raw bytes of a quantized one
+	struct CellKey {
+		int32_t coordinates[4];
+
+		bool operator==(const CellKey& other) const {
+			return std::memcmp(coordinates, other.coordinates, sizeof(coordinates)) == 0;
+		}
+	};
+
+	bool IsFloatFormat(DXGI_FORMAT format) {
+		return format == DXGI_FORMAT_R32G32B32A32_FLOAT || format == DXGI_FORMAT_R32G32B32_FLOAT ||
+			format == DXGI_FORMAT_R32G32_FLOAT || format == DXGI_FORMAT_R32_FLOAT;
+	}
+
+	uint32_t HashCell(const CellKey& key) {
+		// Multiplicative mixing of the coordinates and a murmur finalizer, FNV-1a byte by byte is too slow here
+		uint32_t hash = static_cast<uint32_t>(key.coordinates[0]) * 73856093u ^ static_cast<uint32_t>(key.coordinates[1]) * 19349663u ^
+			static_cast<uint32_t>(key.coordinates[2]) * 83492791u ^ static_cast<uint32_t>(key.coordinates[3]) * 2654435761u;
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6bu;
+		hash ^= hash >> 13;
+		hash *= 0xc2b2ae35u;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	int32_t QuantizeCoordinate(double cell) {
+		// NaN lands in cell 0, it never compares within tolerance anyway
+		if (!(cell > static_cast<double>(INT32_MIN)))
+			return cell != cell ? 0 : INT32_MIN;
+		if (cell >= static_cast<double>(INT32_MAX))
+			return INT32_MAX;
+		return static_cast<int32_t>(cell);
+	}
+
+	// Hash table entry, the hash of the cell saves a cache miss on its key when probing past other cells
+	struct Slot {
+		uint32_t head;  // First unique vertex of the cell, UINT32_MAX if the slot is empty
+		uint32_t hash;
+	};
+
+	class WeldTable {
+		public:
+			WeldTable(const uint8_t* vertices, size_t vertexCount, size_t vertexSize, const VertexAttribute* attributes,
+				size_t attributeCount, const WeldSettings& settings)
+				: m_vertices(vertices), m_vertexSize(vertexSize), m_attributes(attributes), m_attributeCount(attributeCount),
+				m_settings(settings), m_keys(vertexCount), m_next(vertexCount, UINT32_MAX) {
+				m_positionAttribute = 0;
+				for (size_t i = 0; i < attributeCount; ++i) {
+					if (std::strcmp(attributes[i].semanticName, "POSITION") == 0 && attributes[i].semanticIndex == 0) {
+						m_positionAttribute = i;
+						break;
+					}
+				}
+
+				const VertexAttribute& position = attributes[m_positionAttribute];
+				m_gridPosition = IsFloatFormat(position.format) && settings.positionEpsilon > 0.0f;
+				m_positionComponents = IsFloatFormat(position.format) ? position.size / 4 : 0;
+				m_inverseCellSize = m_gridPosition ? 1.0 / (CELL_SIZE_IN_EPSILONS * settings.positionEpsilon) : 0.0;
+
+				// Load factor of at most 0.5 so the probe sequences stay short
+				size_t capacity = 16;
+				while (capacity < vertexCount * 2)
+					capacity *= 2;
+				m_slots.assign(capacity, Slot{ UINT32_MAX, 0 });
+				m_slotMask = capacity - 1;
+			}
+
+			// Returns the unique vertex `vertex` is welded into, registering it as a new one if there's none
+			uint32_t Weld(uint32_t vertex) {
+				const uint8_t* data = m_vertices + vertex * m_vertexSize;
+				const VertexAttribute& position = m_attributes[m_positionAttribute];
+				CellKey& key = m_keys[vertex];
+				std::memset(&key, 0, sizeof(key));
+
+				if (!m_gridPosition) {
+					// Exact matches only: the cell is the bit pattern, with -0 folded into +0 for floats
+					std::memcpy(key.coordinates, data + position.offset, std::min<size_t>(position.size, sizeof(key.coordinates)));
+					for (UINT c = 0; c < m_positionComponents; ++c) {
+						if (key.coordinates[c] == INT32_MIN)
+							key.coordinates[c] = 0;
+					}
+
+					uint32_t match = FindInCell(key, data);
+					if (match != UINT32_MAX)
+						return match;
+				}
+				else {
+					// A vertex within epsilon is in the same cell, or in the neighbour across a border closer than epsilon
+					int32_t neighbours[4] = {};
+					uint32_t neighbourMask = 0;
+					for (UINT c = 0; c < m_positionComponents; ++c) {
+						float value;
+						std::memcpy(&value, data + position.offset + c * sizeof(float), sizeof(float));
+						double scaled = static_cast<double>(value) * m_inverseCellSize;
+						double cell = std::floor(scaled);
+						key.coordinates[c] = QuantizeCoordinate(cell);
+
+						double borderDistance = scaled - cell;
+						if (borderDistance * CELL_SIZE_IN_EPSILONS <= 1.0)
+							neighbours[c] = -1;
+						else if ((1.0 - borderDistance) * CELL_SIZE_IN_EPSILONS <= 1.0)
+							neighbours[c] = 1;
+						neighbourMask |= neighbours[c] != 0 ? 1u << c : 0u;
+					}
+
+					// Every combination of the axes that have a neighbour, the own cell first
+					for (uint32_t mask = 0; mask <= neighbourMask; ++mask) {
+						if ((mask & ~neighbourMask) != 0)
+							continue;
+
+						CellKey probe = key;
+						bool valid = true;
+						for (UINT c = 0; c < m_positionComponents; ++c) {
+							if ((mask & (1u << c)) == 0)
+								continue;
+							int64_t coordinate = static_cast<int64_t>(probe.coordinates[c]) + neighbours[c];
+							valid &= coordinate >= INT32_MIN && coordinate <= INT32_MAX;
+							probe.coordinates[c] = static_cast<int32_t>(coordinate);
+						}
+						if (!valid)
+							continue;
+
+						uint32_t match = FindInCell(probe, data);
+						if (match != UINT32_MAX)
+							return match;
+					}
+				}
+
+				Insert(vertex);
+				return UINT32_MAX;
+			}
+
+		private:
+			// Walks the vertices chained in the cell, returns the first one within tolerance or UINT32_MAX.
+			// Only the hashes are compared: a colliding cell can't hold a vertex within tolerance, so its chain
+			// is walked for nothing but the result is the same, and the keys stay out of the cache.
+			uint32_t FindInCell(const CellKey& key, const uint8_t* data) const {
+				const uint32_t hash = HashCell(key);
+				for (size_t slot = hash & m_slotMask; m_slots[slot].head != UINT32_MAX; slot = (slot + 1) & m_slotMask) {
+					if (m_slots[slot].hash != hash)
+						continue;
+
+					for (uint32_t candidate = m_slots[slot].head; candidate != UINT32_MAX; candidate = m_next[candidate]) {
+						if (AreEquivalent(data, m_vertices + candidate * m_vertexSize))
+							return candidate;
+					}
+				}
+				return UINT32_MAX;
+			}
+
+			// Adds a unique vertex at the head of the chain of its cell
+			void Insert(uint32_t vertex) {
+				const CellKey& key = m_keys[vertex];
+				const uint32_t hash = HashCell(key);
+				size_t slot = hash & m_slotMask;
+				while (m_slots[slot].head != UINT32_MAX && (m_slots[slot].hash != hash || !(m_keys[m_slots[slot].head] == key)))
+					slot = (slot + 1) & m_slotMask;
+
+				m_next[vertex] = m_slots[slot].head;
+				m_slots[slot] = Slot{ vertex, hash };
+			}
+
+			bool AreEquivalent(const uint8_t* a, const uint8_t* b) const {
+				for (size_t i = 0; i < m_attributeCount; ++i) {
+					const VertexAttribute& attribute = m_attributes[i];
+					if (!IsFloatFormat(attribute.format)) {
+						if (std::memcmp(a + attribute.offset, b + attribute.offset, attribute.size) != 0)
+							return false;
+						continue;
+					}
+
+					float epsilon = i == m_positionAttribute ? m_settings.positionEpsilon : m_settings.attributeEpsilon;
+					for (UINT c = 0; c < attribute.size / 4; ++c) {
+						float valueA, valueB;
+						std::memcpy(&valueA, a + attribute.offset + c * sizeof(float), sizeof(float));
+						std::memcpy(&valueB, b + attribute.offset + c * sizeof(float), sizeof(float));
+						if (!(std::fabs(valueA - valueB) <= epsilon))
+							return false;
+					}
+				}
+				return true;
+			}
+
+		private:
+			const uint8_t* m_vertices;
+			size_t m_vertexSize;
+			const VertexAttribute* m_attributes;
+			size_t m_attributeCount;
+			const WeldSettings& m_settings;
+
+			size_t m_positionAttribute;
+			bool m_gridPosition;
+			UINT m_positionComponents;
+			double m_inverseCellSize;
+
+			std::vector<CellKey> m_keys;    // Cell of every vertex
+			std::vector<uint32_t> m_next;   // Next unique vertex in the same cell
+			std::vector<Slot> m_slots;
+			size_t m_slotMask;
+	};
+}
+
+size_t VertexWelder::GenerateWeldRemap(uint32_t* remap, const void* vertices, size_t vertexCount, size_t vertexSize,
+	const VertexAttribute* attributes, size_t attributeCount, const WeldSettings& settings) {
+	if (vertexCount == 0 || attributeCount == 0)
+		return 0;
+
+	WeldTable table(static_cast<const uint8_t*>(vertices), vertexCount, vertexSize, attributes, attributeCount, settings);
+
+	uint32_t uniqueCount = 0;
+	for (size_t i = 0; i < vertexCount; ++i) {
+		uint32_t match = table.Weld(static_cast<uint32_t>(i));
+		remap[i] = match == UINT32_MAX ? uniqueCount++ : remap[match];
+	}
+	return uniqueCount;
+}
+
+size_t VertexWelder::CompactVertexBuffer(void* vertices, size_t vertexCount, size_t vertexSize, const uint32_t* remap) {
+	uint8_t* bytes = static_cast<uint8_t*>(vertices);
+	size_t uniqueCount = 0;
+	for (size_t i = 0; i < vertexCount; ++i) {
+		// The first vertex of a group is the one that got a new index, welded indices never go forward
+		if (remap[i] != uniqueCount)
+			continue;
+		if (uniqueCount != i)
+			std::memcpy(bytes + uniqueCount * vertexSize, bytes + i * vertexSize, vertexSize);
+		uniqueCount++;
+	}
+	return uniqueCount;
+}
+
+size_t VertexWelder::RemoveDegenerateTriangles(uint32_t* indices, size_t indexCount) {
+	size_t writeIndex = 0;
+	for (size_t t = 0; t + 2 < indexCount; t += 3) {
+		uint32_t a = indices[t], b = indices[t + 1], c = indices[t + 2];
+		if (a == b || b == c || a == c)
+			continue;
+		indices[writeIndex++] = a;
+		indices[writeIndex++] = b;
+		indices[writeIndex++] = c;
+	}
+	return writeIndex;
+}
@@ -0,0 +1,86 @@
+#ifndef VERTEX_WELDER_H
+#define VERTEX_WELDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "../graphics/VertexLayout.h"
+#include "MeshOptimizer.h"
+
+
+struct WeldSettings {
+	// Largest difference per position component for two vertices to be merged, 0 only merges exact copies
+	float positionEpsilon = 1e-6f;
+	// Same for the other float attributes (normals, texture coordinates...). Non-float formats are already
+	// quantized and must match exactly.
+	float attributeEpsilon = 1e-5f;
+	// Drops the triangles that end up with two identical corners once welded
+	bool removeDegenerateTriangles = true;
+};
+
+struct WeldReport {
+	size_t vertexCountBefore = 0;
+	size_t vertexCountAfter = 0;
+	size_t degenerateTriangles = 0;  // Triangles dropped by removeDegenerateTriangles
+};
+
+// Merges the vertices that only differ by floating point noise, which importers produce when a mesh is
+// stored per face or exported unwelded.
+//
+// Vertices are looked up by their position, quantized on a grid of cells 8 epsilons wide, in a flat open
+// addressing hash table (8-byte slots holding the chain head and the cell hash, linear probing). A vertex
+// within epsilon of another is in the same cell, or in a neighbouring cell when it's less than epsilon away
+// from the border, so most vertices probe a single cell and none more than 2^3. Every cell chains the
+// vertices that share it but differ by another attribute (hard edges, UV seams), and candidates are
+// compared attribute by attribute with the VertexTraits description of the struct. The whole pass runs in expected linear time.
+//
+// Each vertex is merged into the first vertex found within tolerance, so the welded vertices keep the
+// attributes of the first vertex of their group and the merge isn't transitive: chains of vertices each
+// within epsilon of the next aren't collapsed into one.
+namespace VertexWelder {
+	// Fills `remap` (vertexCount entries) with the welded index of every vertex, in first occurrence order,
+	// so remap[i] <= i. The position is the POSITION attribute (the first attribute if there's none).
+	// Returns the number of unique vertices.
+	size_t GenerateWeldRemap(uint32_t* remap, const void* vertices, size_t vertexCount, size_t vertexSize,
+		const VertexAttribute* attributes, size_t attributeCount, const WeldSettings& settings = {});
+
+	// Moves the first vertex of every group to its welded index, in place. Returns the number of unique vertices.
+	size_t CompactVertexBuffer(void* vertices, size_t vertexCount, size_t vertexSize, const uint32_t* remap);
+
+	// Removes the triangles with two identical indices, in place. Returns the new index count.
+	size_t RemoveDegenerateTriangles(uint32_t* indices, size_t indexCount);
+
+	// Weld remap of any struct with a VertexTraits specialization
+	template <typename VertexType>
+	size_t GenerateWeldRemap(uint32_t* remap, const VertexType* vertices, size_t vertexCount, const WeldSettings& settings = {}) {
+		// Going through VertexLayout checks that the attributes cover every byte of the struct
+		return GenerateWeldRemap(remap, vertices, vertexCount, sizeof(VertexType), VertexTraits<VertexType>::attributes,
+			VertexLayout<VertexType>::AttributeCount, settings);
+	}
+
+	// Welds a mesh in place: compacts the vertices and remaps the indices
+	template <typename VertexType>
+	WeldReport WeldVertices(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices, const WeldSettings& settings = {}) {
+		WeldReport report;
+		report.vertexCountBefore = vertices.size();
+
+		std::vector<uint32_t> remap(vertices.size());
+		size_t uniqueVertices = GenerateWeldRemap(remap.data(), vertices.data(), vertices.size(), settings);
+		MeshOptimizer::RemapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+		CompactVertexBuffer(vertices.data(), vertices.size(), sizeof(VertexType), remap.data());
+		vertices.resize(uniqueVertices);
+
+		if (settings.removeDegenerateTriangles) {
+			size_t indexCount = RemoveDegenerateTriangles(indices.data(), indices.size());
+			report.degenerateTriangles = (indices.size() - indexCount) / 3;
+			indices.resize(indexCount);
+		}
+
+		report.vertexCountAfter = vertices.size();
+		return report;
+	}
+}
+
+#endif // !VERTEX_WELDER_H
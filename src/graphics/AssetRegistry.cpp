@@ -0,0 +1,312 @@
+#include "AssetRegistry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+#include "MemoryBudget.h"
+#include "../assets/ContentStore.h"
+#include "../assets/CookedTexture.h"
+#include "../utils/ConsoleLogger.h"
+#include "../utils/ThreadPool.h"
+
+
+using namespace Microsoft::WRL;
+
+namespace {
+    // Frames the GPU can be behind when the fences can't be created, the DXGI default latency
+    constexpr uint64_t MAX_FRAME_LATENCY = 3;
+
+    bool IsReady(const std::future<bool>& future) {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+}
+
+AssetRegistry::AssetRegistry(ThreadPool& threadPool, const AssetRegistrySettings& settings)
+    : m_threadPool(threadPool), m_settings(settings), m_textureLoader(threadPool) {
+}
+
+AssetRegistry::~AssetRegistry() {
+    // The workers read the mappings
+    for (CookedLoad& load : m_cookedLoads)
+        load.loaded.wait();
+
+    if (m_memoryBudget != nullptr) {
+        for (size_t index = 0; index < m_states.size(); ++index) {
+            if (m_refCounts[index] > 0 && m_states[index] == AssetState::Ready)
+                m_memoryBudget->TrackRelease(MemoryCategory::Textures, m_textureSizes[index]);
+        }
+        for (const RetiredTexture& retired : m_retiredTextures)
+            m_memoryBudget->TrackRelease(MemoryCategory::Textures, retired.size);
+    }
+}
+
+Hash128 AssetRegistry::GetKey(const std::string& filePath, bool sRGB) {
+    // Store files are named after their content, wherever the store is. The color space of a cooked file is its own.
+    Hash128 key;
+    if (std::filesystem::path(filePath).extension() == ".ptex" && ContentStore::GetKey(filePath, key))
+        return key;
+    return Hash::Murmur3(filePath.data(), filePath.size(), sRGB ? 1 : 0);
+}
+
+TextureHandle AssetRegistry::LoadTexture(const std::string& filePath, bool sRGB) {
+    // Data textures (normals, roughness...) are filtered as they are
+    MipSettings mipSettings;
+    mipSettings.sRGB = sRGB;
+    return LoadTexture(filePath, sRGB, mipSettings);
+}
+
+TextureHandle AssetRegistry::LoadTexture(const std::string& filePath, bool sRGB, const std::optional<MipSettings>& mipSettings) {
+    // "textures/./a.png" and "textures/a.png" are the same texture
+    const std::string normalizedPath = std::filesystem::path(filePath).lexically_normal().generic_string();
+    const Hash128 key = GetKey(normalizedPath, sRGB);
+    auto found = m_indicesByKey.find(key);
+    if (found != m_indicesByKey.end()) {
+        const uint32_t index = found->second;
+        ++m_refCounts[index];
+        return TextureHandle::Make(index, m_generations[index]);
+    }
+
+    uint32_t index;
+    if (!m_freeIndices.empty()) {
+        index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+    }
+    else {
+        if (m_generations.size() > TextureHandle::MAX_INDEX) {
+            ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to load ", filePath, ": the asset registry is full.");
+            return TextureHandle();
+        }
+        index = static_cast<uint32_t>(m_generations.size());
+        m_generations.push_back(1);
+        m_states.push_back(AssetState::Queued);
+        m_refCounts.push_back(0);
+        m_textures.emplace_back();
+        m_textureSizes.push_back(0);
+        m_requests.emplace_back();
+    }
+
+    m_refCounts[index] = 1;
+    m_states[index] = AssetState::Queued;
+    ++GetStateCount(AssetState::Queued);
+    ++m_stats.textureCount;
+    TextureRequest& request = m_requests[index];
+    request.filePath = normalizedPath;
+    request.sRGB = sRGB;
+    request.mipSettings = mipSettings;
+    request.key = key;
+    m_indicesByKey.emplace(key, index);
+
+    // The load starts right away if there's room, the decode can then overlap the startup
+    TextureHandle handle = TextureHandle::Make(index, m_generations[index]);
+    if (m_loadsInFlight < m_settings.maxLoadsInFlight)
+        StartLoad(handle);
+    else
+        m_queuedLoads.push_back(handle);
+    return handle;
+}
+
+void AssetRegistry::AddRef(TextureHandle handle) {
+    if (IsValid(handle))
+        ++m_refCounts[handle.GetIndex()];
+}
+
+void AssetRegistry::Release(TextureHandle handle) {
+    if (!IsValid(handle))
+        return;
+    const uint32_t index = handle.GetIndex();
+    if (--m_refCounts[index] > 0)
+        return;
+
+    // The frames already recorded may still sample it. A load in flight finds its handle stale and is dropped.
+    if (m_states[index] == AssetState::Ready) {
+        RetiredTexture retired;
+        retired.texture = m_textures[index];
+        retired.size = m_textureSizes[index];
+        retired.frame = m_frameIndex;
+        m_retiredTextures.push_back(retired);
+    }
+    m_textures[index] = Texture();
+    m_textureSizes[index] = 0;
+    m_indicesByKey.erase(m_requests[index].key);
+    m_requests[index] = TextureRequest();
+
+    --GetStateCount(m_states[index]);
+    --m_stats.textureCount;
+    m_generations[index] = TextureHandle::NextGeneration(m_generations[index]);
+    m_freeIndices.push_back(index);
+}
+
+void AssetRegistry::Update(ID3D11Device* device, ID3D11DeviceContext* context) {
+    UpdateFences(device, context);
+
+    // Destructions the GPU is done with
+    auto firstPending = std::partition(m_retiredTextures.begin(), m_retiredTextures.end(), [this](const RetiredTexture& retired) {
+        return retired.frame >= m_completedFrameCount;
+    });
+    if (m_memoryBudget != nullptr) {
+        for (auto retired = firstPending; retired != m_retiredTextures.end(); ++retired)
+            m_memoryBudget->TrackRelease(MemoryCategory::Textures, retired->size);
+    }
+    m_retiredTextures.erase(firstPending, m_retiredTextures.end());
+
+    // Uploads, cooked textures first, they cost no decode
+    uint32_t uploadCount = 0;
+    for (size_t i = 0; i < m_cookedLoads.size() && uploadCount < m_settings.maxUploadsPerUpdate;) {
+        CookedLoad& load = m_cookedLoads[i];
+        if (!IsReady(load.loaded)) {
+            ++i;
+            continue;
+        }
+        bool loaded = load.loaded.get();
+        Texture texture;
+        if (loaded && IsValid(load.handle)) {
+            loaded = texture.Initialize(device, *load.file);
+            ++uploadCount;
+        }
+        FinishLoad(load.handle, texture, loaded);
+        m_cookedLoads[i] = std::move(m_cookedLoads.back());
+        m_cookedLoads.pop_back();
+    }
+
+    m_textureLoader.PopDecoded(m_decodedImages);
+    size_t decodedCount = 0;
+    for (; decodedCount < m_decodedImages.size() && uploadCount < m_settings.maxUploadsPerUpdate; ++decodedCount) {
+        const DecodedImage& image = m_decodedImages[decodedCount];
+        const TextureHandle handle = TextureHandle::FromValue(image.id);
+        bool loaded = image.IsValid();
+        Texture texture;
+        if (loaded && IsValid(handle)) {
+            loaded = texture.Initialize(device, image, m_requests[handle.GetIndex()].sRGB);
+            ++uploadCount;
+        }
+        FinishLoad(handle, texture, loaded);
+    }
+    // The staging memory of the pixels goes back to the pool
+    m_decodedImages.erase(m_decodedImages.begin(), m_decodedImages.begin() + decodedCount);
+
+    while (!m_queuedLoads.empty() && m_loadsInFlight < m_settings.maxLoadsInFlight) {
+        StartLoad(m_queuedLoads.front());
+        m_queuedLoads.pop_front();
+    }
+    m_stats.pendingDestructions = m_retiredTextures.size();
+}
+
+void AssetRegistry::StartLoad(TextureHandle handle) {
+    // Released while it was queued
+    if (!IsValid(handle))
+        return;
+
+    const uint32_t index = handle.GetIndex();
+    const TextureRequest& request = m_requests[index];
+    SetState(index, AssetState::Loading);
+    ++m_loadsInFlight;
+    if (std::filesystem::path(request.filePath).extension() == ".ptex") {
+        CookedLoad load;
+        load.handle = handle;
+        load.file = std::make_unique<CookedTextureFile>();
+        CookedTextureFile* file = load.file.get();
+        std::string filePath = request.filePath;
+        load.loaded = m_threadPool.Submit([file, filePath]() {
+            if (!file->Load(filePath))
+                return false;
+            file->PageIn();
+            return true;
+        });
+        m_cookedLoads.push_back(std::move(load));
+    }
+    else {
+        m_textureLoader.Load(handle.GetValue(), request.filePath, request.mipSettings);
+    }
+}
+
+void AssetRegistry::FinishLoad(TextureHandle handle, const Texture& texture, bool loaded) {
+    --m_loadsInFlight;
+    // Released while it was loading, the texture is dropped before anything used it
+    if (!IsValid(handle))
+        return;
+
+    const uint32_t index = handle.GetIndex();
+    if (!loaded) {
+        SetState(index, AssetState::Failed);
+        return;
+    }
+    D3D11_TEXTURE2D_DESC desc;
+    texture.GetTexture()->GetDesc(&desc);
+    m_textures[index] = texture;
+    m_textureSizes[index] = MemoryBudget::GetTextureSize(desc);
+    if (m_memoryBudget != nullptr)
+        m_memoryBudget->TrackAllocation(MemoryCategory::Textures, m_textureSizes[index]);
+    SetState(index, AssetState::Ready);
+}
+
+void AssetRegistry::UpdateFences(ID3D11Device* device, ID3D11DeviceContext* context) {
+    // The fence of the frame submitted since the last update
+    ComPtr<ID3D11Query> query;
+    if (!m_freeQueries.empty()) {
+        query = std::move(m_freeQueries.back());
+        m_freeQueries.pop_back();
+    }
+    else {
+        D3D11_QUERY_DESC queryDesc = {};
+        queryDesc.Query = D3D11_QUERY_EVENT;
+        if (FAILED(device->CreateQuery(&queryDesc, &query)))
+            query.Reset();
+    }
+    if (query) {
+        context->End(query.Get());
+        m_frameFences.push_back({ query, m_frameIndex });
+    }
+    else if (m_frameIndex >= MAX_FRAME_LATENCY) {
+        m_completedFrameCount = std::max(m_completedFrameCount, m_frameIndex - MAX_FRAME_LATENCY + 1);
+    }
+    ++m_frameIndex;
+
+    // The fences end in order, stop at the first one still pending
+    while (!m_frameFences.empty()) {
+        BOOL done = FALSE;
+        FrameFence& fence = m_frameFences.front();
+        if (context->GetData(fence.query.Get(), &done, sizeof(done), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK || !done)
+            break;
+        m_completedFrameCount = fence.frame + 1;
+        m_freeQueries.push_back(std::move(fence.query));
+        m_frameFences.pop_front();
+    }
+}
+
+bool AssetRegistry::IsValid(TextureHandle handle) const {
+    const uint32_t index = handle.GetIndex();
+    return handle.IsValid() && index < m_generations.size() && m_generations[index] == handle.GetGeneration() && m_refCounts[index] > 0;
+}
+
+AssetState AssetRegistry::GetState(TextureHandle handle) const {
+    return IsValid(handle) ? m_states[handle.GetIndex()] : AssetState::Failed;
+}
+
+const Texture* AssetRegistry::GetTexture(TextureHandle handle) const {
+    return GetState(handle) == AssetState::Ready ? &m_textures[handle.GetIndex()] : nullptr;
+}
+
+ID3D11ShaderResourceView* AssetRegistry::GetShaderResourceView(TextureHandle handle) const {
+    const Texture* texture = GetTexture(handle);
+    return texture != nullptr ? texture->GetShaderResourceView() : nullptr;
+}
+
+void AssetRegistry::SetState(uint32_t index, AssetState state) {
+    --GetStateCount(m_states[index]);
+    ++GetStateCount(state);
+    m_states[index] = state;
+}
+
+size_t& AssetRegistry::GetStateCount(AssetState state) {
+    switch (state) {
+        case AssetState::Queued:
+            return m_stats.queued;
+        case AssetState::Loading:
+            return m_stats.loading;
+        case AssetState::Ready:
+            return m_stats.ready;
+        default:
+            return m_stats.failed;
+    }
+}
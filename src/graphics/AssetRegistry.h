@@ -0,0 +1,159 @@
+#ifndef ASSET_REGISTRY_H
+#define ASSET_REGISTRY_H
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Texture.h"
+#include "../assets/MipGenerator.h"
+#include "../assets/TextureLoader.h"
+#include "../utils/Handle.h"
+#include "../utils/Hash.h"
+
+class CookedTextureFile;
+class MemoryBudget;
+class ThreadPool;
+
+
+using TextureHandle = Handle<struct TextureHandleTag>;
+
+enum class AssetState {
+    Queued,   // Waiting for a free load slot
+    Loading,  // Decoding or paging in on a worker, or waiting for its upload
+    Ready,
+    Failed    // Already logged. Stale handles are reported as failed too.
+};
+
+struct AssetRegistrySettings {
+    // Loads on the workers at once, the decoded images of the others don't hold staging memory yet
+    uint32_t maxLoadsInFlight = 16;
+    // Textures created per Update, the rest wait for the next frames
+    uint32_t maxUploadsPerUpdate = 8;
+};
+
+struct AssetRegistryStats {
+    size_t textureCount = 0;
+    size_t queued = 0;
+    size_t loading = 0;
+    size_t ready = 0;
+    size_t failed = 0;
+    size_t pendingDestructions = 0;  // Released, waiting for the GPU to finish the frames that may use them
+};
+
+// Owns the textures of the engine behind 32-bit generational handles.
+//
+// LoadTexture returns at once: the texture is decoded by a TextureLoader (images) or mapped and paged in
+// (cooked .ptex files) on the workers, then created on the render thread by Update. Loading the same
+// texture twice returns the same handle with one more reference, each LoadTexture or AddRef is matched by a
+// Release. Files of the content store (see ContentStore.h) are the same texture whenever their key is, so a
+// cooked texture shared by several scenes is loaded and resident once; other files are the same texture
+// when their path is. The last Release frees the slot right away, its handles go stale, but the texture
+// itself is only destroyed once the GPU has finished every frame submitted before the release.
+//
+// Slots live in dense arrays indexed by the handle, lookups are an index and a generation check.
+class AssetRegistry {
+    public:
+        explicit AssetRegistry(ThreadPool& threadPool, const AssetRegistrySettings& settings = AssetRegistrySettings());
+        // Waits for the loads in flight, destroys everything without waiting for the GPU
+        ~AssetRegistry();
+
+        AssetRegistry(const AssetRegistry&) = delete;
+        AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+        // Queues the load of an image file or a cooked texture (.ptex, its format and color space come from
+        // the file and `sRGB` and `mipSettings` are ignored). The same content key, or the same path and
+        // color space, give the same handle. Images get the default full chain, filtered in the color space
+        // of the texture.
+        TextureHandle LoadTexture(const std::string& filePath, bool sRGB = true);
+        // Same with the mip settings of the chain used as given, or no mips if nullopt
+        TextureHandle LoadTexture(const std::string& filePath, bool sRGB, const std::optional<MipSettings>& mipSettings);
+        void AddRef(TextureHandle handle);
+        void Release(TextureHandle handle);
+
+        // Once per frame on the render thread: starts the queued loads, creates the textures whose load
+        // finished and destroys the released ones the GPU is done with
+        void Update(ID3D11Device* device, ID3D11DeviceContext* context);
+
+        bool IsValid(TextureHandle handle) const;
+        AssetState GetState(TextureHandle handle) const;
+        // Null unless the texture is ready
+        const Texture* GetTexture(TextureHandle handle) const;
+        ID3D11ShaderResourceView* GetShaderResourceView(TextureHandle handle) const;
+        const AssetRegistryStats& GetStats() const { return m_stats; }
+
+        // Tracks the textures as they're created and destroyed, set it before the first Update
+        void SetMemoryBudget(MemoryBudget* memoryBudget) { m_memoryBudget = memoryBudget; }
+
+    private:
+        struct TextureRequest {
+            std::string filePath;
+            bool sRGB = true;
+            std::optional<MipSettings> mipSettings;
+            Hash128 key;  // See GetKey
+        };
+
+        // A cooked file being mapped and paged in by a worker
+        struct CookedLoad {
+            TextureHandle handle;
+            std::unique_ptr<CookedTextureFile> file;
+            std::future<bool> loaded;
+        };
+
+        struct RetiredTexture {
+            Texture texture;
+            size_t size = 0;
+            uint64_t frame = 0;  // Last frame that can use it
+        };
+
+        struct FrameFence {
+            Microsoft::WRL::ComPtr<ID3D11Query> query;
+            uint64_t frame = 0;
+        };
+
+    private:
+        static Hash128 GetKey(const std::string& filePath, bool sRGB);
+        void StartLoad(TextureHandle handle);
+        void FinishLoad(TextureHandle handle, const Texture& texture, bool loaded);
+        void UpdateFences(ID3D11Device* device, ID3D11DeviceContext* context);
+        void SetState(uint32_t index, AssetState state);
+        size_t& GetStateCount(AssetState state);
+
+    private:
+        ThreadPool& m_threadPool;
+        AssetRegistrySettings m_settings;
+        AssetRegistryStats m_stats;
+        TextureLoader m_textureLoader;
+        MemoryBudget* m_memoryBudget = nullptr;
+
+        // Slots, indexed by TextureHandle::GetIndex
+        std::vector<uint32_t> m_generations;
+        std::vector<AssetState> m_states;
+        std::vector<uint32_t> m_refCounts;
+        std::vector<Texture> m_textures;
+        std::vector<size_t> m_textureSizes;
+        std::vector<TextureRequest> m_requests;
+        std::vector<uint32_t> m_freeIndices;
+        std::unordered_map<Hash128, uint32_t> m_indicesByKey;
+
+        std::deque<TextureHandle> m_queuedLoads;
+        std::vector<CookedLoad> m_cookedLoads;
+        std::vector<DecodedImage> m_decodedImages;  // Popped from the loader, waiting for an upload slot
+        size_t m_loadsInFlight = 0;
+
+        std::vector<RetiredTexture> m_retiredTextures;
+        std::deque<FrameFence> m_frameFences;
+        std::vector<Microsoft::WRL::ComPtr<ID3D11Query>> m_freeQueries;
+        uint64_t m_frameIndex = 0;
+        uint64_t m_completedFrameCount = 0;  // Frames before this index are done on the GPU
+};
+
+#endif // !ASSET_REGISTRY_H
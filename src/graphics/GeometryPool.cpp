@@ -0,0 +1,124 @@
+#include "GeometryPool.h"
+
+#include "MemoryBudget.h"
+#include "../utils/ConsoleLogger.h"
+
+
+using namespace Microsoft::WRL;
+
+GeometryPool::~GeometryPool() {
+    if (m_memoryBudget != nullptr)
+        m_memoryBudget->TrackRelease(MemoryCategory::Buffers, m_bufferSize);
+}
+
+bool GeometryPool::Initialize(ID3D11Device* device, UINT vertexCapacity, UINT indexCapacity, MemoryBudget* memoryBudget) {
+    // Index buffer sizes must be a multiple of 4 bytes
+    indexCapacity = (indexCapacity + 1) & ~1u;
+
+    // The buffers of a previous Initialize are released below
+    if (m_memoryBudget != nullptr)
+        m_memoryBudget->TrackRelease(MemoryCategory::Buffers, m_bufferSize);
+    m_memoryBudget = nullptr;
+    m_bufferSize = 0;
+
+    if (!CreateBuffer(device, vertexCapacity * PositionStreamLayout::Stride, D3D11_BIND_VERTEX_BUFFER, m_positionBuffer) ||
+        !CreateBuffer(device, vertexCapacity * AttributeStreamLayout::Stride, D3D11_BIND_VERTEX_BUFFER, m_attributeBuffer) ||
+        !CreateBuffer(device, indexCapacity * sizeof(uint16_t), D3D11_BIND_INDEX_BUFFER, m_indexBuffer)) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to create the buffers of a geometry pool.");
+        return false;
+    }
+
+    m_vertexCapacity = vertexCapacity;
+    m_indexCapacity = indexCapacity;
+    m_memoryBudget = memoryBudget;
+    m_bufferSize = size_t(vertexCapacity) * (PositionStreamLayout::Stride + AttributeStreamLayout::Stride) + size_t(indexCapacity) * sizeof(uint16_t);
+    if (m_memoryBudget != nullptr)
+        m_memoryBudget->TrackAllocation(MemoryCategory::Buffers, m_bufferSize);
+    Reset();
+    return true;
+}
+
+bool GeometryPool::CreateBuffer(ID3D11Device* device, UINT byteWidth, UINT bindFlags, ComPtr<ID3D11Buffer>& buffer) {
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    bufferDesc.ByteWidth = byteWidth;
+    bufferDesc.BindFlags = bindFlags;
+
+    return SUCCEEDED(device->CreateBuffer(&bufferDesc, nullptr, &buffer));
+}
+
+bool GeometryPool::Allocate(ID3D11DeviceContext* context, const SimpleVertexData* positions, const CompleteAttributeData* attributes,
+    UINT vertexCount, const uint16_t* indices, UINT indexCount, GeometryAllocation& allocation) {
+    if (vertexCount > MAX_VERTICES_PER_ALLOCATION) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Geometry pool allocations can't have more than ",
+            MAX_VERTICES_PER_ALLOCATION, " vertices, got ", vertexCount, ".");
+        return false;
+    }
+    // Every index range starts 4 byte aligned, like the buffer itself
+    UINT alignedIndexCount = (indexCount + 1) & ~1u;
+    if (m_vertexCount + vertexCount > m_vertexCapacity || m_indexCount + alignedIndexCount > m_indexCapacity) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Geometry pool is full: ", m_vertexCount, "/", m_vertexCapacity,
+            " vertices and ", m_indexCount, "/", m_indexCapacity, " indices used, ", vertexCount, " vertices and ",
+            indexCount, " indices requested.");
+        return false;
+    }
+
+    allocation.baseVertex = m_vertexCount;
+    allocation.firstIndex = m_indexCount;
+    allocation.vertexCount = vertexCount;
+    allocation.indexCount = indexCount;
+
+    UpdateRange(context, m_positionBuffer.Get(), m_vertexCount * PositionStreamLayout::Stride, positions,
+        vertexCount * PositionStreamLayout::Stride);
+    UpdateRange(context, m_attributeBuffer.Get(), m_vertexCount * AttributeStreamLayout::Stride, attributes,
+        vertexCount * AttributeStreamLayout::Stride);
+    UpdateRange(context, m_indexBuffer.Get(), m_indexCount * sizeof(uint16_t), indices, indexCount * sizeof(uint16_t));
+
+    m_vertexCount += vertexCount;
+    m_indexCount += alignedIndexCount;
+    return true;
+}
+
+void GeometryPool::UpdateRange(ID3D11DeviceContext* context, ID3D11Buffer* buffer, UINT byteOffset, const void* data, UINT byteWidth) {
+    if (byteWidth == 0)
+        return;
+
+    D3D11_BOX box = {};
+    box.left = byteOffset;
+    box.right = byteOffset + byteWidth;
+    box.top = 0;
+    box.bottom = 1;
+    box.front = 0;
+    box.back = 1;
+    context->UpdateSubresource(buffer, 0, &box, data, 0, 0);
+}
+
+void GeometryPool::Reset() {
+    m_vertexCount = 0;
+    m_indexCount = 0;
+}
+
+void GeometryPool::Bind(ID3D11DeviceContext* context, MeshPass pass) {
+    if (m_isBound && m_boundPass == pass)
+        return;
+
+    ID3D11Buffer* buffers[] = { m_positionBuffer.Get(), m_attributeBuffer.Get() };
+    UINT offsets[] = { 0, 0 };
+
+    if (pass == MeshPass::DepthOnly) {
+        context->IASetVertexBuffers(0, DepthOnlyLayout::StreamCount, buffers, DepthOnlyLayout::Strides.data(), offsets);
+    }
+    else {
+        context->IASetVertexBuffers(0, FullLayout::StreamCount, buffers, FullLayout::Strides.data(), offsets);
+    }
+
+    context->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    m_isBound = true;
+    m_boundPass = pass;
+}
+
+void GeometryPool::InvalidateBoundState() {
+    m_isBound = false;
+}
@@ -0,0 +1,90 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <cstdint>
+
+#include "VertexFormat.h"
+#include "VertexLayout.h"
+
+class MemoryBudget;
+
+
+// Render passes geometry can be drawn in, each one binds only the vertex streams it reads
+enum class MeshPass {
+    DepthOnly,  // Depth prepass and shadow maps, position stream only
+    Full        // Every attribute, position and attribute streams
+};
+
+// Where an allocation lives in the pool buffers, passed to DrawIndexed as is
+struct GeometryAllocation {
+    UINT baseVertex = 0;
+    UINT firstIndex = 0;
+    UINT vertexCount = 0;
+    UINT indexCount = 0;
+};
+
+// Shared vertex and index buffers for many meshes.
+//
+// Every mesh allocates a range of the position stream, the attribute stream and the 16-bit index
+// buffer, its indices are relative to its base vertex. The buffers are bound once and any number of
+// meshes are drawn with DrawIndexed(count, firstIndex, baseVertex) without rebinding anything.
+// Allocations are linear, the whole pool is released at once with Reset.
+class GeometryPool {
+    public:
+        // Input layouts per pass, shaders of each pass are initialized with them:
+        //     depthShader.InitializeWithLayout<GeometryPool::DepthOnlyLayout>(device, desc, cache);
+        using PositionStreamLayout = VertexLayout<SimpleVertexData, 0>;
+        using AttributeStreamLayout = VertexLayout<CompleteAttributeData, 1>;
+        using DepthOnlyLayout = VertexStreamLayout<PositionStreamLayout>;
+        using FullLayout = VertexStreamLayout<PositionStreamLayout, AttributeStreamLayout>;
+
+        // A base vertex plus a 16-bit index can reach this many vertices
+        static constexpr UINT MAX_VERTICES_PER_ALLOCATION = 65536;
+
+        GeometryPool() = default;
+        ~GeometryPool();
+
+        // Creates the buffers, tracked as buffers by the memory budget if there's one
+        bool Initialize(ID3D11Device* device, UINT vertexCapacity, UINT indexCapacity, MemoryBudget* memoryBudget = nullptr);
+
+        // Copies the geometry into the pool buffers. Fails if the pool is full or if there are
+        // more than MAX_VERTICES_PER_ALLOCATION vertices (see MeshSplitter to split bigger meshes).
+        bool Allocate(ID3D11DeviceContext* context, const SimpleVertexData* positions, const CompleteAttributeData* attributes,
+            UINT vertexCount, const uint16_t* indices, UINT indexCount, GeometryAllocation& allocation);
+        // Drops every allocation, the buffers are kept
+        void Reset();
+
+        // Binds the vertex streams of the pass, the index buffer and the topology, unless they're already bound
+        void Bind(ID3D11DeviceContext* context, MeshPass pass);
+        // Forgets the bound state, call it whenever something else could have changed the IA state
+        void InvalidateBoundState();
+
+        UINT GetVertexCount() const { return m_vertexCount; }
+        UINT GetIndexCount() const { return m_indexCount; }
+        UINT GetVertexCapacity() const { return m_vertexCapacity; }
+        UINT GetIndexCapacity() const { return m_indexCapacity; }
+
+    private:
+        bool CreateBuffer(ID3D11Device* device, UINT byteWidth, UINT bindFlags, Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer);
+        void UpdateRange(ID3D11DeviceContext* context, ID3D11Buffer* buffer, UINT byteOffset, const void* data, UINT byteWidth);
+
+    private:
+        Microsoft::WRL::ComPtr<ID3D11Buffer> m_positionBuffer;
+        Microsoft::WRL::ComPtr<ID3D11Buffer> m_attributeBuffer;
+        Microsoft::WRL::ComPtr<ID3D11Buffer> m_indexBuffer;
+
+        UINT m_vertexCapacity = 0;
+        UINT m_indexCapacity = 0;
+        UINT m_vertexCount = 0;
+        UINT m_indexCount = 0;
+
+        bool m_isBound = false;
+        MeshPass m_boundPass = MeshPass::Full;
+
+        MemoryBudget* m_memoryBudget = nullptr;
+        size_t m_bufferSize = 0;
+};
+
+#endif // !GEOMETRY_POOL_H
@@ -0,0 +1,67 @@
+#include "InputLayoutCache.h"
+
+#include <d3dcompiler.h>
+
+#include "../utils/ConsoleLogger.h"
+#include "../utils/Hash.h"
+
+
+using namespace Microsoft::WRL;
+
+ID3D11InputLayout* InputLayoutCache::Acquire(ID3D11Device* device, const D3D11_INPUT_ELEMENT_DESC* elements, UINT numElements,
+    const void* vertexShaderBytecode, size_t bytecodeSize) {
+    return Acquire(device, elements, numElements, HashElements(elements, numElements), vertexShaderBytecode, bytecodeSize);
+}
+
+ID3D11InputLayout* InputLayoutCache::Acquire(ID3D11Device* device, const D3D11_INPUT_ELEMENT_DESC* elements, UINT numElements,
+    uint64_t elementsHash, const void* vertexShaderBytecode, size_t bytecodeSize) {
+    const uint64_t key = Hash::Combine(elementsHash, HashInputSignature(vertexShaderBytecode, bytecodeSize));
+
+    auto it = m_layouts.find(key);
+    if (it != m_layouts.end()) {
+        return it->second.Get();
+    }
+
+    ComPtr<ID3D11InputLayout> inputLayout;
+    HRESULT result = device->CreateInputLayout(elements, numElements, vertexShaderBytecode, bytecodeSize, &inputLayout);
+    if (FAILED(result)) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to create input layout.");
+        return nullptr;
+    }
+
+    m_layouts[key] = inputLayout;
+    ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Created input layout, ", m_layouts.size(), " unique layouts cached.");
+    return inputLayout.Get();
+}
+
+void InputLayoutCache::Bind(ID3D11DeviceContext* context, ID3D11InputLayout* inputLayout) {
+    if (inputLayout == m_boundLayout && m_externalBindCount == s_externalBindCount)
+        return;
+
+    context->IASetInputLayout(inputLayout);
+    m_boundLayout = inputLayout;
+    m_externalBindCount = s_externalBindCount;
+}
+
+void InputLayoutCache::BindExternal(ID3D11DeviceContext* context, ID3D11InputLayout* inputLayout) {
+    context->IASetInputLayout(inputLayout);
+    ++s_externalBindCount;
+}
+
+void InputLayoutCache::InvalidateBoundState() {
+    m_boundLayout = nullptr;
+}
+
+void InputLayoutCache::Clear() {
+    m_layouts.clear();
+    m_boundLayout = nullptr;
+}
+
+uint64_t InputLayoutCache::HashInputSignature(const void* vertexShaderBytecode, size_t bytecodeSize) {
+    // Only the input signature matters for layout compatibility, not the rest of the shader
+    ComPtr<ID3DBlob> signature;
+    if (FAILED(D3DGetInputSignatureBlob(vertexShaderBytecode, bytecodeSize, &signature))) {
+        return Hash::FNV1a(vertexShaderBytecode, bytecodeSize);
+    }
+    return Hash::FNV1a(signature->GetBufferPointer(), signature->GetBufferSize());
+}
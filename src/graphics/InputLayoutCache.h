@@ -0,0 +1,71 @@
+#ifndef INPUT_LAYOUT_CACHE_H
+#define INPUT_LAYOUT_CACHE_H
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <unordered_map>
+#include <cstdint>
+
+#include "../utils/Hash.h"
+
+
+// Shares ID3D11InputLayout objects between shaders.
+//
+// A layout only depends on the input element descriptions and on the input signature of the
+// vertex shader, so both are hashed into the key: every shader using the same vertex format
+// with a compatible vertex shader input gets the same object. It also remembers the last bound
+// layout so consecutive draws with the same layout skip the IASetInputLayout call.
+class InputLayoutCache {
+    public:
+        InputLayoutCache() = default;
+        ~InputLayoutCache() = default;
+
+        // Returns the shared input layout for the element descriptions and vertex shader bytecode,
+        // creating it the first time the combination is seen. Returns nullptr on failure.
+        ID3D11InputLayout* Acquire(ID3D11Device* device, const D3D11_INPUT_ELEMENT_DESC* elements, UINT numElements,
+            const void* vertexShaderBytecode, size_t bytecodeSize);
+        // Same as above but with the element hash already known (e.g. computed at compile time)
+        ID3D11InputLayout* Acquire(ID3D11Device* device, const D3D11_INPUT_ELEMENT_DESC* elements, UINT numElements,
+            uint64_t elementsHash, const void* vertexShaderBytecode, size_t bytecodeSize);
+
+        // Binds the layout unless it's already the one bound through this cache
+        void Bind(ID3D11DeviceContext* context, ID3D11InputLayout* inputLayout);
+        // Forgets the bound layout, call it whenever something else could have changed the IA state
+        void InvalidateBoundState();
+        // Binds a layout that isn't owned by a cache (shaders created without one). Every cache forgets its
+        // bound layout, so its next Bind isn't skipped.
+        static void BindExternal(ID3D11DeviceContext* context, ID3D11InputLayout* inputLayout);
+
+        // Releases every cached layout
+        void Clear();
+
+        size_t GetLayoutCount() const { return m_layouts.size(); }
+
+        // Hash of the element descriptions, the semantic names are hashed by content.
+        // It's constexpr so layouts generated from VertexLayout get their key at compile time.
+        static constexpr uint64_t HashElements(const D3D11_INPUT_ELEMENT_DESC* elements, UINT numElements) {
+            uint64_t hash = Hash::FNV1A_OFFSET_BASIS;
+            for (UINT i = 0; i < numElements; ++i) {
+                const D3D11_INPUT_ELEMENT_DESC& element = elements[i];
+                hash = Hash::FNV1aString(element.SemanticName, hash);
+                hash = Hash::FNV1aValue(element.SemanticIndex, sizeof(UINT), hash);
+                hash = Hash::FNV1aValue(static_cast<UINT>(element.Format), sizeof(UINT), hash);
+                hash = Hash::FNV1aValue(element.InputSlot, sizeof(UINT), hash);
+                hash = Hash::FNV1aValue(element.AlignedByteOffset, sizeof(UINT), hash);
+                hash = Hash::FNV1aValue(static_cast<UINT>(element.InputSlotClass), sizeof(UINT), hash);
+                hash = Hash::FNV1aValue(element.InstanceDataStepRate, sizeof(UINT), hash);
+            }
+            return hash;
+        }
+        // Hash of the input signature embedded in the vertex shader bytecode
+        static uint64_t HashInputSignature(const void* vertexShaderBytecode, size_t bytecodeSize);
+
+    private:
+        std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D11InputLayout>> m_layouts;
+        ID3D11InputLayout* m_boundLayout = nullptr;
+        // BindExternal calls seen when m_boundLayout was bound, it's stale once the global count moves on
+        uint64_t m_externalBindCount = 0;
+        static inline uint64_t s_externalBindCount = 0;
+};
+
+#endif // !INPUT_LAYOUT_CACHE_H
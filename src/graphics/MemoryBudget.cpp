@@ -0,0 +1,261 @@
+#include "MemoryBudget.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "../assets/MipGenerator.h"
+#include "../utils/ConsoleLogger.h"
+
+
+namespace {
+    // Bytes per 4x4 block of the block compressed formats, 0 for the others
+    uint32_t GetBlockSize(DXGI_FORMAT format) {
+        switch (format) {
+            case DXGI_FORMAT_BC1_TYPELESS: case DXGI_FORMAT_BC1_UNORM: case DXGI_FORMAT_BC1_UNORM_SRGB:
+            case DXGI_FORMAT_BC4_TYPELESS: case DXGI_FORMAT_BC4_UNORM: case DXGI_FORMAT_BC4_SNORM:
+                return 8;
+            case DXGI_FORMAT_BC2_TYPELESS: case DXGI_FORMAT_BC2_UNORM: case DXGI_FORMAT_BC2_UNORM_SRGB:
+            case DXGI_FORMAT_BC3_TYPELESS: case DXGI_FORMAT_BC3_UNORM: case DXGI_FORMAT_BC3_UNORM_SRGB:
+            case DXGI_FORMAT_BC5_TYPELESS: case DXGI_FORMAT_BC5_UNORM: case DXGI_FORMAT_BC5_SNORM:
+            case DXGI_FORMAT_BC6H_TYPELESS: case DXGI_FORMAT_BC6H_UF16: case DXGI_FORMAT_BC6H_SF16:
+            case DXGI_FORMAT_BC7_TYPELESS: case DXGI_FORMAT_BC7_UNORM: case DXGI_FORMAT_BC7_UNORM_SRGB:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    // Bytes per texel of the formats the engine creates, 4 for the ones it doesn't
+    uint32_t GetTexelSize(DXGI_FORMAT format) {
+        switch (format) {
+            case DXGI_FORMAT_R32G32B32A32_TYPELESS: case DXGI_FORMAT_R32G32B32A32_FLOAT: case DXGI_FORMAT_R32G32B32A32_UINT:
+            case DXGI_FORMAT_R32G32B32A32_SINT:
+                return 16;
+            case DXGI_FORMAT_R32G32B32_TYPELESS: case DXGI_FORMAT_R32G32B32_FLOAT: case DXGI_FORMAT_R32G32B32_UINT:
+            case DXGI_FORMAT_R32G32B32_SINT:
+                return 12;
+            case DXGI_FORMAT_R16G16B16A16_TYPELESS: case DXGI_FORMAT_R16G16B16A16_FLOAT: case DXGI_FORMAT_R16G16B16A16_UNORM:
+            case DXGI_FORMAT_R16G16B16A16_UINT: case DXGI_FORMAT_R16G16B16A16_SNORM: case DXGI_FORMAT_R16G16B16A16_SINT:
+            case DXGI_FORMAT_R32G32_TYPELESS: case DXGI_FORMAT_R32G32_FLOAT: case DXGI_FORMAT_R32G32_UINT: case DXGI_FORMAT_R32G32_SINT:
+            case DXGI_FORMAT_R32G8X24_TYPELESS: case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+                return 8;
+            case DXGI_FORMAT_R8G8_TYPELESS: case DXGI_FORMAT_R8G8_UNORM: case DXGI_FORMAT_R8G8_UINT: case DXGI_FORMAT_R8G8_SNORM:
+            case DXGI_FORMAT_R8G8_SINT: case DXGI_FORMAT_R16_TYPELESS: case DXGI_FORMAT_R16_FLOAT: case DXGI_FORMAT_D16_UNORM:
+            case DXGI_FORMAT_R16_UNORM: case DXGI_FORMAT_R16_UINT: case DXGI_FORMAT_R16_SNORM: case DXGI_FORMAT_R16_SINT:
+            case DXGI_FORMAT_B5G6R5_UNORM: case DXGI_FORMAT_B5G5R5A1_UNORM:
+                return 2;
+            case DXGI_FORMAT_R8_TYPELESS: case DXGI_FORMAT_R8_UNORM: case DXGI_FORMAT_R8_UINT: case DXGI_FORMAT_R8_SNORM:
+            case DXGI_FORMAT_R8_SINT: case DXGI_FORMAT_A8_UNORM:
+                return 1;
+            default:
+                return 4;
+        }
+    }
+}
+
+bool DxgiMemoryBudgetSource::Query(uint64_t, MemoryBudgetInfo& info) {
+    DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+    HRESULT result = m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo);
+    if (FAILED(result)) {
+        // Polled every few frames, once is enough
+        if (!m_failureLogged)
+            ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "Failed to query the video memory budget, error ", static_cast<uint32_t>(result), ".");
+        m_failureLogged = true;
+        return false;
+    }
+    info.budget = memoryInfo.Budget;
+    info.currentUsage = memoryInfo.CurrentUsage;
+    return true;
+}
+
+bool FixedMemoryBudgetSource::Query(uint64_t trackedUsage, MemoryBudgetInfo& info) {
+    info.budget = m_budget;
+    info.currentUsage = trackedUsage + m_untrackedUsage;
+    return true;
+}
+
+MemoryBudget::MemoryBudget(MemoryBudgetSource* source, const MemoryBudgetSettings& settings)
+    : m_source(source), m_settings(settings) {
+}
+
+void MemoryBudget::SetSource(MemoryBudgetSource* source) {
+    m_source = source;
+    m_pollNeeded = true;
+}
+
+void MemoryBudget::TrackAllocation(MemoryCategory category, size_t bytes) {
+    m_trackedUsage[static_cast<size_t>(category)].fetch_add(bytes, std::memory_order_relaxed);
+    m_totalTrackedUsage.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void MemoryBudget::TrackRelease(MemoryCategory category, size_t bytes) {
+    m_trackedUsage[static_cast<size_t>(category)].fetch_sub(bytes, std::memory_order_relaxed);
+    m_totalTrackedUsage.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+uint64_t MemoryBudget::GetEstimatedUsage() const {
+    // What was released since the poll can't take the estimate under what the OS doesn't know about
+    const uint64_t trackedUsage = GetTrackedUsage();
+    if (trackedUsage >= m_trackedUsageAtPoll)
+        return m_polledInfo.currentUsage + (trackedUsage - m_trackedUsageAtPoll);
+    return m_polledInfo.currentUsage - std::min(m_polledInfo.currentUsage, m_trackedUsageAtPoll - trackedUsage);
+}
+
+void MemoryBudget::Update() {
+    if (m_source == nullptr)
+        return;
+    ++m_updatesSincePoll;
+    if (m_pollNeeded || m_updatesSincePoll >= m_settings.pollUpdateCount)
+        Poll();
+    if (m_polledInfo.budget == 0)
+        return;
+
+    const double budget = static_cast<double>(m_polledInfo.budget);
+    const uint64_t usage = GetEstimatedUsage();
+    if (usage > budget * m_settings.evictionThreshold) {
+        m_relieved = false;
+        m_updatesUnderRestore = 0;
+
+        // Callbacks with deferred releases report what they freed before the tracking catches up
+        const uint64_t target = static_cast<uint64_t>(budget * m_settings.evictionTarget);
+        const uint64_t needed = usage - std::min(usage, target);
+        uint64_t freed = 0;
+        for (EvictionCallback& callback : m_evictionCallbacks) {
+            if (freed >= needed)
+                break;
+            freed += callback(static_cast<size_t>(needed - freed));
+        }
+
+        // The quality changes take a few frames to show in the usage, one step per poll at most
+        if (freed < needed && usage - freed > budget * m_settings.evictionThreshold && m_updatesSinceQualityChange >= m_settings.pollUpdateCount &&
+            m_qualityLevel < m_settings.maxQualityLevel) {
+            SetQualityLevel(m_qualityLevel + 1);
+        }
+    }
+    else if (usage < budget * m_settings.restoreThreshold) {
+        if (++m_updatesUnderRestore >= m_settings.restoreUpdateCount) {
+            m_updatesUnderRestore = 0;
+            if (m_qualityLevel > 0 || !m_relieved)
+                SetQualityLevel(m_qualityLevel > 0 ? m_qualityLevel - 1 : 0);
+        }
+    }
+    else {
+        m_updatesUnderRestore = 0;
+    }
+    ++m_updatesSinceQualityChange;
+}
+
+void MemoryBudget::Poll() {
+    m_pollNeeded = false;
+    m_updatesSincePoll = 0;
+    const uint64_t trackedUsage = GetTrackedUsage();
+    MemoryBudgetInfo info;
+    if (m_source->Query(trackedUsage, info)) {
+        m_polledInfo = info;
+        m_trackedUsageAtPoll = trackedUsage;
+    }
+}
+
+void MemoryBudget::SetQualityLevel(uint32_t qualityLevel) {
+    if (qualityLevel > m_qualityLevel)
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "GPU memory usage is over the budget (", GetEstimatedUsage() >> 20, "/",
+            m_polledInfo.budget >> 20, " MB), lowering the quality to level ", qualityLevel, ".");
+    m_qualityLevel = qualityLevel;
+    m_updatesSinceQualityChange = 0;
+    if (qualityLevel == 0)
+        m_relieved = true;
+    for (QualityCallback& callback : m_qualityCallbacks)
+        callback(qualityLevel);
+}
+
+size_t MemoryBudget::GetTextureSize(const D3D11_TEXTURE2D_DESC& desc) {
+    const uint32_t blockSize = GetBlockSize(desc.Format);
+    const uint32_t texelSize = GetTexelSize(desc.Format);
+    // MipLevels 0 asks D3D11 for the full chain
+    const uint32_t levelCount = desc.MipLevels > 0 ? desc.MipLevels : MipGenerator::GetFullLevelCount(desc.Width, desc.Height);
+    size_t size = 0;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const size_t width = std::max<size_t>(desc.Width >> level, 1);
+        const size_t height = std::max<size_t>(desc.Height >> level, 1);
+        size += blockSize > 0 ? ((width + 3) / 4) * ((height + 3) / 4) * blockSize : width * height * texelSize;
+    }
+    return size * desc.ArraySize * std::max<UINT>(desc.SampleDesc.Count, 1);
+}
+
+bool MemoryBudget::SelfCheck() {
+    bool passed = true;
+    auto check = [&passed](bool condition, const char* what) {
+        if (!condition) {
+            ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Memory budget self-check failed: ", what, ".");
+            passed = false;
+        }
+    };
+
+    // Tracking, polled once then estimated from the tracked changes
+    {
+        FixedMemoryBudgetSource source(1000, 20);
+        MemoryBudget budget(&source);
+        budget.TrackAllocation(MemoryCategory::Textures, 100);
+        budget.TrackAllocation(MemoryCategory::Buffers, 50);
+        budget.TrackAllocation(MemoryCategory::RenderTargets, 25);
+        budget.TrackRelease(MemoryCategory::Textures, 40);
+        check(budget.GetTrackedUsage(MemoryCategory::Textures) == 60 && budget.GetTrackedUsage(MemoryCategory::Buffers) == 50 &&
+            budget.GetTrackedUsage(MemoryCategory::RenderTargets) == 25 && budget.GetTrackedUsage() == 135, "tracked usage per category");
+        budget.Update();
+        check(budget.GetBudget() == 1000 && budget.GetEstimatedUsage() == 155, "usage polled from the source");
+        budget.TrackAllocation(MemoryCategory::Buffers, 10);
+        check(budget.GetEstimatedUsage() == 165, "usage estimated between polls");
+        budget.TrackRelease(MemoryCategory::Textures, 60);
+        budget.TrackRelease(MemoryCategory::Buffers, 60);
+        budget.TrackRelease(MemoryCategory::RenderTargets, 25);
+        check(budget.GetTrackedUsage() == 0 && budget.GetEstimatedUsage() == 20, "usage after every release");
+    }
+
+    // Thresholds, on a budget of 1000 bytes polled every update: eviction over 900, down to 800, restore
+    // under 700
+    MemoryBudgetSettings settings;
+    settings.pollUpdateCount = 1;
+    settings.restoreUpdateCount = 3;
+    settings.maxQualityLevel = 2;
+    FixedMemoryBudgetSource source(1000);
+    MemoryBudget budget(&source, settings);
+    size_t evictableBytes = 0;
+    std::vector<size_t> evictionRequests;
+    std::vector<uint32_t> qualityLevels;
+    budget.AddEvictionCallback([&](size_t bytes) {
+        evictionRequests.push_back(bytes);
+        const size_t freed = std::min(bytes, evictableBytes);
+        evictableBytes -= freed;
+        budget.TrackRelease(MemoryCategory::Textures, freed);
+        return freed;
+    });
+    budget.AddQualityCallback([&](uint32_t qualityLevel) { qualityLevels.push_back(qualityLevel); });
+
+    budget.TrackAllocation(MemoryCategory::Textures, 890);
+    budget.Update();
+    check(evictionRequests.empty() && qualityLevels.empty(), "nothing should happen under the eviction threshold");
+
+    evictableBytes = 500;
+    budget.TrackAllocation(MemoryCategory::Textures, 60);
+    budget.Update();
+    check(evictionRequests == std::vector<size_t>{ 150 } && budget.GetTrackedUsage() == 800 && qualityLevels.empty(),
+        "eviction should free down to the target without touching the quality");
+
+    // Nothing left to evict: one quality step per poll, up to the maximum
+    evictableBytes = 0;
+    budget.TrackAllocation(MemoryCategory::Textures, 200);
+    for (int i = 0; i < 4; ++i)
+        budget.Update();
+    check(qualityLevels == std::vector<uint32_t>{ 1, 2 } && budget.GetQualityLevel() == 2, "quality should go up one step per poll, up to the maximum");
+
+    // Under the restore threshold, one step back every restoreUpdateCount updates, then nothing more
+    qualityLevels.clear();
+    budget.TrackRelease(MemoryCategory::Textures, 400);
+    for (int i = 0; i < 9; ++i)
+        budget.Update();
+    check(qualityLevels == std::vector<uint32_t>{ 1, 0 } && budget.GetQualityLevel() == 0, "quality should come back one step at a time under the restore threshold");
+
+    if (passed)
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Memory budget self-check passed.");
+    return passed;
+}
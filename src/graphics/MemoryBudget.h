@@ -0,0 +1,146 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <d3d11.h>
+#include <dxgi1_4.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+// What GPU memory is used for, tracked separately
+enum class MemoryCategory {
+    Textures,
+    Buffers,
+    RenderTargets,
+    Count
+};
+
+// GPU memory the OS lets the process use, and how much of it the process uses, drivers allocations included
+struct MemoryBudgetInfo {
+    uint64_t budget = 0;
+    uint64_t currentUsage = 0;
+};
+
+// Where MemoryBudget reads the OS budget from, replaced by a FixedMemoryBudgetSource to simulate memory pressure
+class MemoryBudgetSource {
+    public:
+        virtual ~MemoryBudgetSource() = default;
+        // `trackedUsage` is what MemoryBudget has tracked so far. Returns false if the budget can't be read,
+        // the last one is kept.
+        virtual bool Query(uint64_t trackedUsage, MemoryBudgetInfo& info) = 0;
+};
+
+// Local segment of a DXGI 1.4 adapter, the budget changes with the other processes and the window state
+class DxgiMemoryBudgetSource : public MemoryBudgetSource {
+    public:
+        explicit DxgiMemoryBudgetSource(IDXGIAdapter3* adapter) : m_adapter(adapter) {}
+        bool Query(uint64_t trackedUsage, MemoryBudgetInfo& info) override;
+
+    private:
+        IDXGIAdapter3* m_adapter;
+        bool m_failureLogged = false;
+};
+
+// A budget set by hand. The usage is whatever has been tracked plus `untrackedUsage`.
+class FixedMemoryBudgetSource : public MemoryBudgetSource {
+    public:
+        FixedMemoryBudgetSource(uint64_t budget, uint64_t untrackedUsage = 0) : m_budget(budget), m_untrackedUsage(untrackedUsage) {}
+        bool Query(uint64_t trackedUsage, MemoryBudgetInfo& info) override;
+
+        void SetBudget(uint64_t budget) { m_budget = budget; }
+        void SetUntrackedUsage(uint64_t untrackedUsage) { m_untrackedUsage = untrackedUsage; }
+        uint64_t GetBudget() const { return m_budget; }
+
+    private:
+        uint64_t m_budget;
+        uint64_t m_untrackedUsage;
+};
+
+struct MemoryBudgetSettings {
+    // Updates between two queries of the source, the query costs a kernel call
+    uint32_t pollUpdateCount = 30;
+    // Fractions of the budget. Over `evictionThreshold` the eviction callbacks free memory down to
+    // `evictionTarget`, if they can't the quality level goes up. Once the usage stays under `restoreThreshold`
+    // for `restoreUpdateCount` updates, the quality level goes back down one step.
+    float evictionThreshold = 0.90f;
+    float evictionTarget = 0.80f;
+    float restoreThreshold = 0.70f;
+    uint32_t restoreUpdateCount = 300;
+    uint32_t maxQualityLevel = 4;
+};
+
+// Tracks the GPU memory of the engine by category against the OS budget.
+//
+// Allocations are reported with TrackAllocation/TrackRelease from any thread. Once per frame, Update
+// polls the source every few updates and estimates the usage in between from the tracked changes since the
+// last poll. When the usage gets near the budget it asks the eviction callbacks, in the order they were
+// added, to free memory. When eviction isn't enough the quality level goes up (0 is full quality) and the
+// quality callbacks reduce what the engine asks for: smaller mips, fewer shadow cascades...
+class MemoryBudget {
+    public:
+        // Frees up to `bytes` and returns how much was freed, the freed memory must be released with TrackRelease
+        using EvictionCallback = std::function<size_t(size_t bytes)>;
+        // Called with the new quality level, and with level 0 once the usage is back under the restore threshold
+        // after an eviction, so whatever was given up can be asked for again
+        using QualityCallback = std::function<void(uint32_t qualityLevel)>;
+
+        explicit MemoryBudget(MemoryBudgetSource* source, const MemoryBudgetSettings& settings = MemoryBudgetSettings());
+
+        MemoryBudget(const MemoryBudget&) = delete;
+        MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+        // Changes the source and polls it on the next Update
+        void SetSource(MemoryBudgetSource* source);
+
+        void TrackAllocation(MemoryCategory category, size_t bytes);
+        void TrackRelease(MemoryCategory category, size_t bytes);
+
+        void AddEvictionCallback(EvictionCallback callback) { m_evictionCallbacks.push_back(std::move(callback)); }
+        void AddQualityCallback(QualityCallback callback) { m_qualityCallbacks.push_back(std::move(callback)); }
+
+        // Once per frame on the render thread, the callbacks are called from it
+        void Update();
+
+        uint64_t GetTrackedUsage(MemoryCategory category) const { return m_trackedUsage[static_cast<size_t>(category)].load(std::memory_order_relaxed); }
+        uint64_t GetTrackedUsage() const { return m_totalTrackedUsage.load(std::memory_order_relaxed); }
+        // From the last poll plus what was tracked since
+        uint64_t GetEstimatedUsage() const;
+        uint64_t GetBudget() const { return m_polledInfo.budget; }
+        uint32_t GetQualityLevel() const { return m_qualityLevel; }
+
+        // Bytes of a texture in GPU memory, every level and layer, without the driver padding
+        static size_t GetTextureSize(const D3D11_TEXTURE2D_DESC& desc);
+
+        // Drives budgets through a FixedMemoryBudgetSource and checks the tracked totals per category and the
+        // thresholds at which the eviction and quality callbacks fire. Logs every mismatch, returns false if any.
+        static bool SelfCheck();
+
+    private:
+        void Poll();
+        void SetQualityLevel(uint32_t qualityLevel);
+
+    private:
+        MemoryBudgetSource* m_source;
+        MemoryBudgetSettings m_settings;
+
+        std::array<std::atomic<uint64_t>, static_cast<size_t>(MemoryCategory::Count)> m_trackedUsage = {};
+        std::atomic<uint64_t> m_totalTrackedUsage{ 0 };
+
+        MemoryBudgetInfo m_polledInfo;
+        uint64_t m_trackedUsageAtPoll = 0;
+        uint32_t m_updatesSincePoll = 0;
+        bool m_pollNeeded = true;
+
+        std::vector<EvictionCallback> m_evictionCallbacks;
+        std::vector<QualityCallback> m_qualityCallbacks;
+        uint32_t m_qualityLevel = 0;
+        uint32_t m_updatesSinceQualityChange = 0;
+        uint32_t m_updatesUnderRestore = 0;
+        bool m_relieved = true;  // False from an eviction until the usage is back under the restore threshold
+};
+
+#endif // !MEMORY_BUDGET_H
@@ -0,0 +1,129 @@
+#include "Mesh.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "../utils/ConsoleLogger.h"
+
+
+bool Mesh::Initialize(ID3D11DeviceContext* context, GeometryPool& geometryPool, const CompleteVertexData* vertices,
+    UINT vertexCount, const uint32_t* indices, UINT indexCount, const MeshletSettings& meshletSettings,
+    const MeshLodSettings& lodSettings) {
+    if (vertexCount == 0 || indexCount < 3) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to initialize a mesh: it has no triangles.");
+        return false;
+    }
+
+    std::vector<MeshPartData> parts = MeshParts::BuildParts(vertices, vertexCount, indices, indexCount, meshletSettings, lodSettings);
+    std::vector<MeshPartView> partViews;
+    partViews.reserve(parts.size());
+    for (const MeshPartData& part : parts)
+        partViews.push_back(MeshParts::GetView(part));
+    return InitializeParts(context, geometryPool, partViews.data(), partViews.size());
+}
+
+bool Mesh::InitializeParts(ID3D11DeviceContext* context, GeometryPool& geometryPool, const MeshPartView* parts, size_t partCount) {
+    if (partCount == 0) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to initialize a mesh: it has no parts.");
+        return false;
+    }
+
+    m_geometryPool = &geometryPool;
+    m_parts.clear();
+    m_lodErrors.clear();
+    m_vertexCount = 0;
+    m_indexCount = 0;
+
+    size_t maxMeshletCount = 0;
+    for (size_t p = 0; p < partCount; ++p) {
+        const MeshPartView& view = parts[p];
+        if (view.lodCount == 0) {
+            ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to initialize a mesh: a part has no level of detail.");
+            return false;
+        }
+
+        MeshPart part;
+        part.lods.assign(view.lods, view.lods + view.lodCount);
+        part.meshletData.meshlets.assign(view.meshlets, view.meshlets + view.meshletCount);
+        part.meshletData.bounds.assign(view.meshletBounds, view.meshletBounds + view.meshletCount);
+        part.meshletData.vertices.assign(view.meshletVertices, view.meshletVertices + view.meshletVertexCount);
+        part.meshletData.triangles.assign(view.meshletTriangles, view.meshletTriangles + view.meshletTriangleCount);
+
+        if (!geometryPool.Allocate(context, view.positions, view.attributes, view.vertexCount, view.indices, view.indexCount,
+            part.allocation)) {
+            ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to upload the geometry of a mesh.");
+            return false;
+        }
+
+        for (size_t level = 0; level < part.lods.size(); ++level) {
+            if (level >= m_lodErrors.size())
+                m_lodErrors.push_back(0.0f);
+            m_lodErrors[level] = std::max(m_lodErrors[level], part.lods[level].error);
+        }
+
+        m_vertexCount += view.vertexCount;
+        m_indexCount += part.lods[0].indexCount;
+        maxMeshletCount = std::max(maxMeshletCount, part.meshletData.meshlets.size());
+        m_parts.push_back(std::move(part));
+    }
+
+    m_visibleMeshlets.resize(maxMeshletCount);
+    return true;
+}
+
+void Mesh::Bind(ID3D11DeviceContext* context, MeshPass pass) const {
+    m_geometryPool->Bind(context, pass);
+}
+
+void Mesh::Draw(ID3D11DeviceContext* context) const {
+    DrawLod(context, 0);
+}
+
+void Mesh::DrawLod(ID3D11DeviceContext* context, uint32_t lod) const {
+    for (const MeshPart& part : m_parts) {
+        // Parts that ran out of levels draw their coarsest one, its error is below the requested level's
+        const MeshLod& meshLod = part.lods[std::min(lod, static_cast<uint32_t>(part.lods.size() - 1))];
+        context->DrawIndexed(meshLod.indexCount, part.allocation.firstIndex + meshLod.indexOffset, part.allocation.baseVertex);
+    }
+}
+
+uint32_t Mesh::SelectLod(float distance, float projectionScale, float maxScreenError) const {
+    return MeshSimplifier::SelectLod(m_lodErrors.data(), m_lodErrors.size(), distance, projectionScale, maxScreenError);
+}
+
+UINT Mesh::DrawVisibleMeshlets(ID3D11DeviceContext* context, const ViewFrustum& frustum, const DirectX::XMFLOAT3& cameraPosition) {
+    size_t totalVisibleCount = 0;
+    for (const MeshPart& part : m_parts) {
+        const MeshletData& meshletData = part.meshletData;
+        size_t visibleCount = Meshlets::CullMeshlets(meshletData, frustum, cameraPosition, m_visibleMeshlets.data());
+
+        // Meshlets are contiguous in the index buffer, runs of visible meshlets are drawn as one range
+        size_t i = 0;
+        while (i < visibleCount) {
+            const Meshlet& first = meshletData.meshlets[m_visibleMeshlets[i]];
+            UINT startIndex = part.allocation.firstIndex + first.triangleOffset;
+            UINT indexCount = first.triangleCount * 3;
+
+            while (++i < visibleCount && m_visibleMeshlets[i] == m_visibleMeshlets[i - 1] + 1)
+                indexCount += meshletData.meshlets[m_visibleMeshlets[i]].triangleCount * 3;
+
+            context->DrawIndexed(indexCount, startIndex, part.allocation.baseVertex);
+        }
+        totalVisibleCount += visibleCount;
+    }
+
+    return static_cast<UINT>(totalVisibleCount);
+}
+
+size_t Mesh::GetVertexStreamSize(MeshPass pass) const {
+    size_t stride = 0;
+    if (pass == MeshPass::DepthOnly) {
+        for (UINT streamStride : DepthOnlyLayout::Strides)
+            stride += streamStride;
+    }
+    else {
+        for (UINT streamStride : FullLayout::Strides)
+            stride += streamStride;
+    }
+    return stride * m_vertexCount;
+}
@@ -0,0 +1,83 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <d3d11.h>
+#include <cstdint>
+#include <vector>
+
+#include "GeometryPool.h"
+#include "VertexFormat.h"
+#include "../geometry/Meshlets.h"
+#include "../geometry/MeshParts.h"
+#include "../geometry/MeshSimplifier.h"
+
+
+// A piece of a mesh small enough for 16-bit indices, with its own range of the geometry pool
+struct MeshPart {
+    GeometryAllocation allocation;
+    // Index ranges of the levels of detail, relative to the first index of the allocation
+    std::vector<MeshLod> lods;
+    // Meshlets of the full resolution level, their triangle offsets are relative to the first index too
+    MeshletData meshletData;
+};
+
+// Geometry stored in a GeometryPool as separate vertex streams instead of one interleaved buffer:
+// - Slot 0: positions (SimpleVertexData, 12 bytes per vertex)
+// - Slot 1: every other attribute (CompleteAttributeData, 60 bytes per vertex)
+// Depth-only passes bind slot 0 alone and fetch a sixth of the vertex memory of a full pass.
+// Indices are 16-bit, meshes with more than 65536 vertices are split in parts.
+// The triangles are split in meshlets and the index buffer is stored in meshlet order, so the
+// meshlets can be culled on the CPU and the visible ones drawn as a few index ranges.
+// Coarser levels of detail are appended to the index buffer and share the vertex buffers.
+class Mesh {
+    public:
+        // Input layouts per pass, shaders of each pass are initialized with them:
+        //     depthShader.InitializeWithLayout<Mesh::DepthOnlyLayout>(device, desc, cache);
+        using DepthOnlyLayout = GeometryPool::DepthOnlyLayout;
+        using FullLayout = GeometryPool::FullLayout;
+
+        Mesh() = default;
+        ~Mesh() = default;
+
+        // Splits the interleaved vertices into the position and attribute streams, builds the meshlets and
+        // the levels of detail and uploads them to the pool. The indices should already be vertex cache
+        // optimized (see MeshOptimizer).
+        bool Initialize(ID3D11DeviceContext* context, GeometryPool& geometryPool, const CompleteVertexData* vertices,
+            UINT vertexCount, const uint32_t* indices, UINT indexCount, const MeshletSettings& meshletSettings = {},
+            const MeshLodSettings& lodSettings = {});
+        // Uploads parts built beforehand (see MeshParts), e.g. straight from the mapping of a cooked mesh file
+        bool InitializeParts(ID3D11DeviceContext* context, GeometryPool& geometryPool, const MeshPartView* parts, size_t partCount);
+
+        // Binds the pool the mesh lives in, meshes of the same pool are drawn one after the other without rebinding
+        void Bind(ID3D11DeviceContext* context, MeshPass pass) const;
+
+        // Draws the full resolution level
+        void Draw(ID3D11DeviceContext* context) const;
+        void DrawLod(ID3D11DeviceContext* context, uint32_t lod) const;
+        // Coarsest level whose error stays under `maxScreenError` pixels at `distance`, see MeshSimplifier::SelectLod
+        uint32_t SelectLod(float distance, float projectionScale, float maxScreenError) const;
+        // Culls the meshlets against the frustum and their normal cone, then draws the visible ones, merging
+        // consecutive meshlets in a single draw. The frustum and camera position must be in the space of the
+        // mesh vertices (see Meshlets::ExtractFrustum). Returns the number of meshlets drawn.
+        UINT DrawVisibleMeshlets(ID3D11DeviceContext* context, const ViewFrustum& frustum, const DirectX::XMFLOAT3& cameraPosition);
+
+        // Counts include the vertices duplicated between parts
+        UINT GetVertexCount() const { return m_vertexCount; }
+        UINT GetIndexCount() const { return m_indexCount; }
+        // Vertex memory fetched by a pass, to compare the cost of the passes
+        size_t GetVertexStreamSize(MeshPass pass) const;
+        const std::vector<MeshPart>& GetParts() const { return m_parts; }
+
+    private:
+        GeometryPool* m_geometryPool = nullptr;
+        std::vector<MeshPart> m_parts;
+        // Error of every level, the highest of all parts
+        std::vector<float> m_lodErrors;
+
+        UINT m_vertexCount = 0;
+        UINT m_indexCount = 0;
+
+        std::vector<uint32_t> m_visibleMeshlets;  // Scratch for the culling results
+};
+
+#endif // !MESH_H
@@ -1,5 +1,6 @@
 #include "RenderDeviceD3D11.h"
 
+#include "MemoryBudget.h"
 #include "../Utils/ConsoleLogger.h"
 
 #include <vector>
@@ -23,6 +24,7 @@ RenderDeviceD3D11::~RenderDeviceD3D11() {
     if (m_deviceContext) {
         m_deviceContext->ClearState(); // Break bindings to avoid reference cycles
     }
+    m_inputLayoutCache.Clear();
 
     Microsoft::WRL::ComPtr<ID3D11Debug> debugDevice;
     if (SUCCEEDED(m_device->QueryInterface(IID_PPV_ARGS(&debugDevice)))) {
@@ -38,6 +40,39 @@ ID3D11DeviceContext* RenderDeviceD3D11::GetDeviceContext() {
     return m_deviceContext.Get();
 }
 
+InputLayoutCache* RenderDeviceD3D11::GetInputLayoutCache() {
+    return &m_inputLayoutCache;
+}
+
+IDXGIAdapter3* RenderDeviceD3D11::GetAdapter() {
+    return m_adapter.Get();
+}
+
+void RenderDeviceD3D11::SetMemoryBudget(MemoryBudget* memoryBudget) {
+    if (m_memoryBudget != nullptr)
+        m_memoryBudget->TrackRelease(MemoryCategory::RenderTargets, m_renderTargetSize);
+    m_memoryBudget = memoryBudget;
+    m_renderTargetSize = 0;
+    TrackRenderTargets();
+}
+
+void RenderDeviceD3D11::TrackRenderTargets() {
+    if (m_memoryBudget == nullptr)
+        return;
+    m_memoryBudget->TrackRelease(MemoryCategory::RenderTargets, m_renderTargetSize);
+
+    // Every buffer of the swap chain is the size of the one we got
+    DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
+    m_swapChain->GetDesc(&swapChainDesc);
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    m_backBuffer->GetDesc(&textureDesc);
+    m_renderTargetSize = MemoryBudget::GetTextureSize(textureDesc) * swapChainDesc.BufferCount;
+    m_depthStencilBuffer->GetDesc(&textureDesc);
+    m_renderTargetSize += MemoryBudget::GetTextureSize(textureDesc);
+
+    m_memoryBudget->TrackAllocation(MemoryCategory::RenderTargets, m_renderTargetSize);
+}
+
 void RenderDeviceD3D11::GetVRAMInfo() {
     HRESULT result = m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &videoMemoryInfo);
     if (FAILED(result)) {
@@ -379,6 +414,9 @@ void RenderDeviceD3D11::StartFrame(const std::array<float, 4>& clearColor) {
     // Clear the Depth-Stencil View
     m_deviceContext->ClearDepthStencilView(m_depthStencilView.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
+    // Other code (ImGui) changes the input assembler state between frames
+    m_inputLayoutCache.InvalidateBoundState();
+
     // Start GPU frame timing
     m_deviceContext->Begin(m_disjointQuery.Get());
     m_deviceContext->End(m_startQuery.Get());
@@ -442,6 +480,7 @@ void RenderDeviceD3D11::Resize(int newWidth, int newHeight) {
     CreateRenderTargetView();
     CreateRenderPipeline();
     SetupViewport();
+    TrackRenderTargets();
 }
 
 void RenderDeviceD3D11::LogHRESULTError(HRESULT hr, const char* message) {
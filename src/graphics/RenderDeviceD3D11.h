@@ -8,6 +8,10 @@
 #include <wrl/client.h> // For ComPtr
 #include <array>
 
+#include "InputLayoutCache.h"
+
+class MemoryBudget;
+
 
 class RenderDeviceD3D11 {
 	public:
@@ -16,6 +20,10 @@ class RenderDeviceD3D11 {
 
 		ID3D11Device* GetDevice();
 		ID3D11DeviceContext* GetDeviceContext();
+		InputLayoutCache* GetInputLayoutCache();
+		IDXGIAdapter3* GetAdapter();
+		// Tracks the back buffers and the depth buffer as render targets, across resizes
+		void SetMemoryBudget(MemoryBudget* memoryBudget);
 
 		void Resize(int newWidth, int newHeight);
 		void GetVRAMInfo();
@@ -52,6 +60,8 @@ class RenderDeviceD3D11 {
 		void SetupViewport();
 
 		void InitializeGPUQuery();
+		// Reports the size of the render targets to the memory budget after they're recreated
+		void TrackRenderTargets();
 
 		void LogHRESULTError(HRESULT hr, const char* message);
 
@@ -80,6 +90,12 @@ class RenderDeviceD3D11 {
 
 		D3D11_VIEWPORT m_viewport;
 
+		// Input layouts shared by every shader created on this device
+		InputLayoutCache m_inputLayoutCache;
+
+		MemoryBudget* m_memoryBudget = nullptr;
+		size_t m_renderTargetSize = 0;
+
 };
 
 
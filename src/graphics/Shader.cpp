@@ -1,63 +1,245 @@
 #include "Shader.h"
 
 #include <d3dcompiler.h>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 
 #include "../utils/ConsoleLogger.h"
+#include "../utils/Hash.h"
 
 
 using namespace Microsoft::WRL;
 
-bool Shader::Initialize(ID3D11Device* device, const SHADER_DESC& desc, const D3D11_INPUT_ELEMENT_DESC* layout, UINT numElements) {
-    ComPtr<ID3DBlob> blob;
-    if (desc.vertexShaderPath &&
-        CompileShader(device, desc.vertexShaderPath, desc.vertexEntryPoint, desc.vertexTarget, blob) &&
-        CreateShader(device, blob, m_vertexShader)) {
-        // Create input layout inside the Initialize method
-        HRESULT result = device->CreateInputLayout(
-            layout,
-            numElements,
-            blob->GetBufferPointer(),
-            blob->GetBufferSize(),
-            m_inputLayout.GetAddressOf()
-        );
+namespace {
+    // Compiled bytecode and its reflected binding layout are cached together in this folder
+    const char* SHADER_CACHE_DIRECTORY = "shaders/cache";
+
+    constexpr uint32_t SHADER_CACHE_MAGIC = 0x43535050; // "PPSC"
+    constexpr uint32_t SHADER_CACHE_VERSION = 1;
+
+    struct ShaderCacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t bytecodeSize;
+        uint32_t layoutSize;
+    };
+
+    // Named after everything that selects the compiled output: the full path of the source (two shaders
+    // with the same name in different folders don't share an entry), the entry point, the target and the
+    // compile flags. The stem stays in front so the folder is readable.
+    std::filesystem::path GetShaderCachePath(const std::wstring& filePath, const std::string& entryPoint, const std::string& target,
+        UINT compileFlags) {
+        std::filesystem::path sourcePath(filePath);
+        std::error_code error;
+        const std::wstring fullPath = std::filesystem::absolute(sourcePath, error).lexically_normal().generic_wstring();
+        uint64_t key = Hash::FNV1a(fullPath.data(), fullPath.size() * sizeof(wchar_t));
+        key = Hash::FNV1a(entryPoint.data(), entryPoint.size(), key);
+        key = Hash::FNV1a("\0", 1, key);
+        key = Hash::FNV1a(target.data(), target.size(), key);
+        key = Hash::FNV1a(&compileFlags, sizeof(compileFlags), key);
+
+        char keyText[17];
+        std::snprintf(keyText, sizeof(keyText), "%016llx", static_cast<unsigned long long>(key));
+        std::string fileName = sourcePath.stem().string() + "_" + keyText + ".pcso";
+        return std::filesystem::path(SHADER_CACHE_DIRECTORY) / fileName;
+    }
 
+    // Hashes the preprocessed source (so included files are accounted for) together with
+    // everything else that changes the output of the compiler
+    bool HashShaderSource(const std::wstring& filePath, const std::string& entryPoint, const std::string& target,
+        UINT compileFlags, uint64_t& hash) {
+        std::ifstream file(std::filesystem::path(filePath), std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::string sourceName = std::filesystem::path(filePath).string();
+
+        ComPtr<ID3DBlob> preprocessed;
+        ComPtr<ID3DBlob> errorBlob;
+        HRESULT result = D3DPreprocess(source.data(), source.size(), sourceName.c_str(), nullptr,
+            D3D_COMPILE_STANDARD_FILE_INCLUDE, &preprocessed, &errorBlob);
         if (FAILED(result)) {
-            ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to create input layout.");
             return false;
         }
+
+        hash = Hash::FNV1a(preprocessed->GetBufferPointer(), preprocessed->GetBufferSize());
+        hash = Hash::FNV1a(entryPoint.data(), entryPoint.size(), hash);
+        hash = Hash::FNV1a(target.data(), target.size(), hash);
+        hash = Hash::FNV1a(&compileFlags, sizeof(compileFlags), hash);
+        return true;
+    }
+
+    bool LoadCachedShader(const std::filesystem::path& cachePath, uint64_t sourceHash,
+        ComPtr<ID3DBlob>& blob, ShaderBindingLayout& layout) {
+        std::ifstream file(cachePath, std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        ShaderCacheHeader header = {};
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            header.magic != SHADER_CACHE_MAGIC || header.version != SHADER_CACHE_VERSION ||
+            header.sourceHash != sourceHash) {
+            return false;
+        }
+
+        if (FAILED(D3DCreateBlob(header.bytecodeSize, &blob)) ||
+            !file.read(reinterpret_cast<char*>(blob->GetBufferPointer()), header.bytecodeSize)) {
+            return false;
+        }
+
+        std::vector<uint8_t> layoutData(header.layoutSize);
+        if (!file.read(reinterpret_cast<char*>(layoutData.data()), header.layoutSize)) {
+            return false;
+        }
+        return ShaderReflection::Deserialize(layoutData.data(), layoutData.size(), layout);
+    }
+
+    void WriteCachedShader(const std::filesystem::path& cachePath, uint64_t sourceHash,
+        const ComPtr<ID3DBlob>& blob, const ShaderBindingLayout& layout) {
+        std::error_code ec;
+        std::filesystem::create_directories(cachePath.parent_path(), ec);
+
+        std::vector<uint8_t> layoutData;
+        ShaderReflection::Serialize(layout, layoutData);
+
+        ShaderCacheHeader header = {};
+        header.magic = SHADER_CACHE_MAGIC;
+        header.version = SHADER_CACHE_VERSION;
+        header.sourceHash = sourceHash;
+        header.bytecodeSize = static_cast<uint32_t>(blob->GetBufferSize());
+        header.layoutSize = static_cast<uint32_t>(layoutData.size());
+
+        std::ofstream file(cachePath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            ConsoleLogger::Print(ConsoleLogger::LogType::C_WARNING, "Unable to write shader cache file: ", cachePath.string());
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(blob->GetBufferPointer()), blob->GetBufferSize());
+        file.write(reinterpret_cast<const char*>(layoutData.data()), layoutData.size());
+    }
+
+    void SetConstantBufferForStage(ID3D11DeviceContext* context, UINT stageIndex, UINT slot, ID3D11Buffer* buffer) {
+        switch (stageIndex) {
+        case 0: context->VSSetConstantBuffers(slot, 1, &buffer); break;
+        case 1: context->PSSetConstantBuffers(slot, 1, &buffer); break;
+        case 2: context->GSSetConstantBuffers(slot, 1, &buffer); break;
+        case 3: context->HSSetConstantBuffers(slot, 1, &buffer); break;
+        case 4: context->DSSetConstantBuffers(slot, 1, &buffer); break;
+        case 5: context->CSSetConstantBuffers(slot, 1, &buffer); break;
+        }
+    }
+
+    void SetShaderResourceForStage(ID3D11DeviceContext* context, UINT stageIndex, UINT slot, ID3D11ShaderResourceView* view) {
+        switch (stageIndex) {
+        case 0: context->VSSetShaderResources(slot, 1, &view); break;
+        case 1: context->PSSetShaderResources(slot, 1, &view); break;
+        case 2: context->GSSetShaderResources(slot, 1, &view); break;
+        case 3: context->HSSetShaderResources(slot, 1, &view); break;
+        case 4: context->DSSetShaderResources(slot, 1, &view); break;
+        case 5: context->CSSetShaderResources(slot, 1, &view); break;
+        }
+    }
+
+    void SetSamplerForStage(ID3D11DeviceContext* context, UINT stageIndex, UINT slot, ID3D11SamplerState* sampler) {
+        switch (stageIndex) {
+        case 0: context->VSSetSamplers(slot, 1, &sampler); break;
+        case 1: context->PSSetSamplers(slot, 1, &sampler); break;
+        case 2: context->GSSetSamplers(slot, 1, &sampler); break;
+        case 3: context->HSSetSamplers(slot, 1, &sampler); break;
+        case 4: context->DSSetSamplers(slot, 1, &sampler); break;
+        case 5: context->CSSetSamplers(slot, 1, &sampler); break;
+        }
+    }
+}
+
+bool Shader::Initialize(ID3D11Device* device, const SHADER_DESC& desc, const D3D11_INPUT_ELEMENT_DESC* layout, UINT numElements,
+    InputLayoutCache* inputLayoutCache) {
+    return InitializeInternal(device, desc, layout, numElements, InputLayoutCache::HashElements(layout, numElements), inputLayoutCache);
+}
+
+bool Shader::InitializeInternal(ID3D11Device* device, const SHADER_DESC& desc, const D3D11_INPUT_ELEMENT_DESC* layout, UINT numElements,
+    uint64_t layoutHash, InputLayoutCache* inputLayoutCache) {
+    m_bindingLayout.Clear();
+    m_inputLayoutCache = inputLayoutCache;
+
+    // A stage that fails to compile, reflect or merge with the others fails the shader: a binding mismatch
+    // between stages is reported at load instead of rendering garbage
+    ComPtr<ID3DBlob> blob;
+    if (desc.vertexShaderPath) {
+        if (!CompileShader(device, desc.vertexShaderPath, desc.vertexEntryPoint, desc.vertexTarget, ShaderStage::VertexShader, blob) ||
+            !CreateShader(device, blob, m_vertexShader)) {
+            return false;
+        }
+
+        // Shaders sharing a vertex format share the input layout through the cache
+        if (m_inputLayoutCache) {
+            m_inputLayout = m_inputLayoutCache->Acquire(device, layout, numElements, layoutHash, blob->GetBufferPointer(), blob->GetBufferSize());
+            if (!m_inputLayout) {
+                return false;
+            }
+        }
+        else {
+            // Create input layout inside the Initialize method
+            HRESULT result = device->CreateInputLayout(
+                layout,
+                numElements,
+                blob->GetBufferPointer(),
+                blob->GetBufferSize(),
+                m_inputLayout.GetAddressOf()
+            );
+
+            if (FAILED(result)) {
+                ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to create input layout.");
+                return false;
+            }
+        }
     }
 
     if (desc.pixelShaderPath &&
-        CompileShader(device, desc.pixelShaderPath, desc.pixelEntryPoint, desc.pixelTarget, blob) &&
-        CreateShader(device, blob, m_pixelShader)) {
+        (!CompileShader(device, desc.pixelShaderPath, desc.pixelEntryPoint, desc.pixelTarget, ShaderStage::PixelShader, blob) ||
+        !CreateShader(device, blob, m_pixelShader))) {
+        return false;
     }
 
     if (desc.geometryShaderPath &&
-        CompileShader(device, desc.geometryShaderPath, desc.geometryEntryPoint, desc.geometryTarget, blob) &&
-        CreateShader(device, blob, m_geometryShader)) {
+        (!CompileShader(device, desc.geometryShaderPath, desc.geometryEntryPoint, desc.geometryTarget, ShaderStage::GeometryShader, blob) ||
+        !CreateShader(device, blob, m_geometryShader))) {
+        return false;
     }
 
     if (desc.hullShaderPath &&
-        CompileShader(device, desc.hullShaderPath, desc.hullEntryPoint, desc.hullTarget, blob) &&
-        CreateShader(device, blob, m_hullShader)) {
+        (!CompileShader(device, desc.hullShaderPath, desc.hullEntryPoint, desc.hullTarget, ShaderStage::HullShader, blob) ||
+        !CreateShader(device, blob, m_hullShader))) {
+        return false;
     }
 
     if (desc.domainShaderPath &&
-        CompileShader(device, desc.domainShaderPath, desc.domainEntryPoint, desc.domainTarget, blob) &&
-        CreateShader(device, blob, m_domainShader)) {
+        (!CompileShader(device, desc.domainShaderPath, desc.domainEntryPoint, desc.domainTarget, ShaderStage::DomainShader, blob) ||
+        !CreateShader(device, blob, m_domainShader))) {
+        return false;
     }
 
     if (desc.computeShaderPath &&
-        CompileShader(device, desc.computeShaderPath, desc.computeEntryPoint, desc.computeTarget, blob) &&
-        CreateShader(device, blob, m_computeShader)) {
+        (!CompileShader(device, desc.computeShaderPath, desc.computeEntryPoint, desc.computeTarget, ShaderStage::ComputeShader, blob) ||
+        !CreateShader(device, blob, m_computeShader))) {
+        return false;
     }
 
+    m_constantBuffers.assign(m_bindingLayout.constantBuffers.size(), nullptr);
+    m_shaderResources.assign(m_bindingLayout.shaderResources.size(), nullptr);
+    m_samplers.assign(m_bindingLayout.samplers.size(), nullptr);
+
     return true;
 }
 
 bool Shader::CompileShader(ID3D11Device* device, const std::optional<std::wstring>& filePath,
-    const std::string& entryPoint, const std::string& target,
+    const std::string& entryPoint, const std::string& target, UINT stageFlag,
     ComPtr<ID3DBlob>& blob) {
     if (!filePath) return true;
 
@@ -65,26 +247,45 @@ bool Shader::CompileShader(ID3D11Device* device, const std::optional<std::wstrin
         D3DCOMPILE_ENABLE_STRICTNESS;
     compile_flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 
-    ComPtr<ID3DBlob> errorBlob;
-    HRESULT result = D3DCompileFromFile(
-        filePath->c_str(),
-        nullptr,
-        nullptr,
-        entryPoint.c_str(),
-        target.c_str(),
-        compile_flags,
-        0,
-        &blob,
-        &errorBlob
-    );
+    // Reuse the cached bytecode and binding layout if the source didn't change
+    std::filesystem::path cachePath = GetShaderCachePath(*filePath, entryPoint, target, compile_flags);
+    uint64_t sourceHash = 0;
+    bool hashed = HashShaderSource(*filePath, entryPoint, target, compile_flags, sourceHash);
 
-    if (FAILED(result)) {
-        if (errorBlob) {
-            OutputDebugStringA(reinterpret_cast<const char*>(errorBlob->GetBufferPointer()));
+    ShaderBindingLayout stageLayout;
+    if (!hashed || !LoadCachedShader(cachePath, sourceHash, blob, stageLayout)) {
+        ComPtr<ID3DBlob> errorBlob;
+        HRESULT result = D3DCompileFromFile(
+            filePath->c_str(),
+            nullptr,
+            D3D_COMPILE_STANDARD_FILE_INCLUDE,
+            entryPoint.c_str(),
+            target.c_str(),
+            compile_flags,
+            0,
+            &blob,
+            &errorBlob
+        );
+
+        if (FAILED(result)) {
+            if (errorBlob) {
+                OutputDebugStringA(reinterpret_cast<const char*>(errorBlob->GetBufferPointer()));
+                ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, reinterpret_cast<const char*>(errorBlob->GetBufferPointer()));
+            }
+            return false;
+        }
+
+        // Reflection only runs when the shader is (re)compiled, the result lives in the cache afterwards
+        stageLayout.Clear();
+        if (!ShaderReflection::ReflectStage(blob->GetBufferPointer(), blob->GetBufferSize(), stageFlag, stageLayout)) {
+            return false;
+        }
+        if (hashed) {
+            WriteCachedShader(cachePath, sourceHash, blob, stageLayout);
         }
-        return false;
     }
-    return true;
+
+    return m_bindingLayout.Merge(stageLayout);
 }
 
 template <typename ShaderType>
@@ -115,11 +316,18 @@ bool Shader::CreateShader(ID3D11Device* device, const ComPtr<ID3DBlob>& blob, Co
         return false;
     }
 
-    return SUCCEEDED(result);
+    if (FAILED(result)) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to create shader.");
+        return false;
+    }
+    return true;
 }
 
 void Shader::SetShaders(ID3D11DeviceContext* context) {
-    context->IASetInputLayout(m_inputLayout.Get());
+    if (m_inputLayoutCache)
+        m_inputLayoutCache->Bind(context, m_inputLayout.Get());
+    else
+        InputLayoutCache::BindExternal(context, m_inputLayout.Get());
     if (m_vertexShader != nullptr)
         context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
     if (m_pixelShader != nullptr)
@@ -135,12 +343,26 @@ void Shader::SetShaders(ID3D11DeviceContext* context) {
 }
 
 bool Shader::CreateConstantBuffer(ID3D11Device* device, const std::string& name, const CONSTANT_BUFFER_DESC& desc) {
-    if (m_constantBuffers.count(name)) {
+    int index = m_bindingLayout.FindConstantBuffer(name);
+    if (index < 0) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Constant buffer ", name, " is not declared by any stage of the shader");
+        return false;
+    }
+    if (m_constantBuffers[index]) {
         ConsoleLogger::Print(ConsoleLogger::LogType::C_CRITICAL_ERROR, "Constant buffer already exists: " + name);
     }
 
+    // Constant buffers are sized in 16 byte registers, so compare against the padded size
+    const UINT reflectedSize = m_bindingLayout.constantBuffers[index].size;
+    const UINT bufferSize = (static_cast<UINT>(desc.bufferSize) + 15) & ~15u;
+    if (bufferSize != reflectedSize) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Constant buffer ", name, " size mismatch: C++ declares ",
+            desc.bufferSize, " bytes but the shader expects ", reflectedSize, " bytes");
+        return false;
+    }
+
     D3D11_BUFFER_DESC bufferDesc{};
-    bufferDesc.ByteWidth = static_cast<UINT>(desc.bufferSize);
+    bufferDesc.ByteWidth = bufferSize;
     bufferDesc.Usage = desc.usage;
     bufferDesc.BindFlags = desc.bindFlags;
     bufferDesc.CPUAccessFlags = desc.cpuAccessFlags;
@@ -151,57 +373,82 @@ bool Shader::CreateConstantBuffer(ID3D11Device* device, const std::string& name,
         return false;
     }
 
-    m_constantBuffers[name] = buffer;
-    ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Created constant buffer: ", m_constantBuffers.find(name)->first);
+    m_constantBuffers[index] = buffer;
+    ConsoleLogger::Print(ConsoleLogger::LogType::C_INFO, "Created constant buffer: ", name);
     return true;
 }
 
+int Shader::GetConstantBufferIndex(const std::string& name) const {
+    return m_bindingLayout.FindConstantBuffer(name);
+}
 
 void Shader::UpdateConstantBuffer(ID3D11DeviceContext* context, const std::string& name, const void* data, size_t dataSize) {
-    auto it = m_constantBuffers.find(name);
-    if (it == m_constantBuffers.end()) {
+    int index = m_bindingLayout.FindConstantBuffer(name);
+    if (index < 0) {
         ConsoleLogger::Print(ConsoleLogger::LogType::C_CRITICAL_ERROR, "Constant buffer not found: " + name);
     }
+    UpdateConstantBuffer(context, index, data, dataSize);
+}
+
+void Shader::UpdateConstantBuffer(ID3D11DeviceContext* context, int index, const void* data, size_t dataSize) {
+    if (index < 0 || static_cast<size_t>(index) >= m_bindingLayout.constantBuffers.size()) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Constant buffer index out of range: ", index);
+        return;
+    }
+    ID3D11Buffer* buffer = m_constantBuffers[index].Get();
+    if (buffer == nullptr) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_CRITICAL_ERROR, "Constant buffer was never created: " + m_bindingLayout.constantBuffers[index].name);
+    }
 
     D3D11_MAPPED_SUBRESOURCE mappedResource;
-    if (FAILED(context->Map(it->second.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))) {
-        ConsoleLogger::Print(ConsoleLogger::LogType::C_CRITICAL_ERROR, "Failed to map constant buffer: " + name);
+    if (FAILED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_CRITICAL_ERROR, "Failed to map constant buffer: " + m_bindingLayout.constantBuffers[index].name);
     }
 
     std::memcpy(mappedResource.pData, data, dataSize);
-    context->Unmap(it->second.Get(), 0);
+    context->Unmap(buffer, 0);
 }
 
-void Shader::BindConstantBuffer(ID3D11DeviceContext* context, const std::string& name, UINT slot, UINT shaderFlags) // Use custom flags, not D3D11_BIND_* constants
-{
-    auto it = m_constantBuffers.find(name);
-    if (it == m_constantBuffers.end()) {
-        ConsoleLogger::Print(ConsoleLogger::LogType::C_CRITICAL_ERROR, "Constant buffer not found: " + name);
+bool Shader::SetShaderResource(const std::string& name, ID3D11ShaderResourceView* shaderResourceView) {
+    int index = m_bindingLayout.FindShaderResource(name);
+    if (index < 0) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Shader resource ", name, " is not declared by any stage of the shader");
+        return false;
     }
+    m_shaderResources[index] = shaderResourceView;
+    return true;
+}
 
-    ID3D11Buffer* buffer = it->second.Get();
-
-    // Validate shader flags
-    if (shaderFlags == 0) {
-        ConsoleLogger::Print(ConsoleLogger::LogType::C_CRITICAL_ERROR, "Invalid shader flags for constant buffer: " + name);
-    }
-    // Use custom flags to decide where to bind the constant buffer
-    if (shaderFlags & ShaderStage::VertexShader) {
-        context->VSSetConstantBuffers(slot, 1, &buffer);
-    }
-    if (shaderFlags & ShaderStage::PixelShader) {
-        context->PSSetConstantBuffers(slot, 1, &buffer);
-    }
-    if (shaderFlags & ShaderStage::GeometryShader) {
-        context->GSSetConstantBuffers(slot, 1, &buffer);
+bool Shader::SetSampler(const std::string& name, ID3D11SamplerState* samplerState) {
+    int index = m_bindingLayout.FindSampler(name);
+    if (index < 0) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Sampler ", name, " is not declared by any stage of the shader");
+        return false;
     }
-    if (shaderFlags & ShaderStage::HullShader) {
-        context->HSSetConstantBuffers(slot, 1, &buffer);
+    m_samplers[index] = samplerState;
+    return true;
+}
+
+void Shader::BindResources(ID3D11DeviceContext* context) {
+    for (size_t i = 0; i < m_constantBuffers.size(); ++i) {
+        const ShaderConstantBufferBinding& binding = m_bindingLayout.constantBuffers[i];
+        for (UINT stage = 0; stage < ShaderStage::Count; ++stage) {
+            if (binding.slots[stage] != INVALID_BINDING_SLOT)
+                SetConstantBufferForStage(context, stage, binding.slots[stage], m_constantBuffers[i].Get());
+        }
     }
-    if (shaderFlags & ShaderStage::DomainShader) {
-        context->DSSetConstantBuffers(slot, 1, &buffer);
+    for (size_t i = 0; i < m_shaderResources.size(); ++i) {
+        const ShaderResourceBinding& binding = m_bindingLayout.shaderResources[i];
+        for (UINT stage = 0; stage < ShaderStage::Count; ++stage) {
+            if (binding.slots[stage] != INVALID_BINDING_SLOT)
+                SetShaderResourceForStage(context, stage, binding.slots[stage], m_shaderResources[i]);
+        }
     }
-    if (shaderFlags & ShaderStage::ComputeShader) {
-        context->CSSetConstantBuffers(slot, 1, &buffer);
+    for (size_t i = 0; i < m_samplers.size(); ++i) {
+        const ShaderResourceBinding& binding = m_bindingLayout.samplers[i];
+        for (UINT stage = 0; stage < ShaderStage::Count; ++stage) {
+            if (binding.slots[stage] != INVALID_BINDING_SLOT)
+                SetSamplerForStage(context, stage, binding.slots[stage], m_samplers[i]);
+        }
     }
 }
@@ -4,10 +4,12 @@
 #include <d3d11.h>
 #include <wrl/client.h>
 #include <string>
-#include <unordered_map>
 #include <vector>
 #include <optional>
 
+#include "ShaderReflection.h"
+#include "InputLayoutCache.h"
+#include "VertexLayout.h"
 
 // Descriptor for shader initialization
 struct SHADER_DESC {
@@ -47,29 +49,51 @@ struct CONSTANT_BUFFER_DESC {
     UINT cpuAccessFlags = D3D11_CPU_ACCESS_WRITE;
 };
 
-namespace ShaderStage {
-    constexpr UINT VertexShader = 0x1;
-    constexpr UINT PixelShader = 0x2;
-    constexpr UINT GeometryShader = 0x4;
-    constexpr UINT HullShader = 0x8;
-    constexpr UINT DomainShader = 0x10;
-    constexpr UINT ComputeShader = 0x20;
-}
-
 class Shader {
     public:
         Shader() = default;
         ~Shader() = default;
 
-        bool Initialize(ID3D11Device* device, const SHADER_DESC& desc, const D3D11_INPUT_ELEMENT_DESC* layout, UINT numElements);
+        // When an input layout cache is given the input layout is shared with every other shader
+        // using the same vertex format and vertex shader input signature
+        bool Initialize(ID3D11Device* device, const SHADER_DESC& desc, const D3D11_INPUT_ELEMENT_DESC* layout, UINT numElements,
+            InputLayoutCache* inputLayoutCache = nullptr);
+        // Same as above with the input layout generated at compile time from the VertexTraits of the vertex struct
+        template <typename VertexType>
+        bool Initialize(ID3D11Device* device, const SHADER_DESC& desc, InputLayoutCache* inputLayoutCache = nullptr) {
+            return InitializeWithLayout<VertexLayout<VertexType>>(device, desc, inputLayoutCache);
+        }
+        // Same as above with a compile time layout, either a VertexLayout or a multi stream VertexStreamLayout
+        template <typename LayoutType>
+        bool InitializeWithLayout(ID3D11Device* device, const SHADER_DESC& desc, InputLayoutCache* inputLayoutCache = nullptr) {
+            return InitializeInternal(device, desc, LayoutType::Elements.data(), LayoutType::AttributeCount, LayoutType::Hash, inputLayoutCache);
+        }
         void SetShaders(ID3D11DeviceContext* context);
+        // Creates the constant buffer declared by the shader with the given name.
+        // The name and size are validated against the reflected binding layout, so a mismatch
+        // between C++ and HLSL is reported here instead of producing garbage frames.
         bool CreateConstantBuffer(ID3D11Device* device, const std::string& name, const CONSTANT_BUFFER_DESC& desc);
         void UpdateConstantBuffer(ID3D11DeviceContext* context, const std::string& name, const void* data, size_t dataSize);
-        void BindConstantBuffer(ID3D11DeviceContext* context, const std::string& name, UINT slot, UINT shaderFlags);
+        void UpdateConstantBuffer(ID3D11DeviceContext* context, int index, const void* data, size_t dataSize);
+
+        // Assigns resources to the bindings declared by the shader, resolved by name once at setup time
+        bool SetShaderResource(const std::string& name, ID3D11ShaderResourceView* shaderResourceView);
+        bool SetSampler(const std::string& name, ID3D11SamplerState* samplerState);
+
+        // Binds every constant buffer, shader resource and sampler to the slots and stages
+        // found by reflection. This is a walk over precomputed tables, no name lookups involved.
+        void BindResources(ID3D11DeviceContext* context);
+
+        // Index of a constant buffer inside the binding layout, to update it without name lookups
+        int GetConstantBufferIndex(const std::string& name) const;
+        const ShaderBindingLayout& GetBindingLayout() const { return m_bindingLayout; }
     
     private:
+        bool InitializeInternal(ID3D11Device* device, const SHADER_DESC& desc, const D3D11_INPUT_ELEMENT_DESC* layout, UINT numElements,
+            uint64_t layoutHash, InputLayoutCache* inputLayoutCache);
+
         bool CompileShader(ID3D11Device* device, const std::optional<std::wstring>& filePath,
-            const std::string& entryPoint, const std::string& target,
+            const std::string& entryPoint, const std::string& target, UINT stageFlag,
             Microsoft::WRL::ComPtr<ID3DBlob>& blob);
 
         template <typename ShaderType>
@@ -84,7 +108,13 @@ class Shader {
         Microsoft::WRL::ComPtr<ID3D11ComputeShader> m_computeShader;
 
         Microsoft::WRL::ComPtr<ID3D11InputLayout> m_inputLayout;
-        std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11Buffer>> m_constantBuffers;
+        InputLayoutCache* m_inputLayoutCache = nullptr;
+
+        // Reflected bindings of every stage, the tables below are indexed the same way
+        ShaderBindingLayout m_bindingLayout;
+        std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> m_constantBuffers;
+        std::vector<ID3D11ShaderResourceView*> m_shaderResources;
+        std::vector<ID3D11SamplerState*> m_samplers;
 
 };
 
@@ -0,0 +1,275 @@
+#include "ShaderReflection.h"
+
+#include <d3dcompiler.h>
+#include <d3d11shader.h>
+#include <wrl/client.h>
+#include <cstring>
+
+#include "../utils/ConsoleLogger.h"
+
+
+using namespace Microsoft::WRL;
+
+namespace {
+    template <typename BindingType>
+    int FindByName(const std::vector<BindingType>& bindings, const std::string& name) {
+        for (size_t i = 0; i < bindings.size(); ++i) {
+            if (bindings[i].name == name)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // Adds (or extends) a resource binding with the slot used by the given stage
+    void AddResourceBinding(std::vector<ShaderResourceBinding>& bindings, const D3D11_SHADER_INPUT_BIND_DESC& bindDesc, UINT stageFlag) {
+        int index = FindByName(bindings, bindDesc.Name);
+        if (index < 0) {
+            ShaderResourceBinding binding;
+            binding.name = bindDesc.Name;
+            binding.type = bindDesc.Type;
+            binding.bindCount = bindDesc.BindCount;
+            bindings.push_back(binding);
+            index = static_cast<int>(bindings.size() - 1);
+        }
+        bindings[index].stages |= stageFlag;
+        bindings[index].slots[ShaderStage::ToIndex(stageFlag)] = bindDesc.BindPoint;
+    }
+
+    void MergeResourceBindings(std::vector<ShaderResourceBinding>& target, const std::vector<ShaderResourceBinding>& source) {
+        for (const auto& binding : source) {
+            int index = FindByName(target, binding.name);
+            if (index < 0) {
+                target.push_back(binding);
+                continue;
+            }
+            target[index].stages |= binding.stages;
+            for (UINT stage = 0; stage < ShaderStage::Count; ++stage) {
+                if (binding.slots[stage] != INVALID_BINDING_SLOT)
+                    target[index].slots[stage] = binding.slots[stage];
+            }
+        }
+    }
+
+    /// Minimal binary writer/reader for the layout cache
+    void WriteU32(std::vector<uint8_t>& output, uint32_t value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        output.insert(output.end(), bytes, bytes + sizeof(value));
+    }
+    void WriteString(std::vector<uint8_t>& output, const std::string& value) {
+        WriteU32(output, static_cast<uint32_t>(value.size()));
+        output.insert(output.end(), value.begin(), value.end());
+    }
+    void WriteSlots(std::vector<uint8_t>& output, const std::array<UINT, ShaderStage::Count>& slots) {
+        for (UINT slot : slots)
+            WriteU32(output, slot);
+    }
+    void WriteResourceBindings(std::vector<uint8_t>& output, const std::vector<ShaderResourceBinding>& bindings) {
+        WriteU32(output, static_cast<uint32_t>(bindings.size()));
+        for (const auto& binding : bindings) {
+            WriteString(output, binding.name);
+            WriteU32(output, static_cast<uint32_t>(binding.type));
+            WriteU32(output, binding.bindCount);
+            WriteU32(output, binding.stages);
+            WriteSlots(output, binding.slots);
+        }
+    }
+
+    class LayoutReader {
+        public:
+            LayoutReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+            bool ReadU32(uint32_t& value) {
+                if (m_offset + sizeof(value) > m_size) return false;
+                std::memcpy(&value, m_data + m_offset, sizeof(value));
+                m_offset += sizeof(value);
+                return true;
+            }
+            bool ReadString(std::string& value) {
+                uint32_t length = 0;
+                if (!ReadU32(length) || m_offset + length > m_size) return false;
+                value.assign(reinterpret_cast<const char*>(m_data + m_offset), length);
+                m_offset += length;
+                return true;
+            }
+            // Reads an element count, rejecting counts the rest of the blob can't hold so a corrupt cache
+            // can't make us allocate a huge array. `minElementSize` is the smallest serialized element.
+            bool ReadCount(uint32_t& count, size_t minElementSize) {
+                return ReadU32(count) && count <= (m_size - m_offset) / minElementSize;
+            }
+            bool ReadSlots(std::array<UINT, ShaderStage::Count>& slots) {
+                for (UINT& slot : slots) {
+                    if (!ReadU32(slot)) return false;
+                }
+                return true;
+            }
+            bool ReadResourceBindings(std::vector<ShaderResourceBinding>& bindings) {
+                // Name length, type, bind count, stages and slots
+                uint32_t count = 0;
+                if (!ReadCount(count, sizeof(uint32_t) * (4 + ShaderStage::Count))) return false;
+                bindings.resize(count);
+                for (auto& binding : bindings) {
+                    uint32_t type = 0;
+                    if (!ReadString(binding.name) || !ReadU32(type) || !ReadU32(binding.bindCount) ||
+                        !ReadU32(binding.stages) || !ReadSlots(binding.slots))
+                        return false;
+                    binding.type = static_cast<D3D_SHADER_INPUT_TYPE>(type);
+                }
+                return true;
+            }
+        private:
+            const uint8_t* m_data;
+            size_t m_size;
+            size_t m_offset = 0;
+    };
+}
+
+int ShaderBindingLayout::FindConstantBuffer(const std::string& name) const {
+    return FindByName(constantBuffers, name);
+}
+int ShaderBindingLayout::FindShaderResource(const std::string& name) const {
+    return FindByName(shaderResources, name);
+}
+int ShaderBindingLayout::FindSampler(const std::string& name) const {
+    return FindByName(samplers, name);
+}
+int ShaderBindingLayout::FindUnorderedAccessView(const std::string& name) const {
+    return FindByName(unorderedAccessViews, name);
+}
+
+bool ShaderBindingLayout::Merge(const ShaderBindingLayout& other) {
+    for (const auto& buffer : other.constantBuffers) {
+        int index = FindConstantBuffer(buffer.name);
+        if (index < 0) {
+            constantBuffers.push_back(buffer);
+            continue;
+        }
+
+        ShaderConstantBufferBinding& existing = constantBuffers[index];
+        if (existing.size != buffer.size) {
+            ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Constant buffer ", buffer.name,
+                " is declared with different sizes across stages (", existing.size, " vs ", buffer.size, " bytes)");
+            return false;
+        }
+        existing.stages |= buffer.stages;
+        for (UINT stage = 0; stage < ShaderStage::Count; ++stage) {
+            if (buffer.slots[stage] != INVALID_BINDING_SLOT)
+                existing.slots[stage] = buffer.slots[stage];
+        }
+    }
+
+    MergeResourceBindings(shaderResources, other.shaderResources);
+    MergeResourceBindings(samplers, other.samplers);
+    MergeResourceBindings(unorderedAccessViews, other.unorderedAccessViews);
+    return true;
+}
+
+void ShaderBindingLayout::Clear() {
+    constantBuffers.clear();
+    shaderResources.clear();
+    samplers.clear();
+    unorderedAccessViews.clear();
+}
+
+bool ShaderReflection::ReflectStage(const void* bytecode, size_t bytecodeSize, UINT stageFlag, ShaderBindingLayout& layout) {
+    ComPtr<ID3D11ShaderReflection> reflection;
+    if (FAILED(D3DReflect(bytecode, bytecodeSize, IID_PPV_ARGS(&reflection)))) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to reflect shader bytecode.");
+        return false;
+    }
+
+    D3D11_SHADER_DESC shaderDesc;
+    reflection->GetDesc(&shaderDesc);
+
+    const UINT stageIndex = ShaderStage::ToIndex(stageFlag);
+    for (UINT i = 0; i < shaderDesc.BoundResources; ++i) {
+        D3D11_SHADER_INPUT_BIND_DESC bindDesc;
+        reflection->GetResourceBindingDesc(i, &bindDesc);
+
+        switch (bindDesc.Type) {
+        case D3D_SIT_CBUFFER: {
+            ID3D11ShaderReflectionConstantBuffer* constantBuffer = reflection->GetConstantBufferByName(bindDesc.Name);
+            D3D11_SHADER_BUFFER_DESC bufferDesc;
+            if (FAILED(constantBuffer->GetDesc(&bufferDesc)))
+                break;
+
+            ShaderConstantBufferBinding binding;
+            binding.name = bindDesc.Name;
+            binding.size = bufferDesc.Size;
+            binding.stages = stageFlag;
+            binding.slots[stageIndex] = bindDesc.BindPoint;
+            for (UINT v = 0; v < bufferDesc.Variables; ++v) {
+                D3D11_SHADER_VARIABLE_DESC variableDesc;
+                constantBuffer->GetVariableByIndex(v)->GetDesc(&variableDesc);
+                binding.members.push_back({ variableDesc.Name, variableDesc.StartOffset, variableDesc.Size });
+            }
+            layout.constantBuffers.push_back(std::move(binding));
+            break;
+        }
+        case D3D_SIT_TBUFFER:
+        case D3D_SIT_TEXTURE:
+        case D3D_SIT_STRUCTURED:
+        case D3D_SIT_BYTEADDRESS:
+            AddResourceBinding(layout.shaderResources, bindDesc, stageFlag);
+            break;
+        case D3D_SIT_SAMPLER:
+            AddResourceBinding(layout.samplers, bindDesc, stageFlag);
+            break;
+        case D3D_SIT_UAV_RWTYPED:
+        case D3D_SIT_UAV_RWSTRUCTURED:
+        case D3D_SIT_UAV_RWBYTEADDRESS:
+        case D3D_SIT_UAV_APPEND_STRUCTURED:
+        case D3D_SIT_UAV_CONSUME_STRUCTURED:
+        case D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER:
+            AddResourceBinding(layout.unorderedAccessViews, bindDesc, stageFlag);
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+void ShaderReflection::Serialize(const ShaderBindingLayout& layout, std::vector<uint8_t>& output) {
+    WriteU32(output, static_cast<uint32_t>(layout.constantBuffers.size()));
+    for (const auto& buffer : layout.constantBuffers) {
+        WriteString(output, buffer.name);
+        WriteU32(output, buffer.size);
+        WriteU32(output, buffer.stages);
+        WriteSlots(output, buffer.slots);
+        WriteU32(output, static_cast<uint32_t>(buffer.members.size()));
+        for (const auto& member : buffer.members) {
+            WriteString(output, member.name);
+            WriteU32(output, member.offset);
+            WriteU32(output, member.size);
+        }
+    }
+    WriteResourceBindings(output, layout.shaderResources);
+    WriteResourceBindings(output, layout.samplers);
+    WriteResourceBindings(output, layout.unorderedAccessViews);
+}
+
+bool ShaderReflection::Deserialize(const uint8_t* data, size_t dataSize, ShaderBindingLayout& layout) {
+    LayoutReader reader(data, dataSize);
+    layout.Clear();
+
+    // Name length, size, stages, slots and member count
+    uint32_t bufferCount = 0;
+    if (!reader.ReadCount(bufferCount, sizeof(uint32_t) * (4 + ShaderStage::Count)))
+        return false;
+    layout.constantBuffers.resize(bufferCount);
+    for (auto& buffer : layout.constantBuffers) {
+        uint32_t memberCount = 0;
+        if (!reader.ReadString(buffer.name) || !reader.ReadU32(buffer.size) || !reader.ReadU32(buffer.stages) ||
+            !reader.ReadSlots(buffer.slots) || !reader.ReadCount(memberCount, sizeof(uint32_t) * 3))
+            return false;
+        buffer.members.resize(memberCount);
+        for (auto& member : buffer.members) {
+            if (!reader.ReadString(member.name) || !reader.ReadU32(member.offset) || !reader.ReadU32(member.size))
+                return false;
+        }
+    }
+
+    return reader.ReadResourceBindings(layout.shaderResources) &&
+        reader.ReadResourceBindings(layout.samplers) &&
+        reader.ReadResourceBindings(layout.unorderedAccessViews);
+}
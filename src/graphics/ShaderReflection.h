@@ -0,0 +1,100 @@
+#ifndef SHADER_REFLECTION_H
+#define SHADER_REFLECTION_H
+
+#include <d3d11.h>
+#include <d3dcommon.h>
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+namespace ShaderStage {
+    constexpr UINT VertexShader = 0x1;
+    constexpr UINT PixelShader = 0x2;
+    constexpr UINT GeometryShader = 0x4;
+    constexpr UINT HullShader = 0x8;
+    constexpr UINT DomainShader = 0x10;
+    constexpr UINT ComputeShader = 0x20;
+
+    // Number of programmable stages, used to size the per-stage slot tables
+    constexpr UINT Count = 6;
+
+    // Maps a single stage flag to its index in the per-stage slot tables (VertexShader -> 0, PixelShader -> 1, ...)
+    constexpr UINT ToIndex(UINT stageFlag) {
+        UINT index = 0;
+        while (stageFlag > 1) {
+            stageFlag >>= 1;
+            ++index;
+        }
+        return index;
+    }
+}
+
+// Slot value used for stages where a binding is not referenced
+constexpr UINT INVALID_BINDING_SLOT = 0xFFFFFFFF;
+
+// A single variable inside a constant buffer, as seen by the shader
+struct ShaderConstantBufferMember {
+    std::string name;
+    UINT offset = 0;
+    UINT size = 0;
+};
+
+// A constant buffer declared by one or more stages of a shader program.
+// The same cbuffer name can live in different slots per stage, so slots are stored per stage.
+struct ShaderConstantBufferBinding {
+    std::string name;
+    UINT size = 0;
+    UINT stages = 0;
+    std::array<UINT, ShaderStage::Count> slots;
+    std::vector<ShaderConstantBufferMember> members;
+
+    ShaderConstantBufferBinding() { slots.fill(INVALID_BINDING_SLOT); }
+};
+
+// A texture/buffer SRV, sampler or UAV declared by one or more stages of a shader program
+struct ShaderResourceBinding {
+    std::string name;
+    D3D_SHADER_INPUT_TYPE type = D3D_SIT_TEXTURE;
+    UINT bindCount = 1;
+    UINT stages = 0;
+    std::array<UINT, ShaderStage::Count> slots;
+
+    ShaderResourceBinding() { slots.fill(INVALID_BINDING_SLOT); }
+};
+
+// Compact description of everything a shader program binds, produced once by reflecting
+// the compiled bytecode and serialized next to it in the shader cache.
+//
+// At runtime the Shader class resolves names against this layout only at setup time
+// (buffer creation, resource assignment); per-frame binding walks these tables by index.
+struct ShaderBindingLayout {
+    std::vector<ShaderConstantBufferBinding> constantBuffers;
+    std::vector<ShaderResourceBinding> shaderResources;
+    std::vector<ShaderResourceBinding> samplers;
+    std::vector<ShaderResourceBinding> unorderedAccessViews;
+
+    // Returns the index of the named binding or -1 if the program doesn't declare it
+    int FindConstantBuffer(const std::string& name) const;
+    int FindShaderResource(const std::string& name) const;
+    int FindSampler(const std::string& name) const;
+    int FindUnorderedAccessView(const std::string& name) const;
+
+    // Merges the bindings of another (usually single stage) layout into this one.
+    // Returns false if the same constant buffer is declared with different sizes across stages.
+    bool Merge(const ShaderBindingLayout& other);
+
+    void Clear();
+};
+
+namespace ShaderReflection {
+    // Reflects compiled bytecode of a single stage and fills the layout with its bindings
+    bool ReflectStage(const void* bytecode, size_t bytecodeSize, UINT stageFlag, ShaderBindingLayout& layout);
+
+    // Binary (de)serialization of a layout, used by the shader cache
+    void Serialize(const ShaderBindingLayout& layout, std::vector<uint8_t>& output);
+    bool Deserialize(const uint8_t* data, size_t dataSize, ShaderBindingLayout& layout);
+}
+
+#endif // !SHADER_REFLECTION_H
@@ -0,0 +1,159 @@
+#include "Texture.h"
+
+#include <vector>
+
+#include "../assets/BlockCompression.h"
+#include "../assets/CookedTexture.h"
+#include "../assets/TextureLoader.h"
+#include "../utils/ConsoleLogger.h"
+
+
+namespace {
+    DXGI_FORMAT GetBlockFormat(BlockFormat format, bool sRGB) {
+        switch (format) {
+        case BlockFormat::BC1:
+            return sRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+        case BlockFormat::BC3:
+            return sRGB ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+        case BlockFormat::BC4:
+            return DXGI_FORMAT_BC4_UNORM;
+        case BlockFormat::BC5:
+            return DXGI_FORMAT_BC5_UNORM;
+        case BlockFormat::BC7:
+            return sRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+        case BlockFormat::RGBA8:
+            return sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+        }
+        return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+bool Texture::Initialize(ID3D11Device* device, const DecodedImage& image, bool sRGB) {
+    Release();
+    if (!image.IsValid()) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to create texture ", image.id, ": the image failed to decode.");
+        return false;
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = image.width;
+    desc.Height = image.height;
+    desc.MipLevels = image.levelCount;
+    desc.ArraySize = 1;
+    desc.Format = sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    // The pixels are read from the staging memory during the call, the image can be dropped right after
+    std::vector<D3D11_SUBRESOURCE_DATA> levels(image.levelCount);
+    for (uint32_t level = 0; level < image.levelCount; ++level) {
+        levels[level].pSysMem = image.pixels.get() + image.GetLevelOffset(level);
+        levels[level].SysMemPitch = image.GetRowPitch(level);
+    }
+
+    if (FAILED(device->CreateTexture2D(&desc, levels.data(), &m_texture)) ||
+        FAILED(device->CreateShaderResourceView(m_texture.Get(), nullptr, &m_shaderResourceView))) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to create texture ", image.id, " (", image.width, "x", image.height, ").");
+        Release();
+        return false;
+    }
+    m_width = image.width;
+    m_height = image.height;
+    return true;
+}
+
+bool Texture::Initialize(ID3D11Device* device, const CompressedImage& image) {
+    Release();
+    if (!image.IsValid()) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to create texture ", image.id, ": the image failed to compress.");
+        return false;
+    }
+    if (image.IsBlockCompressed() && (image.width % 4 != 0 || image.height % 4 != 0)) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to create texture ", image.id, ": BCn textures need a size multiple of 4, not ",
+            image.width, "x", image.height, ".");
+        return false;
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = image.width;
+    desc.Height = image.height;
+    desc.MipLevels = image.levelCount;
+    desc.ArraySize = 1;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.Format = GetBlockFormat(image.format, image.sRGB);
+
+    // Pitches are per row of blocks, of texels for RGBA8
+    std::vector<D3D11_SUBRESOURCE_DATA> levels(image.levelCount);
+    for (uint32_t level = 0; level < image.levelCount; ++level) {
+        levels[level].pSysMem = image.data.get() + image.GetLevelOffset(level);
+        levels[level].SysMemPitch = image.GetRowPitch(level);
+    }
+
+    if (FAILED(device->CreateTexture2D(&desc, levels.data(), &m_texture)) ||
+        FAILED(device->CreateShaderResourceView(m_texture.Get(), nullptr, &m_shaderResourceView))) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to create ", BlockCompression::GetFormatName(image.format), " texture ", image.id,
+            " (", image.width, "x", image.height, ").");
+        Release();
+        return false;
+    }
+    m_width = image.width;
+    m_height = image.height;
+    return true;
+}
+
+bool Texture::Initialize(ID3D11Device* device, const CookedTextureFile& file, uint32_t firstLevel) {
+    Release();
+    if (!file.IsLoaded() || firstLevel >= file.GetLevelCount()) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to create texture ", file.GetFilePath(), ": the file isn't loaded or has no level ",
+            firstLevel, ".");
+        return false;
+    }
+
+    const CookedTextureLevelView& top = file.GetLevel(firstLevel);
+    if (firstLevel > file.GetMaxFirstLevel()) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to create texture ", file.GetFilePath(), " from level ", firstLevel,
+            ": BCn textures need a size multiple of 4, not ", top.width, "x", top.height, ".");
+        return false;
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = top.width;
+    desc.Height = top.height;
+    desc.MipLevels = file.GetLevelCount() - firstLevel;
+    desc.ArraySize = file.GetLayerCount();
+    desc.Format = GetBlockFormat(file.GetFormat(), file.IsSRGB());
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    // Straight from the mapping, the driver reads the pages it needs during the call
+    std::vector<D3D11_SUBRESOURCE_DATA> levels(size_t(desc.MipLevels) * desc.ArraySize);
+    for (uint32_t layer = 0; layer < desc.ArraySize; ++layer) {
+        for (uint32_t level = 0; level < desc.MipLevels; ++level) {
+            const CookedTextureLevelView& view = file.GetLevel(firstLevel + level, layer);
+            levels[level + layer * desc.MipLevels].pSysMem = view.data;
+            levels[level + layer * desc.MipLevels].SysMemPitch = view.rowPitch;
+        }
+    }
+
+    if (FAILED(device->CreateTexture2D(&desc, levels.data(), &m_texture)) ||
+        FAILED(device->CreateShaderResourceView(m_texture.Get(), nullptr, &m_shaderResourceView))) {
+        ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to create texture ", file.GetFilePath(), " (",
+            BlockCompression::GetFormatName(file.GetFormat()), ", ", top.width, "x", top.height, ").");
+        Release();
+        return false;
+    }
+    m_width = top.width;
+    m_height = top.height;
+    return true;
+}
+
+void Texture::Release() {
+    m_shaderResourceView.Reset();
+    m_texture.Reset();
+    m_width = 0;
+    m_height = 0;
+}
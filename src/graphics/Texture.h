@@ -0,0 +1,44 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <cstdint>
+
+class CookedTextureFile;
+struct CompressedImage;
+struct DecodedImage;
+
+
+// A 2D texture sampled by shaders, with its shader resource view
+class Texture {
+    public:
+        Texture() = default;
+        ~Texture() = default;
+
+        // Creates an immutable RGBA8 texture from an image decoded by the TextureLoader, on the render thread,
+        // with every mip level the image has (see MipGenerator). Color textures are sRGB, data textures
+        // (normals, roughness...) aren't. Logs and returns false on failure.
+        bool Initialize(ID3D11Device* device, const DecodedImage& image, bool sRGB = true);
+        // Creates an immutable texture in the BCn format of a compressed image (see BlockCompression),
+        // sRGB if the image was compressed as color. Logs and returns false on failure.
+        bool Initialize(ID3D11Device* device, const CompressedImage& image);
+        // Creates an immutable texture from a cooked file, every subresource read from the mapping without
+        // a copy. The file can be closed right after. Levels before `firstLevel` are left out, the texture
+        // then starts at a smaller size (see TextureStreamer). Logs and returns false on failure.
+        bool Initialize(ID3D11Device* device, const CookedTextureFile& file, uint32_t firstLevel = 0);
+        void Release();
+
+        ID3D11Texture2D* GetTexture() const { return m_texture.Get(); }
+        ID3D11ShaderResourceView* GetShaderResourceView() const { return m_shaderResourceView.Get(); }
+        uint32_t GetWidth() const { return m_width; }
+        uint32_t GetHeight() const { return m_height; }
+
+    private:
+        Microsoft::WRL::ComPtr<ID3D11Texture2D> m_texture;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_shaderResourceView;
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+};
+
+#endif // !TEXTURE_H
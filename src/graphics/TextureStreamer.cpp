@@ -0,0 +1,257 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "MemoryBudget.h"
+#include "../assets/CookedTexture.h"
+#include "../utils/ConsoleLogger.h"
+#include "../utils/ThreadPool.h"
+
+
+TextureStreamer::TextureStreamer(ThreadPool& threadPool, const TextureStreamerSettings& settings)
+    : m_threadPool(threadPool), m_settings(settings) {
+}
+
+TextureStreamer::~TextureStreamer() {
+    for (StreamedTexture& texture : m_textures) {
+        if (IsLoading(texture))
+            texture.load.wait();
+    }
+    if (m_memoryBudget != nullptr)
+        m_memoryBudget->TrackRelease(MemoryCategory::Textures, m_stats.residentBytes);
+}
+
+StreamedTextureId TextureStreamer::Register(ID3D11Device* device, const std::string& cookedPath) {
+    auto file = std::make_unique<CookedTextureFile>();
+    if (!file->Load(cookedPath))
+        return INVALID_STREAMED_TEXTURE;
+
+    StreamedTexture texture;
+    // The deepest level a BCn texture can start at bounds the tail, the levels below it can't be evicted
+    texture.tailLevel = file->GetMaxFirstLevel();
+    for (uint32_t level = 0; level < texture.tailLevel; ++level) {
+        if (std::max(file->GetLevel(level).width, file->GetLevel(level).height) <= m_settings.tailSize) {
+            texture.tailLevel = level;
+            break;
+        }
+    }
+    texture.file = std::move(file);
+    texture.wantedLevel = texture.tailLevel;
+    texture.lastRequestUpdate = m_updateIndex;
+    if (!MakeResident(device, texture, texture.tailLevel))
+        return INVALID_STREAMED_TEXTURE;
+
+    StreamedTextureId id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+        m_textures[id] = std::move(texture);
+    }
+    else {
+        id = static_cast<StreamedTextureId>(m_textures.size());
+        m_textures.push_back(std::move(texture));
+    }
+    ++m_stats.textureCount;
+    return id;
+}
+
+void TextureStreamer::Unregister(StreamedTextureId id) {
+    if (id >= m_textures.size() || m_textures[id].file == nullptr)
+        return;
+
+    StreamedTexture& texture = m_textures[id];
+    // The load reads the mapping
+    if (IsLoading(texture))
+        texture.load.wait();
+    const size_t residentSize = GetResidentSize(*texture.file, texture.residentLevel);
+    m_stats.residentBytes -= residentSize;
+    if (m_memoryBudget != nullptr)
+        m_memoryBudget->TrackRelease(MemoryCategory::Textures, residentSize);
+    texture = StreamedTexture();
+    m_freeIds.push_back(id);
+    --m_stats.textureCount;
+}
+
+void TextureStreamer::RequestLevel(StreamedTextureId id, float level) {
+    if (id < m_textures.size())
+        m_textures[id].requestedLevel = std::min(m_textures[id].requestedLevel, level);
+}
+
+void TextureStreamer::RequestLevel(StreamedTextureId id, float uvDensity, float distance, float projectionScale) {
+    if (id >= m_textures.size() || m_textures[id].file == nullptr)
+        return;
+    const CookedTextureLevelView& top = m_textures[id].file->GetLevel(0);
+    RequestLevel(id, ComputeRequiredLevel(top.width, top.height, uvDensity, distance, projectionScale));
+}
+
+void TextureStreamer::Update(ID3D11Device* device) {
+    ++m_updateIndex;
+    m_stats.uploads = 0;
+    m_stats.evictions = 0;
+
+    // Requests to wanted levels
+    std::vector<StreamedTexture*> finishedLoads;
+    for (StreamedTexture& texture : m_textures) {
+        if (texture.file == nullptr)
+            continue;
+        if (texture.requestedLevel != FLT_MAX) {
+            texture.wantedLevel = std::min(static_cast<uint32_t>(std::max(texture.requestedLevel, 0.0f)), texture.tailLevel);
+            texture.lastRequestUpdate = m_updateIndex;
+            texture.requestedLevel = FLT_MAX;
+        }
+        else if (m_updateIndex - texture.lastRequestUpdate > m_settings.unusedUpdateCount) {
+            texture.wantedLevel = texture.tailLevel;
+        }
+        if (IsLoading(texture) && texture.load.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            finishedLoads.push_back(&texture);
+    }
+
+    // Uploads, the most recently requested textures first. The others stay paged in for the next updates.
+    std::sort(finishedLoads.begin(), finishedLoads.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+        return a->lastRequestUpdate > b->lastRequestUpdate;
+    });
+    finishedLoads.resize(std::min<size_t>(finishedLoads.size(), m_settings.maxUploadsPerUpdate));
+    for (StreamedTexture* texture : finishedLoads) {
+        texture->load.get();
+        // The texture may want fewer levels than when the load started
+        uint32_t level = std::max(texture->loadingLevel, texture->wantedLevel);
+        if (level >= texture->residentLevel)
+            continue;
+        size_t bytes = GetResidentSize(*texture->file, level) - GetResidentSize(*texture->file, texture->residentLevel);
+        if (!MakeRoom(device, bytes, texture)) {
+            texture->retryUpdate = m_updateIndex + m_settings.retryUpdateCount;
+            continue;
+        }
+        if (MakeResident(device, *texture, level))
+            ++m_stats.uploads;
+    }
+
+    // The budget may have been lowered
+    MakeRoom(device, 0, nullptr);
+
+    // New loads, the most recently requested textures and the ones missing the most levels first
+    std::vector<StreamedTexture*> missingLevels;
+    size_t pendingLoads = 0;
+    for (StreamedTexture& texture : m_textures) {
+        if (texture.file == nullptr)
+            continue;
+        if (IsLoading(texture))
+            ++pendingLoads;
+        else if (texture.wantedLevel < texture.residentLevel && m_updateIndex >= texture.retryUpdate)
+            missingLevels.push_back(&texture);
+    }
+    std::sort(missingLevels.begin(), missingLevels.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+        if (a->lastRequestUpdate != b->lastRequestUpdate)
+            return a->lastRequestUpdate > b->lastRequestUpdate;
+        return a->residentLevel - a->wantedLevel > b->residentLevel - b->wantedLevel;
+    });
+    for (StreamedTexture* texture : missingLevels) {
+        if (pendingLoads >= m_settings.maxPendingLoads)
+            break;
+        const CookedTextureFile* file = texture->file.get();
+        const uint32_t firstLevel = texture->wantedLevel;
+        const uint32_t endLevel = texture->residentLevel;
+        texture->loadingLevel = firstLevel;
+        texture->load = m_threadPool.Submit([file, firstLevel, endLevel]() { file->PageIn(firstLevel, endLevel); });
+        ++pendingLoads;
+    }
+
+    m_stats.pendingLoads = pendingLoads;
+    m_stats.requestedBytes = 0;
+    for (const StreamedTexture& texture : m_textures) {
+        if (texture.file != nullptr)
+            m_stats.requestedBytes += GetResidentSize(*texture.file, texture.wantedLevel);
+    }
+}
+
+bool TextureStreamer::MakeRoom(ID3D11Device* device, size_t bytes, const StreamedTexture* requester) {
+    while (m_stats.residentBytes + bytes > m_settings.budgetBytes) {
+        // Levels nobody wants first, then the least recently requested textures, the largest first
+        StreamedTexture* victim = nullptr;
+        bool victimHasExcess = false;
+        for (StreamedTexture& texture : m_textures) {
+            if (texture.file == nullptr || &texture == requester || texture.residentLevel >= texture.tailLevel)
+                continue;
+            const bool hasExcess = texture.residentLevel < texture.wantedLevel;
+            if (!hasExcess && requester != nullptr && texture.lastRequestUpdate >= requester->lastRequestUpdate)
+                continue;
+            bool better = victim == nullptr;
+            if (!better && hasExcess != victimHasExcess)
+                better = hasExcess;
+            else if (!better && texture.lastRequestUpdate != victim->lastRequestUpdate)
+                better = texture.lastRequestUpdate < victim->lastRequestUpdate;
+            else if (!better)
+                better = texture.residentLevel < victim->residentLevel;
+            if (better) {
+                victim = &texture;
+                victimHasExcess = hasExcess;
+            }
+        }
+        if (victim == nullptr)
+            return false;
+
+        uint32_t level = victimHasExcess ? victim->wantedLevel : victim->residentLevel + 1;
+        if (!MakeResident(device, *victim, level))
+            return false;
+        ++m_stats.evictions;
+    }
+    return true;
+}
+
+bool TextureStreamer::MakeResident(ID3D11Device* device, StreamedTexture& texture, uint32_t level) {
+    // The new texture is complete before the old one is released, a failure keeps the resident levels
+    Texture resident;
+    if (!resident.Initialize(device, *texture.file, level))
+        return false;
+
+    const size_t previousSize = texture.texture.GetTexture() != nullptr ? GetResidentSize(*texture.file, texture.residentLevel) : 0;
+    const size_t residentSize = GetResidentSize(*texture.file, level);
+    m_stats.residentBytes = m_stats.residentBytes - previousSize + residentSize;
+    if (m_memoryBudget != nullptr) {
+        m_memoryBudget->TrackAllocation(MemoryCategory::Textures, residentSize);
+        m_memoryBudget->TrackRelease(MemoryCategory::Textures, previousSize);
+    }
+    texture.texture = resident;
+    texture.residentLevel = level;
+    return true;
+}
+
+size_t TextureStreamer::Trim(ID3D11Device* device, size_t bytes) {
+    const size_t residentBytes = m_stats.residentBytes;
+    m_settings.budgetBytes = residentBytes - std::min(residentBytes, bytes);
+    MakeRoom(device, 0, nullptr);
+    // What the tails kept over the budget
+    m_settings.budgetBytes = std::max(m_settings.budgetBytes, m_stats.residentBytes);
+    return residentBytes - m_stats.residentBytes;
+}
+
+size_t TextureStreamer::GetResidentSize(const CookedTextureFile& file, uint32_t level) {
+    size_t size = 0;
+    for (uint32_t layer = 0; layer < file.GetLayerCount(); ++layer) {
+        for (uint32_t i = level; i < file.GetLevelCount(); ++i)
+            size += file.GetLevel(i, layer).size;
+    }
+    return size;
+}
+
+ID3D11ShaderResourceView* TextureStreamer::GetShaderResourceView(StreamedTextureId id) const {
+    if (id >= m_textures.size() || m_textures[id].file == nullptr)
+        return nullptr;
+    return m_textures[id].texture.GetShaderResourceView();
+}
+
+uint32_t TextureStreamer::GetResidentLevel(StreamedTextureId id) const {
+    if (id >= m_textures.size() || m_textures[id].file == nullptr)
+        return UINT32_MAX;
+    return m_textures[id].residentLevel;
+}
+
+float TextureStreamer::ComputeRequiredLevel(uint32_t width, uint32_t height, float uvDensity, float distance, float projectionScale) {
+    // Texels of the top level per pixel along the largest side, each level halves it
+    const float texelsPerWorldUnit = uvDensity * static_cast<float>(std::max(width, height));
+    const float pixelsPerWorldUnit = projectionScale / std::max(distance, 1e-4f);
+    const float texelsPerPixel = texelsPerWorldUnit / pixelsPerWorldUnit;
+    return texelsPerPixel > 1.0f ? std::log2(texelsPerPixel) : 0.0f;
+}
@@ -0,0 +1,135 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <d3d11.h>
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Texture.h"
+
+class CookedTextureFile;
+class MemoryBudget;
+class ThreadPool;
+
+
+// Index of a texture in its streamer, stable until it's unregistered
+using StreamedTextureId = uint32_t;
+constexpr StreamedTextureId INVALID_STREAMED_TEXTURE = UINT32_MAX;
+
+struct TextureStreamerSettings {
+    // GPU memory of the resident levels of every texture, mip tails included
+    size_t budgetBytes = size_t(256) << 20;
+    // Levels this size or smaller (largest side, in texels) are the tail, uploaded at registration and never evicted.
+    // The tail starts higher when the smaller levels aren't multiples of 4, see CookedTextureFile::GetMaxFirstLevel.
+    uint32_t tailSize = 64;
+    // Loads in flight on the workers, and finished loads uploaded per Update
+    uint32_t maxPendingLoads = 8;
+    uint32_t maxUploadsPerUpdate = 4;
+    // A texture not requested for this many updates only needs its tail
+    uint32_t unusedUpdateCount = 120;
+    // Updates before a load that didn't fit in the budget is tried again
+    uint32_t retryUpdateCount = 30;
+};
+
+struct TextureStreamerStats {
+    size_t textureCount = 0;
+    size_t residentBytes = 0;
+    size_t requestedBytes = 0;  // If every texture had the levels it was requested with
+    size_t pendingLoads = 0;
+    // During the last Update
+    size_t uploads = 0;
+    size_t evictions = 0;
+};
+
+// Streams the mips of cooked textures (see CookedTexture.h) under a memory budget.
+//
+// Every texture keeps its file mapped and its tail resident. The visibility pass reports the level each
+// visible draw needs with RequestLevel, from the UV density of its part, its distance and the projection;
+// once per frame Update turns the requests into wanted levels. Missing levels are paged in from the
+// mapping by a worker, then the render thread recreates the texture with the finer levels straight from
+// the mapping: D3D11 can't change the mip count of a texture, and an immutable texture costs no copy.
+// Room is made by evicting first the levels nobody asks for anymore, then the least recently requested
+// textures one level at a time.
+class TextureStreamer {
+    public:
+        explicit TextureStreamer(ThreadPool& threadPool, const TextureStreamerSettings& settings = TextureStreamerSettings());
+        // Waits for the loads in flight, they read the mappings
+        ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        // Maps a cooked texture and uploads its tail. Logs and returns INVALID_STREAMED_TEXTURE on failure.
+        StreamedTextureId Register(ID3D11Device* device, const std::string& cookedPath);
+        // Releases the texture and closes its file, the id can be given to another texture
+        void Unregister(StreamedTextureId id);
+
+        // Asks for a level (0 is the largest, fractions round to the finer level) until the next Update,
+        // the finest level requested wins
+        void RequestLevel(StreamedTextureId id, float level);
+        // Asks for the level a draw of a part needs, see ComputeRequiredLevel
+        void RequestLevel(StreamedTextureId id, float uvDensity, float distance, float projectionScale);
+        // Once per frame on the render thread: uploads finished loads, evicts to stay in the budget and
+        // starts the loads of the levels requested since the last update
+        void Update(ID3D11Device* device);
+
+        // Changes the budget, levels over it are evicted on the next Update
+        void SetBudget(size_t budgetBytes) { m_settings.budgetBytes = budgetBytes; }
+        size_t GetBudget() const { return m_settings.budgetBytes; }
+        // Evicts at least `bytes` right away if it can, tails excepted, and lowers the budget to what's left.
+        // Returns the bytes evicted. Made for the eviction callbacks of a MemoryBudget.
+        size_t Trim(ID3D11Device* device, size_t bytes);
+        // Tracks the resident levels as textures, set it before registering anything
+        void SetMemoryBudget(MemoryBudget* memoryBudget) { m_memoryBudget = memoryBudget; }
+
+        // Null for ids that aren't registered. The view changes whenever the resident levels do, bind it every frame.
+        ID3D11ShaderResourceView* GetShaderResourceView(StreamedTextureId id) const;
+        // Finest level in GPU memory, or UINT32_MAX for ids that aren't registered
+        uint32_t GetResidentLevel(StreamedTextureId id) const;
+        const TextureStreamerStats& GetStats() const { return m_stats; }
+
+        // Level a draw needs for a texture of `width` x `height`: its UVs cover `uvDensity` UV units per world unit
+        // (MeshPartView::uvDensity), at `distance` world units from a camera whose projection covers `projectionScale`
+        // pixels per world unit at a distance of 1 (viewport height / (2 tan(fovY / 2)))
+        static float ComputeRequiredLevel(uint32_t width, uint32_t height, float uvDensity, float distance, float projectionScale);
+
+    private:
+        struct StreamedTexture {
+            std::unique_ptr<CookedTextureFile> file;  // Null for free slots
+            Texture texture;
+            uint32_t tailLevel = 0;       // First level of the tail
+            uint32_t residentLevel = 0;   // First level in GPU memory
+            uint32_t wantedLevel = 0;     // From the requests
+            float requestedLevel = FLT_MAX;  // Finest request since the last Update, FLT_MAX if none
+            uint64_t lastRequestUpdate = 0;
+            uint64_t retryUpdate = 0;     // No loads before this update
+            std::future<void> load;       // Pages in the levels from `loadingLevel`
+            uint32_t loadingLevel = 0;
+        };
+
+    private:
+        // Bytes of the levels from `level` to the last one
+        static size_t GetResidentSize(const CookedTextureFile& file, uint32_t level);
+        // Evicts until `bytes` more fit in the budget, never from `requester`. Only textures requested less
+        // recently than the requester, or holding levels they don't want, are evicted.
+        bool MakeRoom(ID3D11Device* device, size_t bytes, const StreamedTexture* requester);
+        // Recreates the texture with the levels from `level`
+        bool MakeResident(ID3D11Device* device, StreamedTexture& texture, uint32_t level);
+        bool IsLoading(const StreamedTexture& texture) const { return texture.load.valid(); }
+
+    private:
+        ThreadPool& m_threadPool;
+        TextureStreamerSettings m_settings;
+        TextureStreamerStats m_stats;
+        MemoryBudget* m_memoryBudget = nullptr;
+        std::vector<StreamedTexture> m_textures;
+        std::vector<StreamedTextureId> m_freeIds;
+        uint64_t m_updateIndex = 0;
+};
+
+#endif // !TEXTURE_STREAMER_H
@@ -0,0 +1,110 @@
+#include "VertexCompression.h"
+
+#include <DirectXPackedVector.h>
+#include <cfloat>
+
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+XMVECTOR XM_CALLCONV VertexCompression::OctahedralEncode(FXMVECTOR normal) {
+	// Project on the octahedron |x| + |y| + |z| = 1 (guarding against zero length vectors)
+	XMVECTOR l1Norm = XMVector3Dot(XMVectorAbs(normal), XMVectorSplatOne());
+	XMVECTOR projected = XMVectorDivide(normal, XMVectorMax(l1Norm, XMVectorReplicate(FLT_MIN)));
+
+	// Fold the lower hemisphere over the diagonals
+	XMVECTOR signs = XMVectorSelect(XMVectorNegate(XMVectorSplatOne()), XMVectorSplatOne(),
+		XMVectorGreaterOrEqual(projected, XMVectorZero()));
+	XMVECTOR folded = XMVectorMultiply(
+		XMVectorSubtract(XMVectorSplatOne(), XMVectorAbs(XMVectorSwizzle<1, 0, 2, 3>(projected))), signs);
+
+	XMVECTOR lowerHemisphere = XMVectorLess(XMVectorSplatZ(projected), XMVectorZero());
+	return XMVectorSelect(projected, folded, lowerHemisphere);
+}
+
+XMVECTOR XM_CALLCONV VertexCompression::OctahedralDecode(FXMVECTOR encoded) {
+	XMVECTOR absEncoded = XMVectorAbs(encoded);
+	XMVECTOR z = XMVectorSubtract(XMVectorSplatOne(), XMVectorAdd(XMVectorSplatX(absEncoded), XMVectorSplatY(absEncoded)));
+
+	// Unfold the lower hemisphere
+	XMVECTOR t = XMVectorSaturate(XMVectorNegate(z));
+	XMVECTOR offset = XMVectorSelect(t, XMVectorNegate(t), XMVectorGreaterOrEqual(encoded, XMVectorZero()));
+	XMVECTOR xy = XMVectorAdd(encoded, offset);
+
+	XMVECTOR normal = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_1Z, XM_PERMUTE_1W>(xy, z);
+	return XMVector3Normalize(normal);
+}
+
+MeshBounds VertexCompression::ComputeBounds(const CompleteVertexData* vertices, size_t vertexCount) {
+	MeshBounds bounds = {};
+	if (vertexCount == 0) {
+		return bounds;
+	}
+
+	XMVECTOR boundsMin = XMLoadFloat3(&vertices[0].vPosition);
+	XMVECTOR boundsMax = boundsMin;
+	for (size_t i = 1; i < vertexCount; ++i) {
+		XMVECTOR position = XMLoadFloat3(&vertices[i].vPosition);
+		boundsMin = XMVectorMin(boundsMin, position);
+		boundsMax = XMVectorMax(boundsMax, position);
+	}
+
+	XMStoreFloat3(&bounds.boundsMin, boundsMin);
+	XMStoreFloat3(&bounds.boundsExtent, XMVectorSubtract(boundsMax, boundsMin));
+	return bounds;
+}
+
+void VertexCompression::EncodeVertices(const CompleteVertexData* vertices, size_t vertexCount, const MeshBounds& bounds,
+	PackedVertexData* packedVertices) {
+	XMVECTOR boundsMin = XMLoadFloat3(&bounds.boundsMin);
+	XMVECTOR boundsExtent = XMLoadFloat3(&bounds.boundsExtent);
+	// Flat axes (e.g. a plane) get a zero scale, all their vertices decode to boundsMin
+	XMVECTOR inverseExtent = XMVectorSelect(XMVectorReciprocal(boundsExtent), XMVectorZero(),
+		XMVectorEqual(boundsExtent, XMVectorZero()));
+
+	for (size_t i = 0; i < vertexCount; ++i) {
+		const CompleteVertexData& vertex = vertices[i];
+		PackedVertexData& packed = packedVertices[i];
+
+		XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&vertex.vNormal));
+		// Gram-Schmidt so the tangent frame rebuilt on the GPU stays orthogonal
+		XMVECTOR tangent = XMLoadFloat3(&vertex.vTangent);
+		tangent = XMVector3Normalize(XMVectorSubtract(tangent, XMVectorMultiply(normal, XMVector3Dot(normal, tangent))));
+		XMVECTOR bitangent = XMLoadFloat3(&vertex.vBitangent);
+		XMVECTOR handedness = XMVectorLess(XMVector3Dot(XMVector3Cross(normal, tangent), bitangent), XMVectorZero());
+
+		XMVECTOR position = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&vertex.vPosition), boundsMin), inverseExtent);
+		position = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_0Z, XM_PERMUTE_1W>(position,
+			XMVectorSelect(XMVectorSplatOne(), XMVectorZero(), handedness));
+		XMStoreUShortN4(&packed.vPosition, position);
+
+		XMVECTOR normalTangent = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_1X, XM_PERMUTE_1Y>(
+			OctahedralEncode(normal), OctahedralEncode(tangent));
+		XMStoreShortN4(&packed.vNormalTangent, normalTangent);
+
+		XMStoreHalf2(&packed.vTexCoordinate, XMLoadFloat2(&vertex.vTexCoordinate));
+		XMStoreUByteN4(&packed.vColor, XMLoadFloat4(&vertex.vColor));
+	}
+}
+
+CompleteVertexData VertexCompression::DecodeVertex(const PackedVertexData& packedVertex, const MeshBounds& bounds) {
+	CompleteVertexData vertex = {};
+
+	XMVECTOR position = XMLoadUShortN4(&packedVertex.vPosition);
+	XMVECTOR handedness = XMVectorGreater(XMVectorSplatW(position), XMVectorReplicate(0.5f));
+	position = XMVectorMultiplyAdd(position, XMLoadFloat3(&bounds.boundsExtent), XMLoadFloat3(&bounds.boundsMin));
+	XMStoreFloat3(&vertex.vPosition, position);
+
+	XMVECTOR normalTangent = XMLoadShortN4(&packedVertex.vNormalTangent);
+	XMVECTOR normal = OctahedralDecode(normalTangent);
+	XMVECTOR tangent = OctahedralDecode(XMVectorSwizzle<2, 3, 0, 1>(normalTangent));
+	XMVECTOR bitangent = XMVector3Cross(normal, tangent);
+	bitangent = XMVectorSelect(XMVectorNegate(bitangent), bitangent, handedness);
+	XMStoreFloat3(&vertex.vNormal, normal);
+	XMStoreFloat3(&vertex.vTangent, tangent);
+	XMStoreFloat3(&vertex.vBitangent, bitangent);
+
+	XMStoreFloat2(&vertex.vTexCoordinate, XMLoadHalf2(&packedVertex.vTexCoordinate));
+	XMStoreFloat4(&vertex.vColor, XMLoadUByteN4(&packedVertex.vColor));
+	return vertex;
+}
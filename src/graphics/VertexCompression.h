@@ -0,0 +1,40 @@
+#ifndef VERTEX_COMPRESSION_H
+#define VERTEX_COMPRESSION_H
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+#include "VertexFormat.h"
+
+
+// Axis aligned bounds of a mesh, packed positions are stored relative to them.
+// The vertex shader needs `boundsMin` and `boundsExtent` to decode the positions, the padding
+// matches the HLSL packing rules so it can be uploaded as is to the MeshBoundsBuffer cbuffer.
+struct MeshBounds {
+	DirectX::XMFLOAT3 boundsMin;
+	float padding0;
+	DirectX::XMFLOAT3 boundsExtent;
+	float padding1;
+};
+
+// Import time encoders for PackedVertexData, the matching decoders for the GPU live in
+// resources/shaders/VertexCompression.hlsli. Everything runs on DirectXMath vectors, so the
+// quantization of every attribute is done with SIMD instructions.
+namespace VertexCompression {
+	// Computes the bounds used to quantize the positions of the vertices
+	MeshBounds ComputeBounds(const CompleteVertexData* vertices, size_t vertexCount);
+
+	// Packs the vertices, `packedVertices` must have room for `vertexCount` elements.
+	// Normals and tangents are expected to be normalized, the bitangent is only used to get the handedness.
+	void EncodeVertices(const CompleteVertexData* vertices, size_t vertexCount, const MeshBounds& bounds,
+		PackedVertexData* packedVertices);
+
+	// CPU decoder, mirrors the HLSL one. Used to validate the encoding and for CPU side processing.
+	CompleteVertexData DecodeVertex(const PackedVertexData& packedVertex, const MeshBounds& bounds);
+
+	// Octahedral mapping of a unit vector to [-1, 1]^2 (result in x and y) and its inverse
+	DirectX::XMVECTOR XM_CALLCONV OctahedralEncode(DirectX::FXMVECTOR normal);
+	DirectX::XMVECTOR XM_CALLCONV OctahedralDecode(DirectX::FXMVECTOR encoded);
+}
+
+#endif // !VERTEX_COMPRESSION_H
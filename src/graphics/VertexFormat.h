@@ -2,6 +2,9 @@
 #define VERTEX_FORMAT_H
 
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+#include "VertexLayout.h"
 
 // This is a self implementation of the next file from the Adria-DX11 Engine
 // https://github.com/mateeeeeee/Adria-DX11/blob/master/Adria/Graphics/GfxVertexFormat.h
@@ -52,6 +55,126 @@ struct CompleteVertexData {
 	DirectX::XMFLOAT3 vBitangent;
 };
 
+// Everything but the position of CompleteVertexData. Meshes store it as a second vertex stream so
+// passes that only need positions (depth prepass, shadows) don't fetch it, see Mesh.h.
+// The position stream uses SimpleVertexData.
+struct CompleteAttributeData {
+	DirectX::XMFLOAT4 vColor;
+	DirectX::XMFLOAT3 vNormal;
+	DirectX::XMFLOAT2 vTexCoordinate;
+	DirectX::XMFLOAT3 vTangent;
+	DirectX::XMFLOAT3 vBitangent;
+};
+
+// Compressed vertex for large meshes, 24 bytes instead of the 72 of CompleteVertexData.
+// Encoded at import time by VertexCompression and decoded in the vertex shader (VertexCompression.hlsli):
+// - Position: 16-bit UNORM relative to the mesh AABB, w holds the tangent handedness (0 = -1, 1 = +1)
+// - Normal and tangent: octahedral encoded as 16-bit SNORM (normal.xy, tangent.xy), the bitangent is
+//   rebuilt as cross(normal, tangent) * handedness
+// - Texture coordinates: half floats
+// - Color: UNORM8
+struct PackedVertexData {
+	DirectX::PackedVector::XMUSHORTN4 vPosition;
+	DirectX::PackedVector::XMSHORTN4 vNormalTangent;
+	DirectX::PackedVector::XMHALF2 vTexCoordinate;
+	DirectX::PackedVector::XMUBYTEN4 vColor;
+};
+static_assert(sizeof(PackedVertexData) == 24, "PackedVertexData must stay at 24 bytes");
+
+/// Attribute descriptions of the vertex formats, see VertexLayout.h
+// Keep them next to their struct: VertexLayout<T> static_asserts that both stay in sync.
+
+template <>
+struct VertexTraits<SimpleVertexData> {
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(SimpleVertexData, vPosition, "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT)
+	};
+};
+
+template <>
+struct VertexTraits<ColoredVertexData> {
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(ColoredVertexData, vPosition, "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(ColoredVertexData, vColor, "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT)
+	};
+};
+
+template <>
+struct VertexTraits<ColoredNormalVertexData> {
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(ColoredNormalVertexData, vPosition, "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(ColoredNormalVertexData, vColor, "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT),
+		VERTEX_ATTRIBUTE(ColoredNormalVertexData, vNormal, "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT)
+	};
+};
+
+template <>
+struct VertexTraits<ColoredTexturedVertexData> {
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(ColoredTexturedVertexData, vPosition, "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(ColoredTexturedVertexData, vColor, "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT),
+		VERTEX_ATTRIBUTE(ColoredTexturedVertexData, vTexCoordinate, "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT)
+	};
+};
+
+template <>
+struct VertexTraits<TexturedVertexData> {
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(TexturedVertexData, vPosition, "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(TexturedVertexData, vTexCoordinate, "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT)
+	};
+};
+
+template <>
+struct VertexTraits<TexturedNormalVertexData> {
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(TexturedNormalVertexData, vPosition, "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(TexturedNormalVertexData, vTexCoordinate, "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT),
+		VERTEX_ATTRIBUTE(TexturedNormalVertexData, vNormal, "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT)
+	};
+};
+
+template <>
+struct VertexTraits<NormalVertexData> {
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(NormalVertexData, vPosition, "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(NormalVertexData, vNormal, "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT)
+	};
+};
+
+template <>
+struct VertexTraits<CompleteVertexData> {
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(CompleteVertexData, vPosition, "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(CompleteVertexData, vColor, "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT),
+		VERTEX_ATTRIBUTE(CompleteVertexData, vNormal, "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(CompleteVertexData, vTexCoordinate, "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT),
+		VERTEX_ATTRIBUTE(CompleteVertexData, vTangent, "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(CompleteVertexData, vBitangent, "BINORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT)
+	};
+};
+
+template <>
+struct VertexTraits<CompleteAttributeData> {
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(CompleteAttributeData, vColor, "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT),
+		VERTEX_ATTRIBUTE(CompleteAttributeData, vNormal, "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(CompleteAttributeData, vTexCoordinate, "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT),
+		VERTEX_ATTRIBUTE(CompleteAttributeData, vTangent, "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT),
+		VERTEX_ATTRIBUTE(CompleteAttributeData, vBitangent, "BINORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT)
+	};
+};
+
+template <>
+struct VertexTraits<PackedVertexData> {
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(PackedVertexData, vPosition, "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM),
+		VERTEX_ATTRIBUTE(PackedVertexData, vNormalTangent, "NORMAL", 0, DXGI_FORMAT_R16G16B16A16_SNORM),
+		VERTEX_ATTRIBUTE(PackedVertexData, vTexCoordinate, "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT),
+		VERTEX_ATTRIBUTE(PackedVertexData, vColor, "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM)
+	};
+};
+
 
 #endif // !VERTEX_FORMAT_H
 
@@ -0,0 +1,172 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <d3d11.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+#include "InputLayoutCache.h"
+
+
+// Compile-time vertex layout description.
+//
+// Every vertex struct declares a VertexTraits specialization listing its attributes (semantic,
+// format and the member they map to). VertexLayout turns that list into the
+// D3D11_INPUT_ELEMENT_DESC array, the stride and the input layout cache key, all as constant
+// expressions, and static_asserts that the list actually matches the struct: every format has
+// the size of its member, attributes don't overlap and every byte of the struct is covered.
+
+// A single vertex attribute as declared by VertexTraits
+struct VertexAttribute {
+	const char* semanticName;
+	UINT semanticIndex;
+	DXGI_FORMAT format;
+	UINT offset;
+	UINT size; // Size of the struct member, checked against the size of the format
+};
+
+// Declares an attribute bound to a member of a vertex struct
+#define VERTEX_ATTRIBUTE(VertexType, member, semantic, semanticIndex, format) \
+	VertexAttribute{ semantic, semanticIndex, format, static_cast<UINT>(offsetof(VertexType, member)), static_cast<UINT>(sizeof(VertexType::member)) }
+
+// Specialize it for every vertex struct with a `static constexpr VertexAttribute attributes[]` member
+template <typename VertexType>
+struct VertexTraits;
+
+// Size in bytes of the formats that can be used as vertex attributes, 0 if unsupported
+constexpr UINT GetVertexFormatSize(DXGI_FORMAT format) {
+	switch (format) {
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return 16;
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+		return 12;
+	case DXGI_FORMAT_R32G32_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R16G16B16A16_SNORM:
+	case DXGI_FORMAT_R16G16B16A16_UINT:
+		return 8;
+	case DXGI_FORMAT_R32_FLOAT:
+	case DXGI_FORMAT_R32_UINT:
+	case DXGI_FORMAT_R16G16_FLOAT:
+	case DXGI_FORMAT_R16G16_UNORM:
+	case DXGI_FORMAT_R16G16_SNORM:
+	case DXGI_FORMAT_R16G16_UINT:
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_SNORM:
+	case DXGI_FORMAT_R8G8B8A8_UINT:
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+		return 4;
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_R16_UNORM:
+	case DXGI_FORMAT_R16_UINT:
+	case DXGI_FORMAT_R8G8_UNORM:
+		return 2;
+	case DXGI_FORMAT_R8_UNORM:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+namespace VertexLayoutDetail {
+	template <size_t Count>
+	constexpr bool FormatsMatchMembers(const VertexAttribute (&attributes)[Count]) {
+		for (size_t i = 0; i < Count; ++i) {
+			if (GetVertexFormatSize(attributes[i].format) != attributes[i].size)
+				return false;
+		}
+		return true;
+	}
+
+	// Attributes must be declared in member order and must not overlap
+	template <size_t Count>
+	constexpr bool AttributesAreOrdered(const VertexAttribute (&attributes)[Count]) {
+		for (size_t i = 1; i < Count; ++i) {
+			if (attributes[i].offset < attributes[i - 1].offset + attributes[i - 1].size)
+				return false;
+		}
+		return true;
+	}
+
+	// Every byte of the struct must belong to an attribute, so a member can't be forgotten
+	template <size_t Count>
+	constexpr UINT CoveredSize(const VertexAttribute (&attributes)[Count]) {
+		UINT size = 0;
+		for (size_t i = 0; i < Count; ++i)
+			size += attributes[i].size;
+		return size;
+	}
+
+	template <size_t Count, size_t... Indices>
+	constexpr std::array<D3D11_INPUT_ELEMENT_DESC, Count> MakeElements(const VertexAttribute (&attributes)[Count], UINT inputSlot,
+		std::index_sequence<Indices...>) {
+		return { {
+			D3D11_INPUT_ELEMENT_DESC{ attributes[Indices].semanticName, attributes[Indices].semanticIndex, attributes[Indices].format,
+				inputSlot, attributes[Indices].offset, D3D11_INPUT_PER_VERTEX_DATA, 0 }...
+		} };
+	}
+}
+
+// Input layout of a vertex struct bound at the given input slot.
+//
+// Usage:
+//     using Layout = VertexLayout<ColoredTexturedVertexData>;
+//     shader.InitializeWithLayout<Layout>(device, desc);
+//     UINT stride = Layout::Stride;
+template <typename VertexType, UINT InputSlot = 0>
+struct VertexLayout {
+	using Traits = VertexTraits<VertexType>;
+
+	static constexpr UINT AttributeCount = static_cast<UINT>(std::size(Traits::attributes));
+	static constexpr UINT Stride = static_cast<UINT>(sizeof(VertexType));
+
+	static_assert(VertexLayoutDetail::FormatsMatchMembers(Traits::attributes),
+		"VertexTraits: an attribute format doesn't match the size of its struct member");
+	static_assert(VertexLayoutDetail::AttributesAreOrdered(Traits::attributes),
+		"VertexTraits: attributes must be declared in member order without overlapping");
+	static_assert(VertexLayoutDetail::CoveredSize(Traits::attributes) == sizeof(VertexType),
+		"VertexTraits: the attributes don't cover the whole vertex struct (missing member or padding)");
+
+	static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, AttributeCount> Elements =
+		VertexLayoutDetail::MakeElements(Traits::attributes, InputSlot, std::make_index_sequence<AttributeCount>{});
+
+	// Key used by the InputLayoutCache, equal to InputLayoutCache::HashElements(Elements)
+	static constexpr uint64_t Hash = InputLayoutCache::HashElements(Elements.data(), AttributeCount);
+};
+
+namespace VertexLayoutDetail {
+	template <size_t Count, typename... StreamLayouts>
+	constexpr std::array<D3D11_INPUT_ELEMENT_DESC, Count> ConcatElements() {
+		std::array<D3D11_INPUT_ELEMENT_DESC, Count> elements{};
+		size_t index = 0;
+		auto append = [&elements, &index](const auto& streamElements) {
+			for (size_t i = 0; i < streamElements.size(); ++i)
+				elements[index++] = streamElements[i];
+		};
+		(append(StreamLayouts::Elements), ...);
+		return elements;
+	}
+}
+
+// Input layout made of several vertex streams, each one a VertexLayout bound at its own input slot.
+//
+// Usage (positions in slot 0, the rest of the attributes in slot 1):
+//     using Layout = VertexStreamLayout<VertexLayout<SimpleVertexData, 0>, VertexLayout<CompleteAttributeData, 1>>;
+template <typename... StreamLayouts>
+struct VertexStreamLayout {
+	static constexpr UINT StreamCount = static_cast<UINT>(sizeof...(StreamLayouts));
+	static constexpr UINT AttributeCount = (StreamLayouts::AttributeCount + ...);
+
+	static constexpr std::array<UINT, sizeof...(StreamLayouts)> Strides = { StreamLayouts::Stride... };
+
+	static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, AttributeCount> Elements =
+		VertexLayoutDetail::ConcatElements<AttributeCount, StreamLayouts...>();
+
+	static constexpr uint64_t Hash = InputLayoutCache::HashElements(Elements.data(), AttributeCount);
+};
+
+#endif // !VERTEX_LAYOUT_H
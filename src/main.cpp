@@ -2,23 +2,40 @@
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
 
+#include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <chrono>
+#include <unordered_map>
 #include <d3dcompiler.h>
 
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_glfw.h>
 #include <imgui/backends/imgui_impl_dx11.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb/stb_image.h>
+#include "assets/BlockCompression.h"
+#include "assets/ContentStore.h"
+#include "assets/CookedMesh.h"
+#include "assets/CookedTexture.h"
+#include "assets/GltfAsset.h"
+#include "assets/GltfConversion.h"
+#include "assets/GltfImporter.h"
+#include "assets/MipGenerator.h"
+#include "assets/TextureLoader.h"
 
+#include "geometry/Meshlets.h"
+
+#include "graphics/AssetRegistry.h"
+#include "graphics/MemoryBudget.h"
 #include "graphics/RenderDeviceD3D11.h"
 #include "graphics/VertexFormat.h"
 #include "graphics/Shader.h"
+#include "graphics/Texture.h"
+#include "graphics/TextureStreamer.h"
 
 #include "utils/ConsoleLogger.h"
 #include "utils/FileSystem.h"
+#include "utils/ThreadPool.h"
 
 
 using namespace Microsoft::WRL;
@@ -160,6 +177,165 @@ void RenderImGuiPerformance() {
 	ImGui::End();
 }
 
+// Cooked textures of every scene, where the cooker puts them when run from resources/ like the engine
+const ContentStore contentStore("store");
+
+void RenderImGuiAssets(ThreadPool& threadPool) {
+	ImGui::Begin("Assets", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	// Runs on the main thread, the frame stalls until the results are logged
+	if (ImGui::Button("Benchmark Sponza import"))
+		GltfImporter::Benchmark("models/Sponza/glTF/Sponza.gltf", threadPool);
+	// Cooked with: Penumbra-Cooker models/Sponza/glTF/Sponza.gltf models/Sponza/Sponza.pmesh
+	if (ImGui::Button("Benchmark cooked Sponza load"))
+		CookedMeshFile::Benchmark("models/Sponza/Sponza.pmesh");
+	if (ImGui::Button("Benchmark Sponza texture decoding"))
+		TextureLoader::Benchmark("models/Sponza/glTF/Sponza.gltf");
+	// The cooker writes the textures of every scene to the content store, not next to the cooked mesh
+	if (ImGui::Button("Benchmark cooked Sponza texture load"))
+		CookedTextureFile::Benchmark(contentStore.GetRootDirectory());
+	if (ImGui::Button("Benchmark mip generation"))
+		MipGenerator::Benchmark(threadPool);
+	if (ImGui::Button("Benchmark block compression"))
+		BlockCompression::Benchmark(threadPool);
+	if (ImGui::Button("Benchmark accessor conversion"))
+		GltfConversion::Benchmark();
+	ImGui::End();
+}
+
+std::vector<StreamedTextureId> streamedTextures;
+int streamingBudgetMb = 256;
+// The cooked Sponza the textures are streamed for, and the streamed textures of the material of each of its meshes
+CookedMeshFile streamedScene;
+std::vector<std::vector<StreamedTextureId>> streamedMeshTextures;
+// Camera of the visibility pass, in glTF space (Y up)
+DirectX::XMFLOAT3 streamingCameraPosition = { 0.0f, 2.0f, 0.0f };
+float streamingCameraYaw = 0.0f;  // Degrees, 0 looks down +X
+constexpr float STREAMING_CAMERA_FOV_Y = DirectX::XM_PIDIV4;
+size_t visibleStreamedMeshes = 0;
+
+void StopTextureStreaming(TextureStreamer& textureStreamer) {
+	for (StreamedTextureId id : streamedTextures)
+		textureStreamer.Unregister(id);
+	streamedTextures.clear();
+	streamedMeshTextures.clear();
+	streamedScene.Close();
+	visibleStreamedMeshes = 0;
+}
+
+void StartTextureStreaming(TextureStreamer& textureStreamer, ID3D11Device* device, ThreadPool& threadPool) {
+	// The cooked mesh keeps the material index of its meshes, the textures of the materials are in the glTF
+	GltfAsset asset;
+	if (!streamedScene.Load("models/Sponza/Sponza.pmesh") || !asset.Load("models/Sponza/glTF/Sponza.gltf", &threadPool)) {
+		StopTextureStreaming(textureStreamer);
+		return;
+	}
+	std::vector<std::optional<Hash128>> textureKeys;
+	ContentStore::ReadIndex(ContentStore::GetIndexPath("models/Sponza/Sponza.pmesh"), textureKeys);
+
+	// Images sharing a cooked texture are streamed once
+	std::unordered_map<std::string, StreamedTextureId> texturesByPath;
+	auto getTexture = [&](const GltfTextureInfo& info) {
+		if (info.texture >= asset.GetTextures().size())
+			return INVALID_STREAMED_TEXTURE;
+		const uint32_t image = asset.GetTextures()[info.texture].source;
+		if (image >= textureKeys.size() || !textureKeys[image].has_value())
+			return INVALID_STREAMED_TEXTURE;
+		const std::string texturePath = contentStore.GetPath(*textureKeys[image], ".ptex");
+		auto [texture, inserted] = texturesByPath.try_emplace(texturePath, INVALID_STREAMED_TEXTURE);
+		if (inserted) {
+			texture->second = textureStreamer.Register(device, texturePath);
+			if (texture->second != INVALID_STREAMED_TEXTURE)
+				streamedTextures.push_back(texture->second);
+		}
+		return texture->second;
+	};
+	for (const CookedMeshView& mesh : streamedScene.GetMeshes()) {
+		std::vector<StreamedTextureId>& meshTextures = streamedMeshTextures.emplace_back();
+		if (mesh.material >= asset.GetMaterials().size())
+			continue;
+		const GltfMaterial& material = asset.GetMaterials()[mesh.material];
+		for (const GltfTextureInfo* info : { &material.baseColorTexture, &material.metallicRoughnessTexture, &material.normalTexture,
+			&material.occlusionTexture, &material.emissiveTexture }) {
+			const StreamedTextureId id = getTexture(*info);
+			if (id != INVALID_STREAMED_TEXTURE)
+				meshTextures.push_back(id);
+		}
+	}
+	// Nothing to stream, the scene isn't kept
+	if (streamedTextures.empty())
+		StopTextureStreaming(textureStreamer);
+}
+
+// Visibility pass of the streamed scene: the meshes in the view frustum of the camera ask for the level every part needs
+// from its UV density, at the distance of the nearest point of their bounds
+void RequestVisibleTextureLevels(TextureStreamer& textureStreamer, float viewportWidth, float viewportHeight) {
+	const DirectX::XMVECTOR cameraPosition = DirectX::XMLoadFloat3(&streamingCameraPosition);
+	const float yaw = DirectX::XMConvertToRadians(streamingCameraYaw);
+	const DirectX::XMMATRIX view = DirectX::XMMatrixLookToLH(cameraPosition, DirectX::XMVectorSet(std::cos(yaw), 0.0f, std::sin(yaw), 0.0f),
+		DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(STREAMING_CAMERA_FOV_Y, viewportWidth / viewportHeight, 0.1f, 1000.0f);
+	const ViewFrustum frustum = Meshlets::ExtractFrustum(DirectX::XMMatrixMultiply(view, projection));
+	const float projectionScale = viewportHeight / (2.0f * std::tan(STREAMING_CAMERA_FOV_Y * 0.5f));
+
+	visibleStreamedMeshes = 0;
+	for (size_t i = 0; i < streamedScene.GetMeshCount(); ++i) {
+		const CookedMeshView& mesh = streamedScene.GetMesh(i);
+		if (streamedMeshTextures[i].empty() || !Meshlets::IsSphereVisible(frustum, mesh.bounds->center, mesh.bounds->radius))
+			continue;
+		++visibleStreamedMeshes;
+		const DirectX::XMVECTOR offset = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&mesh.bounds->center), cameraPosition);
+		const float distance = std::max(DirectX::XMVectorGetX(DirectX::XMVector3Length(offset)) - mesh.bounds->radius, 0.1f);
+		for (uint32_t part = 0; part < mesh.partCount; ++part) {
+			for (StreamedTextureId id : streamedMeshTextures[i])
+				textureStreamer.RequestLevel(id, mesh.parts[part].uvDensity, distance, projectionScale);
+		}
+	}
+}
+
+void RenderImGuiTextureStreaming(TextureStreamer& textureStreamer, ID3D11Device* device, ThreadPool& threadPool) {
+	ImGui::Begin("Texture Streaming", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	if (streamedTextures.empty()) {
+		if (ImGui::Button("Stream cooked Sponza textures"))
+			StartTextureStreaming(textureStreamer, device, threadPool);
+	}
+	else {
+		ImGui::DragFloat3("Camera position", &streamingCameraPosition.x, 0.1f);
+		ImGui::SliderFloat("Camera yaw", &streamingCameraYaw, -180.0f, 180.0f);
+		ImGui::Text("Visible meshes: %zu / %zu", visibleStreamedMeshes, streamedScene.GetMeshCount());
+		if (ImGui::Button("Stop streaming"))
+			StopTextureStreaming(textureStreamer);
+	}
+	if (ImGui::SliderInt("Budget (MB)", &streamingBudgetMb, 1, 1024))
+		textureStreamer.SetBudget(size_t(streamingBudgetMb) << 20);
+
+	const TextureStreamerStats& stats = textureStreamer.GetStats();
+	ImGui::Text("Textures: %zu, pending loads: %zu", stats.textureCount, stats.pendingLoads);
+	ImGui::Text("Resident: %.2f MB, requested: %.2f MB", stats.residentBytes / 1048576.0f, stats.requestedBytes / 1048576.0f);
+	ImGui::Text("Last update: %zu uploads, %zu evictions", stats.uploads, stats.evictions);
+	ImGui::End();
+}
+
+bool simulateBudget = false;
+int simulatedBudgetMb = 256;
+
+void RenderImGuiMemoryBudget(MemoryBudget& memoryBudget, DxgiMemoryBudgetSource& dxgiSource, FixedMemoryBudgetSource& simulatedSource) {
+	ImGui::Begin("Memory Budget", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	ImGui::Text("Budget: %llu MB, estimated usage: %llu MB", memoryBudget.GetBudget() >> 20, memoryBudget.GetEstimatedUsage() >> 20);
+	ImGui::Text("Tracked: textures %.2f MB, buffers %.2f MB, render targets %.2f MB",
+		memoryBudget.GetTrackedUsage(MemoryCategory::Textures) / 1048576.0,
+		memoryBudget.GetTrackedUsage(MemoryCategory::Buffers) / 1048576.0,
+		memoryBudget.GetTrackedUsage(MemoryCategory::RenderTargets) / 1048576.0);
+	ImGui::Text("Quality level: %u", memoryBudget.GetQualityLevel());
+	// The simulated usage is what the engine tracks, without the driver and the other allocations
+	if (ImGui::Checkbox("Simulate budget", &simulateBudget))
+		memoryBudget.SetSource(simulateBudget ? static_cast<MemoryBudgetSource*>(&simulatedSource) : &dxgiSource);
+	if (simulateBudget && ImGui::SliderInt("Simulated budget (MB)", &simulatedBudgetMb, 16, 2048))
+		simulatedSource.SetBudget(uint64_t(simulatedBudgetMb) << 20);
+	if (ImGui::Button("Run self-check"))
+		MemoryBudget::SelfCheck();
+	ImGui::End();
+}
+
 void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
 	// Store the new width and height, and mark the need to resize DirectX resources.
@@ -169,12 +345,12 @@ void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
 	}
 }
 
-void UpdateRotation(Shader& shader, ID3D11DeviceContext* context, float angle)
+void UpdateRotation(Shader& shader, ID3D11DeviceContext* context, int worldMatrixBufferIndex, float angle)
 {
 	DirectX::XMMATRIX worldMatrix = DirectX::XMMatrixRotationAxis(DirectX::FXMVECTOR{0.0f, 0.0f, 1.0f}, angle);
 	worldMatrix = DirectX::XMMatrixTranspose(worldMatrix); // Transpose for HLSL compatibility
 
-	shader.UpdateConstantBuffer(context, "WorldMatrixBuffer", &worldMatrix, sizeof(worldMatrix));
+	shader.UpdateConstantBuffer(context, worldMatrixBufferIndex, &worldMatrix, sizeof(worldMatrix));
 }
 
 int main() {
@@ -182,6 +358,14 @@ int main() {
 
 	FileSystem::setWorkingDirectory("resources");
 
+	// Workers for the import passes (conversion, welding, tangents, optimization)
+	ThreadPool threadPool;
+	// Textures decode on the workers, the tile texture while the window and the device are created
+	AssetRegistry assetRegistry(threadPool);
+	MipSettings tileMipSettings;
+	tileMipSettings.edgeMode = MipEdgeMode::Clamp;  // Matches the sampler
+	TextureHandle tileTexture = assetRegistry.LoadTexture("textures/tile_64x64.png", true, tileMipSettings);
+
 	glfwInit();
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -203,6 +387,20 @@ int main() {
 	/// How to render a colored quad in D3D11:
 	ID3D11Device* device = renderDevice->GetDevice(); // This is to call the creation of buffers with device->CreateBuffer() call
 	ID3D11DeviceContext* deviceContext = renderDevice->GetDeviceContext();
+	// GPU memory of the engine against the budget DXGI gives the process, or a simulated one to test memory pressure
+	DxgiMemoryBudgetSource dxgiBudgetSource(renderDevice->GetAdapter());
+	FixedMemoryBudgetSource simulatedBudgetSource(size_t(simulatedBudgetMb) << 20);
+	MemoryBudget memoryBudget(&dxgiBudgetSource);
+	renderDevice->SetMemoryBudget(&memoryBudget);
+	assetRegistry.SetMemoryBudget(&memoryBudget);
+	// Mips of the cooked textures paged in from their mappings on the workers
+	TextureStreamer textureStreamer(threadPool);
+	textureStreamer.SetMemoryBudget(&memoryBudget);
+	// Streamed mips go first under memory pressure, each quality level halves what the streamer may keep
+	memoryBudget.AddEvictionCallback([&](size_t bytes) { return textureStreamer.Trim(device, bytes); });
+	memoryBudget.AddQualityCallback([&](uint32_t qualityLevel) {
+		textureStreamer.SetBudget((size_t(streamingBudgetMb) << 20) >> qualityLevel);
+	});
 		/// First create the Vertex Buffer
 	// Declare the vertices and their data, in this case, vertex position and vertex colors
 	ColoredTexturedVertexData vertices[] = {
@@ -222,9 +420,10 @@ int main() {
 	vertexData.pSysMem = vertices;
 	// Create the vertex buffer
 	device->CreateBuffer(&vertexBufferDesc, &vertexData, &vertexBuffer);
+	memoryBudget.TrackAllocation(MemoryCategory::Buffers, vertexBufferDesc.ByteWidth);
 		/// Now let's create the index buffer
-	// We declare the indices here
-	uint32_t indices[] = {
+	// We declare the indices here, 16 bits are plenty for 4 vertices and take half the memory
+	uint16_t indices[] = {
 		0, 1, 2,
 		1, 3, 2 
 	};
@@ -238,79 +437,34 @@ int main() {
 	indexData.pSysMem = indices;
 	// Create the index buffer
 	device->CreateBuffer(&indexBufferDesc, &indexData, &indexBuffer);
+	memoryBudget.TrackAllocation(MemoryCategory::Buffers, indexBufferDesc.ByteWidth);
 
 		/// Here we create a shader and initialize it!
-	// Example input layout (this should match your vertex structure)
-	D3D11_INPUT_ELEMENT_DESC layout[] = {
-		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-		{"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-		{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}  // Texture Coordinates
-	};
-	UINT numElements = ARRAYSIZE(layout);
+	// The input layout comes from the VertexTraits of the vertex struct (see VertexFormat.h),
+	// so it's generated and validated at compile time instead of being written by hand
+	using QuadVertexLayout = VertexLayout<ColoredTexturedVertexData>;
 
 	SHADER_DESC shaderDesc = {};
 	shaderDesc.vertexShaderPath = L"shaders/ColoredTexturedVertex_vs.hlsl";
 	shaderDesc.pixelShaderPath = L"shaders/ColoredTexturedVertex_ps.hlsl";
 	
 	Shader shaderTest;
-	shaderTest.Initialize(device, shaderDesc, layout, numElements);
+	if (!shaderTest.Initialize<ColoredTexturedVertexData>(device, shaderDesc, renderDevice->GetInputLayoutCache())) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Unable to load the test shader");
+		glfwTerminate();
+		exit(EXIT_FAILURE);
+	}
 
 	CONSTANT_BUFFER_DESC cBufferDesc = {};
 	cBufferDesc.bufferSize = sizeof(DirectX::XMMATRIX);
 
+	// The name and size are checked against the reflected cbuffer, the slot comes from reflection
 	shaderTest.CreateConstantBuffer(device, "WorldMatrixBuffer", cBufferDesc);
+	int worldMatrixBufferIndex = shaderTest.GetConstantBufferIndex("WorldMatrixBuffer");
+	if (worldMatrixBufferIndex < 0)
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "WorldMatrixBuffer is not declared by the test shader, the quad won't rotate");
 	float angle = 1.0f;
 
-		/// Now let's create a texturE
-	// craete texture
-	ID3D11Texture2D* texture = nullptr;
-	int ImageWidth;
-	int ImageHeight;
-	int ImageChannels;
-	int ImageDesiredChannels = 4;
-
-	unsigned char* ImageData = stbi_load("textures/tile_64x64.png",
-		&ImageWidth,
-		&ImageHeight,
-		&ImageChannels, ImageDesiredChannels);
-	assert(ImageData);
-
-	int ImagePitch = ImageWidth * 4;
-
-	// Texture
-
-	D3D11_TEXTURE2D_DESC ImageTextureDesc = {};
-
-	ImageTextureDesc.Width = ImageWidth;
-	ImageTextureDesc.Height = ImageHeight;
-	ImageTextureDesc.MipLevels = 1;
-	ImageTextureDesc.ArraySize = 1;
-	ImageTextureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-	ImageTextureDesc.SampleDesc.Count = 1;
-	ImageTextureDesc.SampleDesc.Quality = 0;
-	ImageTextureDesc.Usage = D3D11_USAGE_IMMUTABLE;
-	ImageTextureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-
-	D3D11_SUBRESOURCE_DATA ImageSubresourceData = {};
-
-	ImageSubresourceData.pSysMem = ImageData;
-	ImageSubresourceData.SysMemPitch = ImagePitch;
-
-	device->CreateTexture2D(&ImageTextureDesc,
-		&ImageSubresourceData,
-		&texture
-	);
-
-
-	free(ImageData);
-
-	// Shader resource view
-	ID3D11ShaderResourceView* ImageShaderResourceView;
-	device->CreateShaderResourceView(texture,
-		nullptr,
-		&ImageShaderResourceView
-	);
-
 	// Sampler
 	D3D11_SAMPLER_DESC ImageSamplerDesc = {};
 	ImageSamplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
@@ -327,14 +481,14 @@ int main() {
 	ImageSamplerDesc.MinLOD = -FLT_MAX;
 	ImageSamplerDesc.MaxLOD = FLT_MAX;
 
-	ID3D11SamplerState* ImageSamplerState;
+	ComPtr<ID3D11SamplerState> imageSamplerState;
 
 	device->CreateSamplerState(&ImageSamplerDesc,
-		&ImageSamplerState);
+		&imageSamplerState);
 	
-	// set texture and sampler
-	deviceContext->PSSetShaderResources(0, 1, &ImageShaderResourceView);
-	deviceContext->PSSetSamplers(0, 1, &ImageSamplerState);
+	// set the sampler, the slots are resolved from the shader reflection. The texture is set once it's loaded.
+	shaderTest.SetSampler("samplerState", imageSamplerState.Get());
+	bool tileTextureResolved = false;  // Bound, or its load failed
 
 		/// Let's try initialize ImGui
 	// Setup Dear ImGui context
@@ -365,6 +519,27 @@ int main() {
 		//ImGui::ShowDemoWindow();
 
 		RenderImGuiPerformance();
+		RenderImGuiAssets(threadPool);
+		// The texture is created by the registry on the render thread once the worker has decoded it
+		assetRegistry.Update(device, deviceContext);
+		if (!tileTextureResolved && assetRegistry.GetState(tileTexture) == AssetState::Ready) {
+			shaderTest.SetShaderResource("texture_input", assetRegistry.GetShaderResourceView(tileTexture));
+			tileTextureResolved = true;
+		}
+		else if (!tileTextureResolved && assetRegistry.GetState(tileTexture) == AssetState::Failed) {
+			ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to load the tile texture, the quad is drawn without it");
+			tileTextureResolved = true;
+		}
+
+		RenderImGuiTextureStreaming(textureStreamer, device, threadPool);
+		RenderImGuiMemoryBudget(memoryBudget, dxgiBudgetSource, simulatedBudgetSource);
+		int framebufferWidth = 0;
+		int framebufferHeight = 0;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		if (framebufferWidth > 0 && framebufferHeight > 0)
+			RequestVisibleTextureLevels(textureStreamer, static_cast<float>(framebufferWidth), static_cast<float>(framebufferHeight));
+		textureStreamer.Update(device);
+		memoryBudget.Update();
 
 		// Clear the render target and depth/stencil view
 		renderDevice->StartFrame(clearColor);
@@ -373,18 +548,19 @@ int main() {
 		angle += 0.01f;
 
 		// Update constant buffer
-		UpdateRotation(shaderTest, deviceContext, angle);
+		if (worldMatrixBufferIndex >= 0)
+			UpdateRotation(shaderTest, deviceContext, worldMatrixBufferIndex, angle);
 
 		shaderTest.SetShaders(deviceContext);
 
-		shaderTest.BindConstantBuffer(deviceContext, "WorldMatrixBuffer", 0, ShaderStage::VertexShader);
+		shaderTest.BindResources(deviceContext);
 
-		UINT stride = sizeof(ColoredTexturedVertexData);
+		UINT stride = QuadVertexLayout::Stride;
 		UINT offset = 0;
 		//Bind the vertex buffer
 		deviceContext->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
 		// Bind the index buffer
-		deviceContext->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+		deviceContext->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
 
 		// Define the the type of primitive topology that should be rendered from this vertex buffer, in this case triangles
 		deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -404,6 +580,11 @@ int main() {
 		
 	}
 
+	// The render device and the asset registry outlive the budget
+	renderDevice->SetMemoryBudget(nullptr);
+	assetRegistry.Release(tileTexture);
+	assetRegistry.SetMemoryBudget(nullptr);
+
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
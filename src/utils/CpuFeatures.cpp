@@ -0,0 +1,45 @@
+#include "CpuFeatures.h"
+
+#include <intrin.h>
+
+
+namespace {
+	SimdLevel DetectSimdLevel() {
+		int cpuInfo[4] = {};
+		__cpuid(cpuInfo, 0);
+		const int maxLeaf = cpuInfo[0];
+
+		__cpuid(cpuInfo, 1);
+		const bool sse41 = (cpuInfo[2] & (1 << 19)) != 0;
+		const bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+		const bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+		const bool fma = (cpuInfo[2] & (1 << 12)) != 0;
+		if (!sse41)
+			return SimdLevel::Scalar;
+
+		// XCR0 bits 1 and 2: the OS saves the XMM and YMM registers
+		const bool osSavesYmm = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+		bool avx2 = false;
+		if (maxLeaf >= 7) {
+			__cpuidex(cpuInfo, 7, 0);
+			avx2 = (cpuInfo[1] & (1 << 5)) != 0;
+		}
+		return avx && avx2 && fma && osSavesYmm ? SimdLevel::AVX2 : SimdLevel::SSE41;
+	}
+}
+
+SimdLevel CpuFeatures::GetSimdLevel() {
+	static const SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+const char* CpuFeatures::GetSimdLevelName(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::SSE41:
+		return "SSE4.1";
+	case SimdLevel::AVX2:
+		return "AVX2";
+	default:
+		return "Scalar";
+	}
+}
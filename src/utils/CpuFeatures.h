@@ -0,0 +1,23 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <cstdint>
+
+
+// Instruction sets the SIMD kernels can be compiled for, ordered so a level implies the ones below it.
+// SSE2 is the x64 baseline, so the scalar level is only used as a reference or a fallback.
+enum class SimdLevel : uint8_t {
+	Scalar,
+	SSE41,
+	AVX2
+};
+
+namespace CpuFeatures {
+	// Highest level supported by both the CPU and the OS (AVX needs the YMM state saved on context switches).
+	// Detected with cpuid on the first call.
+	SimdLevel GetSimdLevel();
+
+	const char* GetSimdLevelName(SimdLevel level);
+}
+
+#endif // !CPU_FEATURES_H
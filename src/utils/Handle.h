@@ -0,0 +1,48 @@
+#ifndef HANDLE_H
+#define HANDLE_H
+
+#include <cstdint>
+#include <functional>
+
+
+// 32-bit handle to a slot of a pool: the low INDEX_BITS are the slot, the high bits its generation.
+//
+// A slot's generation is bumped whenever what it holds is destroyed, so a handle kept after that
+// no longer matches and lookups fail instead of reaching whatever reuses the slot. Generations start at 1,
+// the all-zero handle is never valid. `Tag` only keeps handles of different pools from mixing.
+template <typename Tag>
+class Handle {
+	public:
+		static constexpr uint32_t INDEX_BITS = 20;
+		static constexpr uint32_t MAX_INDEX = (1u << INDEX_BITS) - 1;
+		static constexpr uint32_t MAX_GENERATION = (1u << (32 - INDEX_BITS)) - 1;
+
+		constexpr Handle() = default;
+		static constexpr Handle Make(uint32_t index, uint32_t generation) { return Handle((generation << INDEX_BITS) | index); }
+		static constexpr Handle FromValue(uint32_t value) { return Handle(value); }
+		// Generation after `generation`, skipping 0 when it wraps around
+		static constexpr uint32_t NextGeneration(uint32_t generation) { return generation >= MAX_GENERATION ? 1 : generation + 1; }
+
+		constexpr bool IsValid() const { return m_value != 0; }
+		constexpr uint32_t GetIndex() const { return m_value & MAX_INDEX; }
+		constexpr uint32_t GetGeneration() const { return m_value >> INDEX_BITS; }
+		constexpr uint32_t GetValue() const { return m_value; }
+
+		constexpr bool operator==(Handle other) const { return m_value == other.m_value; }
+		constexpr bool operator!=(Handle other) const { return m_value != other.m_value; }
+
+	private:
+		explicit constexpr Handle(uint32_t value) : m_value(value) {}
+
+	private:
+		uint32_t m_value = 0;
+};
+
+namespace std {
+	template <typename Tag>
+	struct hash<Handle<Tag>> {
+		size_t operator()(Handle<Tag> handle) const { return hash<uint32_t>()(handle.GetValue()); }
+	};
+}
+
+#endif // !HANDLE_H
@@ -0,0 +1,165 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string>
+
+
+// Small hashing helpers shared by the caches of the engine.
+//
+// FNV-1a is used for keys (cache lookups, file validation): it's tiny, constexpr friendly
+// and good enough for the amount of data those keys cover.
+// MurmurHash3 is used for content (whole files, the keys of the content store): it reads 16 bytes per
+// step, and its 128 bits make two different contents sharing a key a non-issue.
+
+struct Hash128 {
+	uint64_t low = 0;
+	uint64_t high = 0;
+
+	bool operator==(const Hash128& other) const { return low == other.low && high == other.high; }
+	bool operator!=(const Hash128& other) const { return !(*this == other); }
+};
+
+namespace Hash {
+	constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+	constexpr uint64_t FNV1A_PRIME = 0x100000001b3ull;
+
+	// Hashes a block of memory, optionally continuing from a previous hash value
+	inline uint64_t FNV1a(const void* data, size_t size, uint64_t hash = FNV1A_OFFSET_BASIS) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= FNV1A_PRIME;
+		}
+		return hash;
+	}
+
+	// Hashes a null terminated string, usable in constant expressions
+	constexpr uint64_t FNV1aString(const char* str, uint64_t hash = FNV1A_OFFSET_BASIS) {
+		while (*str) {
+			hash ^= static_cast<uint8_t>(*str++);
+			hash *= FNV1A_PRIME;
+		}
+		return hash;
+	}
+
+	// Hashes the bytes of an integral value, usable in constant expressions
+	constexpr uint64_t FNV1aValue(uint64_t value, size_t byteCount, uint64_t hash = FNV1A_OFFSET_BASIS) {
+		for (size_t i = 0; i < byteCount; ++i) {
+			hash ^= static_cast<uint8_t>(value >> (i * 8));
+			hash *= FNV1A_PRIME;
+		}
+		return hash;
+	}
+
+	// Combines two hashes into one (boost::hash_combine style)
+	constexpr uint64_t Combine(uint64_t seed, uint64_t value) {
+		return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+	}
+
+	namespace Detail {
+		inline uint64_t RotateLeft(uint64_t value, int bits) {
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		inline uint64_t Mix(uint64_t value) {
+			value ^= value >> 33;
+			value *= 0xff51afd7ed558ccdull;
+			value ^= value >> 33;
+			value *= 0xc4ceb9fe1a85ec53ull;
+			return value ^ (value >> 33);
+		}
+	}
+
+	// MurmurHash3_x64_128 (Austin Appleby, public domain). Seeds below 2^32 give the reference results.
+	inline Hash128 Murmur3(const void* data, size_t size, uint64_t seed = 0) {
+		constexpr uint64_t C1 = 0x87c37b91114253d5ull;
+		constexpr uint64_t C2 = 0x4cf5ad432745937full;
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t h1 = seed;
+		uint64_t h2 = seed;
+
+		const size_t blockCount = size / 16;
+		for (size_t i = 0; i < blockCount; ++i) {
+			uint64_t k1;
+			uint64_t k2;
+			std::memcpy(&k1, bytes + i * 16, 8);
+			std::memcpy(&k2, bytes + i * 16 + 8, 8);
+
+			h1 ^= Detail::RotateLeft(k1 * C1, 31) * C2;
+			h1 = (Detail::RotateLeft(h1, 27) + h2) * 5 + 0x52dce729;
+			h2 ^= Detail::RotateLeft(k2 * C2, 33) * C1;
+			h2 = (Detail::RotateLeft(h2, 31) + h1) * 5 + 0x38495ab5;
+		}
+
+		// Last 0 to 15 bytes, little endian
+		const uint8_t* tail = bytes + blockCount * 16;
+		const size_t tailSize = size & 15;
+		uint64_t k1 = 0;
+		uint64_t k2 = 0;
+		for (size_t i = tailSize; i > 8; --i)
+			k2 = (k2 << 8) | tail[i - 1];
+		for (size_t i = tailSize < 8 ? tailSize : 8; i > 0; --i)
+			k1 = (k1 << 8) | tail[i - 1];
+		if (tailSize > 8)
+			h2 ^= Detail::RotateLeft(k2 * C2, 33) * C1;
+		if (tailSize > 0)
+			h1 ^= Detail::RotateLeft(k1 * C1, 31) * C2;
+
+		h1 ^= size;
+		h2 ^= size;
+		h1 += h2;
+		h2 += h1;
+		h1 = Detail::Mix(h1);
+		h2 = Detail::Mix(h2);
+		h1 += h2;
+		h2 += h1;
+		return { h1, h2 };
+	}
+
+	// 32 lowercase hex digits, high half first
+	inline std::string ToString(const Hash128& hash) {
+		constexpr char DIGITS[] = "0123456789abcdef";
+		std::string text(32, '0');
+		for (int i = 0; i < 16; ++i) {
+			text[15 - i] = DIGITS[(hash.high >> (i * 4)) & 15];
+			text[31 - i] = DIGITS[(hash.low >> (i * 4)) & 15];
+		}
+		return text;
+	}
+
+	// Reads a hash written by ToString, false if `text` isn't 32 hex digits
+	inline bool FromString(const std::string& text, Hash128& hash) {
+		if (text.size() != 32)
+			return false;
+		uint64_t halves[2] = {};
+		for (size_t i = 0; i < 32; ++i) {
+			const char c = text[i];
+			uint64_t digit;
+			if (c >= '0' && c <= '9')
+				digit = c - '0';
+			else if (c >= 'a' && c <= 'f')
+				digit = c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F')
+				digit = c - 'A' + 10;
+			else
+				return false;
+			halves[i / 16] = (halves[i / 16] << 4) | digit;
+		}
+		hash.high = halves[0];
+		hash.low = halves[1];
+		return true;
+	}
+}
+
+namespace std {
+	template <>
+	struct hash<Hash128> {
+		size_t operator()(const Hash128& hash) const { return static_cast<size_t>(hash.low); }
+	};
+}
+
+#endif // !HASH_H
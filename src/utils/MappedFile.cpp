@@ -0,0 +1,76 @@
+#include "MappedFile.h"
+
+#include "ConsoleLogger.h"
+
+#include <Windows.h>
+
+#include <utility>
+
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: m_file(std::exchange(other.m_file, nullptr)), m_mapping(std::exchange(other.m_mapping, nullptr)),
+	m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) {
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		Close();
+		m_file = std::exchange(other.m_file, nullptr);
+		m_mapping = std::exchange(other.m_mapping, nullptr);
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+	}
+	return *this;
+}
+
+bool MappedFile::Open(const std::string& filePath) {
+	Close();
+
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to open file: ", filePath);
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize)) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to get the size of file: ", filePath);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	// Empty files can't be mapped, they're open without data
+	if (m_size == 0)
+		return true;
+
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping != nullptr)
+		m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (m_data == nullptr) {
+		ConsoleLogger::Print(ConsoleLogger::LogType::C_ERROR, "Failed to map file: ", filePath);
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close() {
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+	if (m_file != nullptr)
+		CloseHandle(m_file);
+
+	m_file = nullptr;
+	m_mapping = nullptr;
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,41 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+// Read-only memory mapping of a whole file.
+//
+// Asset data (glTF buffers, cooked files) is read straight from the mapping instead of being copied
+// into heap buffers: the OS pages it in on first access and can drop it under memory pressure.
+// The pointer stays valid until the file is closed or the MappedFile destroyed.
+class MappedFile {
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Maps the file, an open file is closed first. Logs and returns false on failure.
+		bool Open(const std::string& filePath);
+		void Close();
+
+		bool IsOpen() const { return m_file != nullptr; }
+		// nullptr for empty files
+		const uint8_t* GetData() const { return m_data; }
+		size_t GetSize() const { return m_size; }
+
+	private:
+		// Windows handles, kept opaque so the header doesn't pull Windows.h
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+		const uint8_t* m_data = nullptr;
+		size_t m_size = 0;
+};
+
+#endif // !MAPPED_FILE_H
@@ -0,0 +1,177 @@
+#include "StagingMemory.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+
+namespace {
+	// Classes go from 4 KiB to 1 GiB, bigger blocks come from the system and go back to it
+	constexpr size_t MIN_BLOCK_SHIFT = 12;
+	constexpr size_t MAX_BLOCK_SHIFT = 30;
+	constexpr uint32_t SUBCLASS_BITS = 2;
+	constexpr uint32_t CLASS_COUNT = (uint32_t(MAX_BLOCK_SHIFT - MIN_BLOCK_SHIFT) << SUBCLASS_BITS) + 1;
+	constexpr uint32_t UNPOOLED_CLASS = UINT32_MAX;
+	constexpr size_t DEFAULT_CACHE_LIMIT = size_t(256) << 20;
+
+	// In front of every block, its size keeps the block 16 byte aligned
+	struct BlockHeader {
+		uint32_t sizeClass;
+		uint32_t padding;
+		size_t capacity;
+	};
+	static_assert(sizeof(BlockHeader) == 16, "The header keeps the blocks 16 byte aligned");
+
+	size_t GetClassCapacity(uint32_t sizeClass) {
+		const size_t shift = MIN_BLOCK_SHIFT + (sizeClass >> SUBCLASS_BITS);
+		const size_t step = size_t(1) << (shift - SUBCLASS_BITS);
+		return (size_t(1) << shift) + (sizeClass & ((1u << SUBCLASS_BITS) - 1)) * step;
+	}
+
+	uint32_t GetSizeClass(size_t size) {
+		if (size <= (size_t(1) << MIN_BLOCK_SHIFT))
+			return 0;
+		if (size > (size_t(1) << MAX_BLOCK_SHIFT))
+			return UNPOOLED_CLASS;
+
+		// Largest power of two strictly below the size, then the subclass step that covers the rest.
+		// A rest of four steps is the first class of the next power of two, the formula stays the same.
+		size_t shift = MIN_BLOCK_SHIFT;
+		while ((size - 1) >> (shift + 1))
+			++shift;
+		const size_t step = size_t(1) << (shift - SUBCLASS_BITS);
+		const size_t subclass = (size - (size_t(1) << shift) + step - 1) / step;
+		return (uint32_t(shift - MIN_BLOCK_SHIFT) << SUBCLASS_BITS) + uint32_t(subclass);
+	}
+
+	BlockHeader* GetHeader(void* memory) {
+		return static_cast<BlockHeader*>(memory) - 1;
+	}
+
+	class Pool {
+		public:
+			void* Allocate(size_t size) {
+				const uint32_t sizeClass = GetSizeClass(size);
+				const size_t capacity = sizeClass == UNPOOLED_CLASS ? size : GetClassCapacity(sizeClass);
+
+				BlockHeader* header = nullptr;
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (sizeClass != UNPOOLED_CLASS && !m_freeBlocks[sizeClass].empty()) {
+						header = m_freeBlocks[sizeClass].back();
+						m_freeBlocks[sizeClass].pop_back();
+						m_stats.cachedBytes -= capacity;
+						++m_stats.pooledAllocations;
+					}
+					else {
+						++m_stats.systemAllocations;
+					}
+					m_stats.liveBytes += capacity;
+					m_stats.peakLiveBytes = std::max(m_stats.peakLiveBytes, m_stats.liveBytes);
+				}
+
+				if (header == nullptr) {
+					// malloc is 16 byte aligned on 64-bit targets, the header keeps the block aligned
+					header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + capacity));
+					if (header == nullptr) {
+						std::lock_guard<std::mutex> lock(m_mutex);
+						m_stats.liveBytes -= capacity;
+						return nullptr;
+					}
+					header->sizeClass = sizeClass;
+					header->padding = 0;
+					header->capacity = capacity;
+				}
+				return header + 1;
+			}
+
+			void Free(void* memory) {
+				BlockHeader* header = GetHeader(memory);
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_stats.liveBytes -= header->capacity;
+					if (header->sizeClass != UNPOOLED_CLASS && m_stats.cachedBytes + header->capacity <= m_cacheLimit) {
+						m_freeBlocks[header->sizeClass].push_back(header);
+						m_stats.cachedBytes += header->capacity;
+						return;
+					}
+				}
+				std::free(header);
+			}
+
+			void SetCacheLimit(size_t bytes) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_cacheLimit = bytes;
+			}
+
+			void Trim() {
+				std::vector<BlockHeader*> blocks;
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					for (std::vector<BlockHeader*>& freeBlocks : m_freeBlocks) {
+						blocks.insert(blocks.end(), freeBlocks.begin(), freeBlocks.end());
+						freeBlocks.clear();
+					}
+					m_stats.cachedBytes = 0;
+				}
+				for (BlockHeader* header : blocks)
+					std::free(header);
+			}
+
+			StagingMemory::Stats GetStats() {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				return m_stats;
+			}
+
+		private:
+			std::mutex m_mutex;
+			std::vector<BlockHeader*> m_freeBlocks[CLASS_COUNT];
+			size_t m_cacheLimit = DEFAULT_CACHE_LIMIT;
+			StagingMemory::Stats m_stats;
+	};
+
+	// Never destroyed: blocks can still be freed by static destructors at exit
+	Pool& GetPool() {
+		static Pool* pool = new Pool();
+		return *pool;
+	}
+}
+
+void* StagingMemory::Allocate(size_t size) {
+	return GetPool().Allocate(size);
+}
+
+void* StagingMemory::Reallocate(void* memory, size_t size) {
+	if (memory == nullptr)
+		return Allocate(size);
+
+	const size_t capacity = GetHeader(memory)->capacity;
+	if (size <= capacity)
+		return memory;
+
+	void* block = Allocate(size);
+	if (block == nullptr)
+		return nullptr;  // The old block stays valid, as with realloc
+	std::memcpy(block, memory, capacity);
+	Free(memory);
+	return block;
+}
+
+void StagingMemory::Free(void* memory) {
+	if (memory != nullptr)
+		GetPool().Free(memory);
+}
+
+void StagingMemory::SetCacheLimit(size_t bytes) {
+	GetPool().SetCacheLimit(bytes);
+}
+
+void StagingMemory::Trim() {
+	GetPool().Trim();
+}
+
+StagingMemory::Stats StagingMemory::GetStats() {
+	return GetPool().GetStats();
+}
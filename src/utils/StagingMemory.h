@@ -0,0 +1,46 @@
+#ifndef STAGING_MEMORY_H
+#define STAGING_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+// Pool for the large, short lived CPU buffers of asset loading: decoded images waiting for their
+// upload and the scratch buffers of the decoders.
+//
+// Blocks come in size classes, four per power of two from 4 KiB, so a block is at most 25% larger than
+// requested. Freed blocks are kept per class and handed back to the next allocation of that class:
+// once a scene load is past its first few images, decodes stop going to the system allocator.
+// Thread-safe. stb_image allocates through it (see TextureLoader.cpp).
+namespace StagingMemory {
+	// Blocks are 16 byte aligned. Allocate(0) returns a valid minimum size block.
+	void* Allocate(size_t size);
+	// Grows in place while the block capacity allows it, like the doubling buffers of the decoders.
+	// Reallocate(nullptr, size) is Allocate(size).
+	void* Reallocate(void* memory, size_t size);
+	// Returns the block to its class, or to the system once the pool holds the cache limit. Free(nullptr) does nothing.
+	void Free(void* memory);
+
+	// Bytes of free blocks kept for reuse, 256 MiB by default
+	void SetCacheLimit(size_t bytes);
+	// Releases every free block to the system, after a scene load for example
+	void Trim();
+
+	struct Stats {
+		size_t systemAllocations = 0;  // Blocks that had to come from the system allocator
+		size_t pooledAllocations = 0;  // Blocks reused from the pool
+		size_t liveBytes = 0;          // Capacity of the blocks in use
+		size_t peakLiveBytes = 0;
+		size_t cachedBytes = 0;        // Capacity of the free blocks kept for reuse
+	};
+	Stats GetStats();
+
+	struct Deleter {
+		void operator()(void* memory) const { Free(memory); }
+	};
+	// Owning pointer to a staging block
+	using Buffer = std::unique_ptr<uint8_t[], Deleter>;
+}
+
+#endif // !STAGING_MEMORY_H
@@ -0,0 +1,95 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+
+ThreadPool::ThreadPool(size_t threadCount) {
+	if (threadCount == 0) {
+		unsigned hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	m_workers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i)
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+
+	// Workers finish the queued tasks before exiting
+	for (std::thread& worker : m_workers)
+		worker.join();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push(std::move(task));
+	}
+	m_condition.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+			if (m_tasks.empty())
+				return;
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+		}
+		task();
+	}
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& function) {
+	if (count == 0)
+		return;
+
+	batchSize = std::max<size_t>(batchSize, 1);
+	const size_t batchCount = (count + batchSize - 1) / batchSize;
+	if (batchCount == 1) {
+		function(0, count);
+		return;
+	}
+
+	// Shared with the helper tasks, which can start after the loop is already over
+	struct LoopState {
+		std::atomic<size_t> nextBatch{ 0 };
+		std::atomic<size_t> finishedBatches{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+	auto state = std::make_shared<LoopState>();
+
+	auto runBatches = [state, &function, count, batchSize, batchCount]() {
+		size_t batch;
+		while ((batch = state->nextBatch.fetch_add(1)) < batchCount) {
+			size_t begin = batch * batchSize;
+			function(begin, std::min(begin + batchSize, count));
+			if (state->finishedBatches.fetch_add(1) + 1 == batchCount) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->finished.notify_all();
+			}
+		}
+	};
+
+	// `function` is only used while batches remain, so late helpers never touch it after the return
+	size_t helperCount = std::min(m_workers.size(), batchCount - 1);
+	for (size_t i = 0; i < helperCount; ++i)
+		Enqueue(runBatches);
+
+	runBatches();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state, batchCount]() { return state->finishedBatches.load() == batchCount; });
+}
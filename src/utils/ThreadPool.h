@@ -0,0 +1,56 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of worker threads running tasks from a shared queue.
+//
+// Import passes (tangents, texture decoding, mip generation...) submit one task per asset with
+// Submit, or split a large loop over the workers with ParallelFor. Tasks must not block on other
+// tasks of the same pool, except through ParallelFor which also runs batches on the calling thread.
+class ThreadPool {
+	public:
+		// A thread count of 0 uses one worker per hardware thread, minus the calling thread
+		explicit ThreadPool(size_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// Queues a task, the future holds its result (or the exception it threw)
+		template<typename Function>
+		auto Submit(Function&& function) -> std::future<decltype(function())> {
+			using ResultType = decltype(function());
+			auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Function>(function));
+			std::future<ResultType> result = task->get_future();
+			Enqueue([task]() { (*task)(); });
+			return result;
+		}
+
+		// Runs `function(begin, end)` over [0, count) in batches of `batchSize` on the workers and
+		// the calling thread. Returns once every batch is done.
+		void ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& function);
+
+		size_t GetThreadCount() const { return m_workers.size(); }
+
+	private:
+		void Enqueue(std::function<void()> task);
+		void WorkerLoop();
+
+	private:
+		std::vector<std::thread> m_workers;
+		std::queue<std::function<void()>> m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stopping = false;
+};
+
+#endif // !THREAD_POOL_H